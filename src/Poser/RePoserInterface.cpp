@@ -155,6 +155,8 @@ void RePoserBase::exportStarted( int numObjects ) {
 }
 
 void RePoserBase::exportingObject( const QString& objName ) {
+  // Counters of the objects exported so far
+  realityIPC->exportProgress(RealitySceneData->getExportProgress());
   realityIPC->exportingObject(objName);
 }
 
@@ -356,12 +356,12 @@ public:
   /*
    * Geometry
    */
-  inline void newGeometryBuffer( const QString& bufferName,
+  inline bool newGeometryBuffer( const QString& bufferName,
                                  const int numVertices, 
                                  const int numTriangles, 
                                  const bool hasUVs ) const
   {
-    RealitySceneData->newGeometryBuffer(bufferName, 
+    return RealitySceneData->newGeometryBuffer(bufferName, 
                                         numVertices,
                                         numTriangles, 
                                         hasUVs);
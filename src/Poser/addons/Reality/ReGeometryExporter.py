@@ -487,12 +487,15 @@ class ReGeometryExporter:
         mat = self.materials[matName]
         hasUVs = len(mat["uv"]) > 0
         #!!! What happens if there are no UVs?
-        self.RealitySceneData.newGeometryBuffer( 
+        if not self.RealitySceneData.newGeometryBuffer( 
           matName,
           len(self.materials[matName]["v"])/3,
           len(self.materials[matName]["i"])/3,
           hasUVs
-        )
+        ):
+          # Not enough memory for the geometry, the material is skipped
+          del self.materials[matName]
+          continue
         # We have UV maps for this material
         if hasUVs:
           self.RealitySceneData.copyUVData(mat["uv"], mat["v"], mat["n"])
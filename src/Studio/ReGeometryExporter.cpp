@@ -6,6 +6,8 @@
 
 #include "ReGeometryExporter.h"
 
+#include <QCryptographicHash>
+#include <QVector>
 #include <dzcustomdata.h>
 #include <dzface.h>
 #include <dzfacetmesh.h>
@@ -199,13 +201,56 @@ void ReGeometryExporter::exportObject( const QString& objName,
 };
 
 
+QByteArray ReGeometryExporter::getGeometryHash( const QString& objName ) {
+  auto node = nodes.value(objName);
+  if ( !node || !setup(node) ) {
+    return QByteArray();
+  }
+  // The cached geometry is in world space so this covers also the pose
+  // and the position of the object
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  int numVertices = geom->getNumVertices();
+  int numFacets   = geom->getNumFacets();
+  hash.addData(reinterpret_cast<const char*>(&numVertices), sizeof(numVertices));
+  hash.addData(reinterpret_cast<const char*>(&numFacets), sizeof(numFacets));
+  hash.addData(reinterpret_cast<const char*>(geom->getVerticesPtr()), 
+               numVertices * sizeof(DzPnt3));
+  // The visibility of the facets
+  hash.addData(reinterpret_cast<const char*>(geom->getFacetFlagsPtr()), 
+               numFacets * sizeof(*geom->getFacetFlagsPtr()));
+  // The vertex, normal and UV indices and the material of the facets
+  hash.addData(reinterpret_cast<const char*>(geom->getFacetsPtr()), 
+               numFacets * sizeof(DzFacet));
+  int numNormals = geom->getNumNormals();
+  hash.addData(reinterpret_cast<const char*>(&numNormals), sizeof(numNormals));
+  hash.addData(reinterpret_cast<const char*>(geom->getNormalsPtr()), 
+               numNormals * sizeof(DzPnt3));
+  // The UVs of the active UV set, read as they are by exportMaterial()
+  DzMap* dzUVs = geom->getUVs();
+  int numUVs = dzUVs ? dzUVs->getNumValues() : 0;
+  QVector<float> uvs(numUVs*2);
+  for (int i = 0; i < numUVs; i++) {
+    auto uvPoint = dzUVs->getPnt2Value(i);
+    uvs[i*2]   = uvPoint[0];
+    uvs[i*2+1] = uvPoint[1];
+  }
+  hash.addData(reinterpret_cast<const char*>(&numUVs), sizeof(numUVs));
+  hash.addData(reinterpret_cast<const char*>(uvs.constData()), 
+               uvs.count() * sizeof(float));
+  return hash.result();
+}
+
 void ReGeometryExporter::exportMaterial( const QString& matName, 
                                          const QString objName ) 
 {
-  RealitySceneData->newGeometryBuffer( matName.toUtf8(), 
-                                       vertMap.count(), 
-                                       triList.count(),
-                                       true );
+  if ( !RealitySceneData->newGeometryBuffer( matName.toUtf8(), 
+                                             vertMap.count(), 
+                                             triList.count(),
+                                             true ) ) 
+  {
+    startMaterial();
+    return;
+  }
   float* verts   = RealitySceneData->getGeometryVertexBuffer();
   float* normals = RealitySceneData->getGeometryNormalBuffer();
   ReUVPoint* uvs = RealitySceneData->getGeometryUVPointBuffer();
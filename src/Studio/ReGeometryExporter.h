@@ -117,6 +117,12 @@ public:
   }
 
   void exportObject( const QString& objName, const ReGeometryObjectPtr obj );
+
+  //! Returns a hash of the geometry of the object, as it would be exported
+  //! in this frame. Used to find out if the object can be reused from an
+  //! interrupted export. Returns an empty hash if the geometry cannot be
+  //! found.
+  QByteArray getGeometryHash( const QString& objName );
   void exportMaterial( const QString& matName, const QString objName  );
 
   inline void startMaterial() {
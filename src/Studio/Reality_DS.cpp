@@ -109,6 +109,7 @@ Reality_DS::Reality_DS():
   sceneLevel = 0;
   isSceneLoading = false;
   sceneIsMerging = false;
+  isBatchingMaterials = false;
   instance = this;
 };
 
@@ -204,6 +205,8 @@ void Reality_DS::startup() {
 
   RealityBase* rBase = RealityBase::getRealityBase();
   rBase->startHostSideServices(DAZStudio);
+  // Commands from the GUI are executed as soon as they are queued
+  RealityBase::getCommandQueue()->setReceiver(this);
   rBase->setHostVersion(dzApp->getLongVersionStringProp());
   realityActive = false;
   shuttingDown = false;
@@ -359,6 +362,7 @@ void Reality_DS::shutdown() {
   }
 
   removeHooks();
+  RealityBase::getCommandQueue()->setReceiver(NULL);
   realityIPC->closeGUI();
   RealityBase::getRealityBase()->stopHostSideServices();  
 };
@@ -412,9 +416,12 @@ void Reality_DS::sceneLoaded() {
 void Reality_DS::addNode( ReStudioEvent* reEvent ) {
   RE_LOG_INFO() << "File or group finished loading";
   int numNodes = nodeList.count();
+  isBatchingMaterials = true;
   for (int i = 0; i < numNodes; i++) {
     addNode(nodeList[i]);
   }
+  isBatchingMaterials = false;
+  commitMaterialBatch();
   nodeList.clear();
   // Add the monitors for objects loaded from the Studio scene for 
   // which Reality data was loaded.
@@ -528,6 +535,11 @@ void Reality_DS::updateMaterialList() {
 
 bool Reality_DS::event( QEvent* e ) {
 
+  if (e->type() == ReHostCommandQueue::getEventType()) {
+    RealityBase::getCommandQueue()->acknowledgeEvent();
+    processHostCommands();
+    return true;
+  }
   if (e->type() != ReStudioEvent::reEventType) {
     return false;
   }
@@ -654,7 +666,7 @@ void Reality_DS::cameraRenamed( const QString& newLabel ) {
   RealitySceneData->renameCamera(ReGUID::getGUID(dsCam), newLabel);
 };
 
-void Reality_DS::renderFrame( const QString& sceneFileName, 
+bool Reality_DS::renderFrame( const QString& sceneFileName, 
                               const unsigned int frameNo,
                               const bool runRenderer ) 
 {
@@ -666,9 +678,10 @@ void Reality_DS::renderFrame( const QString& sceneFileName,
   auto objs = exporter->getNodes();
   ReGeometryExporter::NodeDictIterator nodeIter(objs);
 
-  DzProgress progressInd("Rendering", objs.count(), false, true);
+  DzProgress progressInd("Rendering", objs.count(), true, true);
   realityIPC->exportStarted(objs.count());
 
+  bool cancelled = false;
   while( nodeIter.hasNext() ) {
     nodeIter.next();
     QString objName = nodeIter.key();
@@ -686,7 +699,27 @@ void Reality_DS::renderFrame( const QString& sceneFileName,
     progressInd.setInfo(msg);
     progressInd.step();
 
-    exporter->exportObject( objName, obj );
+    // Objects completed by an interrupted export are copied from it
+    if ( !RealitySceneData->renderSceneResumeObject(
+            objName, exporter->getGeometryHash(objName)
+         ) ) 
+    {
+      exporter->exportObject( objName, obj );
+    }
+    realityIPC->exportProgress(RealitySceneData->getExportProgress());
+
+    // Cancellation checkpoint, from Studio's progress bar or Reality's UI
+    if (progressInd.isCancelled() || RealitySceneData->renderSceneIsCancelled()) {
+      cancelled = true;
+      break;
+    }
+  }
+  if (cancelled) {
+    RE_LOG_INFO() << "Export cancelled by the user";
+    RealitySceneData->renderSceneAbort();
+    realityIPC->exportFinished();
+    delete exporter;
+    return false;
   }
   // Export the instances
   int numInstances = instances.count();
@@ -718,6 +751,7 @@ void Reality_DS::renderFrame( const QString& sceneFileName,
 
   realityIPC->exportFinished();  
   delete exporter;
+  return true;
 };
 
 void Reality_DS::renderCurrentFrame( const QString& sceneFileName, 
@@ -783,7 +817,10 @@ void Reality_DS::renderAnimation( const bool runRenderer,
     }
     updateCameraData();
     QString fileName = expandFrameNumber(sceneName, i);
-    renderFrame(fileName, i, false);
+    if ( !renderFrame(fileName, i, false) ) {
+      renderWasInterrupted = true;
+      break;
+    }
     renderQueue << fileName;
   }
   dzScene->setFrame(currentFrame);
@@ -831,49 +868,50 @@ void Reality_DS::processTimedEvents() {
   updateCameraData();
   updateAnimationLimits();
 
-  // Check if there are commands pending from the GUI to us
+  // Commands are normally executed when the queue notifies us, this
+  // catches any command queued before the notification was set up
+  processHostCommands();
+}
+
+void Reality_DS::processHostCommands() {
   RealityBase* rBase = RealityBase::getRealityBase();
-  while( rBase->getNumCommands() ) {
-    QString cmd = rBase->commandStackPop();
-    if (cmd == "changed") {
-      dzScene->markChanged();
-    }
-    else if (cmd == "render") { 
-      QString runRender = rBase->commandStackPop();
-      renderCurrentFrame( "", 0, runRender == "1" );
-    }
-    else if (cmd == "renderAnim") { 
-      QString runRender = rBase->commandStackPop();
-      int startFrame = rBase->commandStackPop().toInt();
-      int endFrame = rBase->commandStackPop().toInt();
-      renderAnimation( runRender == "1", startFrame, endFrame );
-    }
-    else if (cmd == "sip") { 
-      // Set IBL Preview
-      QString mapName = rBase->commandStackPop();
-      setIBLPreviewMap(mapName);
-    }
-    else if (cmd == "save") {
-      auto sceneName = dzScene->getFilename();
-      if (sceneName == "") {
-        sceneName = dzScene->getAssetLoadPath();
-      };
-      auto mainWindow = dzApp->getInterface();
-      if (sceneName == "") {
-        mainWindow->doFileSaveAs();
-      }
-      else {
-        mainWindow->doFileSave();            
+  ReHostCommand cmd;
+  while( rBase->popCommand(cmd) ) {
+    switch( cmd.type ) {
+      case ReHostCommand::SceneChanged:
+        dzScene->markChanged();
+        break;
+      case ReHostCommand::RenderFrame:
+        renderCurrentFrame( "", 0, cmd.runRenderer );
+        break;
+      case ReHostCommand::RenderAnimation:
+        renderAnimation( cmd.runRenderer, cmd.startFrame, cmd.endFrame );
+        break;
+      case ReHostCommand::SetIBLPreview:
+        setIBLPreviewMap(cmd.fileName);
+        break;
+      case ReHostCommand::SaveScene: {
+        auto sceneName = dzScene->getFilename();
+        if (sceneName == "") {
+          sceneName = dzScene->getAssetLoadPath();
+        };
+        auto mainWindow = dzApp->getInterface();
+        if (sceneName == "") {
+          mainWindow->doFileSaveAs();
+        }
+        else {
+          mainWindow->doFileSave();            
+        }
+        break;
       }
-    }    
-    else if (cmd == "smha") {
-      // Select material in host app
-      QString objectID = rBase->commandStackPop();
-      QString materialName = rBase->commandStackPop();
-      selectStudioMaterial(objectID, materialName);
+      case ReHostCommand::SelectMaterial:
+        selectStudioMaterial(cmd.objectID, cmd.materialName);
+        break;
+      case ReHostCommand::RefreshScene:
+        // Not used in Studio
+        break;
     }
   }
-
 }
 
 void Reality_DS::updateCameraData() {
@@ -1530,14 +1568,47 @@ void Reality_DS::addRealityObject( const QString& objID,
     DzMaterial* theMat = shape->getAssemblyMaterial(l);
     QVariantMap* matInfo = matConverter->convertMaterial(theMat);
     QString matName = theMat->getLabel();
+    // Only the data from Studio is collected here, the conversion must
+    // happen in this thread because it uses the Studio API. The conversion
+    // to Reality materials is done later by commitMaterialBatch()
+    if (isBatchingMaterials) {
+      materialBatch.addMaterial(objID, matName, *matInfo);
+      BatchedMaterial bm;
+      bm.objID = objID;
+      bm.matName = matName;
+      bm.matIndex = theMat->getIndex();
+      batchedMaterials.append(bm);
+      continue;
+    }
     RealitySceneData->addMaterial(objID, matName, *matInfo);
     auto reMat = RealitySceneData->getMaterial(objID, matName);
     flatMatList.storeMaterial(theMat->getIndex(), reMat);
   }
   // ReAcsel::getInstance()->stopCaching();
+  if (isBatchingMaterials) {
+    batchedObjects.append(objID);
+    return;
+  }
   realityIPC->objectAdded(objID);  
 };
 
+void Reality_DS::commitMaterialBatch() {
+  if (materialBatch.count()) {
+    RE_LOG_INFO() << "Converting " << materialBatch.count() << " materials for "
+                  << materialBatch.getObjectIDs().count() << " objects";
+    materialBatch.convert();
+  }
+  foreach(const BatchedMaterial& bm, batchedMaterials) {
+    auto reMat = RealitySceneData->getMaterial(bm.objID, bm.matName);
+    flatMatList.storeMaterial(bm.matIndex, reMat);
+  }
+  batchedMaterials.clear();
+  foreach(QString objID, batchedObjects) {
+    realityIPC->objectAdded(objID);
+  }
+  batchedObjects.clear();
+}
+
 void Reality_DS::shapeSwitchHandler() {
   RE_LOG_INFO() << "]! Shape switched!";
 }
@@ -21,6 +21,7 @@
 #include "ReDSMatCollection.h"
 #include "ReGUID.h"
 #include "ReLogger.h"
+#include "ReMaterialBatchConverter.h"
 
 namespace Reality {
   class ReStudioEvent;
@@ -154,6 +155,28 @@ class Reality_DS : public DzPlugin {
     //! regardless of which object owns it
     ReDSMatCollection flatMatList;
 
+    //! When enabled the materials of the objects added to the scene are
+    //! queued in materialBatch instead of being converted right away.
+    //! Used when adding the nodes of a scene that has been loaded, so that
+    //! the materials are converted in parallel.
+    bool isBatchingMaterials;
+    ReMaterialBatchConverter materialBatch;
+
+    //! A material queued in materialBatch, with the index used by Studio
+    struct BatchedMaterial {
+      QString objID;
+      QString matName;
+      int matIndex;
+    };
+    QList<BatchedMaterial> batchedMaterials;
+    //! The objects added while batching, notified to the GUI once their
+    //! materials have been converted
+    QStringList batchedObjects;
+
+    //! Converts the materials queued in materialBatch and notifies the
+    //! GUI of the addition of their objects
+    void commitMaterialBatch();
+
     //! Updates the flatMatList object with the materials in the scene
     void updateFlatMaterialList();
 
@@ -182,7 +205,10 @@ class Reality_DS : public DzPlugin {
 
     void updateAnimationLimits();
   
-    void renderFrame( const QString& sceneFileName = "", 
+    //! Exports the scene for one frame. The export can be cancelled by the
+    //! user after each object, in that case the method returns false and
+    //! the next export resumes from the last object completed.
+    bool renderFrame( const QString& sceneFileName = "", 
                       const unsigned int frameNo = 0,
                       const bool runRenderer = true );
 
@@ -288,6 +314,10 @@ class Reality_DS : public DzPlugin {
     //! Background processing via a timer
     void processTimedEvents();
 
+    //! Executes the commands queued for the host by the GUI. See
+    //! <ReHostCommandQueue>.
+    void processHostCommands();
+
     //! Stores the definition of a camera
     void cameraAdded( DzCamera* camera );
 
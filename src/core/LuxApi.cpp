@@ -10,6 +10,7 @@ luxWorldEndFunc          luxWorldEnd          = NULL;
 luxUpdateFramebufferFunc luxUpdateFramebuffer = NULL;
 luxFramebufferFunc       luxFramebuffer       = NULL;
 luxStatisticsFunc        luxStatistics        = NULL;
+luxAbortFunc             luxAbort             = NULL;
 
 bool LuxLibraryLoader::isLuxLibraryLoaded = false;
 QLibrary LuxLibraryLoader::luxLibrary;
@@ -19,11 +20,20 @@ void LuxLibraryLoader::initLuxLibrary( const QString& libraryPath ) {
     return;
   }
 
+  QString fileName;
 #if defined(__APPLE__)
-  luxLibrary.setFileName(QString("%1/LuxRender.app/Contents/MacOS/liblux").arg(libraryPath));
+  fileName = QString("%1/LuxRender.app/Contents/MacOS/liblux").arg(libraryPath);
 #elif defined(_WIN32)
-  luxLibrary.setFileName(QString("%1/lux.dll").arg(libraryPath));
+  fileName = QString("%1/lux.dll").arg(libraryPath);
 #endif
+  loadLuxLibrary(fileName);
+}
+
+bool LuxLibraryLoader::loadLuxLibrary( const QString& fileName ) {
+  if (isLuxLibraryLoaded) {
+    return true;
+  }
+  luxLibrary.setFileName(fileName);
   luxLibrary.load();
   isLuxLibraryLoaded = luxLibrary.isLoaded();
   if (isLuxLibraryLoaded) {
@@ -35,8 +45,11 @@ void LuxLibraryLoader::initLuxLibrary( const QString& libraryPath ) {
     luxUpdateFramebuffer = (luxUpdateFramebufferFunc) luxLibrary.resolve("luxUpdateFramebuffer");
     luxFramebuffer       = (luxFramebufferFunc)       luxLibrary.resolve("luxFramebuffer");
     luxStatistics        = (luxStatisticsFunc)        luxLibrary.resolve("luxStatistics");
-    RE_LOG_INFO() << "Lux library found: " << getLuxVersion();
+    luxAbort             = (luxAbortFunc)             luxLibrary.resolve("luxAbort");
+    RE_LOG_INFO() << "Lux library found: " 
+                  << (getLuxVersion ? getLuxVersion() : "unknown version");
   }
+  return isLuxLibraryLoaded;
 }
 
 LuxLibraryLoader::LuxLibraryLoader( const QString& luxPath ) : 
@@ -61,6 +74,7 @@ void LuxLibraryLoader::unloadLuxLibrary() {
     luxUpdateFramebuffer = NULL;
     luxFramebuffer       = NULL;
     luxStatistics        = NULL;
+    luxAbort             = NULL;
   }
 }
 
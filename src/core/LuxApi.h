@@ -39,6 +39,9 @@ typedef unsigned char* (*luxFramebufferFunc)();
 // Statistics allow us to know if the render is finished
 typedef double (*luxStatisticsFunc)(const char *statName);
 
+// Stop the rendering in progress, luxParse() returns as soon as possible
+typedef void (*luxAbortFunc)();
+
 // Global variables to be initialized at runtime when the shared library is loaded
 extern luxInitFunc              luxInit;
 extern luxVersionFunc           getLuxVersion;
@@ -48,6 +51,7 @@ extern luxWorldEndFunc          luxWorldEnd;
 extern luxFramebufferFunc       luxFramebuffer;
 extern luxUpdateFramebufferFunc luxUpdateFramebuffer;
 extern luxStatisticsFunc        luxStatistics;
+extern luxAbortFunc             luxAbort;
 
 
 class REALITY_LIB_EXPORT LuxLibraryLoader {
@@ -66,6 +70,12 @@ public:
   static bool isLuxLibraryLoaded;
 
   static void initLuxLibrary( const QString& luxPath );
+  /**
+   * Loads the Lux library from the given file and resolves the functions
+   * of the API. The functions not exported by the library are set to NULL.
+   * Returns true if the library is loaded.
+   */
+  static bool loadLuxLibrary( const QString& fileName );
   static void unloadLuxLibrary();
 };
 
@@ -0,0 +1,191 @@
+/*
+  Reality plug-in
+  Copyright (c) Pret-a-3D/Paolo Ciccone 2012. All rights reserved.
+*/
+
+#include "ReAsyncLogger.h"
+
+#include <cstring>
+#include <QMutexLocker>
+#include <QThread>
+
+
+namespace Reality {
+
+//! Longest time that the writer sleeps before checking the ring again,
+//! in milliseconds. It limits the delay of a wake-up lost to a race.
+#define RE_LOG_WRITER_SLEEP 200
+
+class ReAsyncLogger::WriterThread : public QThread {
+
+private:
+  ReAsyncLogger* logger;
+
+public:
+  WriterThread( ReAsyncLogger* logger ) : logger(logger) {
+  }
+
+  void run() {
+    while( logger->running.load(boost::memory_order_acquire) ) {
+      bool wrote;
+      {
+        QMutexLocker locker(&logger->writeLock);
+        wrote = logger->writePending();
+      }
+      if (wrote) {
+        continue;
+      }
+      QMutexLocker locker(&logger->wakeLock);
+      logger->writerSleeping.store(true);
+      // Check again, a message could have been pushed before the flag
+      // was set
+      quint32 pos = logger->dequeuePos.load(boost::memory_order_relaxed);
+      quint32 seq = logger->slots[pos & logger->mask].sequence.load();
+      if ( seq != pos+1 && logger->running.load() ) {
+        logger->wakeCondition.wait(&logger->wakeLock, RE_LOG_WRITER_SLEEP);
+      }
+      logger->writerSleeping.store(false);
+    }
+    QMutexLocker locker(&logger->writeLock);
+    logger->writePending();
+  }
+};
+
+ReAsyncLogger::ReAsyncLogger( std::ostream& out, const quint32 capacity ) :
+  enqueuePos(0),
+  dequeuePos(0),
+  out(out),
+  writerSleeping(false),
+  running(false),
+  droppedMessages(0),
+  writer(NULL)
+{
+  quint32 size = 2;
+  while( size < capacity ) {
+    size <<= 1;
+  }
+  mask = size-1;
+  slots = new Slot[size];
+  for (quint32 i = 0; i < size; i++) {
+    slots[i].sequence.store(i, boost::memory_order_relaxed);
+  }
+}
+
+ReAsyncLogger::~ReAsyncLogger() {
+  // If stop() has not been called we are being destroyed at the exit of
+  // the process. Joining a thread at this point can deadlock while a DLL
+  // is unloaded on Windows, so the writer and the ring are left alone.
+  if (!writer) {
+    delete[] slots;
+  }
+}
+
+void ReAsyncLogger::start() {
+  if (writer) {
+    return;
+  }
+  running.store(true);
+  writer = new WriterThread(this);
+  writer->start(QThread::LowPriority);
+}
+
+void ReAsyncLogger::stop() {
+  if (!writer) {
+    return;
+  }
+  running.store(false);
+  {
+    QMutexLocker locker(&wakeLock);
+    wakeCondition.wakeOne();
+  }
+  writer->wait();
+  delete writer;
+  writer = NULL;
+  // Messages pushed while the writer was exiting
+  QMutexLocker locker(&writeLock);
+  writePending();
+}
+
+bool ReAsyncLogger::push( const char* text, const quint32 length ) {
+  Slot* slot;
+  quint32 pos = enqueuePos.load(boost::memory_order_relaxed);
+  for (;;) {
+    slot = &slots[pos & mask];
+    quint32 seq = slot->sequence.load(boost::memory_order_acquire);
+    qint32 diff = static_cast<qint32>(seq - pos);
+    if (diff == 0) {
+      if (enqueuePos.compare_exchange_weak(pos, pos+1, boost::memory_order_relaxed)) {
+        break;
+      }
+    }
+    else if (diff < 0) {
+      return false;
+    }
+    else {
+      pos = enqueuePos.load(boost::memory_order_relaxed);
+    }
+  }
+  slot->length = length;
+  memcpy(slot->text, text, length);
+  slot->sequence.store(pos+1, boost::memory_order_seq_cst);
+  return true;
+}
+
+bool ReAsyncLogger::writePending() {
+  bool wrote = false;
+  quint32 dropped = droppedMessages.exchange(0);
+  if (dropped) {
+    out << "!! " << dropped << " log messages dropped\n";
+    wrote = true;
+  }
+  for (;;) {
+    quint32 pos = dequeuePos.load(boost::memory_order_relaxed);
+    Slot* slot = &slots[pos & mask];
+    quint32 seq = slot->sequence.load(boost::memory_order_acquire);
+    if (static_cast<qint32>(seq - (pos+1)) < 0) {
+      break;
+    }
+    out.write(slot->text, slot->length);
+    slot->sequence.store(pos+mask+1, boost::memory_order_release);
+    dequeuePos.store(pos+1, boost::memory_order_relaxed);
+    wrote = true;
+  }
+  if (wrote) {
+    out << std::flush;
+  }
+  return wrote;
+}
+
+void ReAsyncLogger::writeNow( const char* text, const quint32 length ) {
+  QMutexLocker locker(&writeLock);
+  writePending();
+  out.write(text, length);
+  out << std::flush;
+}
+
+bool ReAsyncLogger::sendLogMessage( cpplog::LogData* logData ) {
+  cpplog::helpers::fixed_streambuf* const sb = &logData->streamBuffer;
+  quint32 length = sb->length();
+  // Warnings and errors must not be lost, or delayed, if the host crashes.
+  // Long messages, like the dumps of the scene, don't fit in a slot.
+  if ( !running.load(boost::memory_order_acquire) || 
+       logData->level >= LL_WARN ||
+       length > static_cast<quint32>(MaxMessageLength) )
+  {
+    writeNow(sb->c_str(), length);
+    return true;
+  }
+  if (!push(sb->c_str(), length)) {
+    droppedMessages.fetch_add(1);
+  }
+  // Wake up the writer only if it's waiting, the common case costs one
+  // atomic read
+  if (writerSleeping.load(boost::memory_order_seq_cst)) {
+    QMutexLocker locker(&wakeLock);
+    wakeCondition.wakeOne();
+  }
+  // The text has been copied, cpplog can delete the message
+  return true;
+}
+
+} // namespace
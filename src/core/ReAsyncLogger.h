@@ -0,0 +1,111 @@
+/*
+  Reality plug-in
+  Copyright (c) Pret-a-3D/Paolo Ciccone 2012. All rights reserved.
+*/
+
+#ifndef RE_ASYNC_LOGGER_H
+#define RE_ASYNC_LOGGER_H
+
+#include <boost/atomic.hpp>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include "ReLogger.h"
+
+
+namespace Reality {
+
+/**
+ * Logger that moves the writing of the messages to a background thread.
+ *
+ * The formatted messages are copied into a ring of preallocated slots,
+ * claimed by the producers with a compare-and-swap. The writer thread
+ * drains the ring, writes the messages to the stream and flushes it when
+ * the ring is empty. Logging from a loop then costs the formatting of the
+ * message and a copy, without any file I/O or lock.
+ *
+ * Warnings and errors, and the messages longer than \ref MaxMessageLength,
+ * are written and flushed by the thread that logs them, after the messages
+ * already in the ring, so that they are in the file even if the process
+ * crashes right after. When the ring is full the messages are dropped and
+ * the writer reports how many have been lost.
+ *
+ * Until \ref start() is called, and after \ref stop(), all messages are
+ * written directly to the stream, serialized by a mutex.
+ */
+class REALITY_LIB_EXPORT ReAsyncLogger : public cpplog::BaseLogger {
+
+public:
+  static const int MaxMessageLength = 500;
+
+private:
+  struct Slot {
+    boost::atomic<quint32> sequence;
+    quint32 length;
+    char text[MaxMessageLength];
+  };
+
+  Slot* slots;
+  quint32 mask;
+
+  // The positions are on separate cache lines to avoid false sharing
+  // between the producers and the writer
+  char pad0[64];
+  boost::atomic<quint32> enqueuePos;
+  char pad1[64];
+  boost::atomic<quint32> dequeuePos;
+  char pad2[64];
+
+  std::ostream& out;
+
+  //! Serializes the writes to the stream, it's held by the writer thread
+  //! while it drains the ring
+  QMutex writeLock;
+
+  //! Used by the writer thread to sleep while the ring is empty
+  QMutex wakeLock;
+  QWaitCondition wakeCondition;
+  boost::atomic<bool> writerSleeping;
+
+  boost::atomic<bool> running;
+  boost::atomic<quint32> droppedMessages;
+
+  class WriterThread;
+  friend class WriterThread;
+  WriterThread* writer;
+
+  bool push( const char* text, const quint32 length );
+
+  //! Writes all the messages in the ring. Returns false if the ring
+  //! was empty. Must be called with writeLock held.
+  bool writePending();
+
+  //! Writes a message after the ones in the ring and flushes the stream
+  void writeNow( const char* text, const quint32 length );
+
+  // Not copyable
+  ReAsyncLogger( const ReAsyncLogger& );
+  ReAsyncLogger& operator =( const ReAsyncLogger& );
+
+public:
+  //! The capacity is rounded up to a power of two
+  ReAsyncLogger( std::ostream& out, const quint32 capacity = 4096 );
+  ~ReAsyncLogger();
+
+  //! Starts the writer thread
+  void start();
+
+  //! Writes all the pending messages and stops the writer thread. Must be
+  //! called before the stream is closed.
+  void stop();
+
+  inline bool isRunning() const {
+    return running.load(boost::memory_order_acquire);
+  }
+
+  virtual bool sendLogMessage( cpplog::LogData* logData );
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,179 @@
+/*
+  Reality plug-in
+  Copyright (c) Pret-a-3D/Paolo Ciccone 2012. All rights reserved.
+*/
+
+#include "ReHostCommandQueue.h"
+
+#include <QCoreApplication>
+
+
+namespace Reality {
+
+/*
+ * ReHostCommand
+ */
+ReHostCommand ReHostCommand::renderFrame( const bool runRenderer ) {
+  ReHostCommand cmd(RenderFrame);
+  cmd.runRenderer = runRenderer;
+  return cmd;
+}
+
+ReHostCommand ReHostCommand::renderAnimation( const bool runRenderer,
+                                              const int startFrame,
+                                              const int endFrame )
+{
+  ReHostCommand cmd(RenderAnimation);
+  cmd.runRenderer = runRenderer;
+  cmd.startFrame = startFrame;
+  cmd.endFrame = endFrame;
+  return cmd;
+}
+
+ReHostCommand ReHostCommand::setIBLPreview( const QString& fileName ) {
+  ReHostCommand cmd(SetIBLPreview);
+  cmd.fileName = fileName;
+  return cmd;
+}
+
+ReHostCommand ReHostCommand::selectMaterial( const QString& objectID,
+                                             const QString& materialName )
+{
+  ReHostCommand cmd(SelectMaterial);
+  cmd.objectID = objectID;
+  cmd.materialName = materialName;
+  return cmd;
+}
+
+QStringList ReHostCommand::toTokens() const {
+  QStringList tokens;
+  switch( type ) {
+    case SceneChanged:
+      tokens << "changed";
+      break;
+    case RenderFrame:
+      tokens << "render" << (runRenderer ? "1" : "0");
+      break;
+    case RenderAnimation:
+      tokens << "renderAnim" 
+             << (runRenderer ? "1" : "0")
+             << QString::number(startFrame)
+             << QString::number(endFrame);
+      break;
+    case SetIBLPreview:
+      // sip => Set IBL Preview
+      tokens << "sip" << fileName;
+      break;
+    case SaveScene:
+      tokens << "save";
+      break;
+    case RefreshScene:
+      tokens << "refresh";
+      break;
+    case SelectMaterial:
+      // smha => Select material in host app
+      tokens << "smha" << objectID << materialName;
+      break;
+  }
+  return tokens;
+}
+
+/*
+ * ReHostCommandQueue
+ */
+int ReHostCommandQueue::eventType = QEvent::registerEventType();
+
+ReHostCommandQueue::ReHostCommandQueue( const quint32 capacity ) :
+  enqueuePos(0),
+  dequeuePos(0),
+  notificationPending(false),
+  receiver(NULL)
+{
+  quint32 size = 2;
+  while( size < capacity ) {
+    size <<= 1;
+  }
+  mask = size-1;
+  slots = new Slot[size];
+  for (quint32 i = 0; i < size; i++) {
+    slots[i].sequence.store(i, boost::memory_order_relaxed);
+  }
+}
+
+ReHostCommandQueue::~ReHostCommandQueue() {
+  delete[] slots;
+}
+
+bool ReHostCommandQueue::push( const ReHostCommand& cmd ) {
+  Slot* slot;
+  quint32 pos = enqueuePos.load(boost::memory_order_relaxed);
+  for (;;) {
+    slot = &slots[pos & mask];
+    quint32 seq = slot->sequence.load(boost::memory_order_acquire);
+    qint32 diff = static_cast<qint32>(seq - pos);
+    // The slot is free, try to claim it
+    if (diff == 0) {
+      if (enqueuePos.compare_exchange_weak(pos, pos+1, boost::memory_order_relaxed)) {
+        break;
+      }
+    }
+    // The slot still holds a command from the previous lap: the queue is full
+    else if (diff < 0) {
+      return false;
+    }
+    // Another producer claimed the slot
+    else {
+      pos = enqueuePos.load(boost::memory_order_relaxed);
+    }
+  }
+  slot->command = cmd;
+  slot->sequence.store(pos+1, boost::memory_order_release);
+
+  QObject* target = receiver.load(boost::memory_order_acquire);
+  if (target && !notificationPending.exchange(true, boost::memory_order_acq_rel)) {
+    QCoreApplication::postEvent(target, new QEvent(QEvent::Type(eventType)));
+  }
+  return true;
+}
+
+bool ReHostCommandQueue::pop( ReHostCommand& cmd ) {
+  quint32 pos = dequeuePos.load(boost::memory_order_relaxed);
+  Slot* slot = &slots[pos & mask];
+  quint32 seq = slot->sequence.load(boost::memory_order_acquire);
+  if (static_cast<qint32>(seq - (pos+1)) < 0) {
+    return false;
+  }
+  cmd = slot->command;
+  // Release the strings now instead of when the slot is reused
+  slot->command = ReHostCommand();
+  slot->sequence.store(pos+mask+1, boost::memory_order_release);
+  dequeuePos.store(pos+1, boost::memory_order_relaxed);
+  return true;
+}
+
+int ReHostCommandQueue::count() const {
+  return static_cast<qint32>(
+           enqueuePos.load(boost::memory_order_acquire) - 
+           dequeuePos.load(boost::memory_order_acquire)
+         );
+}
+
+void ReHostCommandQueue::setReceiver( QObject* newReceiver ) {
+  receiver.store(newReceiver, boost::memory_order_release);
+  notificationPending.store(false);
+  // Commands might have been queued before the receiver was available
+  if (newReceiver && count() > 0) {
+    notificationPending.store(true);
+    QCoreApplication::postEvent(newReceiver, new QEvent(QEvent::Type(eventType)));
+  }
+}
+
+void ReHostCommandQueue::acknowledgeEvent() {
+  notificationPending.store(false, boost::memory_order_release);
+}
+
+int ReHostCommandQueue::getEventType() {
+  return eventType;
+}
+
+} // namespace
@@ -0,0 +1,149 @@
+/*
+  Reality plug-in
+  Copyright (c) Pret-a-3D/Paolo Ciccone 2012. All rights reserved.
+*/
+
+#ifndef RE_HOST_COMMAND_QUEUE_H
+#define RE_HOST_COMMAND_QUEUE_H
+
+#include <boost/atomic.hpp>
+#include <QEvent>
+#include <QStringList>
+
+#include "reality_lib_export.h"
+
+
+namespace Reality {
+
+/**
+ * A command sent to the host-side portion of Reality, the Poser Python
+ * code or the Studio plugin. Commands are generated by the IPC thread,
+ * on request from the GUI, and by the scene data. They are executed by
+ * the main thread of the host, which is the only one allowed to call the
+ * host API.
+ */
+struct REALITY_LIB_EXPORT ReHostCommand {
+  enum CommandType {
+    //! The scene has been modified by the GUI
+    SceneChanged,
+    RenderFrame,
+    RenderAnimation,
+    //! Set the map used for the IBL preview sphere
+    SetIBLPreview,
+    SaveScene,
+    RefreshScene,
+    //! Select a material in the host app
+    SelectMaterial
+  };
+
+  CommandType type;
+  bool runRenderer;
+  int startFrame;
+  int endFrame;
+  QString objectID;
+  QString materialName;
+  QString fileName;
+
+  ReHostCommand( const CommandType type = SceneChanged ) :
+    type(type),
+    runRenderer(false),
+    startFrame(0),
+    endFrame(0)
+  {
+  }
+
+  static ReHostCommand renderFrame( const bool runRenderer );
+  static ReHostCommand renderAnimation( const bool runRenderer,
+                                        const int startFrame,
+                                        const int endFrame );
+  static ReHostCommand setIBLPreview( const QString& fileName );
+  static ReHostCommand selectMaterial( const QString& objectID,
+                                       const QString& materialName );
+
+  //! Returns the command in the format used by the original command stack:
+  //! the name of the command followed by its parameters. This is the format
+  //! expected by the Python code in Poser.
+  QStringList toTokens() const;
+};
+
+/**
+ * Bounded, lock-free, multiple-producer/single-consumer queue of
+ * \ref ReHostCommand.
+ *
+ * Any thread can push commands. Only one thread, the main thread of the
+ * host, can pop them. When a receiver is set, the first push into an idle
+ * queue posts an event of type \ref getEventType() to the receiver, so that
+ * the commands are executed as soon as the host's event loop runs instead
+ * of waiting for the next poll. The receiver must call
+ * \ref acknowledgeEvent() before draining the queue.
+ *
+ * The queue is a ring of slots, each with a sequence number that tells
+ * producers and the consumer whether the slot is free or filled. Producers
+ * claim a slot with a compare-and-swap on the enqueue position.
+ */
+class REALITY_LIB_EXPORT ReHostCommandQueue {
+
+private:
+  struct Slot {
+    boost::atomic<quint32> sequence;
+    ReHostCommand command;
+  };
+
+  Slot* slots;
+  quint32 mask;
+
+  // The positions are on separate cache lines to avoid false sharing
+  // between the producers and the consumer
+  char pad0[64];
+  boost::atomic<quint32> enqueuePos;
+  char pad1[64];
+  boost::atomic<quint32> dequeuePos;
+  char pad2[64];
+
+  //! True when an event has been posted and not yet acknowledged
+  boost::atomic<bool> notificationPending;
+  boost::atomic<QObject*> receiver;
+
+  static int eventType;
+
+  // Not copyable
+  ReHostCommandQueue( const ReHostCommandQueue& );
+  ReHostCommandQueue& operator =( const ReHostCommandQueue& );
+
+public:
+  //! The capacity is rounded up to a power of two
+  ReHostCommandQueue( const quint32 capacity = 1024 );
+  ~ReHostCommandQueue();
+
+  //! Adds a command to the queue. Returns false if the queue is full.
+  bool push( const ReHostCommand& cmd );
+
+  //! Removes the oldest command from the queue. Returns false if the queue
+  //! is empty. Must be called only by the consumer thread.
+  bool pop( ReHostCommand& cmd );
+
+  //! Number of commands in the queue. The value is exact only when called
+  //! by the consumer with no producers running.
+  int count() const;
+
+  inline quint32 capacity() const {
+    return mask+1;
+  }
+
+  //! Sets the object that is notified when new commands are available.
+  //! The object must live in the consumer thread and it must be removed,
+  //! by passing NULL, before it's deleted.
+  void setReceiver( QObject* newReceiver );
+
+  //! Called by the receiver when it gets the notification event, before
+  //! draining the queue. Commands pushed after this call will post a new
+  //! event.
+  void acknowledgeEvent();
+
+  //! The type of the QEvent posted to the receiver
+  static int getEventType();
+};
+
+} // namespace
+
+#endif
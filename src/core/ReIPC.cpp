@@ -31,7 +31,7 @@ CommandPollingThread* realityIPC;
 
 void CommandPollingThread::setSceneAsDirty() {
   RealityBase* rb = RealityBase::getRealityBase();
-  rb->commandStackPush("changed");
+  rb->pushCommand(ReHostCommand(ReHostCommand::SceneChanged));
   RealitySceneData->setNeedsSaving(true);
 }
 
@@ -425,6 +425,34 @@ void CommandPollingThread::processRequest(zmq::message_t& request, zmq::socket_t
         
         break;
       }
+      case UI_MATERIAL_EDITED_BATCH: {
+        quint32 numEdits;
+        commandStream >> numEdits;
+        // The whole batch is decoded before applying it so that a 
+        // malformed message doesn't leave the materials half updated
+        QList<MaterialEdit> edits;
+        for (quint32 i = 0; i < numEdits; i++) {
+          MaterialEdit edit;
+          commandStream >> edit.objectID >> edit.materialName
+                        >> edit.textureName >> edit.propertyName 
+                        >> edit.value;
+          edits.append(edit);
+        }
+        if (commandStream.status() != QDataStream::Ok) {
+          RE_LOG_WARN() << "Malformed batch of material edits, ignored";
+          sendReplyToGUI(socket, cmd, "ERROR");
+          break;
+        }
+        foreach( const MaterialEdit& edit, edits ) {
+          uiMaterialEdited(edit.objectID, edit.materialName, 
+                           edit.propertyName, edit.value, edit.textureName);
+        }
+        sendReplyToGUI(socket, cmd, "OK");
+        // One notification for the whole batch
+        setSceneAsDirty();
+
+        break;
+      }
       case MAKE_NEW_TEXTURE: {
         QString objectID, 
                 materialID, 
@@ -663,8 +691,7 @@ void CommandPollingThread::processRequest(zmq::message_t& request, zmq::socket_t
         bool runRenderer;
         commandStream >> runRenderer;
         RealityBase* rb = RealityBase::getRealityBase();
-        rb->commandStackPush(runRenderer ? "1" : "0");
-        rb->commandStackPush("render");
+        rb->pushCommand(ReHostCommand::renderFrame(runRenderer));
         sendReplyToGUI(socket, cmd, "OK");
         
         break;
@@ -674,24 +701,23 @@ void CommandPollingThread::processRequest(zmq::message_t& request, zmq::socket_t
         int startFrame, endFrame;
         commandStream >> runRenderer >> startFrame >> endFrame;
         RealityBase* rb = RealityBase::getRealityBase();
-        rb->commandStackPush(QString::number(endFrame));
-        rb->commandStackPush(QString::number(startFrame));
-        rb->commandStackPush(runRenderer ? "1" : "0");
-        rb->commandStackPush("renderAnim");
+        rb->pushCommand(
+          ReHostCommand::renderAnimation(runRenderer, startFrame, endFrame)
+        );
         sendReplyToGUI(socket, cmd, "OK");
         
         break;
       }
       case SAVE_SCENE: {
         RealityBase* rb = RealityBase::getRealityBase();
-        rb->commandStackPush("save");
+        rb->pushCommand(ReHostCommand(ReHostCommand::SaveScene));
         sendReplyToGUI(socket, cmd, "OK");
         
         break;
       }
       case REFRESH_SCENE: {
         RealityBase* rb = RealityBase::getRealityBase();
-        rb->commandStackPush("refresh");
+        rb->pushCommand(ReHostCommand(ReHostCommand::RefreshScene));
         sendReplyToGUI(socket, cmd, "OK");
         
         break;
@@ -703,6 +729,14 @@ void CommandPollingThread::processRequest(zmq::message_t& request, zmq::socket_t
         doWrite = true;
         break;
       }
+      case CANCEL_EXPORT: {
+        // The export runs in the host's thread, it checks the request
+        // after each object
+        RealitySceneData->renderSceneRequestCancel();
+        sendReplyToGUI(socket, cmd, "OK");
+
+        break;
+      }
       case PING: {
         time(&lastGUIPing);
         sendReplyToGUI(socket, cmd, "OK");
@@ -714,12 +748,9 @@ void CommandPollingThread::processRequest(zmq::message_t& request, zmq::socket_t
 
         QString objectName, materialName;
         commandStream >> objectName >> materialName;
-        // Send the command via the command stack
+        // Send the command via the command queue
         RealityBase* rb = RealityBase::getRealityBase();
-        rb->commandStackPush(materialName);
-        rb->commandStackPush(objectName);
-        // "smha" => select material in host app
-        rb->commandStackPush("smha");
+        rb->pushCommand(ReHostCommand::selectMaterial(objectName, materialName));
 
         sendReplyToGUI(socket, cmd, "OK");
         break;
@@ -1010,6 +1041,16 @@ void CommandPollingThread::exportingObject( const QString objectName ) {
   transmit(buffer);
 };
 
+void CommandPollingThread::exportProgress( const ReExportProgress& progress ) {
+  if (!guiAppIsRunning) {
+    return;
+  }
+  QByteArray buffer;
+  QDataStream stream(&buffer,QIODevice::WriteOnly);
+  stream << (quint16) EXP_EXPORT_PROGRESS << progress;
+  transmit(buffer);
+};
+
 void CommandPollingThread::exportFinished() {
   if (!guiAppIsRunning) {
     return;
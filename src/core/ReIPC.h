@@ -19,6 +19,7 @@
 #include <zmq.hpp>
 
 #include "reality_lib_export.h"
+#include "ReExportSession.h"
 #include "ReSharedMemIPC.h"
 #include "importers/qt/ReQtMaterialImporter.h"
 
@@ -105,6 +106,15 @@ private:
                          const QString& propertyName,
                          const QVariant& value,
                          const QString& textureName ) const;
+
+  //! One of the edits received with the UI_MATERIAL_EDITED_BATCH message
+  struct MaterialEdit {
+    QString objectID;
+    QString materialName;
+    QString textureName;
+    QString propertyName;
+    QVariant value;
+  };
   void updateMatFromClipboardData( const QString& objectID, 
                                    const QString& materialID, 
                                    const QString& clipboardData,
@@ -261,6 +271,9 @@ public:
     //! Signal that the exporter is processing object objectName
     void exportingObject( const QString objectName );
 
+    //! Sends the counters of the data exported so far
+    void exportProgress( const ReExportProgress& progress );
+
     //! Signals that the export has finished.
     void exportFinished();
 
@@ -205,7 +205,20 @@ enum IPC_MESSAGES {
   //! Replace a texture with data in JSON format, usually from a copy/paste operation
   REPLACE_TEXTURE,
 
-  UPDATE_ANIMATION_LIMITS
+  UPDATE_ANIMATION_LIMITS,
+
+  //! Message sent by the UI with a batch of material and texture edits.
+  //! It replaces a series of UI_MATERIAL_EDITED messages and it's applied
+  //! by the host as a single change of the scene.
+  UI_MATERIAL_EDITED_BATCH,
+
+  //! Sent by the exporter to the GUI after each object with the counters
+  //! of the data exported so far. See ReExportProgress
+  EXP_EXPORT_PROGRESS,
+
+  //! Sent by the GUI to stop the export. The host stops after the object
+  //! being exported and the next export resumes from that point.
+  CANCEL_EXPORT
 
 };
 
@@ -1,15 +1,43 @@
 /*
   Reality plug-in
-  Copyright (c) Pret-a-3D/Paolo Ciccone 2012. All rights reserved.    
+  Copyright (c) Pret-a-3D/Paolo Ciccone 2012. All rights reserved.
 */
 
 #include "ReLogger.h"
 
 #include <fstream>
 
+#include "ReAsyncLogger.h"
+
 
 //! The log file that we use to keep track of important message from the library
 std::ofstream logFile;
-cpplog::OstreamLogger RealityLogger(logFile);
+static Reality::ReAsyncLogger asyncLogger(logFile);
+cpplog::BaseLogger& RealityLogger = asyncLogger;
 
 QString CustomLogMessage::prefix = "";
+
+void RE_createLogger( QString prefix ) {
+  QString documentsDir = QDesktopServices::storageLocation(QDesktopServices::DocumentsLocation);
+  QString logFileName = QString("%1/Reality_plugin_Log.txt").arg(documentsDir);
+  QFile logFileHandler(logFileName);
+  if (logFileHandler.size() > RE_LOG_FILE_MAX_SIZE) {
+    logFileHandler.remove();
+  }
+  logFile.open(logFileName.toUtf8(), std::ios::app);
+  if (!prefix.isEmpty()) {
+    CustomLogMessage::setPrefix(prefix);
+  }
+  asyncLogger.start();
+}
+
+void RE_stopLogger() {
+  asyncLogger.stop();
+}
+
+void RE_closeLogger() {
+  asyncLogger.stop();
+  if ( logFile.is_open() ) {
+    logFile.close();
+  }
+}
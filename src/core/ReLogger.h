@@ -18,12 +18,19 @@
 // This define must be before including "cpplog.hpp"
 // it implements a custom format for the log. See the class definition below
 #define LOG_LEVEL(level, logger) CustomLogMessage(__FILE__, "", __LINE__, (level), logger).getStream()
+// Messages with a level lower than CPPLOG_FILTER_LEVEL are removed by the
+// compiler, together with the expressions that format them. The level is 
+// set by the REALITY_LOG_LEVEL CMake option, cpplog uses LL_DEBUG if it's
+// not defined.
 #include "logging/cpplog.hpp"
 
 
 //! File-based stream for persistence of the log
 extern std::ofstream logFile;
-REALITY_LIB_EXPORT extern cpplog::OstreamLogger RealityLogger;
+//! The logger used by the RE_LOG macros. Once the log is created by 
+//! RE_createLogger() the messages are written by a background thread,
+//! see Reality::ReAsyncLogger
+REALITY_LIB_EXPORT extern cpplog::BaseLogger& RealityLogger;
 
 // Shortcut macros to help us with the log
 #define RE_LOG_INFO()  LOG_INFO(RealityLogger)
@@ -85,23 +92,16 @@ protected:
   }
 };
 
-inline void RE_createLogger( QString prefix = "" ) {
-  QString documentsDir = QDesktopServices::storageLocation(QDesktopServices::DocumentsLocation);
-  QString logFileName = QString("%1/Reality_plugin_Log.txt").arg(documentsDir);
-  QFile logFileHandler(logFileName);
-  if (logFileHandler.size() > RE_LOG_FILE_MAX_SIZE) {
-    logFileHandler.remove();
-  }
-  logFile.open(logFileName.toUtf8(), std::ios::app);
-  if (!prefix.isEmpty()) {
-    CustomLogMessage::setPrefix(prefix);
-  }
-}
+//! Opens the log file and starts the background writer
+REALITY_LIB_EXPORT void RE_createLogger( QString prefix = "" );
 
-inline void RE_closeLogger() {
-  if ( logFile.is_open() ) {
-    logFile.close();
-  }
-}
+//! Writes the pending messages and stops the background writer. The log
+//! file stays open and the following messages are written directly to it.
+//! Must be called when the plugin is unloaded and when the GUI exits, the
+//! writer can't be stopped safely at the exit of the process.
+REALITY_LIB_EXPORT void RE_stopLogger();
+
+//! Writes the pending messages and closes the log file
+REALITY_LIB_EXPORT void RE_closeLogger();
 
 #endif
@@ -0,0 +1,121 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#include "ReLuxLibraryRenderer.h"
+
+#include <string.h>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+
+#include "LuxApi.h"
+#include "ReLogger.h"
+
+
+namespace Reality {
+
+//! Interval, in milliseconds, at which luxAbort() is repeated while
+//! waiting for the render thread to end. Lux ignores the requests
+//! received before the scene is ready.
+#define RE_LUX_ABORT_INTERVAL 20
+
+ReLuxLibraryRenderer::ReLuxLibraryRenderer() :
+  parseResult(-1),
+  sceneLoaded(false)
+{
+  sceneFileName = QDir::temp().absoluteFilePath(
+                    QString("RealityPreview_%1_%2.lxs")
+                      .arg(QCoreApplication::applicationPid())
+                      .arg(reinterpret_cast<quintptr>(this), 0, 16)
+                  );
+}
+
+ReLuxLibraryRenderer::~ReLuxLibraryRenderer() {
+  abort();
+  QFile::remove(sceneFileName);
+}
+
+bool ReLuxLibraryRenderer::isAvailable() {
+  return LuxLibraryLoader::isLuxLibraryLoaded &&
+         luxInit && luxCleanup && luxParse && luxAbort && luxStatistics &&
+         luxUpdateFramebuffer && luxFramebuffer;
+}
+
+void ReLuxLibraryRenderer::run() {
+  luxInit();
+  parseResult = luxParse(QFile::encodeName(sceneFileName).constData());
+}
+
+bool ReLuxLibraryRenderer::start( const QByteArray& scene ) {
+  abort();
+  QFile sceneFile(sceneFileName);
+  if ( !sceneFile.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+       sceneFile.write(scene) != scene.size() )
+  {
+    RE_LOG_WARN() << "Cannot write the preview scene to " << QSS(sceneFileName);
+    return false;
+  }
+  sceneFile.close();
+  parseResult = -1;
+  sceneLoaded = true;
+  QThread::start();
+  return true;
+}
+
+bool ReLuxLibraryRenderer::isDone() const {
+  if (!sceneLoaded || isFinished()) {
+    return true;
+  }
+  return luxStatistics("sceneIsReady") > 0 && luxStatistics("enoughSamples") > 0;
+}
+
+double ReLuxLibraryRenderer::getSamplesPerPixel() const {
+  if (!sceneLoaded || luxStatistics("sceneIsReady") <= 0) {
+    return 0.0;
+  }
+  return luxStatistics("samplesPx");
+}
+
+bool ReLuxLibraryRenderer::getFrameBuffer( QByteArray& frameBuffer, const int numBytes ) {
+  frameBuffer.clear();
+  if (!sceneLoaded) {
+    return false;
+  }
+  // The render thread can still be running, Lux keeps the film until
+  // the scene is released
+  bool rendered = (!isFinished() || parseResult == 0) &&
+                  luxStatistics("sceneIsReady") > 0;
+  if (rendered) {
+    int width  = static_cast<int>(luxStatistics("filmXres"));
+    int height = static_cast<int>(luxStatistics("filmYres"));
+    rendered = width * height * 3 == numBytes;
+  }
+  if (rendered) {
+    luxUpdateFramebuffer();
+    const unsigned char* pixels = luxFramebuffer();
+    rendered = pixels != NULL;
+    if (rendered) {
+      frameBuffer.resize(numBytes);
+      memcpy(frameBuffer.data(), pixels, numBytes);
+    }
+  }
+  abort();
+  return rendered;
+}
+
+void ReLuxLibraryRenderer::abort() {
+  if (!sceneLoaded) {
+    return;
+  }
+  while (!wait(RE_LUX_ABORT_INTERVAL)) {
+    luxAbort();
+  }
+  luxCleanup();
+  sceneLoaded = false;
+}
+
+} // namespace
@@ -0,0 +1,86 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#ifndef RE_LUX_LIBRARY_RENDERER_H
+#define RE_LUX_LIBRARY_RENDERER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QThread>
+
+#include "reality_lib_export.h"
+
+
+namespace Reality {
+
+/**
+ * Renders a Lux scene inside the Reality process, with the Lux library
+ * loaded by LuxLibraryLoader, instead of running luxconsole.
+ *
+ * luxParse() reads the scene from a file and returns only when the
+ * rendering is complete, so it runs in a thread of its own. The caller
+ * starts the rendering with start(), polls isDone() and then reads the
+ * image with getFrameBuffer(). A rendering can be stopped at any time
+ * with abort().
+ *
+ * Lux keeps the scene in global variables, so only one instance of this
+ * class can render at any time.
+ */
+class REALITY_LIB_EXPORT ReLuxLibraryRenderer : public QThread {
+
+private:
+  //! The file used to pass the scene to Lux
+  QString sceneFileName;
+
+  //! Result of luxParse(), 0 if the scene has been rendered
+  int parseResult;
+
+  //! True from start() until luxCleanup() is called for the scene
+  bool sceneLoaded;
+
+protected:
+  //! The render thread, it runs luxParse() on the scene file
+  void run();
+
+public:
+  ReLuxLibraryRenderer();
+
+  ~ReLuxLibraryRenderer();
+
+  //! Returns true if the Lux library is loaded and it provides all the
+  //! functions used by this class
+  static bool isAvailable();
+
+  /**
+   * Starts the rendering of a scene. The scene must set a halt condition
+   * and it must not write any output.
+   * \return false if the scene could not be passed to Lux
+   */
+  bool start( const QByteArray& scene );
+
+  //! Returns true when the rendering started by start() has ended
+  bool isDone() const;
+
+  //! Returns the number of samples per pixel rendered so far
+  double getSamplesPerPixel() const;
+
+  /**
+   * Copies the image to frameBuffer, as RGB bytes like the --bindump 
+   * output of luxconsole, and releases the scene. To be called once 
+   * isDone() returns true.
+   * \param numBytes The size of the image, 3 bytes per pixel
+   * \return false if the scene has not been rendered or if the image
+   *         has a different size
+   */
+  bool getFrameBuffer( QByteArray& frameBuffer, const int numBytes );
+
+  //! Stops the rendering in progress, if any, and releases the scene
+  void abort();
+};
+
+} // namespace
+
+#endif
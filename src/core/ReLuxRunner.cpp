@@ -355,6 +355,18 @@ QString ReLuxRunner::getLuxConsoleProgramName() {
   return "";
 }
 
+QString ReLuxRunner::getLuxLibraryName() {
+  QString luxProgramDir = QFileInfo(
+                            RealityBase::getRealityBase()->getRendererPath(LuxRender)
+                          ).absolutePath();
+  #if defined(__APPLE__)
+    return QString("%1/liblux.dylib").arg(luxProgramDir);
+  #elif defined(_WIN32)
+    return QString("%1/lux.dll").arg(luxProgramDir);
+  #endif
+  return "";
+}
+
 
 /**
  * Returns the name of the SLG  executable 
@@ -91,7 +91,12 @@ public:
   };
 
   inline void writeToStdin( const QString& input ) {
-    luxProc.write(input.toUtf8());
+    writeToStdin(input.toUtf8());
+  }
+
+  //! Writes text already encoded in UTF-8, with a single write
+  inline void writeToStdin( const QByteArray& input ) {
+    luxProc.write(input);
     luxProc.closeWriteChannel();
   }
 
@@ -99,6 +104,12 @@ public:
     luxProc.waitForFinished();
   }
 
+  //! Waits until new output is available, or until msecs have passed.
+  //! Returns false on timeout or if the process has finished.
+  inline bool waitForReadyRead( const int msecs ) {
+    return luxProc.waitForReadyRead(msecs);
+  }
+
   inline QByteArray& readAllStandardOutput() {
     procOutput = luxProc.readAllStandardOutput();
     return procOutput;
@@ -127,6 +138,12 @@ public:
    * as used by the current OS.
    */
   QString getLuxConsoleProgramName();
+
+  /**
+   * Returns the absolute path of the Lux shared library, installed next 
+   * to the Lux console executable, as used by the current OS.
+   */
+  static QString getLuxLibraryName();
  
   /**
    * Called when the SLG process has data in stdout that is ready to be read
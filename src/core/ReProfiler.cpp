@@ -0,0 +1,168 @@
+/*
+  Reality plug-in
+  Copyright (c) Pret-a-3D/Paolo Ciccone 2012. All rights reserved.
+*/
+
+#include "ReProfiler.h"
+
+#include <QFile>
+#include <QMutexLocker>
+#include <QThreadStorage>
+#include <QJson/Serializer>
+
+
+namespace Reality {
+
+boost::atomic<bool> ReProfiler::enabled(false);
+QElapsedTimer ReProfiler::clock;
+QMutex ReProfiler::buffersLock;
+QList<ReProfiler::ThreadBuffer*> ReProfiler::buffers;
+
+// The buffers are owned by the profiler, the thread storage only keeps a
+// reference. In this way the data survives the threads that recorded it.
+struct ThreadBufferRef {
+  ReProfiler::ThreadBuffer* buffer;
+  int generation;
+
+  ThreadBufferRef() : buffer(NULL), generation(-1) {
+  }
+};
+
+static QThreadStorage<ThreadBufferRef> threadBuffers;
+//! Incremented at each session, it invalidates the references held by
+//! the threads to the buffers of the previous session
+static int sessionGeneration = 0;
+
+ReProfiler::ThreadBuffer* ReProfiler::getThreadBuffer() {
+  ThreadBufferRef& ref = threadBuffers.localData();
+  if (ref.buffer && ref.generation == sessionGeneration) {
+    return ref.buffer;
+  }
+  QMutexLocker locker(&buffersLock);
+  ref.buffer = new ThreadBuffer();
+  ref.buffer->threadNo = buffers.count();
+  ref.buffer->events.reserve(1024);
+  ref.generation = sessionGeneration;
+  buffers.append(ref.buffer);
+  return ref.buffer;
+}
+
+void ReProfiler::clear() {
+  QMutexLocker locker(&buffersLock);
+  qDeleteAll(buffers);
+  buffers.clear();
+  sessionGeneration++;
+}
+
+void ReProfiler::beginSession() {
+  clear();
+  clock.start();
+  // The clock is published with the flag
+  enabled.store(true, boost::memory_order_release);
+}
+
+void ReProfiler::addEvent( const char* name, const qint64 start, const qint64 end ) {
+  Event ev;
+  ev.name = name;
+  ev.start = start;
+  ev.duration = end - start;
+  getThreadBuffer()->events.append(ev);
+}
+
+void ReProfiler::addCounter( const char* name, const qint64 value ) {
+  getThreadBuffer()->counters[name] += value;
+}
+
+QVariantMap ReProfiler::endSession() {
+  enabled.store(false, boost::memory_order_release);
+  qint64 sessionTime = clock.isValid() ? clock.nsecsElapsed() : 0;
+
+  // Counters and phases are merged by name, the same literal can have a
+  // different address in each module
+  QHash<QString, qint64> phaseCalls;
+  QHash<QString, qint64> phaseTotals;
+  QHash<QString, qint64> phaseMax;
+  QHash<QString, qint64> counters;
+
+  QMutexLocker locker(&buffersLock);
+  foreach(ThreadBuffer* buffer, buffers) {
+    foreach(const Event& ev, buffer->events) {
+      QString name = ev.name;
+      phaseCalls[name]++;
+      phaseTotals[name] += ev.duration;
+      if (ev.duration > phaseMax.value(name)) {
+        phaseMax[name] = ev.duration;
+      }
+    }
+    QHashIterator<const char*, qint64> ci(buffer->counters);
+    while( ci.hasNext() ) {
+      ci.next();
+      counters[ci.key()] += ci.value();
+    }
+  }
+
+  QVariantMap phases;
+  QHashIterator<QString, qint64> pi(phaseTotals);
+  while( pi.hasNext() ) {
+    pi.next();
+    QVariantMap phase;
+    phase["calls"]   = phaseCalls.value(pi.key());
+    phase["totalMs"] = pi.value() / 1000000.0;
+    phase["maxMs"]   = phaseMax.value(pi.key()) / 1000000.0;
+    phases[pi.key()] = phase;
+  }
+  QVariantMap counterMap;
+  QHashIterator<QString, qint64> ci(counters);
+  while( ci.hasNext() ) {
+    ci.next();
+    counterMap[ci.key()] = ci.value();
+  }
+
+  QVariantMap report;
+  report["totalMs"]    = sessionTime / 1000000.0;
+  report["numThreads"] = buffers.count();
+  report["phases"]     = phases;
+  report["counters"]   = counterMap;
+  return report;
+}
+
+bool ReProfiler::writeReport( const QString& fileName, const QVariantMap& report ) {
+  QFile reportFile(fileName);
+  if (!reportFile.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  QJson::Serializer json;
+  json.setIndentMode(QJson::IndentFull);
+  return reportFile.write(json.serialize(report)) != -1;
+}
+
+bool ReProfiler::writeTrace( const QString& fileName ) {
+  QFile traceFile(fileName);
+  if (!traceFile.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  // The trace can have hundreds of thousands of events, it's faster to
+  // write it directly than to build a QVariantList for the serializer
+  traceFile.write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  bool first = true;
+  QMutexLocker locker(&buffersLock);
+  foreach(ThreadBuffer* buffer, buffers) {
+    foreach(const Event& ev, buffer->events) {
+      traceFile.write(
+        QString("%1{\"name\":\"%2\",\"ph\":\"X\",\"pid\":1,\"tid\":%3,"
+                "\"ts\":%4,\"dur\":%5}\n")
+          .arg(first ? "" : ",")
+          .arg(ev.name)
+          .arg(buffer->threadNo)
+          .arg(ev.start / 1000.0, 0, 'f', 3)
+          .arg(ev.duration / 1000.0, 0, 'f', 3)
+          .toUtf8()
+      );
+      first = false;
+    }
+  }
+  traceFile.write("]}\n");
+  return true;
+}
+
+} // namespace
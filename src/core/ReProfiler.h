@@ -0,0 +1,138 @@
+/*
+  Reality plug-in
+  Copyright (c) Pret-a-3D/Paolo Ciccone 2012. All rights reserved.
+*/
+
+#ifndef RE_PROFILER_H
+#define RE_PROFILER_H
+
+//! Profiling facility for the export pipeline
+
+#include <boost/atomic.hpp>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QVariantMap>
+#include <QVector>
+
+#include "reality_lib_export.h"
+
+
+namespace Reality {
+
+/**
+ * Collects timings and counters for the export of a scene.
+ *
+ * Profiling is organized in sessions, normally one per export. Code is
+ * instrumented with the \ref RE_PROFILE_SCOPE and \ref RE_PROFILE_COUNT
+ * macros. When no session is active the cost of an instrumentation point
+ * is the test of an atomic flag, read by the worker threads while the
+ * export thread starts and ends the sessions.
+ *
+ * Each thread records its data in its own buffer so that the threads don't
+ * need to synchronize while the export is running. The buffers are merged
+ * by \ref endSession(), which must be called when the export is complete
+ * and the worker threads are idle.
+ */
+class REALITY_LIB_EXPORT ReProfiler {
+
+public:
+  //! A timed section of code. The times are in nanoseconds from the
+  //! start of the session.
+  struct Event {
+    const char* name;
+    qint64 start;
+    qint64 duration;
+  };
+
+  //! Data recorded by one thread
+  struct ThreadBuffer {
+    int threadNo;
+    QVector<Event> events;
+    QHash<const char*, qint64> counters;
+  };
+
+private:
+  static boost::atomic<bool> enabled;
+  static QElapsedTimer clock;
+  static QMutex buffersLock;
+  static QList<ThreadBuffer*> buffers;
+
+  //! Returns the buffer for the calling thread, creating it if needed
+  static ThreadBuffer* getThreadBuffer();
+
+  //! Discards all the data collected
+  static void clear();
+
+public:
+  static inline bool isEnabled() {
+    return enabled.load(boost::memory_order_acquire);
+  }
+
+  //! Starts a new profiling session. Data from a previous session is
+  //! discarded.
+  static void beginSession();
+
+  //! Ends the session and returns the report. The report lists, for each
+  //! phase, the number of calls, the total time and the longest call, in
+  //! milliseconds. Counters are summed across threads.
+  static QVariantMap endSession();
+
+  //! Current time, in nanoseconds from the start of the session
+  static inline qint64 now() {
+    return clock.nsecsElapsed();
+  }
+
+  static void addEvent( const char* name, const qint64 start, const qint64 end );
+  static void addCounter( const char* name, const qint64 value );
+
+  //! Writes the report returned by endSession() as a JSON file
+  static bool writeReport( const QString& fileName, const QVariantMap& report );
+
+  //! Writes the events of the last session in the Chrome trace-event
+  //! format. The file can be loaded in chrome://tracing
+  static bool writeTrace( const QString& fileName );
+};
+
+/**
+ * Times the scope in which it's declared. Use it via the
+ * \ref RE_PROFILE_SCOPE macro.
+ */
+class ReScopedTimer {
+private:
+  const char* name;
+  qint64 start;
+
+public:
+  inline ReScopedTimer( const char* name ) : name(name), start(-1) {
+    if (ReProfiler::isEnabled()) {
+      start = ReProfiler::now();
+    }
+  }
+
+  inline ~ReScopedTimer() {
+    if (start >= 0 && ReProfiler::isEnabled()) {
+      ReProfiler::addEvent(name, start, ReProfiler::now());
+    }
+  }
+};
+
+} // namespace
+
+#define RE_PROFILE_CONCAT2(a, b) a##b
+#define RE_PROFILE_CONCAT(a, b) RE_PROFILE_CONCAT2(a, b)
+
+//! Times the rest of the enclosing scope as the phase `name`. The name
+//! must be a string literal.
+#define RE_PROFILE_SCOPE(name) \
+  Reality::ReScopedTimer RE_PROFILE_CONCAT(reScopedTimer_, __LINE__)(name)
+
+//! Adds value to the counter `name`. The name must be a string literal.
+#define RE_PROFILE_COUNT(name, value) \
+  do { \
+    if (Reality::ReProfiler::isEnabled()) { \
+      Reality::ReProfiler::addCounter(name, value); \
+    } \
+  } while (0)
+
+#endif
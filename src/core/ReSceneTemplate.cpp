@@ -0,0 +1,144 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#include "ReSceneTemplate.h"
+
+#include <string.h>
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include "ReDataDir.h"
+#include "ReLogger.h"
+
+
+namespace Reality {
+
+#define RE_PREVIEW_SCENES_DIR "PreviewScenes"
+
+static inline bool isDigit( const char c ) {
+  return c >= '0' && c <= '9';
+}
+
+ReSceneTemplate::ReSceneTemplate() :
+  maxNumber(0)
+{
+}
+
+ReSceneTemplate::ReSceneTemplate( const QByteArray& utf8Text ) :
+  maxNumber(0)
+{
+  parse(utf8Text);
+}
+
+void ReSceneTemplate::parse( const QByteArray& utf8Text ) {
+  text = utf8Text;
+  segments.clear();
+  maxNumber = 0;
+  const char* str = text.constData();
+  int length = text.size();
+  int start = 0;
+  int i = 0;
+  while (i < length) {
+    if (str[i] != '%' || i + 1 >= length || !isDigit(str[i+1])) {
+      i++;
+      continue;
+    }
+    // Like QString::arg(), the placeholders have one or two digits
+    int number = str[i+1] - '0';
+    int end = i + 2;
+    if (end < length && isDigit(str[end])) {
+      number = number * 10 + str[end] - '0';
+      end++;
+    }
+    if (number == 0) {
+      i = end;
+      continue;
+    }
+    if (i > start) {
+      Segment staticPart = { start, i - start, 0 };
+      segments << staticPart;
+    }
+    Segment placeholder = { i, end - i, number };
+    segments << placeholder;
+    maxNumber = qMax(maxNumber, number);
+    start = i = end;
+  }
+  if (length > start) {
+    Segment staticPart = { start, length - start, 0 };
+    segments << staticPart;
+  }
+}
+
+QByteArray ReSceneTemplate::fill( const QList<QByteArray>& values ) const {
+  int numSegments = segments.count();
+  int size = 0;
+  for (int i = 0; i < numSegments; i++) {
+    const Segment& seg = segments[i];
+    size += (seg.number > 0 && seg.number <= values.count()) ? 
+              values[seg.number - 1].size() : seg.length;
+  }
+  QByteArray result;
+  result.resize(size);
+  char* dest = result.data();
+  const char* src = text.constData();
+  for (int i = 0; i < numSegments; i++) {
+    const Segment& seg = segments[i];
+    if (seg.number > 0 && seg.number <= values.count()) {
+      const QByteArray& value = values[seg.number - 1];
+      memcpy(dest, value.constData(), value.size());
+      dest += value.size();
+    }
+    else {
+      memcpy(dest, src + seg.start, seg.length);
+      dest += seg.length;
+    }
+  }
+  return result;
+}
+
+
+ReSceneTemplateCache::ReSceneTemplateCache() {
+  overrideDir = getRealityDataDir(RE_PREVIEW_SCENES_DIR);
+}
+
+void ReSceneTemplateCache::setOverrideDir( const QString& dirName ) {
+  overrideDir = dirName;
+  entries.clear();
+}
+
+const ReSceneTemplate& ReSceneTemplateCache::get( const QString& fileName ) {
+  QString source = fileName;
+  uint modified = 0;
+  qint64 size = 0;
+  if (!overrideDir.isEmpty()) {
+    QFileInfo overrideInfo(QDir(overrideDir).absoluteFilePath(QFileInfo(fileName).fileName()));
+    if (overrideInfo.exists()) {
+      source   = overrideInfo.absoluteFilePath();
+      modified = overrideInfo.lastModified().toTime_t();
+      size     = overrideInfo.size();
+    }
+  }
+  Entry& entry = entries[fileName];
+  if ( !entry.source.isEmpty() && entry.source == source && 
+       entry.modified == modified && entry.size == size ) 
+  {
+    return entry.sceneTemplate;
+  }
+  QFile file(source);
+  if (!file.open(QIODevice::ReadOnly)) {
+    RE_LOG_WARN() << "Cannot read the scene template " << QSS(source);
+  }
+  entry.sceneTemplate.parse(file.readAll());
+  entry.source   = source;
+  entry.modified = modified;
+  entry.size     = size;
+  return entry.sceneTemplate;
+}
+
+} // namespace
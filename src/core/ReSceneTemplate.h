@@ -0,0 +1,134 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#ifndef RE_SCENE_TEMPLATE_H
+#define RE_SCENE_TEMPLATE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+#include "reality_lib_export.h"
+
+
+namespace Reality {
+
+/**
+ * A scene file with placeholders, like the scenes used for the material
+ * previews.
+ *
+ * The placeholders use the same notation of QString::arg(), %1 to %99.
+ * The text is split once, when the template is loaded, in static parts
+ * and placeholders, so filling the template costs as much as copying the
+ * result. Unlike a chain of calls to arg(), the values are never scanned
+ * for placeholders, so a % in a material definition is copied unchanged.
+ *
+ * The text is kept as UTF-8, the encoding used to send the scenes to the
+ * renderer.
+ */
+class REALITY_LIB_EXPORT ReSceneTemplate {
+
+private:
+  //! A static part of the text, or a placeholder when number is not zero
+  struct Segment {
+    int start;
+    int length;
+    int number;
+  };
+
+  QByteArray text;
+  QVector<Segment> segments;
+
+  //! The number of the largest placeholder
+  int maxNumber;
+
+public:
+
+  ReSceneTemplate();
+
+  explicit ReSceneTemplate( const QByteArray& utf8Text );
+
+  //! Splits the text in static parts and placeholders
+  void parse( const QByteArray& utf8Text );
+
+  inline const QByteArray& getText() const {
+    return text;
+  }
+
+  inline bool isEmpty() const {
+    return text.isEmpty();
+  }
+
+  //! The number of the largest placeholder, 0 if there are none
+  inline int getNumPlaceholders() const {
+    return maxNumber;
+  }
+
+  /**
+   * Returns the text with the placeholders replaced by the values. The
+   * first value replaces %1. Placeholders without a value are left in the
+   * text.
+   */
+  QByteArray fill( const QList<QByteArray>& values ) const;
+};
+
+
+/**
+ * The scene templates used by a client, loaded once and kept in memory.
+ *
+ * The templates are normally read from the resources of the program. If
+ * the override directory contains a file with the same name, that file
+ * is used instead and it's checked at every request, so the template is
+ * reloaded as soon as the file is saved. This makes it possible to edit
+ * the preview scenes while Reality is running.
+ *
+ * This class is not thread-safe, each thread must use its own cache.
+ */
+class REALITY_LIB_EXPORT ReSceneTemplateCache {
+
+private:
+  struct Entry {
+    ReSceneTemplate sceneTemplate;
+    //! The file the template has been read from
+    QString source;
+    uint modified;
+    qint64 size;
+  };
+
+  QString overrideDir;
+  QHash<QString, Entry> entries;
+
+public:
+
+  //! By default the templates can be overridden by the files in the
+  //! PreviewScenes directory next to the ACSEL database
+  ReSceneTemplateCache();
+
+  inline const QString& getOverrideDir() const {
+    return overrideDir;
+  }
+
+  void setOverrideDir( const QString& dirName );
+
+  /**
+   * Returns the template stored in a file, reading it the first time and
+   * when the override file changes. The reference is valid until the
+   * next call.
+   * \param fileName The file of the template, usually a resource path
+   *                 like ":/textResources/plane_preview.lxs"
+   */
+  const ReSceneTemplate& get( const QString& fileName );
+
+  void clear() {
+    entries.clear();
+  }
+};
+
+} // namespace
+
+#endif
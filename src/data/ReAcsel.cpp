@@ -14,6 +14,9 @@
 #include <QJson/Serializer>
 
 #include "RealityBase.h"
+#include "ReAcselBundleStream.h"
+#include "ReDataDir.h"
+#include "ReProfiler.h"
 
 
 #if defined(SQLITECPP_ENABLE_ASSERT_HANDLER)
@@ -103,6 +106,7 @@ ReMaterialType ReAcsel::getMaterialType( const QString str ) {
 QString ReAcsel::getAcselID( const QString geometryFileName, 
                              const QString matID, 
                              const QStringList& acselTextures ) {
+  RE_PROFILE_SCOPE("acselLookup");
   char separator = '|';
   QString objectID = geometryFileName;
   // Find the object alias, if present
@@ -141,13 +145,29 @@ bool ReAcsel::getOriginalShader( const QString objID,
                                  const QString matID,
                                  QString& shaderCode ) 
 {
+  RE_PROFILE_SCOPE("acselLookup");
   if (!dbOpen) {
     return false;
   }
+  // The shader could be still waiting to be written
+  {
+    QMutexLocker locker(&pendingShadersLock);
+    auto pending = pendingShaders.constFind(pendingShaderKey(objID, matID));
+    if (pending != pendingShaders.constEnd()) {
+      if (pending->code.isEmpty()) {
+        QJson::Serializer toJson;
+        shaderCode = QString::fromUtf8(toJson.serialize(pending->data));
+      }
+      else {
+        shaderCode = pending->code;
+      }
+      return true;
+    }
+  }
   // Retrieve the shader code for the original state of the material,
   // before any change applied by the user of ACSEL
   QString q = QString(
-                "SELECT ShaderCode FROM %1 WHERE App=? AND ObjectID=? AND"
+                "SELECT ShaderData FROM %1 WHERE App=? AND ObjectID=? AND"
                 " MatID=?"
               )
               .arg(RE_ACSEL_TABLE_ORIGINAL_SHADERS);
@@ -157,7 +177,11 @@ bool ReAcsel::getOriginalShader( const QString objID,
   s.bind(3, static_cast<const char*>(matID.toUtf8()));
   
   if (s.executeStep()) {
-    shaderCode = s.getColumn(0).getText();
+    auto blobData = s.getColumn(0);
+    shaderCode = QString::fromUtf8(
+                   qUncompress(static_cast<const uchar*>(blobData.getBlob()), 
+                               blobData.getBytes())
+                 );
   }
   return true;
 }
@@ -166,6 +190,16 @@ bool ReAcsel::getOriginalShader( const QString objID,
                                  const QString matID,
                                  QVariantMap& shaderData ) 
 {
+  // If the shader has not been written yet we can return the data 
+  // without going through JSON
+  {
+    QMutexLocker locker(&pendingShadersLock);
+    auto pending = pendingShaders.constFind(pendingShaderKey(objID, matID));
+    if (pending != pendingShaders.constEnd() && pending->code.isEmpty()) {
+      shaderData = pending->data;
+      return true;
+    }
+  }
   QString shaderCode;
   if ( !getOriginalShader(objID, matID, shaderCode) ) {
     return false;
@@ -182,12 +216,7 @@ bool ReAcsel::getOriginalShader( const QString objID,
 
 
 const QString ReAcsel::getDatabaseFileName() const {
-  QString dbDirName = QString("%1/Pret-a-3D/Reality")
-                        .arg(
-                           QDesktopServices::storageLocation(
-                             QDesktopServices::DocumentsLocation
-                           )
-                         );
+  QString dbDirName = getRealityDataDir();
   QDir dbDir(dbDirName);
   if (!dbDir.exists()) {
     QDir().mkpath(dbDirName);
@@ -261,6 +290,18 @@ bool ReAcsel::createTableIfMissing( const QString& tableName,
   return false;
 }
 
+bool ReAcsel::tableHasColumn( const QString& tableName, 
+                              const QString& columnName ) 
+{
+  SQLite::Statement s(*db, QString("PRAGMA table_info(%1)").arg(tableName).toUtf8());
+  while( s.executeStep() ) {
+    if (columnName.compare(s.getColumn(1).getText(), Qt::CaseInsensitive) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void ReAcsel::initDB() {
   if (!dbOpen) {
     // Open the connection
@@ -436,10 +477,17 @@ void ReAcsel::initDB() {
     /*
      * Original material definitions
      */
+    // The table used to store the shaders as plain text. It holds only 
+    // temporary data so it's simply recreated with the new layout.
+    if ( db->tableExists(RE_ACSEL_TABLE_ORIGINAL_SHADERS) && 
+         !tableHasColumn(RE_ACSEL_TABLE_ORIGINAL_SHADERS, "Hash") ) 
+    {
+      runQuery(QString("DROP TABLE %1").arg(RE_ACSEL_TABLE_ORIGINAL_SHADERS));
+    }
     str = QString(
             "CREATE TABLE %1"
-            " (App TEXT, ObjectID TEXT, MatID TEXT, ShaderCode TEXT,"
-            " PRIMARY KEY(App,ObjectID,MatID))"
+            " (App TEXT, ObjectID TEXT, MatID TEXT, ShaderData BLOB,"
+            " Hash TEXT, PRIMARY KEY(App,ObjectID,MatID))"
           )
           .arg(RE_ACSEL_TABLE_ORIGINAL_SHADERS);
     createTableIfMissing(RE_ACSEL_TABLE_ORIGINAL_SHADERS, str);
@@ -936,6 +984,7 @@ bool ReAcsel::storeUUID( const QString& UUID, const QString& schema ) {
 }
 
 bool ReAcsel::findShader( const QString& shaderID, QVariantMap& data ) {
+  RE_PROFILE_SCOPE("acselLookup");
   if (!dbOpen) {
     return false;
   }
@@ -973,6 +1022,7 @@ bool ReAcsel::findShader( const QString& shaderSetID,
                           const QString& materialName,
                           QString& shaderCode,
                           ReMaterialType& matType ) {
+  RE_PROFILE_SCOPE("acselLookup");
   if (!dbOpen) {
     return false;
   }
@@ -1000,6 +1050,7 @@ bool ReAcsel::findShaderSet( const QString& setID,
                              QVariantMap& setData,
                              bool useName ) 
 {
+  RE_PROFILE_SCOPE("acselLookup");
   if (!dbOpen) {
     return false;
   }
@@ -1055,6 +1106,7 @@ bool ReAcsel::findShaderSet( const QString& setID,
 }
 
 bool ReAcsel::findDefaultShaderSet( const QString& objectID, QVariantMap& data ) {
+  RE_PROFILE_SCOPE("acselLookup");
   if (!dbOpen) {
     return false;
   }
@@ -1099,6 +1151,10 @@ void ReAcsel::eraseTempData() {
   if (!dbOpen) {
     return;
   }
+  {
+    QMutexLocker locker(&pendingShadersLock);
+    pendingShaders.clear();
+  }
   QString appCode = getAppCode();
   SQLite::Statement q(*db, 
                       QString("SELECT count(UUID) from %1 WHERE APP='%2'")
@@ -1401,28 +1457,114 @@ bool ReAcsel::storeOriginalShader( const QString& objID,
   if (!dbOpen) {
     return false;
   }
-  bool retVal; 
-  try{
-    QString q = QString(
-                  "INSERT OR REPLACE INTO %1 (App, ObjectID, MatID, ShaderCode)"
-                  " values(?,?,?,?)"
-                ).arg(RE_ACSEL_TABLE_ORIGINAL_SHADERS);
-    SQLite::Statement s( *db, q.toUtf8());
-    s.bind(1, (const char*)getAppCode().toAscii());
-    s.bind(2, (const char*)objID.toUtf8());
-    s.bind(3, (const char*)matID.toUtf8());
-    s.bind(4, (const char*)shaderCode.toUtf8());
-    retVal = s.exec();
+  PendingShader shader;
+  shader.objID = objID;
+  shader.matID = matID;
+  shader.code  = shaderCode;
+  queueOriginalShader(shader);
+  return true;
+}
+
+bool ReAcsel::storeOriginalShader( const QString& objID, 
+                                   const QString& matID,
+                                   const QVariantMap& shaderData ) 
+{
+  if (!dbOpen) {
+    return false;
+  }
+  PendingShader shader;
+  shader.objID = objID;
+  shader.matID = matID;
+  shader.data  = shaderData;
+  queueOriginalShader(shader);
+  return true;
+}
+
+void ReAcsel::queueOriginalShader( const PendingShader& shader ) {
+  {
+    QMutexLocker locker(&pendingShadersLock);
+    pendingShaders[pendingShaderKey(shader.objID, shader.matID)] = shader;
+  }
+  // Outside of a scene load there is nothing to batch with
+  if (cachingLevels == 0) {
+    flushOriginalShaders();
+  }
+}
+
+void ReAcsel::flushOriginalShaders() {
+  if (!dbOpen) {
+    return;
+  }
+  QHash<QString, PendingShader> shaders;
+  {
+    QMutexLocker locker(&pendingShadersLock);
+    shaders.swap(pendingShaders);
+  }
+  if (shaders.isEmpty()) {
+    return;
+  }
+  RE_PROFILE_SCOPE("acselOriginalShaders");
+  QByteArray appCode = getAppCode().toUtf8();
+  try {
+    AcselTransactionPtr transaction = startTransaction();
+    SQLite::Statement findHash(
+      *db, 
+      QString("SELECT Hash FROM %1 WHERE App=? AND ObjectID=? AND MatID=?")
+        .arg(RE_ACSEL_TABLE_ORIGINAL_SHADERS)
+        .toUtf8()
+    );
+    SQLite::Statement store(
+      *db, 
+      QString("INSERT OR REPLACE INTO %1 (App, ObjectID, MatID, ShaderData, Hash)"
+              " values(?,?,?,?,?)")
+        .arg(RE_ACSEL_TABLE_ORIGINAL_SHADERS)
+        .toUtf8()
+    );
+    QJson::Serializer toJson;
+    QHashIterator<QString, PendingShader> i(shaders);
+    while( i.hasNext() ) {
+      i.next();
+      const PendingShader& shader = i.value();
+      QByteArray objID = shader.objID.toUtf8();
+      QByteArray matID = shader.matID.toUtf8();
+      QByteArray json = shader.code.isEmpty() ? 
+                        toJson.serialize(shader.data) :
+                        shader.code.toUtf8();
+      QByteArray hash = QCryptographicHash::hash(json, QCryptographicHash::Sha1)
+                          .toHex();
+      // Reloading the same scene captures the same shaders again
+      findHash.bind(1, appCode.constData());
+      findHash.bind(2, objID.constData());
+      findHash.bind(3, matID.constData());
+      bool unchanged = findHash.executeStep() && 
+                       hash == findHash.getColumn(0).getText();
+      findHash.reset();
+      if (unchanged) {
+        RE_PROFILE_COUNT("originalShadersSkipped", 1);
+        continue;
+      }
+      QByteArray blob = qCompress(json);
+      store.bind(1, appCode.constData());
+      store.bind(2, objID.constData());
+      store.bind(3, matID.constData());
+      store.bind(4, blob.constData(), blob.size());
+      store.bind(5, hash.constData());
+      store.exec();
+      store.reset();
+      RE_PROFILE_COUNT("originalShadersWritten", 1);
+    }
+    transaction->commit();
   }
   catch( SQLite::Exception e ) {
-    RE_LOG_INFO() << "Exception in ReAcsel::storeOriginalShader(): "
+    RE_LOG_INFO() << "Exception in ReAcsel::flushOriginalShaders(): "
                   << e.what();
   }
-  return retVal;
 }
 
 
-QString ReAcsel::exportDbToBundle( const QString& bundleFileName ) {
+QString ReAcsel::exportDbToBundle( const QString& bundleFileName,
+                                   const ProgressCallback& progress ) 
+{
   if (!dbOpen) {
     return "Database is not available";
   }
@@ -1447,7 +1589,8 @@ QString ReAcsel::exportDbToBundle( const QString& bundleFileName ) {
            universalShaders, 
            "ACSEL Base Bundle", 
            "Pret-a-3D", 
-           bundleFileName
+           bundleFileName,
+           progress
          );
 }
 
@@ -1455,7 +1598,9 @@ QString ReAcsel::exportToBundle( const QStringList& sets,
                                  const QStringList& universalShaders,
                                  const QString& title,
                                  const QString& sourceName,
-                                 const QString& fileName ) {
+                                 const QString& fileName,
+                                 const ProgressCallback& progress ) 
+{
   if (!dbOpen) {
     return "Database is not available";
   }
@@ -1463,40 +1608,42 @@ QString ReAcsel::exportToBundle( const QStringList& sets,
   if (!bundleFile.open(QIODevice::WriteOnly)) {
     return QString(
              QObject::tr(
-               "Could not open the file %1 for writing the ACSEL bundle \"%2\""
+               "Could not open the file %1 for writing the ACSEL bundle"
              )
            )
            .arg(fileName);
   }
-  QVariantMap bundle;
-  bundle[RE_ACSEL_BUNDLE_ID]      = RE_ACSEL_BUNDLE_SIGNATURE;
-  bundle[RE_ACSEL_BUNDLE_TITLE]   = title;
-  bundle[RE_ACSEL_BUNDLE_VERSION] = RE_ACSEL_VERSION;
-  bundle[RE_ACSEL_BUNDLE_SOURCE]  = sourceName;
+  QVariantMap header;
+  header[RE_ACSEL_BUNDLE_ID]      = RE_ACSEL_BUNDLE_SIGNATURE;
+  header[RE_ACSEL_BUNDLE_TITLE]   = title;
+  header[RE_ACSEL_BUNDLE_VERSION] = RE_ACSEL_VERSION;
+  header[RE_ACSEL_BUNDLE_SOURCE]  = sourceName;
 
-  QVariantList shaderData;
   int numSets = sets.count();
-  if (numSets) {
-    for (int i = 0; i < numSets; i++) {
-      shaderData.append( exportShaderSet(sets[i]) );
-    }
-  }
-  // Export the universal shaders
   int numUniShaders = universalShaders.count();
-  if (numUniShaders) {
-    for (int i = 0; i < numUniShaders; i++) {
-      shaderData.append( exportUniversalShader(universalShaders[i]) );
+  int numRecords = numSets + numUniShaders;
+  QString writeError = QString(
+                         QObject::tr("Error in writing the ACSEL bundle to file %1")
+                       )
+                       .arg(fileName);
+
+  ReAcselBundleWriter writer(&bundleFile);
+  if (!writer.writeHeader(header, numRecords)) {
+    return writeError;
+  }
+  // Each shader set is written as soon as it's read from the database so
+  // that only one set at a time is kept in memory
+  for (int i = 0; i < numRecords; i++) {
+    QVariantMap record = (i < numSets) ? 
+                         exportShaderSet(sets[i]) :
+                         exportUniversalShader(universalShaders[i-numSets]);
+    QVariantMap desc = record.take(RE_ACSEL_BUNDLE_DESCRIPTION).toMap();
+    if (!writer.writeRecord(desc, record)) {
+      return writeError;
+    }
+    if (progress) {
+      progress(i+1, numRecords);
     }
-  }
-  bundle[RE_ACSEL_BUNDLE_DATA] = shaderData;
-  // JSONize and write to disk
-  QJson::Serializer json;
-  json.setIndentMode(QJson::IndentFull);
-  if ( bundleFile.write(json.serialize(bundle)) == -1 ) {
-    return QString(
-             QObject::tr("Error in writing the ACSEL bundle to file %1")
-           )
-           .arg(fileName);
   }
 
   bundleFile.close();
@@ -1513,7 +1660,7 @@ bool ACSELVersionCheck( const QString bv ) {
 }
 
 ReAcsel::ReturnCode ReAcsel::checkIfShaderSetsExist( 
-                      const QVariantMap& bundle, 
+                      const QVariantList& descriptions, 
                       ExistingShaderSets& existingShaderSets 
                     )
 {
@@ -1523,24 +1670,20 @@ ReAcsel::ReturnCode ReAcsel::checkIfShaderSetsExist(
   // Just to stay on the safe side...
   existingShaderSets.clear();
 
-  QVariantList shaderSets = bundle.value(RE_ACSEL_BUNDLE_DATA).toList();
-  int shaderCount = shaderSets.count();
+  int shaderCount = descriptions.count();
 
   for (int i = 0; i < shaderCount; i++) {
-    auto oneEntry = shaderSets[i].toMap();
-    if ( oneEntry.value(RE_ACSEL_BUNDLE_TYPE) == RE_ACSEL_UNIVERSAL_SHADER_SIGNATURE ) {
+    QVariantMap ss = descriptions[i].toMap();
+    if ( ss.value(RE_ACSEL_BUNDLE_TYPE) == RE_ACSEL_UNIVERSAL_SHADER_SIGNATURE ) {
       // Universal shaders are structured differently
-      QString id = oneEntry[RE_ACSEL_BUNDLE_ID].toString();
+      QString id = ss[RE_ACSEL_BUNDLE_ID].toString();
       QVariantMap data;
       if (findUniversalShader(id, data)) {
-        existingShaderSets[oneEntry[RE_ACSEL_BUNDLE_NAME].toString()] = 
-          oneEntry[RE_ACSEL_BUNDLE_DESCRIPTION].toString();
+        existingShaderSets[ss[RE_ACSEL_BUNDLE_NAME].toString()] = 
+          ss[RE_ACSEL_BUNDLE_DESCRIPTION].toString();
       }
       continue;
     }
-    // shaderSets[i] gives us the whole object that defines the shader set,
-    // which means the three sections of description, shaders and uuids.
-    QVariantMap ss = shaderSets[i].toMap().value(RE_ACSEL_BUNDLE_DESCRIPTION).toMap();
     if ( !(ss.contains(RE_ACSEL_BUNDLE_SET_ID) && ss.contains(RE_ACSEL_BUNDLE_DESCRIPTION)) ) {
       return NotAnACSELBundle;
     }
@@ -1662,23 +1805,26 @@ ReAcsel::ReturnCode ReAcsel::importUniversalShader( QVariantMap& shaderData ) {
   return GeneralError;
 }
 
-ReAcsel::ReturnCode ReAcsel::importBundle( const QString bundleFileName, 
-                                           const bool overwrite,
-                                           ExistingShaderSets& existingShaderSets ) 
-{
-  if (!dbOpen) {
-    return GeneralError;
+ReAcsel::ReturnCode ReAcsel::importRecord( QVariantMap& shaderData ) {
+  QString shaderType = shaderData.value(RE_ACSEL_BUNDLE_DESCRIPTION).toMap()
+                         .value(RE_ACSEL_BUNDLE_TYPE).toString();
+  if (shaderType == RE_ACSEL_SHADER_SET_SIGNATURE) {
+    return importShaderSet(shaderData);
   }
+  else if (shaderType == RE_ACSEL_UNIVERSAL_SHADER_SIGNATURE) {
+    importUniversalShader(shaderData);
+  }
+  return Success;
+}
 
+ReAcsel::ReturnCode ReAcsel::importJsonBundle( QIODevice& bundleFile,
+                                               const bool overwrite,
+                                               ExistingShaderSets& existingShaderSets,
+                                               const ProgressCallback& progress )
+{
   QJson::Parser jsonParser;
   bool ok = false;
-  QVariantMap bundle;
-
-  QFile bundleFile(bundleFileName);
-  if (bundleFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-    bundle = jsonParser.parse(&bundleFile, &ok).toMap();
-    bundleFile.close();
-  }
+  QVariantMap bundle = jsonParser.parse(&bundleFile, &ok).toMap();
 
   if (!ok) {
     return SyntaxError;
@@ -1694,36 +1840,126 @@ ReAcsel::ReturnCode ReAcsel::importBundle( const QString bundleFileName,
     return WrongACSELVersion;
   }
 
+  QVariantList shaderSets = bundle.value(RE_ACSEL_BUNDLE_DATA).toList();
+  int shaderCount = shaderSets.count();
+
   // Check if the shaders in the bundle is already in the ACSEL database
   if (!overwrite) {
-    if ( checkIfShaderSetsExist( bundle, existingShaderSets ) == ShaderSetAlreadyExists ) {
+    QVariantList descriptions;
+    for (int i = 0; i < shaderCount; i++) {
+      descriptions.append(
+        shaderSets[i].toMap().value(RE_ACSEL_BUNDLE_DESCRIPTION)
+      );
+    }
+    if ( checkIfShaderSetsExist( descriptions, existingShaderSets ) == ShaderSetAlreadyExists ) {
       return ShaderSetAlreadyExists;
     }
   }
   /**************************
    * Install the shaders
    **************************/
-
-  QVariantList shaderSets = bundle.value(RE_ACSEL_BUNDLE_DATA).toList();
-  int shaderCount = shaderSets.count();
   ReturnCode retCode;
   for (int i = 0; i < shaderCount; i++) {
     QVariantMap shaderData  = shaderSets[i].toMap();
-    QString shaderType = shaderData.value(RE_ACSEL_BUNDLE_DESCRIPTION).toMap()
-                           .value(RE_ACSEL_BUNDLE_TYPE).toString();
-    if (shaderType == RE_ACSEL_SHADER_SET_SIGNATURE) {
-      if ( (retCode = importShaderSet(shaderData)) != Success ) {
-        return retCode;
+    if ( (retCode = importRecord(shaderData)) != Success ) {
+      return retCode;
+    }
+    if (progress) {
+      progress(i+1, shaderCount);
+    }
+  }
+  tran->commit();
+  return Success;
+}
+
+ReAcsel::ReturnCode ReAcsel::importStreamedBundle( QIODevice& bundleFile,
+                                                   const bool overwrite,
+                                                   ExistingShaderSets& existingShaderSets,
+                                                   const ProgressCallback& progress )
+{
+  ReAcselBundleReader reader(&bundleFile);
+  QVariantMap header;
+  if (!reader.readHeader(header)) {
+    return SyntaxError;
+  }
+  AcselTransactionPtr tran = startTransaction();
+  // Integrity check
+  if (header.value(RE_ACSEL_BUNDLE_ID).toString() != RE_ACSEL_BUNDLE_SIGNATURE) {
+    return NotAnACSELBundle;
+  }
+  QString version = header.value(RE_ACSEL_BUNDLE_VERSION).toString();
+  if ( !ACSELVersionCheck(version) ) {
+    return WrongACSELVersion;
+  }
+
+  int shaderCount = reader.count();
+
+  // Check if the shaders in the bundle is already in the ACSEL database.
+  // Only the descriptions are read, the shaders are skipped without 
+  // decompressing them.
+  if (!overwrite) {
+    QVariantList descriptions;
+    QVariantMap desc;
+    for (int i = 0; i < shaderCount; i++) {
+      if (!reader.readRecord(desc)) {
+        return SyntaxError;
       }
+      descriptions.append(desc);
+    }
+    if ( checkIfShaderSetsExist( descriptions, existingShaderSets ) == ShaderSetAlreadyExists ) {
+      return ShaderSetAlreadyExists;
     }
-    else if (shaderType == RE_ACSEL_UNIVERSAL_SHADER_SIGNATURE) {
-      importUniversalShader(shaderData);
+    if (!reader.rewind()) {
+      return GeneralError;
+    }
+  }
+  /**************************
+   * Install the shaders
+   **************************/
+  // Each record is inserted as soon as it's decoded. A corrupted record
+  // rolls back the whole bundle.
+  ReturnCode retCode;
+  for (int i = 0; i < shaderCount; i++) {
+    QVariantMap desc, shaderData;
+    if (!reader.readRecord(desc, &shaderData)) {
+      return SyntaxError;
+    }
+    shaderData[RE_ACSEL_BUNDLE_DESCRIPTION] = desc;
+    if ( (retCode = importRecord(shaderData)) != Success ) {
+      return retCode;
+    }
+    if (progress) {
+      progress(i+1, shaderCount);
     }
   }
   tran->commit();
   return Success;
 }
 
+ReAcsel::ReturnCode ReAcsel::importBundle( const QString bundleFileName, 
+                                           const bool overwrite,
+                                           ExistingShaderSets& existingShaderSets,
+                                           const ProgressCallback& progress ) 
+{
+  if (!dbOpen) {
+    return GeneralError;
+  }
+
+  QFile bundleFile(bundleFileName);
+  if (!bundleFile.open(QIODevice::ReadOnly)) {
+    return SyntaxError;
+  }
+  if (ReAcselBundleReader::isStreamedBundle(&bundleFile)) {
+    return importStreamedBundle(bundleFile, overwrite, existingShaderSets, progress);
+  }
+  // Older bundles are in JSON format
+  bundleFile.close();
+  if (!bundleFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    return SyntaxError;
+  }
+  return importJsonBundle(bundleFile, overwrite, existingShaderSets, progress);
+}
+
 void ReAcsel::importObjectAliases( const QVariantMap& aliases ) {
   QString qry = QString("INSERT OR REPLACE INTO %1 (ObjectID, Alias) VALUES(:objID,:alias)").arg(RE_ACSEL_TABLE_ALIASES);
   SQLite::Statement s( *db, qry.toUtf8());
@@ -1949,6 +2185,7 @@ bool ReAcsel::saveUniversalShader( QString& shaderID,
 
 bool ReAcsel::findUniversalShader( const QString& shaderID, 
                                    QVariantMap& data ) {
+  RE_PROFILE_SCOPE("acselLookup");
   if (!dbOpen) {
     return false;
   }
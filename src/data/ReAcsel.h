@@ -67,9 +67,12 @@
 #define RE_ACSEL_H
 
 #include <QHash>
+#include <QIODevice>
 #include <QMap>
+#include <QMutex>
 #include <QSharedPointer>
 #include <SQLiteCpp/SQLiteCpp.h>
+#include <boost/function.hpp>
 
 #include "reality_lib_export.h"
 #include "ReLogger.h"
@@ -137,6 +140,10 @@
 //!   having changed the material's type, we can restore the definition 
 //!   just by querying this table. 
 //!  
+//!
+//! The shaders are written in batches, see ReAcsel::storeOriginalShader(),
+//! as JSON text compressed with qCompress(). The SHA1 of the text is stored
+//! with it to avoid rewriting a shader that didn't change.
 #define RE_ACSEL_TABLE_ORIGINAL_SHADERS "OriginalShaders"
 
 //! Name of the ACSEL session
@@ -211,6 +218,11 @@ public:
   //! Map used for the check of existing shader sets in the database
   typedef QMap<QString,QString> ExistingShaderSets;
 
+  //! Callback used to report the progress of the export and import of
+  //! bundles. It receives the number of records processed and the total
+  //! number of records in the bundle.
+  typedef boost::function<void (const int, const int)> ProgressCallback;
+
 private:
   bool dbOpen;
 
@@ -337,9 +349,29 @@ private:
 
   //! Method used by importBundle() to verify if the shader sets included
   //! in the bundle already exist in the ACSEL database.
-  ReturnCode checkIfShaderSetsExist( const QVariantMap& bundle, 
+  //! \param descriptions The list of the descriptions of the shader sets
+  //!                     and universal shaders in the bundle
+  ReturnCode checkIfShaderSetsExist( const QVariantList& descriptions, 
                                      ExistingShaderSets& existingShaderSets );
 
+  //! Helper method for importBundle() that imports one record of the 
+  //! bundle, either a shader set or a universal shader.
+  ReturnCode importRecord( QVariantMap& shaderData );
+
+  //! Helper method for importBundle() that handles the bundles in JSON
+  //! format
+  ReturnCode importJsonBundle( QIODevice& bundleFile,
+                               const bool overwrite,
+                               ExistingShaderSets& existingShaderSets,
+                               const ProgressCallback& progress );
+
+  //! Helper method for importBundle() that handles the streamed bundles.
+  //! See ReAcselBundleStream.h for a description of the format.
+  ReturnCode importStreamedBundle( QIODevice& bundleFile,
+                                   const bool overwrite,
+                                   ExistingShaderSets& existingShaderSets,
+                                   const ProgressCallback& progress );
+
   //! Checks the version of the database against the version handled by
   //! the program. If the database is older it converts it to the new 
   //! version.
@@ -370,6 +402,35 @@ private:
   //! variable reaches zero the caching is disabled
   int cachingLevels;
 
+  //! An original shader waiting to be written to the database. Only one
+  //! of the two fields is set, depending on the form in which the shader 
+  //! has been received.
+  struct PendingShader {
+    QString objID;
+    QString matID;
+    QVariantMap data;
+    QString code;
+  };
+
+  //! Original shaders captured and not yet written to the database. Keyed
+  //! by object ID and material ID.
+  QHash<QString, PendingShader> pendingShaders;
+  QMutex pendingShadersLock;
+
+  //! Returns the key used for pendingShaders
+  static inline QString pendingShaderKey( const QString& objID, 
+                                          const QString& matID ) 
+  {
+    return QString("%1|%2").arg(objID).arg(matID);
+  }
+
+  //! Adds a shader to the pending list and writes the list if caching
+  //! is not active
+  void queueOriginalShader( const PendingShader& shader );
+
+  //! Returns true if the table has a column with the given name
+  bool tableHasColumn( const QString& tableName, const QString& columnName );
+
 public:
 
   //! Access method to retrieve the instance. It creates an instance if it
@@ -385,6 +446,7 @@ public:
     // Avoid deleting the instance more than once
     ReAcsel::instance = NULL;
     if (db) {
+      flushOriginalShaders();
       delete db;
     }
   };
@@ -403,6 +465,9 @@ public:
     // RE_LOG_INFO() << "(-) Committed global ACSEL transaction";
     cachingLevels--;
     if (!globalTransaction.isNull() && (cachingLevels == 0)) {
+      // The original shaders captured while caching are written as part
+      // of the same transaction
+      flushOriginalShaders();
       globalTransaction->commit();
       globalTransaction.clear();
     }
@@ -597,12 +662,28 @@ public:
   bool deleteUniversalShader( const QString& shaderID );
 
 
-  //! Stores a shader in the temporary table RE_ACSEL_TABLE_ORIGINAL_MATS
+  //! Stores a shader in the temporary table RE_ACSEL_TABLE_ORIGINAL_SHADERS
+  //!
+  //! The shader is not written immediately. While the caching is active,
+  //! during the loading of a scene, the shaders are kept in memory and 
+  //! written all together by \ref flushOriginalShaders() when the caching 
+  //! stops. getOriginalShader() returns the pending shaders as well.
+  //! \param shaderCode The shader in JSON format
   //! \returns true if the operation was successful, false otherwise.
   bool storeOriginalShader( const QString& objID, 
                             const QString& matID,
                             const QString& shaderCode );
 
+  //! Overloaded version that accepts the shader data as received from the
+  //! host. The conversion to JSON is done only when the shader is written.
+  bool storeOriginalShader( const QString& objID, 
+                            const QString& matID,
+                            const QVariantMap& shaderData );
+
+  //! Writes all the pending original shaders, in one transaction. Shaders
+  //! that are already in the database with the same content are skipped.
+  void flushOriginalShaders();
+
   //! Retrieves the data of an original shader previously stored.
   //! \param objID The unique identifier of the object
   //! \param matID The unique identifier of the material
@@ -627,11 +708,20 @@ public:
    *              be empty
    * \param universalShaders. A list of universal shader that need to be 
    *                          exported. It can be empty.
-   * \param fileName. The name of the JSON file that will contain the
+   * \param fileName. The name of the file that will contain the
    *        exported bundle
+   * \param progress. Optional callback called after each shader set or 
+   *        universal shader has been written
+   *
+   * The bundle is written in the streamed format described in 
+   * ReAcselBundleStream.h. Each shader set is read from the database, 
+   * compressed and written before the next one is read, so only one
+   * shader set at a time is kept in memory. Each record of the streamed
+   * bundle holds one of the elements of the "data" array described below.
    *
-   * Format of the ACSEL bundle, the way to distribute ACSEL shaders to be 
-   * installed by Reality via command line.
+   * Format of the JSON ACSEL bundle, the way to distribute ACSEL shaders 
+   * to be installed by Reality via command line. Bundles in this format
+   * are still accepted by importBundle().
    *
    * - The storage format is JSON
    * - The tables exported are: 
@@ -691,13 +781,16 @@ public:
                           const QStringList& universalShaders,
                           const QString& title, 
                           const QString& sourceName,
-                          const QString& fileName );
+                          const QString& fileName,
+                          const ProgressCallback& progress = ProgressCallback() );
 
   //! Exports to whole database to a bundle.
   //! \param bundleFileName The name of the file that will contain the bundle.
+  //! \param progress Optional progress callback, see exportToBundle()
   //! \return A string with the result of the operation. A blank string
   //!         means no error, otherwise an error message is provided.
-  QString exportDbToBundle( const QString& bundleFileName );
+  QString exportDbToBundle( const QString& bundleFileName,
+                            const ProgressCallback& progress = ProgressCallback() );
 
   /**
    * Imports a bundle into the database
@@ -712,6 +805,13 @@ public:
    *                           The map is keyed by shader set name and the
    *                           associated value is the description for the set
    *                           as it was found in the database.
+   * \param progress Optional callback called after each shader set or
+   *                 universal shader has been imported
+   *
+   * Both the JSON and the streamed bundles are accepted. The records of a
+   * streamed bundle are inserted, inside one transaction, as they are 
+   * decoded.
+   *
    * \return A code that signals the result of the operation. For example, if
    *         a bundle includes pre-existing shader sets and the overwrite flag
    *         is false then the function will return ShaderSetAlreadyExists
@@ -719,7 +819,8 @@ public:
   ReturnCode importBundle( 
     const QString bundleFileName,
     const bool overwrite,
-    ExistingShaderSets& existingShaderSets
+    ExistingShaderSets& existingShaderSets,
+    const ProgressCallback& progress = ProgressCallback()
   );
 
   //! Exports a shader set as a QVariantMap string
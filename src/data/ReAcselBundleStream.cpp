@@ -0,0 +1,154 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#include "ReAcselBundleStream.h"
+
+#include <cstring>
+
+
+using namespace Reality;
+
+// Length of the magic string, without the terminating zero
+static const int magicLength = sizeof(RE_ACSEL_STREAMED_BUNDLE_MAGIC)-1;
+
+/*
+ * Writer
+ */
+ReAcselBundleWriter::ReAcselBundleWriter( QIODevice* device ) :
+  device(device),
+  stream(device)
+{
+  stream.setVersion(QDataStream::Qt_4_8);
+}
+
+bool ReAcselBundleWriter::writeBlock( const QVariantMap& data ) {
+  QByteArray raw;
+  QDataStream rawStream(&raw, QIODevice::WriteOnly);
+  rawStream.setVersion(QDataStream::Qt_4_8);
+  rawStream << data;
+
+  QByteArray block = qCompress(raw);
+  stream << static_cast<quint32>(block.size());
+  if (stream.writeRawData(block.constData(), block.size()) != block.size()) {
+    return false;
+  }
+  return stream.status() == QDataStream::Ok;
+}
+
+bool ReAcselBundleWriter::writeHeader( const QVariantMap& header,
+                                       const int numRecords )
+{
+  if (stream.writeRawData(RE_ACSEL_STREAMED_BUNDLE_MAGIC, magicLength) != magicLength) {
+    return false;
+  }
+  stream << static_cast<quint32>(RE_ACSEL_STREAMED_BUNDLE_VERSION);
+  if (!writeBlock(header)) {
+    return false;
+  }
+  stream << static_cast<quint32>(numRecords);
+  return stream.status() == QDataStream::Ok;
+}
+
+bool ReAcselBundleWriter::writeRecord( const QVariantMap& description,
+                                       const QVariantMap& content )
+{
+  return writeBlock(description) && writeBlock(content);
+}
+
+/*
+ * Reader
+ */
+ReAcselBundleReader::ReAcselBundleReader( QIODevice* device ) :
+  device(device),
+  stream(device),
+  numRecords(0),
+  firstRecordPos(0)
+{
+  stream.setVersion(QDataStream::Qt_4_8);
+}
+
+bool ReAcselBundleReader::isStreamedBundle( QIODevice* device ) {
+  QByteArray magic = device->peek(magicLength);
+  return magic == RE_ACSEL_STREAMED_BUNDLE_MAGIC;
+}
+
+bool ReAcselBundleReader::readBlock( QVariantMap& data ) {
+  quint32 length = 0;
+  stream >> length;
+  // A length larger than the rest of the file means that the file is
+  // corrupted, don't try to allocate it
+  if (stream.status() != QDataStream::Ok || length > device->bytesAvailable()) {
+    return false;
+  }
+  QByteArray block(length, 0);
+  if (stream.readRawData(block.data(), length) != static_cast<int>(length)) {
+    return false;
+  }
+  QByteArray raw = qUncompress(block);
+  if (raw.isEmpty()) {
+    return false;
+  }
+  QDataStream rawStream(raw);
+  rawStream.setVersion(QDataStream::Qt_4_8);
+  rawStream >> data;
+  return rawStream.status() == QDataStream::Ok;
+}
+
+bool ReAcselBundleReader::skipBlock() {
+  quint32 length = 0;
+  stream >> length;
+  if (stream.status() != QDataStream::Ok || length > device->bytesAvailable()) {
+    return false;
+  }
+  return stream.skipRawData(length) == static_cast<int>(length);
+}
+
+bool ReAcselBundleReader::readHeader( QVariantMap& header ) {
+  char magic[magicLength];
+  if (stream.readRawData(magic, magicLength) != magicLength ||
+      memcmp(magic, RE_ACSEL_STREAMED_BUNDLE_MAGIC, magicLength) != 0)
+  {
+    return false;
+  }
+  quint32 version = 0;
+  stream >> version;
+  if (version > RE_ACSEL_STREAMED_BUNDLE_VERSION) {
+    return false;
+  }
+  if (!readBlock(header)) {
+    return false;
+  }
+  quint32 count = 0;
+  stream >> count;
+  if (stream.status() != QDataStream::Ok) {
+    return false;
+  }
+  numRecords = count;
+  firstRecordPos = device->pos();
+  return true;
+}
+
+bool ReAcselBundleReader::readRecord( QVariantMap& description,
+                                      QVariantMap* content )
+{
+  description.clear();
+  if (!readBlock(description)) {
+    return false;
+  }
+  if (content) {
+    content->clear();
+    return readBlock(*content);
+  }
+  return skipBlock();
+}
+
+bool ReAcselBundleReader::rewind() {
+  if (!device->seek(firstRecordPos)) {
+    return false;
+  }
+  stream.resetStatus();
+  return true;
+}
@@ -0,0 +1,119 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#ifndef RE_ACSEL_BUNDLE_STREAM_H
+#define RE_ACSEL_BUNDLE_STREAM_H
+
+#include <QDataStream>
+#include <QVariantMap>
+
+#include "reality_lib_export.h"
+
+//! The first bytes of a streamed bundle. A JSON bundle starts with "{" so
+//! the two formats can be told apart by reading the first bytes of the file
+#define RE_ACSEL_STREAMED_BUNDLE_MAGIC   "RSBZ"
+//! Version of the layout of the streamed bundle
+#define RE_ACSEL_STREAMED_BUNDLE_VERSION 1
+
+
+namespace Reality {
+
+/**
+ * Streamed format of the ACSEL bundles.
+ *
+ * A streamed bundle is written and read one shader set, or universal
+ * shader, at a time. This avoids building the whole bundle in memory,
+ * as it's necessary with the JSON format.
+ *
+ * Layout of the file:
+ *
+ *   - The magic string RE_ACSEL_STREAMED_BUNDLE_MAGIC
+ *   - The format version, as a quint32
+ *   - The header block, with the same identifying information of the
+ *     JSON bundle
+ *   - The number of records that follow, as a quint32
+ *   - For each record, two blocks:
+ *       - The description of the shader set or universal shader
+ *       - The rest of the record: shaders, volumes, UUIDs, thumbnail
+ *
+ * Each block is a QVariantMap serialized with QDataStream and compressed
+ * with qCompress(), prefixed by its compressed length as a quint32.
+ * The description is stored separately so that the content of a bundle
+ * can be listed without decompressing the shaders.
+ *
+ * The content of the maps is defined by ReAcsel, these classes handle only
+ * the framing and the compression of the blocks.
+ */
+class REALITY_LIB_EXPORT ReAcselBundleWriter {
+
+private:
+  QIODevice* device;
+  QDataStream stream;
+
+  bool writeBlock( const QVariantMap& data );
+
+public:
+  ReAcselBundleWriter( QIODevice* device );
+
+  //! Writes the file signature and the header. Must be called first.
+  //! \param numRecords The number of records that will be written
+  //! \return false in case of error
+  bool writeHeader( const QVariantMap& header, const int numRecords );
+
+  //! Writes one shader set or universal shader
+  //! \return false in case of error
+  bool writeRecord( const QVariantMap& description, 
+                    const QVariantMap& content );
+};
+
+
+class REALITY_LIB_EXPORT ReAcselBundleReader {
+
+private:
+  QIODevice* device;
+  QDataStream stream;
+
+  //! Number of records declared in the header
+  int numRecords;
+
+  //! Position of the first record in the file
+  qint64 firstRecordPos;
+
+  bool readBlock( QVariantMap& data );
+  bool skipBlock();
+
+public:
+  ReAcselBundleReader( QIODevice* device );
+
+  //! Returns true if the device, open for reading, contains a streamed
+  //! bundle. The read position is not changed.
+  static bool isStreamedBundle( QIODevice* device );
+
+  //! Reads and validates the file signature and the header
+  //! \return false if the device doesn't contain a streamed bundle or if
+  //!         the header is corrupted
+  bool readHeader( QVariantMap& header );
+
+  //! Number of records in the bundle. Valid after \ref readHeader()
+  inline int count() const {
+    return numRecords;
+  }
+
+  //! Reads the next record.
+  //! \param description Receives the description of the record
+  //! \param content Receives the rest of the record. If NULL the content
+  //!                is skipped without decompressing it.
+  //! \return false if the record is corrupted or if the end of the file
+  //!         has been reached
+  bool readRecord( QVariantMap& description, QVariantMap* content = NULL );
+
+  //! Moves back to the first record
+  bool rewind();
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,123 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#include "ReCameraView.h"
+
+#include <math.h>
+
+#include "ReMatrix.h"
+
+
+namespace Reality {
+
+static void normalize( ReVector& v ) {
+  float length = sqrt(v.X*v.X + v.Y*v.Y + v.Z*v.Z);
+  if (length > 0.0f) {
+    v.X /= length;
+    v.Y /= length;
+    v.Z /= length;
+  }
+}
+
+ReCameraView::ReCameraView() :
+  tanHalfHeight(0.0f),
+  tanHalfWidth(0.0f),
+  frameHeight(0),
+  valid(false)
+{
+  eye.X = eye.Y = eye.Z = 0.0f;
+  right = up = forward = eye;
+}
+
+void ReCameraView::set( const ReMatrix& matrix,
+                        const float fov,
+                        const unsigned int width,
+                        const unsigned int height )
+{
+  matrix.getPosition(eye);
+  // Same axes used by ReMatrix::getTarget() and getUpVector()
+  right.X   =  matrix.m[0][0];
+  right.Y   =  matrix.m[0][1];
+  right.Z   =  matrix.m[0][2];
+  up.X      =  matrix.m[1][0];
+  up.Y      =  matrix.m[1][1];
+  up.Z      =  matrix.m[1][2];
+  forward.X = -matrix.m[2][0];
+  forward.Y = -matrix.m[2][1];
+  forward.Z = -matrix.m[2][2];
+  normalize(right);
+  normalize(up);
+  normalize(forward);
+
+  frameHeight   = height;
+  tanHalfHeight = tan(fov * M_PI / 360.0);
+  tanHalfWidth  = height > 0 ? tanHalfHeight * width / height : 0.0f;
+  valid = fov > 0.0f && width > 0 && height > 0;
+}
+
+float ReCameraView::getDistance( const ReVectorF& boxMin, const ReVectorF& boxMax ) const {
+  float e[3] = { eye.X, eye.Y, eye.Z };
+  float dist2 = 0.0f;
+  for (int i = 0; i < 3; i++) {
+    float d = 0.0f;
+    if (e[i] < boxMin[i]) {
+      d = boxMin[i] - e[i];
+    }
+    else if (e[i] > boxMax[i]) {
+      d = e[i] - boxMax[i];
+    }
+    dist2 += d*d;
+  }
+  return sqrt(dist2);
+}
+
+float ReCameraView::getPixelSize( const float distance ) const {
+  if (!valid) {
+    return 0.0f;
+  }
+  return 2.0f * distance * tanHalfHeight / frameHeight;
+}
+
+bool ReCameraView::isOutside( const ReVectorF& boxMin, 
+                              const ReVectorF& boxMax, 
+                              const float margin ) const 
+{
+  if (!valid) {
+    return false;
+  }
+  float scale = 1.0f + 2.0f * margin;
+  float tanX = tanHalfWidth * scale;
+  float tanY = tanHalfHeight * scale;
+  // Counts, for each plane of the view, the corners on the outer side
+  int behind = 0, left = 0, rightSide = 0, below = 0, above = 0;
+  for (int i = 0; i < 8; i++) {
+    float cx = ((i & 1) ? boxMax[0] : boxMin[0]) - eye.X;
+    float cy = ((i & 2) ? boxMax[1] : boxMin[1]) - eye.Y;
+    float cz = ((i & 4) ? boxMax[2] : boxMin[2]) - eye.Z;
+    // The corner in the coordinates of the camera
+    float x = cx*right.X   + cy*right.Y   + cz*right.Z;
+    float y = cx*up.X      + cy*up.Y      + cz*up.Z;
+    float z = cx*forward.X + cy*forward.Y + cz*forward.Z;
+    if (z < 0.0f) {
+      behind++;
+    }
+    if (x < -tanX * z) {
+      left++;
+    }
+    if (x > tanX * z) {
+      rightSide++;
+    }
+    if (y < -tanY * z) {
+      below++;
+    }
+    if (y > tanY * z) {
+      above++;
+    }
+  }
+  return behind == 8 || left == 8 || rightSide == 8 || below == 8 || above == 8;
+}
+
+} // namespace
@@ -0,0 +1,89 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#ifndef RE_CAMERA_VIEW_H
+#define RE_CAMERA_VIEW_H
+
+#include "reality_lib_export.h"
+#include "ReDefs.h"
+
+namespace Reality {
+  class ReMatrix;
+}
+
+
+namespace Reality {
+
+/**
+ * The view of the selected camera, used by the exporter to estimate how
+ * large the objects are in the rendered image and to find the objects
+ * that are out of the frame.
+ *
+ * The values are in the coordinate system and units of the host app, the
+ * same used for the geometry sent to the exporter. The field of view is
+ * the one written to the Lux scene, which covers the height of the frame.
+ */
+class REALITY_LIB_EXPORT ReCameraView {
+
+private:
+  ReVector eye;
+  //! The axes of the camera
+  ReVector right;
+  ReVector up;
+  ReVector forward;
+
+  //! Tangent of half the vertical and horizontal field of view
+  float tanHalfHeight;
+  float tanHalfWidth;
+
+  unsigned int frameHeight;
+
+  bool valid;
+
+public:
+
+  ReCameraView();
+
+  /**
+   * Sets the view from the matrix of a camera
+   * \param fov The vertical field of view, in degrees
+   */
+  void set( const ReMatrix& matrix,
+            const float fov,
+            const unsigned int width,
+            const unsigned int height );
+
+  void clear() {
+    valid = false;
+  }
+
+  inline bool isValid() const {
+    return valid;
+  }
+
+  //! Distance between the camera and the closest point of a bounding box.
+  //! Returns 0 if the camera is inside the box.
+  float getDistance( const ReVectorF& boxMin, const ReVectorF& boxMax ) const;
+
+  //! Size, in scene units, of one pixel of the frame at the given distance
+  //! from the camera
+  float getPixelSize( const float distance ) const;
+
+  /**
+   * Returns true if a bounding box is completely out of the view. The test
+   * is conservative, some boxes near the corners of the view are reported
+   * as inside.
+   * \param margin Enlarges the view, on each side, by this fraction of the
+   *               size of the frame
+   */
+  bool isOutside( const ReVectorF& boxMin, 
+                  const ReVectorF& boxMax, 
+                  const float margin ) const;
+};
+
+} // namespace
+
+#endif
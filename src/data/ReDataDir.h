@@ -0,0 +1,36 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#ifndef RE_DATA_DIR_H
+#define RE_DATA_DIR_H
+
+#include <QDesktopServices>
+#include <QString>
+
+
+namespace Reality {
+
+//! Location of the Reality data, relative to the user's documents
+#define RE_DATA_DIR "Pret-a-3D/Reality"
+
+/**
+ * Returns the directory where Reality keeps the ACSEL database, the
+ * caches and the user's overrides. The directory is not created.
+ * \param entryName If not empty, the name of a file or of a directory
+ *                  inside the data directory, whose path is returned
+ */
+inline QString getRealityDataDir( const QString& entryName = QString() ) {
+  QString dirName = QDesktopServices::storageLocation(QDesktopServices::DocumentsLocation) +
+                    "/" RE_DATA_DIR;
+  if (entryName.isEmpty()) {
+    return dirName;
+  }
+  return dirName + "/" + entryName;
+}
+
+} // namespace
+
+#endif
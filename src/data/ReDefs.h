@@ -76,6 +76,10 @@
 #define RE_CFG_LUX_WRITE_INTERVAL       "LuxWriteInterval"
 #define RE_CFG_OVERWRITE_WARNING        "OverwriteWarning"
 #define RE_CFG_MAT_PREVIEW_CACHE_SIZE   "MatPreviewCacheSize"
+#define RE_CFG_MAT_PREVIEW_DRAFT        "MatPreviewDraftPass"
+//! Render the material previews with the Lux library, when available,
+//! instead of running luxconsole
+#define RE_CFG_MAT_PREVIEW_IN_PROCESS   "MatPreviewInProcess"
 // #define RE_CFG_USE_GPU                  "UseGPU"
 #define RE_CFG_OCL_GROUP_SIZE           "OpenCLWorkgroupSize"
 #define RE_CFG_DEFAULT_SCENE_LOCATION   "DefaultSceneLocation"
@@ -90,6 +94,33 @@
 #define RE_CFG_LAST_UPDATE_CHECK        "lastUpdateCheck"
 // #define RE_CFG_USE_NATIVE_UI            "UseNativeLook"
 #define RE_CFG_KEEP_UI_RESPONSIVE       "KeepUiResponsive"
+//! Write a report with the timings of each export next to the scene file
+#define RE_CFG_EXPORT_PROFILING         "ExportProfiling"
+//! Write also the timing of each call, in the Chrome trace-event format
+#define RE_CFG_EXPORT_TRACE             "ExportTrace"
+//! Size, in MB, from which the geometry buffer is memory-mapped
+#define RE_CFG_GEOMETRY_MAP_SIZE        "GeometryMapSize"
+//! Map the large geometry buffers to temporary files instead of memory
+#define RE_CFG_GEOMETRY_MAP_TO_FILE     "GeometryMapToFile"
+//! Run the subdivision and displacement in the exporter, see ReMeshRefiner
+#define RE_CFG_BAKE_SUBDIVISION         "BakeSubdivision"
+//! Size, in MB, of the cache of the refined meshes, see ReMeshRefiner
+#define RE_CFG_MESH_CACHE_SIZE          "MeshCacheSize"
+//! Decimate the meshes that are small in the frame, see ReMeshDecimator
+#define RE_CFG_LOD_DECIMATION           "LODDecimation"
+//! How much, in pixels, the decimated meshes can differ from the originals
+#define RE_CFG_LOD_PIXEL_ERROR          "LODPixelError"
+//! Skip the meshes that are out of the frame of the selected camera
+#define RE_CFG_FRUSTUM_CULLING          "FrustumCulling"
+//! Fraction of the frame added on each side of the view before culling
+#define RE_CFG_CULLING_MARGIN           "CullingMargin"
+//! Angle, in degrees, above which the repaired normals are not smoothed,
+//! see ReNormalRepair
+#define RE_CFG_NORMALS_CREASE_ANGLE     "NormalsCreaseAngle"
+//! Reorder the triangles and vertices of the meshes, see ReMeshOptimizer
+#define RE_CFG_MESH_OPTIMIZATION        "MeshOptimization"
+//! Follow a Morton curve when the mesh optimization reaches a dead end
+#define RE_CFG_MESH_MORTON_ORDER        "MeshMortonOrder"
 
 #define RE_CFG_DEFAULT_SCENE_NAME        "reality_scene.lxs"
 #define RE_CFG_DEFAULT_IMAGE_NAME        "reality_scene.png"
@@ -385,6 +416,15 @@ enum ReTextureSize {
   T_ORIGINAL, 
 };
 
+//! Maximum width of the IBL maps passed to the renderer, see ReIBLMapCache
+enum ReIBLMapSize {
+  IBL_1K,
+  IBL_2K,
+  IBL_4K,
+  IBL_8K,
+  IBL_ORIGINAL
+};
+
 enum LUX_LOG_LEVEL {
   LUX_WARNINGS    = 101,
   LUX_INFORMATION,
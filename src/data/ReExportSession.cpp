@@ -0,0 +1,392 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#include "ReExportSession.h"
+
+#include <QDir>
+
+#include "ReLogger.h"
+
+
+namespace Reality {
+
+//! Identifies the journal files, "REXJ"
+#define RE_EXPORT_JOURNAL_MAGIC   0x5245584a
+#define RE_EXPORT_JOURNAL_VERSION 1
+
+//! Size of the blocks used to copy the fragments of the interrupted export
+#define RE_EXPORT_COPY_BLOCK      (1024*1024)
+
+ReExportSession::ReExportSession() :
+  resumePosition(0),
+  inSync(false),
+  objectOpen(false),
+  cancelRequested(0),
+  active(false)
+{
+}
+
+ReExportSession::~ReExportSession() {
+  if (active) {
+    abort();
+  }
+}
+
+bool ReExportSession::readJournal() {
+  previousEntries.clear();
+  previousKey.clear();
+
+  QFile journal(includeFileName + RE_EXPORT_JOURNAL_EXT);
+  if (!journal.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  QDataStream stream(&journal);
+  stream.setVersion(QDataStream::Qt_4_8);
+  quint32 magic, version;
+  stream >> magic >> version;
+  if (magic != RE_EXPORT_JOURNAL_MAGIC || version != RE_EXPORT_JOURNAL_VERSION) {
+    return false;
+  }
+  stream >> previousKey;
+  // The last entry can be incomplete if the host crashed while writing it
+  while(!stream.atEnd()) {
+    JournalEntry entry;
+    stream >> entry.objectID >> entry.hash >> entry.offset >> entry.length
+           >> entry.materials >> entry.triangles;
+    if (stream.status() != QDataStream::Ok) {
+      break;
+    }
+    previousEntries.append(entry);
+  }
+  return !previousEntries.isEmpty();
+}
+
+bool ReExportSession::begin( const QString& sceneName, const QString& includeName ) {
+  if (active) {
+    abort();
+  }
+  sceneFileName   = sceneName;
+  includeFileName = includeName;
+  progress.reset();
+  cancelRequested = 0;
+  resumePosition  = 0;
+  inSync          = true;
+  objectOpen      = false;
+  stagedDirs.clear();
+
+  QString tempIncludeName = includeFileName + RE_EXPORT_TEMP_EXT;
+  QString resumeName      = includeFileName + RE_EXPORT_RESUME_EXT;
+  QFile::remove(resumeName);
+
+  // The include file of the interrupted export is moved out of the way
+  // and its fragments are copied, if possible, into the new file
+  if (readJournal() && QFile::exists(tempIncludeName)) {
+    if (!QFile::rename(tempIncludeName, resumeName)) {
+      previousEntries.clear();
+    }
+  }
+  else {
+    previousEntries.clear();
+  }
+  // The entries are in memory now and the journal will be rewritten for
+  // the new include file
+  QFile::remove(includeFileName + RE_EXPORT_JOURNAL_EXT);
+  QFile::remove(tempIncludeName);
+  QFile::remove(sceneFileName + RE_EXPORT_TEMP_EXT);
+
+  if (!previousEntries.isEmpty()) {
+    resumeFile.setFileName(resumeName);
+    if (!resumeFile.open(QIODevice::ReadOnly)) {
+      previousEntries.clear();
+    }
+  }
+
+  sceneFile.setFileName(sceneFileName + RE_EXPORT_TEMP_EXT);
+  if ( !sceneFile.open(QIODevice::WriteOnly) ) {
+    RE_LOG_WARN() << "Error: could not open the file "
+                  << QSS(sceneFile.fileName())
+                  << " for writing. Rendering aborted";
+    closeFiles();
+    return false;
+  }
+  includeFile.setFileName(tempIncludeName);
+  if ( !includeFile.open(QIODevice::WriteOnly) ) {
+    RE_LOG_WARN() << "Error: could not open the file "
+                  << QSS(includeFile.fileName())
+                  << " for writing. Rendering aborted";
+    closeFiles();
+    return false;
+  }
+  active = true;
+  return true;
+}
+
+void ReExportSession::setSceneKey( const QByteArray& key ) {
+  if (!active) {
+    return;
+  }
+  if (key != previousKey) {
+    previousEntries.clear();
+  }
+  journalFile.setFileName(includeFileName + RE_EXPORT_JOURNAL_EXT);
+  if ( !journalFile.open(QIODevice::WriteOnly) ) {
+    RE_LOG_WARN() << "Could not create the export journal "
+                  << QSS(journalFile.fileName())
+                  << ". The export will not be resumable";
+    return;
+  }
+  QDataStream stream(&journalFile);
+  stream.setVersion(QDataStream::Qt_4_8);
+  stream << (quint32) RE_EXPORT_JOURNAL_MAGIC
+         << (quint32) RE_EXPORT_JOURNAL_VERSION
+         << key;
+  journalFile.flush();
+}
+
+void ReExportSession::stageDirectory( const QString& dirName ) {
+  if (active && !stagedDirs.contains(dirName)) {
+    stagedDirs.append(dirName);
+  }
+}
+
+qint64 ReExportSession::writeScene( const QByteArray& data ) {
+  qint64 bytes = sceneFile.write(data);
+  if (bytes > 0) {
+    progress.bytes += bytes;
+  }
+  return bytes;
+}
+
+qint64 ReExportSession::writeInclude( const QByteArray& data ) {
+  qint64 bytes = includeFile.write(data);
+  if (bytes > 0) {
+    progress.bytes += bytes;
+  }
+  return bytes;
+}
+
+void ReExportSession::writeJournalEntry( const JournalEntry& entry ) {
+  if (!journalFile.isOpen()) {
+    return;
+  }
+  // The fragment must be on disk before the journal says it's complete
+  includeFile.flush();
+  QDataStream stream(&journalFile);
+  stream.setVersion(QDataStream::Qt_4_8);
+  stream << entry.objectID << entry.hash << entry.offset << entry.length
+         << entry.materials << entry.triangles;
+  journalFile.flush();
+}
+
+bool ReExportSession::reuseObject( const QString& objectID, const QByteArray& hash ) {
+  if ( !active || !inSync || hash.isEmpty() ||
+       resumePosition >= previousEntries.count() )
+  {
+    return false;
+  }
+  const JournalEntry& previous = previousEntries[resumePosition];
+  if (previous.objectID != objectID || previous.hash != hash) {
+    return false;
+  }
+  JournalEntry entry = previous;
+  entry.offset = includeFile.pos();
+
+  bool copied = resumeFile.seek(previous.offset);
+  qint64 remaining = previous.length;
+  while( copied && remaining > 0 ) {
+    QByteArray block = resumeFile.read(qMin<qint64>(remaining, RE_EXPORT_COPY_BLOCK));
+    copied = !block.isEmpty() && includeFile.write(block) == block.size();
+    remaining -= block.size();
+  }
+  if (!copied) {
+    RE_LOG_WARN() << "Could not reuse the data of object " << QSS(objectID)
+                  << " from the interrupted export";
+    // Remove what has been copied, the object will be exported
+    includeFile.resize(entry.offset);
+    includeFile.seek(entry.offset);
+    inSync = false;
+    return false;
+  }
+  resumePosition++;
+  writeJournalEntry(entry);
+
+  progress.objects++;
+  progress.reusedObjects++;
+  progress.materials += entry.materials;
+  progress.triangles += entry.triangles;
+  progress.bytes     += entry.length;
+  return true;
+}
+
+void ReExportSession::beginObject( const QString& objectID, const QByteArray& hash ) {
+  if (!active) {
+    return;
+  }
+  // An object that is exported again with the same content, like the
+  // source of instances, doesn't change what follows it
+  if (inSync) {
+    inSync = !hash.isEmpty() &&
+             resumePosition < previousEntries.count() &&
+             previousEntries[resumePosition].objectID == objectID &&
+             previousEntries[resumePosition].hash == hash;
+    if (inSync) {
+      resumePosition++;
+    }
+  }
+  currentObject = JournalEntry();
+  currentObject.objectID = objectID;
+  currentObject.hash     = hash;
+  currentObject.offset   = includeFile.pos();
+  objectOpen = true;
+}
+
+void ReExportSession::addMaterial( const int numTriangles ) {
+  progress.materials++;
+  progress.triangles += numTriangles;
+  if (objectOpen) {
+    currentObject.materials++;
+    currentObject.triangles += numTriangles;
+  }
+}
+
+void ReExportSession::endObject() {
+  if (!objectOpen) {
+    return;
+  }
+  objectOpen = false;
+  currentObject.length = includeFile.pos() - currentObject.offset;
+  progress.objects++;
+  if (!currentObject.hash.isEmpty()) {
+    writeJournalEntry(currentObject);
+  }
+}
+
+void ReExportSession::closeFiles() {
+  sceneFile.close();
+  includeFile.close();
+  journalFile.close();
+  resumeFile.close();
+  active = false;
+  objectOpen = false;
+}
+
+bool ReExportSession::replaceFile( const QString& tempFileName, const QString& fileName ) {
+  QString backupFileName = fileName + RE_EXPORT_BACKUP_EXT;
+  bool hasBackup = QFile::exists(fileName);
+  if (hasBackup) {
+    QFile::remove(backupFileName);
+    if (!QFile::rename(fileName, backupFileName)) {
+      RE_LOG_WARN() << "Warning: cannot rename " << QSS(fileName)
+                    << " to " << QSS(backupFileName);
+      return false;
+    }
+  }
+  if (!QFile::rename(tempFileName, fileName)) {
+    RE_LOG_WARN() << "Warning: cannot rename " << QSS(tempFileName)
+                  << " to " << QSS(fileName);
+    if (hasBackup && !QFile::rename(backupFileName, fileName)) {
+      RE_LOG_WARN() << "Warning: the previous file is saved as " 
+                    << QSS(backupFileName);
+    }
+    return false;
+  }
+  if (hasBackup) {
+    QFile::remove(backupFileName);
+  }
+  return true;
+}
+
+//! Removes a directory and the files in it
+static bool removeDirectory( const QString& dirName ) {
+  QDir dir(dirName);
+  if (!dir.exists()) {
+    return true;
+  }
+  foreach( QString fileName, dir.entryList(QDir::Files | QDir::Hidden | QDir::System) ) {
+    dir.remove(fileName);
+  }
+  return QDir().rmdir(dirName);
+}
+
+bool ReExportSession::replaceDirectory( const QString& tempDirName, const QString& dirName ) {
+  QDir dir;
+  QString backupDirName = dirName + RE_EXPORT_BACKUP_EXT;
+  bool hasBackup = dir.exists(dirName);
+  if (hasBackup) {
+    removeDirectory(backupDirName);
+    if (!dir.rename(dirName, backupDirName)) {
+      RE_LOG_WARN() << "Warning: cannot rename " << QSS(dirName)
+                    << " to " << QSS(backupDirName);
+      return false;
+    }
+  }
+  if (!dir.rename(tempDirName, dirName)) {
+    RE_LOG_WARN() << "Warning: cannot rename " << QSS(tempDirName)
+                  << " to " << QSS(dirName);
+    if (hasBackup && !dir.rename(backupDirName, dirName)) {
+      RE_LOG_WARN() << "Warning: the previous directory is saved as " 
+                    << QSS(backupDirName);
+    }
+    return false;
+  }
+  if (hasBackup && !removeDirectory(backupDirName)) {
+    RE_LOG_WARN() << "Warning: cannot remove " << QSS(backupDirName);
+  }
+  return true;
+}
+
+bool ReExportSession::commit() {
+  if (!active) {
+    return false;
+  }
+  bool written = sceneFile.error() == QFile::NoError &&
+                 includeFile.error() == QFile::NoError;
+  closeFiles();
+  QFile::remove(includeFileName + RE_EXPORT_RESUME_EXT);
+  if (!written) {
+    RE_LOG_WARN() << "Error while writing the scene " << QSS(sceneFileName)
+                  << ". Rendering aborted";
+    QFile::remove(includeFileName + RE_EXPORT_JOURNAL_EXT);
+    return false;
+  }
+  // The staged files go first, the include file references them
+  foreach( QString dirName, stagedDirs ) {
+    QString stagingDir = getStagingDir(dirName);
+    if (QDir(stagingDir).exists() && !replaceDirectory(stagingDir, dirName)) {
+      return false;
+    }
+  }
+  // The include file goes next, the scene file references it
+  if ( !replaceFile(includeFileName + RE_EXPORT_TEMP_EXT, includeFileName) ||
+       !replaceFile(sceneFileName + RE_EXPORT_TEMP_EXT, sceneFileName) )
+  {
+    return false;
+  }
+  QFile::remove(includeFileName + RE_EXPORT_JOURNAL_EXT);
+  return true;
+}
+
+void ReExportSession::abort() {
+  if (!active) {
+    return;
+  }
+  closeFiles();
+  // The fragments still needed have been copied to the new include file
+  QFile::remove(includeFileName + RE_EXPORT_RESUME_EXT);
+  QFile::remove(sceneFileName + RE_EXPORT_TEMP_EXT);
+  RE_LOG_INFO() << "Export of " << QSS(sceneFileName) << " stopped after "
+                << progress.objects << " objects";
+}
+
+void ReExportSession::requestCancel() {
+  cancelRequested = 1;
+}
+
+bool ReExportSession::isCancelRequested() const {
+  return cancelRequested != 0;
+}
+
+} // namespace
@@ -0,0 +1,262 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#ifndef RE_EXPORT_SESSION_H
+#define RE_EXPORT_SESSION_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+#include <QList>
+#include <QMetaType>
+#include <QString>
+#include <QStringList>
+
+#include "reality_lib_export.h"
+
+
+namespace Reality {
+
+//! Extension of the temporary files written during the export
+#define RE_EXPORT_TEMP_EXT    ".tmp"
+//! Extension of the journal of the objects exported
+#define RE_EXPORT_JOURNAL_EXT ".journal"
+//! Extension of the include file of an interrupted export, while its
+//! data is being reused
+#define RE_EXPORT_RESUME_EXT  ".resume"
+//! Extension of the previous scene files while they are being replaced
+#define RE_EXPORT_BACKUP_EXT  ".bak"
+
+/**
+ * Counters of the data written by an export. They are sent to the GUI
+ * after each object so that the user can see how the export is going.
+ */
+struct ReExportProgress {
+  quint32 objects;
+  //! Objects copied from an interrupted export instead of being exported
+  quint32 reusedObjects;
+  quint32 materials;
+  quint64 triangles;
+  quint64 bytes;
+
+  ReExportProgress() {
+    reset();
+  }
+
+  void reset() {
+    objects       = 0;
+    reusedObjects = 0;
+    materials     = 0;
+    triangles     = 0;
+    bytes         = 0;
+  }
+};
+
+inline QDataStream& operator <<( QDataStream& strm, const ReExportProgress& p ) {
+  strm << p.objects << p.reusedObjects << p.materials << p.triangles << p.bytes;
+  return strm;
+}
+
+inline QDataStream& operator >>( QDataStream& strm, ReExportProgress& p ) {
+  strm >> p.objects >> p.reusedObjects >> p.materials >> p.triangles >> p.bytes;
+  return strm;
+}
+
+/**
+ * An export of the scene to the renderer.
+ *
+ * The scene and include files are written to temporary files, next to the
+ * final ones, and they replace the files of the previous export only when
+ * the export is committed. The directories registered with 
+ * stageDirectory(), like the one of the PLY and hair files, are written
+ * in a staging directory and they are swapped in the same way. Cancelling,
+ * or a failure, leaves the scene, include and geometry files of the
+ * previous export untouched. The textures collected with the scene are
+ * shared by the exports and they are updated in place.
+ *
+ * Every object is written to the include file as one fragment. When the
+ * object is completed the position of the fragment and the hash of the
+ * object's content are appended to a journal. If the export is aborted
+ * the temporary include file and the journal are kept and the next export
+ * of the same scene copies the fragments of the objects that have not
+ * changed, instead of exporting them again.
+ *
+ * Only the objects at the beginning of the export can be reused, up to
+ * the first object that is different from the interrupted export. The
+ * definition of a texture is written only once in the include file, by
+ * the first material that uses it, so a fragment can depend on the
+ * fragments that precede it.
+ */
+class REALITY_LIB_EXPORT ReExportSession {
+
+public:
+  //! An object recorded in the journal
+  struct JournalEntry {
+    QString objectID;
+    QByteArray hash;
+    //! Position of the fragment in the include file
+    qint64 offset;
+    qint64 length;
+    quint32 materials;
+    quint64 triangles;
+
+    JournalEntry() : offset(0), length(0), materials(0), triangles(0) {
+    }
+  };
+
+private:
+  QString sceneFileName;
+  QString includeFileName;
+
+  QFile sceneFile;
+  QFile includeFile;
+  QFile journalFile;
+
+  //! The include file of the interrupted export
+  QFile resumeFile;
+
+  //! Directories replaced by their staging directory on commit
+  QStringList stagedDirs;
+
+  //! The objects completed by the interrupted export, in order
+  QList<JournalEntry> previousEntries;
+
+  //! The scene key of the interrupted export
+  QByteArray previousKey;
+
+  //! Index, in previousEntries, of the next object that can be reused
+  int resumePosition;
+
+  //! False after the first object that differs from the interrupted
+  //! export. From that point on nothing else can be reused.
+  bool inSync;
+
+  //! The object being exported, between beginObject() and endObject()
+  JournalEntry currentObject;
+  bool objectOpen;
+
+  ReExportProgress progress;
+
+  //! Set by requestCancel(), possibly from another thread
+  QAtomicInt cancelRequested;
+
+  bool active;
+
+  //! Loads the journal of an interrupted export
+  bool readJournal();
+
+  void writeJournalEntry( const JournalEntry& entry );
+
+  void closeFiles();
+
+  //! Replaces fileName with the temporary file. The previous file is 
+  //! moved aside first and it's restored if the replacement fails.
+  static bool replaceFile( const QString& tempFileName, const QString& fileName );
+
+  //! Same as replaceFile() for a directory. Only the files directly in
+  //! the directory are removed with it.
+  static bool replaceDirectory( const QString& tempDirName, const QString& dirName );
+
+public:
+
+  ReExportSession();
+  ~ReExportSession();
+
+  //! Starts the export. The temporary files are created and, if there is
+  //! a journal for the include file, the data of the interrupted export
+  //! is prepared for being reused.
+  //! \return false if the temporary files cannot be created
+  bool begin( const QString& sceneFileName, const QString& includeFileName );
+
+  //! Returns true if there is data from an interrupted export that can
+  //! possibly be reused. Valid after begin().
+  inline bool canResume() const {
+    return !previousEntries.isEmpty();
+  }
+
+  /**
+   * Sets the key that identifies the scene settings. It must be called
+   * before the first object is exported. The data of the interrupted
+   * export is discarded if it has been exported with a different key.
+   */
+  void setSceneKey( const QByteArray& key );
+
+  /**
+   * Registers a directory whose files are part of the export. The files
+   * are written to the staging directory returned by getStagingDir() and
+   * they replace the content of dirName when the export is committed. The
+   * staging directory is kept by abort(), the include file of the
+   * interrupted export references its files.
+   */
+  void stageDirectory( const QString& dirName );
+
+  //! Returns the directory where the files for dirName are written during
+  //! the export
+  static QString getStagingDir( const QString& dirName ) {
+    return dirName + RE_EXPORT_TEMP_EXT;
+  }
+
+  qint64 writeScene( const QByteArray& data );
+  qint64 writeInclude( const QByteArray& data );
+
+  /**
+   * Copies the fragment of the object from the interrupted export, if
+   * the object has been completed and its content hasn't changed.
+   * \return true if the object has been copied, in that case the object
+   *         must not be exported.
+   */
+  bool reuseObject( const QString& objectID, const QByteArray& hash );
+
+  //! Starts the fragment of an object. An empty hash means that the
+  //! object cannot be reused by the next export.
+  void beginObject( const QString& objectID, const QByteArray& hash );
+
+  //! Counts a material exported for the current object
+  void addMaterial( const int numTriangles );
+
+  //! Closes the fragment of the object and records it in the journal
+  void endObject();
+
+  //! Replaces the staged directories and the scene and include files with
+  //! the ones just written. The journal is deleted.
+  bool commit();
+
+  //! Stops the export. The scene, include and geometry files of the 
+  //! previous export are left untouched. The journal and the include file just written
+  //! are kept so that the next export can resume from where this one
+  //! stopped.
+  void abort();
+
+  //! Asks the exporter to stop at the next checkpoint. This method can be
+  //! called from any thread.
+  void requestCancel();
+
+  bool isCancelRequested() const;
+
+  inline bool isActive() const {
+    return active;
+  }
+
+  inline const ReExportProgress& getProgress() const {
+    return progress;
+  }
+
+  inline const QString& getSceneFileName() const {
+    return sceneFileName;
+  }
+
+  inline const QString& getIncludeFileName() const {
+    return includeFileName;
+  }
+};
+
+} // namespace
+
+//! Used by the GUI to pass the export progress between threads
+Q_DECLARE_METATYPE(Reality::ReExportProgress)
+
+#endif
@@ -7,7 +7,13 @@
 #ifndef REGEOMETRY_H
 #define REGEOMETRY_H
 
+#include <string.h>
+
 #include <QSharedPointer>
+#include <QVector>
+
+#include "reality_lib_export.h"
+#include "ReDefs.h"
 
 namespace Reality {
 
@@ -26,6 +32,76 @@ union ReTriangle {
 typedef QSharedPointer<ReTriangle> ReTrianglePtr;
 typedef QList<ReTrianglePtr> ReTriangleList;
 
+/**
+ * A copy of the geometry of a material, in arrays owned by the object.
+ * Used by the classes that rebuild the geometry before the export, like
+ * ReMeshRefiner, ReMeshDecimator and ReMeshOptimizer. The result can be
+ * lent to a ReGeometryBuffer with ReGeometryBuffer::lend().
+ */
+class REALITY_LIB_EXPORT ReMeshData {
+
+protected:
+  //! XYZ of each vertex
+  QVector<float> points;
+  //! Normal of each vertex
+  QVector<float> normals;
+  //! UV of each vertex, empty if the mesh has no UVs
+  QVector<float> uvs;
+  //! Three indices per triangle
+  QVector<int> triangles;
+
+public:
+
+  //! Copies the mesh
+  //! \param uvMap Can be NULL if the mesh has no UVs
+  void setMesh( const int numVertices,
+                const ReVectorF* vertices,
+                const ReVectorF* vertexNormals,
+                const ReUVPoint* uvMap,
+                const int numTriangles,
+                const ReTriangle* tris )
+  {
+    points.resize(numVertices*3);
+    normals.resize(numVertices*3);
+    memcpy(points.data(), vertices, sizeof(float) * numVertices * 3);
+    memcpy(normals.data(), vertexNormals, sizeof(float) * numVertices * 3);
+    if (uvMap) {
+      uvs.resize(numVertices*2);
+      memcpy(uvs.data(), uvMap, sizeof(float) * numVertices * 2);
+    }
+    else {
+      uvs.clear();
+    }
+    triangles.resize(numTriangles*3);
+    memcpy(triangles.data(), tris, sizeof(int) * numTriangles * 3);
+  }
+
+  inline int getNumVertices() const {
+    return points.count() / 3;
+  }
+
+  inline int getNumTriangles() const {
+    return triangles.count() / 3;
+  }
+
+  inline ReVectorF* getVertices() {
+    return reinterpret_cast<ReVectorF*>(points.data());
+  }
+
+  inline ReVectorF* getNormals() {
+    return reinterpret_cast<ReVectorF*>(normals.data());
+  }
+
+  //! Returns NULL if the mesh has no UVs
+  inline ReUVPoint* getUVs() {
+    return uvs.isEmpty() ? NULL : reinterpret_cast<ReUVPoint*>(uvs.data());
+  }
+
+  inline ReTriangle* getTriangles() {
+    return reinterpret_cast<ReTriangle*>(triangles.data());
+  }
+};
+
 } // namespace
 
 #endif
@@ -0,0 +1,148 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#include "ReGeometryArena.h"
+
+#include <new>
+
+#include <QDir>
+#include <QTemporaryFile>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include "ReLogger.h"
+
+
+namespace Reality {
+
+//! Default size from which the arena is memory-mapped, 64MB
+#define RE_GEOMETRY_ARENA_MAP_THRESHOLD (64*1024*1024)
+
+//! The arena never shrinks below this size, 1MB, to avoid reallocating
+//! it for every small material at the beginning of the export
+#define RE_GEOMETRY_ARENA_MIN_SIZE      (1024*1024)
+
+ReGeometryArena::ReGeometryArena() :
+  data(NULL),
+  heapBlock(NULL),
+  capacity(0),
+  used(0),
+  backing(Heap),
+  mappingThreshold(RE_GEOMETRY_ARENA_MAP_THRESHOLD),
+  mapFile(NULL)
+{
+}
+
+ReGeometryArena::~ReGeometryArena() {
+  release();
+}
+
+bool ReGeometryArena::allocateBlock( const size_t size ) {
+  if (size < mappingThreshold) {
+    // new[] aligns only at 8 bytes on 32-bit systems
+    heapBlock = new (std::nothrow) char[size + 15];
+    backing = Heap;
+    if (!heapBlock) {
+      return false;
+    }
+    data = reinterpret_cast<char*>(
+      (reinterpret_cast<quintptr>(heapBlock) + 15) & ~static_cast<quintptr>(15)
+    );
+    return true;
+  }
+
+  if (!mappingDir.isEmpty()) {
+    mapFile = new QTemporaryFile(
+      QDir(mappingDir).absoluteFilePath("RealityGeometry-XXXXXX")
+    );
+    if ( mapFile->open() && mapFile->resize(size) ) {
+      data = reinterpret_cast<char*>(mapFile->map(0, size));
+    }
+    if (data) {
+      backing = FileMap;
+      return true;
+    }
+    RE_LOG_WARN() << "Could not map the geometry buffer to a file in "
+                  << QSS(mappingDir) << ", using an anonymous mapping";
+    delete mapFile;
+    mapFile = NULL;
+  }
+
+#if defined(_WIN32)
+  data = reinterpret_cast<char*>(
+    VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE)
+  );
+#else
+  void* block = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+  data = block == MAP_FAILED ? NULL : reinterpret_cast<char*>(block);
+#endif
+  backing = AnonymousMap;
+  return data != NULL;
+}
+
+bool ReGeometryArena::reserve( const size_t size ) {
+  used = 0;
+  if (size <= capacity) {
+    return true;
+  }
+  size_t newCapacity = qMax<size_t>(capacity * 2, RE_GEOMETRY_ARENA_MIN_SIZE);
+  while( newCapacity < size ) {
+    newCapacity *= 2;
+  }
+  release();
+  if (!allocateBlock(newCapacity)) {
+    RE_LOG_WARN() << "Could not allocate " << newCapacity
+                  << " bytes for the geometry buffer";
+    release();
+    return false;
+  }
+  capacity = newCapacity;
+  return true;
+}
+
+void* ReGeometryArena::allocate( const size_t size ) {
+  size_t blockSize = alignedSize(size);
+  if (used + blockSize > capacity) {
+    return NULL;
+  }
+  void* block = data + used;
+  used += blockSize;
+  return block;
+}
+
+void ReGeometryArena::release() {
+  if (data) {
+    switch(backing) {
+      case Heap:
+        delete[] heapBlock;
+        break;
+      case AnonymousMap:
+#if defined(_WIN32)
+        VirtualFree(data, 0, MEM_RELEASE);
+#else
+        munmap(data, capacity);
+#endif
+        break;
+      case FileMap:
+        mapFile->unmap(reinterpret_cast<uchar*>(data));
+        break;
+    }
+  }
+  // Deleting the temporary file removes it from disk
+  delete mapFile;
+  mapFile   = NULL;
+  data      = NULL;
+  heapBlock = NULL;
+  capacity = 0;
+  used     = 0;
+  backing  = Heap;
+}
+
+} // namespace
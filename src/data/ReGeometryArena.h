@@ -0,0 +1,130 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#ifndef RE_GEOMETRY_ARENA_H
+#define RE_GEOMETRY_ARENA_H
+
+#include <stddef.h>
+
+#include <QString>
+
+#include "reality_lib_export.h"
+
+class QTemporaryFile;
+
+namespace Reality {
+
+/**
+ * A block of memory used to store the geometry of the materials during
+ * the export.
+ *
+ * The export used to allocate, and free, the arrays of vertices, normals,
+ * UVs and triangles for every material. With thousands of materials that
+ * fragments the heap of the host app. The arena is instead allocated once
+ * and reused for all the materials. When a material needs more space the
+ * arena grows geometrically, so it's reallocated only a few times during
+ * an export.
+ *
+ * Arenas larger than the mapping threshold are allocated with an
+ * anonymous memory mapping, outside of the heap, or with a mapping of a
+ * temporary file if a mapping directory has been set. The file-backed
+ * mapping lets the OS page the geometry of very large meshes to disk
+ * instead of exhausting the memory of the host.
+ */
+class REALITY_LIB_EXPORT ReGeometryArena {
+
+public:
+  enum Backing {
+    Heap,
+    AnonymousMap,
+    FileMap
+  };
+
+private:
+  char* data;
+  //! The block returned by new[] for the heap backing. data is this
+  //! pointer aligned at 16 bytes.
+  char* heapBlock;
+  size_t capacity;
+  size_t used;
+  Backing backing;
+
+  //! Arenas of this size, or larger, are memory-mapped
+  size_t mappingThreshold;
+
+  //! If set, large arenas are mapped to temporary files in this directory
+  QString mappingDir;
+
+  QTemporaryFile* mapFile;
+
+  //! Allocates the block using the backing selected for its size
+  bool allocateBlock( const size_t size );
+
+  // The arena owns its memory, it cannot be copied
+  ReGeometryArena( const ReGeometryArena& );
+  ReGeometryArena& operator =( const ReGeometryArena& );
+
+public:
+
+  ReGeometryArena();
+  ~ReGeometryArena();
+
+  /**
+   * Makes sure that the arena can store at least size bytes. The content
+   * of the arena is discarded. The capacity is at least doubled every time
+   * the arena needs to grow.
+   * \return false if the memory could not be allocated
+   */
+  bool reserve( const size_t size );
+
+  //! Returns a block of size bytes, aligned at 16 bytes. The space must
+  //! have been reserved with reserve(). Returns NULL if the arena is full.
+  void* allocate( const size_t size );
+
+  //! Makes all the space of the arena available again, without freeing it
+  inline void clear() {
+    used = 0;
+  }
+
+  //! Frees the memory of the arena
+  void release();
+
+  //! Returns the number of bytes needed to store size bytes with
+  //! allocate(), including the alignment
+  static inline size_t alignedSize( const size_t size ) {
+    return (size + 15) & ~static_cast<size_t>(15);
+  }
+
+  inline size_t getCapacity() const {
+    return capacity;
+  }
+
+  inline Backing getBacking() const {
+    return backing;
+  }
+
+  inline size_t getMappingThreshold() const {
+    return mappingThreshold;
+  }
+
+  void setMappingThreshold( const size_t bytes ) {
+    mappingThreshold = bytes;
+  }
+
+  inline const QString& getMappingDir() const {
+    return mappingDir;
+  }
+
+  //! Sets the directory for the file-backed mappings. If empty, the large
+  //! arenas use an anonymous mapping.
+  void setMappingDir( const QString& dirName ) {
+    mappingDir = dirName;
+  }
+};
+
+} // namespace
+
+#endif
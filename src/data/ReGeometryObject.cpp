@@ -7,7 +7,7 @@
 #include "ReGeometryObject.h"
 
 #include <QJson/Parser>
-#include <QJson/Serializer>
+#include <QMutexLocker>
 
 #include "ReAcsel.h"
 #include "ReCloth.h"
@@ -41,7 +41,10 @@
 
 using namespace Reality;
 
-QString ReGeometryObject::computeAcselID( const QString& matID, 
+QMutex ReGeometryObject::conversionLock;
+
+QString ReGeometryObject::computeAcselID( const ReMaterialInfo& matInfo,
+                                          const QString& matID, 
                                           const bool forDefaultShader ) 
 {
   QStringList textures;
@@ -71,11 +74,7 @@ void storeOriginalShader( const QString& objID,
                           const QString& matName,
                           const QVariantMap& mat ) 
 {
-  QString matDef;
-  QJson::Serializer toJson;
-  ReAcsel::getInstance()->storeOriginalShader(
-    objID, matName, toJson.serialize(mat)
-  );
+  ReAcsel::getInstance()->storeOriginalShader(objID, matName, mat);
 }
 
 ReGeometryObject::ReGeometryObject( const QString name, 
@@ -233,7 +232,8 @@ ReColorMathPtr combineTextures( const QString& texName,
 }
 */
 
-ReTexturePtr ReGeometryObject::convertSpecular( const QVariantMap& specData,
+ReTexturePtr ReGeometryObject::convertSpecular( ReNodeConverter& nodeConverter,
+                                                const QVariantMap& specData,
                                                 const QString& matID,
                                                 const QString& suffix ) 
 {
@@ -242,7 +242,7 @@ ReTexturePtr ReGeometryObject::convertSpecular( const QVariantMap& specData,
   ReTexturePtr specularMap;
 
   if (mapStr != "") {
-    ReTexturePtr specularTmp = ReNodeConverter::convertNode(
+    ReTexturePtr specularTmp = nodeConverter.convertNode(
                                  mapStr, ReNodeConverter::ColorNode
                                );
     // Specular maps must have linear gamma
@@ -262,7 +262,7 @@ ReTexturePtr ReGeometryObject::convertSpecular( const QVariantMap& specData,
                                        specularColor,
                                        specularTmp
                                      ));
-      // ReNodeConverter::addNode(specularMap);
+      // nodeConverter.addNode(specularMap);
     }
     else {
       // if the specular map is a constant color, test if that color is too
@@ -288,7 +288,7 @@ ReTexturePtr ReGeometryObject::convertSpecular( const QVariantMap& specData,
                                      specularColor
                                    ));
   }
-  ReNodeConverter::addNode(specularMap);
+  nodeConverter.addNode(specularMap);
   return specularMap;
 }
 
@@ -315,10 +315,20 @@ ReMaterialPtr ReGeometryObject::convertMaterial( const QString matID,
 ReMaterialPtr ReGeometryObject::convertMaterial( const QString matID, 
                                                  const QVariantMap& srcMat,
                                                  const ReMaterialType materialType )
+{
+  ReMaterialConversionContext context;
+  return convertMaterial(context, matID, srcMat, materialType);
+}
+
+ReMaterialPtr ReGeometryObject::convertMaterial( ReMaterialConversionContext& context,
+                                                 const QString matID, 
+                                                 const QVariantMap& srcMat,
+                                                 const ReMaterialType materialType )
 {
   // Is this object a mesh light? The light flag can be enabled by the
   // <addObject> method if the object name begins with "RealityLight"
   if ( isLightFlag || matID.startsWith(REALITY_LIGHT_PREFIX) ) {
+    QMutexLocker locker(&conversionLock);
     ReLightMaterialPtr matPtr = ReLightMaterialPtr( new ReLightMaterial(matID, this) );
     // We don't want to make it possible to return the meshlight to a material,
     // it makes no sense.
@@ -326,12 +336,12 @@ ReMaterialPtr ReGeometryObject::convertMaterial( const QString matID,
     return matPtr;    
   }
   // Reset all the maps to a clean state
-  matInfo.init();
+  context.init(srcMat[RE_MAT_KEY_NODES_ROOT].toMap());
+  ReMaterialInfo& matInfo = context.matInfo;
+  ReNodeConverter& nodeConverter = context.nodeConverter;
 
   matInfo.shaderSource = srcMat["source"].toString();
 
-  ReNodeConverter::init(srcMat[RE_MAT_KEY_NODES_ROOT].toMap());
-
   // Gather the colors first
   matInfo.diffuseColor      = convertFloatColor(
                                 srcMat[RE_MAT_KEY_DIFFUSE].toMap()["color"].toList()
@@ -367,7 +377,7 @@ ReMaterialPtr ReGeometryObject::convertMaterial( const QString matID,
   // Now let's build the texture network from the nodes that have been converted
   QString mapStr = srcMat[RE_MAT_KEY_DIFFUSE].toMap()["map"].toString();
   if (mapStr != "") {
-    ReTexturePtr diffuseTmp = ReNodeConverter::convertNode(mapStr, ReNodeConverter::ColorNode);
+    ReTexturePtr diffuseTmp = nodeConverter.convertNode(mapStr, ReNodeConverter::ColorNode);
     // Make sure that we use gain at 1.0 for human figures textures
     if (isHumanFigure) {
       auto skinMap = findImageMapTexture(diffuseTmp);
@@ -409,7 +419,7 @@ ReMaterialPtr ReGeometryObject::convertMaterial( const QString matID,
   mapStr = srcMat[RE_MAT_KEY_DIFFUSE2].toMap()["map"].toString();
   if (mapStr != "") {
     // If the Alternate Diffuse input is present we add it to the diffuse node
-    ReTexturePtr d2Tmp = ReNodeConverter::convertNode(mapStr, ReNodeConverter::ColorNode);
+    ReTexturePtr d2Tmp = nodeConverter.convertNode(mapStr, ReNodeConverter::ColorNode);
     // Make sure that we use gain at 1.0 for human figures textures
     if (isHumanFigure) {
       auto skinMap = findImageMapTexture(d2Tmp);
@@ -500,13 +510,13 @@ ReMaterialPtr ReGeometryObject::convertMaterial( const QString matID,
     matInfo.vGlossiness = RE_MIN_GLOSSINESS;
   }
 
-  auto specularTex = convertSpecular(srcMat[RE_MAT_KEY_SPECULAR].toMap(), matID,"1");
+  auto specularTex = convertSpecular(nodeConverter, srcMat[RE_MAT_KEY_SPECULAR].toMap(), matID,"1");
   // Should we use the specular map or specular 2?
   QVariantMap spec2 = srcMat[RE_MAT_KEY_SPECULAR2].toMap();
   QColor spec2Clr = convertFloatColor(spec2["color"].toList());
   ReTexturePtr specular2Tex;
   if ( spec2.value("map") != "" || !isColorBlack(spec2Clr) ) {
-    specular2Tex = convertSpecular(spec2, matID,"2");
+    specular2Tex = convertSpecular(nodeConverter, spec2, matID,"2");
     matInfo.specularMap = ReColorMathPtr( 
                             new Reality::ReColorMath(
                                   QString("%1_CombinedSpec").arg(matID), 
@@ -523,14 +533,14 @@ ReMaterialPtr ReGeometryObject::convertMaterial( const QString matID,
 
   // Convert the glossiness strength
   if (!glossTex.isEmpty()) {
-    matInfo.glossinessMap = ReNodeConverter::convertNode(glossTex, ReNodeConverter::NumericNode);
-    ReNodeConverter::addNode(matInfo.glossinessMap);
+    matInfo.glossinessMap = nodeConverter.convertNode(glossTex, ReNodeConverter::NumericNode);
+    nodeConverter.addNode(matInfo.glossinessMap);
   }
 
   // Coat layer
   mapStr = srcMat[RE_MAT_KEY_COAT].toMap()["map"].toString();
   if (mapStr != "") {
-    auto tmpCoat = ReNodeConverter::convertNode(
+    auto tmpCoat = nodeConverter.convertNode(
                      mapStr, ReNodeConverter::NumericNode, true
                    );
     tmpCoat->setTextureDataType(ReTexture::color);
@@ -549,7 +559,7 @@ ReMaterialPtr ReGeometryObject::convertMaterial( const QString matID,
     else {
       matInfo.coatMap = tmpCoat;
     }
-    // ReNodeConverter::addNode(matInfo.coatMap);
+    // nodeConverter.addNode(matInfo.coatMap);
   }
   else {
     matInfo.coatMap = ReTexturePtr(new Reality::ReConstant(
@@ -567,7 +577,7 @@ ReMaterialPtr ReGeometryObject::convertMaterial( const QString matID,
   if (matInfo.translucenceEnabled) {    
     mapStr = translucenceData["map"].toString();
     if (mapStr != "") {
-      auto tmpTrans = ReNodeConverter::convertNode(
+      auto tmpTrans = nodeConverter.convertNode(
                        mapStr, ReNodeConverter::NumericNode, true
                      );
       tmpTrans->setTextureDataType(ReTexture::color);
@@ -586,7 +596,7 @@ ReMaterialPtr ReGeometryObject::convertMaterial( const QString matID,
       else {
         matInfo.translucenceMap = tmpTrans;
       }
-      // ReNodeConverter::addNode(matInfo.translucenceMap);
+      // nodeConverter.addNode(matInfo.translucenceMap);
     }
     else {
       matInfo.translucenceMap = ReTexturePtr(new Reality::ReConstant(
@@ -603,9 +613,9 @@ ReMaterialPtr ReGeometryObject::convertMaterial( const QString matID,
   matInfo.alphaStrength = srcMat[RE_MAT_KEY_ALPHA].toMap()["strength"].toDouble();
   if (mapStr != "") {
     // True third parameter makes the texture unique, not shared
-    matInfo.alphaMap = ReNodeConverter::convertNode(mapStr, ReNodeConverter::NumericNode, true);
+    matInfo.alphaMap = nodeConverter.convertNode(mapStr, ReNodeConverter::NumericNode, true);
     matInfo.alphaMap->setTextureDataType(ReTexture::numeric);
-    ReNodeConverter::addNode(matInfo.alphaMap);
+    nodeConverter.addNode(matInfo.alphaMap);
   }
 
   // Bump map
@@ -613,23 +623,23 @@ ReMaterialPtr ReGeometryObject::convertMaterial( const QString matID,
   mapStr = tmpMap["map"].toString();
   if (mapStr != "") {
     // True third parameter makes the texture unique, not shared
-    matInfo.bumpMap = ReNodeConverter::convertNode(
+    matInfo.bumpMap = nodeConverter.convertNode(
       mapStr, ReNodeConverter::NumericNode, true
     );
     matInfo.bmStrength = tmpMap["strength"].toDouble();
     matInfo.bmPositive = tmpMap["pos"].toDouble();
     matInfo.bmNegative = tmpMap["neg"].toDouble();
-    ReNodeConverter::addNode(matInfo.bumpMap);
+    nodeConverter.addNode(matInfo.bumpMap);
   }
   // Displacement map
   tmpMap = srcMat[RE_MAT_KEY_DISPLACEMENT].toMap();
   mapStr = tmpMap["map"].toString();
   if (mapStr != "") {
-    matInfo.displacementMap = ReNodeConverter::convertNode(mapStr, ReNodeConverter::NumericNode);
+    matInfo.displacementMap = nodeConverter.convertNode(mapStr, ReNodeConverter::NumericNode);
     matInfo.dmStrength = tmpMap["strength"].toDouble();
     matInfo.dmPositive = tmpMap["pos"].toDouble();
     matInfo.dmNegative = tmpMap["neg"].toDouble();
-    ReNodeConverter::addNode(matInfo.displacementMap);
+    nodeConverter.addNode(matInfo.displacementMap);
   }
 
   // Ambient settings
@@ -647,7 +657,7 @@ ReMaterialPtr ReGeometryObject::convertMaterial( const QString matID,
     // for Reality/Lux because it doesn't work well. The texture from Diffuse
     // is used for the emission.
     if (mapStr != "") {
-      ReTexturePtr tmpTex = ReNodeConverter::convertNode(mapStr, ReNodeConverter::ColorNode);
+      ReTexturePtr tmpTex = nodeConverter.convertNode(mapStr, ReNodeConverter::ColorNode);
 
       // We use a ColorMath node because it has a built-in multiplication
       // of a color with another texture, similarly to what is in Poser
@@ -659,19 +669,23 @@ ReMaterialPtr ReGeometryObject::convertMaterial( const QString matID,
                                             )
                             );
       matInfo.ambientMap->setNamedValue("function", ReColorMath::none);
-      ReNodeConverter::addNode(matInfo.ambientMap);
+      nodeConverter.addNode(matInfo.ambientMap);
     }
   }
 
   /*
    * Here is where we create the actual materials
    */
+  // Everything up to this point uses only the context. ACSEL and the 
+  // scene data are shared by all the conversions so the creation of the
+  // material is serialized.
+  QMutexLocker locker(&conversionLock);
   // This call must be executed before createMaterial() because the 
-  // original shader data must be in the database before createMaterial() can do 
-  // its job.
+  // original shader data must be stored in ACSEL before createMaterial() 
+  // can do its job. The write to the database is deferred by ACSEL.
   storeOriginalShader(getInternalName(), matID, srcMat);
   ReMaterialPtr matPtr;
-  createMaterial(matID, matPtr, materialType);
+  createMaterial(matInfo, matID, matPtr, materialType);
 
   return matPtr;
 }
@@ -726,6 +740,7 @@ void setModifiers( ReModifiedMaterial* mat, ReMaterialInfo& matInfo ) {
 }
 
 ReMaterialType ReGeometryObject::createMaterialFromAcselShader( 
+                 ReMaterialInfo& matInfo,
                  const QString& matID, 
                  ReMaterialPtr& matPtr 
                )
@@ -735,13 +750,13 @@ ReMaterialType ReGeometryObject::createMaterialFromAcselShader(
   // Get the reference to ACSEL
   ReAcsel* acsel = ReAcsel::getInstance();
   // Get the ACSEL ID based on all the textures used... 
-  QString acselID = computeAcselID(matID, false);
+  QString acselID = computeAcselID(matInfo, matID, false);
   matInfo.acselID = acselID;
 
   QVariantMap shaderInfo;
   if (!acsel->findShader( acselID, shaderInfo ) ) {
     // Then try to find a generic shader
-    QString defaultAcselID = computeAcselID(matID, true);
+    QString defaultAcselID = computeAcselID(matInfo, matID, true);
     if (!acsel->findShader( defaultAcselID, shaderInfo ) ) {
       return MatUndefined;
     }
@@ -861,7 +876,8 @@ void changeTextureGain( ReTexturePtr t ) {
   t->setNamedValue("gain", 1.1);
 }
 
-void ReGeometryObject::createMaterial( const QString matID, 
+void ReGeometryObject::createMaterial( ReMaterialInfo& matInfo,
+                                       const QString matID, 
                                        ReMaterialPtr& matPtr,
                                        const ReMaterialType materialType ) 
 {
@@ -887,7 +903,7 @@ void ReGeometryObject::createMaterial( const QString matID,
     // the opportunity to override whatever conversion hint was found
     // before, if an ACSEL shader is available.
     ReMaterialType axlMatClass;
-    if ( (axlMatClass = createMaterialFromAcselShader(matID, matPtr)) != MatUndefined ) {
+    if ( (axlMatClass = createMaterialFromAcselShader(matInfo, matID, matPtr)) != MatUndefined ) {
       matClass = axlMatClass;
       // If the material has been created from an ACSEL shader then 
       // we are done. Get outta here!
@@ -1179,6 +1195,14 @@ void ReGeometryObject::addMaterial( const QString matID, const QString srcMat) {
 
 void ReGeometryObject::addMaterial( const QString matID, 
                                     const QVariantMap& srcMat) 
+{
+  ReMaterialConversionContext context;
+  addMaterial(context, matID, srcMat);
+}
+
+void ReGeometryObject::addMaterial( ReMaterialConversionContext& context,
+                                    const QString matID, 
+                                    const QVariantMap& srcMat )
 {
   if (materials.contains(matID)) {
     RE_LOG_INFO() << QString("Material %1/%2 already existing. Addition skipped.")
@@ -1186,7 +1210,7 @@ void ReGeometryObject::addMaterial( const QString matID,
                        .arg(matID).toStdString();
     return;
   }
-  ReMaterialPtr newMat = convertMaterial(matID, srcMat);
+  ReMaterialPtr newMat = convertMaterial(context, matID, srcMat);
   if (newMat.isNull()) {
     RE_LOG_WARN() << "Error: material " << matID.toStdString() << " could not be converted";
     return;
@@ -1195,6 +1219,7 @@ void ReGeometryObject::addMaterial( const QString matID,
   // If this is a material converted to light then we need to add it to the list
   // of lights as well
   if (newMat->getType() == MatLight) {
+    QMutexLocker locker(&conversionLock);
     lights->insert(matID, newMat);
     ReLightPtr matLight = newMat.staticCast<ReLightMaterial>()->getLight();
     // Add the light to the list of lights of the scene
@@ -10,6 +10,7 @@
 #define REGEOMETRY_OBJECT_H
 
 #include <QHash>
+#include <QMutex>
 #include <QSharedPointer>
 #include <QVariantMap>
 
@@ -17,6 +18,7 @@
 #include "ReDefs.h"
 #include "ReLightMaterial.h"
 #include "ReLogger.h"
+#include "ReNodeConverter.h"
 
 namespace Reality {
   class ReGlossy;
@@ -188,6 +190,29 @@ public:
   */
 };
 
+/**
+ * The state of the conversion of one material: the table of nodes received
+ * from the host, the textures converted so far and the information gathered
+ * for the creation of the material.
+ *
+ * The conversion doesn't use any global state besides ACSEL and the scene
+ * data, which are accessed only when the material is created. A thread
+ * that uses its own context can then convert materials at the same time
+ * as other threads. See \ref ReMaterialBatchConverter.
+ */
+class ReMaterialConversionContext {
+
+public:
+  ReMaterialInfo matInfo;
+  ReNodeConverter nodeConverter;
+
+  //! Resets the context at the beginning of the conversion of a material
+  void init( const QVariantMap& nodes ) {
+    matInfo.init();
+    nodeConverter.init(nodes);
+  }
+};
+
 
 //! A smart pointer to a ReGeometryObject. Used for garbage collection.
 typedef QSharedPointer<ReGeometryObject> ReGeometryObjectPtr;
@@ -376,18 +401,33 @@ protected:
   ReMaterialPtr convertMaterial( const QString matID, 
                                  const QVariantMap& srcMat,
                                  ReMaterialType materialType = MatUndefined );
-  ReMaterialInfo matInfo;
+
+  //! Overloaded version that uses the conversion context passed by the
+  //! caller. This version can be called by several threads at the same
+  //! time as long as each thread uses its own context and no two threads
+  //! convert materials of the same object.
+  ReMaterialPtr convertMaterial( ReMaterialConversionContext& context,
+                                 const QString matID, 
+                                 const QVariantMap& srcMat,
+                                 ReMaterialType materialType = MatUndefined );
 
   //! Returns the ACSEL ID for a material based on the textures present
+  //! \param matInfo The data gathered by the conversion of the material
   //! \param matID The ID of the material for which we need the ACSEL ID
   //! \param forDefaultShader If this parameter is set to true the
   //!                         ID returned is for the default shader
-  QString computeAcselID( const QString& matID, 
+  QString computeAcselID( const ReMaterialInfo& matInfo,
+                          const QString& matID, 
                           const bool forDefaultShader = false );
 
 private:
 
-  void createMaterial( const QString matID, 
+  //! Serializes the access to ACSEL and to the scene data by the
+  //! material conversions running in parallel
+  static QMutex conversionLock;
+
+  void createMaterial( ReMaterialInfo& matInfo,
+                       const QString matID, 
                        ReMaterialPtr& matPtr, 
                        const ReMaterialType materialType = MatUndefined);
 
@@ -401,7 +441,8 @@ private:
    * \return A ReMaterialType set to a valid material type if an ACSEL 
    *         shader was found. Otherwise the value is set to MatUndefined
    */
-  ReMaterialType createMaterialFromAcselShader( const QString& matID, 
+  ReMaterialType createMaterialFromAcselShader( ReMaterialInfo& matInfo,
+                                                const QString& matID, 
                                                 ReMaterialPtr& matPtr );
 
   //! Removes the light materials from the scene
@@ -415,12 +456,14 @@ private:
   //! combine them via multiplication.
   //! This method is used to perform the same conversion on both "specular"
   //! and "specular 2" dictionaries. 
+  //! \param nodeConverter The converter for the nodes of the material
   //! \param specData A QVariantMap that holds the material data from the
   //!                 host.
   //! \param matID The ID of the material being processed.
   //! \param suffix A string to make the ID of the textures created unique.
   //! \return A texture corresponding to the data in input.
-  ReTexturePtr convertSpecular( const QVariantMap& specData, 
+  ReTexturePtr convertSpecular( ReNodeConverter& nodeConverter,
+                                const QVariantMap& specData, 
                                 const QString& matID,
                                 const QString& suffix );
 
@@ -488,6 +531,11 @@ public:
   void addMaterial( const QString matID, const QString srcMat);
   //! Overloaded version
   void addMaterial( const QString matID, const QVariantMap& srcMat);
+  //! Overloaded version that uses the conversion context passed by the
+  //! caller. See \ref convertMaterial() for the rules about threads.
+  void addMaterial( ReMaterialConversionContext& context,
+                    const QString matID, 
+                    const QVariantMap& srcMat );
   
   inline void addMaterial( const QString matGUID, ReMaterialPtr newMat) {
     materials[matGUID] = newMat;
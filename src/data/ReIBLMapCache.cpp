@@ -0,0 +1,612 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#include "ReIBLMapCache.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+
+#include "ReDataDir.h"
+#include "ReLogger.h"
+#include "ReProfiler.h"
+#include "ReTextureInfoCache.h"
+
+
+namespace Reality {
+
+#define RE_IBL_CACHE_DIR     "IBLCache"
+//! Size of the buffer used to read the HDR files
+#define RE_HDR_READ_BUFFER   65536
+
+ReIBLMapCache* ReIBLMapCache::instance = NULL;
+
+/*
+ * Radiance RGBE support
+ */
+
+//! Buffered reader of the bytes of a file. Reading the RLE scanlines
+//! one byte at the time from QFile would be very slow.
+class ReByteReader {
+  QFile& file;
+  QByteArray buffer;
+  int pos;
+
+public:
+  ReByteReader( QFile& file ) : file(file), pos(0) {
+  }
+
+  inline bool getByte( uchar& c ) {
+    if (pos >= buffer.size()) {
+      buffer = file.read(RE_HDR_READ_BUFFER);
+      pos = 0;
+      if (buffer.isEmpty()) {
+        return false;
+      }
+    }
+    c = static_cast<uchar>(buffer.at(pos++));
+    return true;
+  }
+
+  inline bool read( uchar* dst, const int count ) {
+    for (int i = 0; i < count; i++) {
+      if (!getByte(dst[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  //! Reads a line of text, without the newline
+  bool readLine( QByteArray& line ) {
+    line.clear();
+    uchar c;
+    while( getByte(c) ) {
+      if (c == '\n') {
+        return true;
+      }
+      line.append(static_cast<char>(c));
+      // A header line is never this long, this is not an HDR file
+      if (line.size() > 1024) {
+        return false;
+      }
+    }
+    return false;
+  }
+};
+
+static inline void rgbeToFloat( const uchar* rgbe, float* rgb ) {
+  if (rgbe[3] == 0) {
+    rgb[0] = rgb[1] = rgb[2] = 0.0f;
+    return;
+  }
+  float f = ldexp(1.0, rgbe[3]-(128+8));
+  rgb[0] = rgbe[0] * f;
+  rgb[1] = rgbe[1] * f;
+  rgb[2] = rgbe[2] * f;
+}
+
+static inline void floatToRGBE( const float* rgb, uchar* rgbe ) {
+  float v = qMax(rgb[0], qMax(rgb[1], rgb[2]));
+  if (v < 1e-32) {
+    rgbe[0] = rgbe[1] = rgbe[2] = rgbe[3] = 0;
+    return;
+  }
+  int e;
+  v = frexp(v, &e) * 256.0 / v;
+  rgbe[0] = static_cast<uchar>(qMax(0.0f, rgb[0]) * v);
+  rgbe[1] = static_cast<uchar>(qMax(0.0f, rgb[1]) * v);
+  rgbe[2] = static_cast<uchar>(qMax(0.0f, rgb[2]) * v);
+  rgbe[3] = static_cast<uchar>(e + 128);
+}
+
+//! Reads the header of an HDR file, up to and including the resolution line
+static bool readHDRHeader( ReByteReader& reader, int& width, int& height ) {
+  QByteArray line;
+  if (!reader.readLine(line) || !line.startsWith("#?")) {
+    return false;
+  }
+  // Header variables, terminated by an empty line
+  while( true ) {
+    if (!reader.readLine(line)) {
+      return false;
+    }
+    if (line.isEmpty()) {
+      break;
+    }
+    if (line.startsWith("FORMAT=") && line != "FORMAT=32-bit_rle_rgbe") {
+      return false;
+    }
+  }
+  if (!reader.readLine(line)) {
+    return false;
+  }
+  QList<QByteArray> res = line.simplified().split(' ');
+  if (res.count() != 4 || res[0] != "-Y" || res[2] != "+X") {
+    return false;
+  }
+  bool okH, okW;
+  height = res[1].toInt(&okH);
+  width  = res[3].toInt(&okW);
+  return okH && okW && width > 0 && height > 0;
+}
+
+//! Reads one scanline, in RGBE format
+static bool readHDRScanline( ReByteReader& reader,
+                             const int width,
+                             QVector<uchar>& scanline )
+{
+  uchar* data = scanline.data();
+  if (!reader.read(data, 4)) {
+    return false;
+  }
+  // Flat scanline
+  if (width < 8 || width > 0x7fff || data[0] != 2 || data[1] != 2 || (data[2] & 0x80)) {
+    // Old-style RLE is not supported
+    if (data[0] == 1 && data[1] == 1 && data[2] == 1) {
+      return false;
+    }
+    return reader.read(data+4, (width-1)*4);
+  }
+  if (((data[2] << 8) | data[3]) != width) {
+    return false;
+  }
+  // New RLE scanline, the four components are stored one after the other
+  QVector<uchar> component(width);
+  for (int c = 0; c < 4; c++) {
+    int x = 0;
+    while( x < width ) {
+      uchar count;
+      if (!reader.getByte(count)) {
+        return false;
+      }
+      if (count > 128) {
+        count -= 128;
+        uchar value;
+        if (count > width-x || !reader.getByte(value)) {
+          return false;
+        }
+        memset(component.data()+x, value, count);
+      }
+      else {
+        if (count == 0 || count > width-x || !reader.read(component.data()+x, count)) {
+          return false;
+        }
+      }
+      x += count;
+    }
+    for (int i = 0; i < width; i++) {
+      data[i*4+c] = component[i];
+    }
+  }
+  return true;
+}
+
+//! Encodes one component of a scanline with the RLE scheme of the
+//! Radiance files
+static void encodeHDRComponent( const uchar* data, const int n, QByteArray& out ) {
+  int cur = 0;
+  while( cur < n ) {
+    // Find the next run of at least four identical bytes
+    int begRun = cur;
+    int runCount = 0;
+    int oldRunCount = 0;
+    while( runCount < 4 && begRun < n ) {
+      begRun += runCount;
+      oldRunCount = runCount;
+      runCount = 1;
+      while( begRun+runCount < n && runCount < 127 &&
+             data[begRun] == data[begRun+runCount] )
+      {
+        runCount++;
+      }
+    }
+    // A short run just before the long one is cheaper as a run
+    if (oldRunCount > 1 && oldRunCount == begRun-cur) {
+      out.append(static_cast<char>(128+oldRunCount));
+      out.append(static_cast<char>(data[cur]));
+      cur = begRun;
+    }
+    // Literal bytes up to the start of the run
+    while( cur < begRun ) {
+      int nonRun = qMin(128, begRun-cur);
+      out.append(static_cast<char>(nonRun));
+      out.append(reinterpret_cast<const char*>(data+cur), nonRun);
+      cur += nonRun;
+    }
+    if (runCount >= 4) {
+      out.append(static_cast<char>(128+runCount));
+      out.append(static_cast<char>(data[begRun]));
+      cur += runCount;
+    }
+  }
+}
+
+bool ReIBLMapCache::readRadianceHDRSize( const QString& fileName, int& width, int& height ) {
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  ReByteReader reader(file);
+  return readHDRHeader(reader, width, height);
+}
+
+bool ReIBLMapCache::readRadianceHDR( const QString& fileName,
+                                     FloatImage& image,
+                                     const int maxWidth )
+{
+  RE_PROFILE_SCOPE("readRadianceHDR");
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  ReByteReader reader(file);
+  int srcWidth, srcHeight;
+  if (!readHDRHeader(reader, srcWidth, srcHeight)) {
+    return false;
+  }
+
+  // The image is reduced with a box filter while reading, one scanline at
+  // the time, so that the original image is never kept in memory.
+  int width = srcWidth, height = srcHeight;
+  if (maxWidth > 0 && srcWidth > maxWidth) {
+    width  = maxWidth;
+    height = qMax(1, qRound(static_cast<double>(srcHeight) * width / srcWidth));
+  }
+  image.resize(width, height);
+
+  QVector<int> colMap(srcWidth);
+  QVector<int> colCount(width, 0);
+  for (int x = 0; x < srcWidth; x++) {
+    colMap[x] = static_cast<int>(static_cast<qint64>(x) * width / srcWidth);
+    colCount[colMap[x]]++;
+  }
+  QVector<int> rowCount(height, 0);
+
+  QVector<uchar> scanline(srcWidth*4);
+  float rgb[3];
+  for (int y = 0; y < srcHeight; y++) {
+    if (!readHDRScanline(reader, srcWidth, scanline)) {
+      return false;
+    }
+    int ty = static_cast<int>(static_cast<qint64>(y) * height / srcHeight);
+    rowCount[ty]++;
+    const uchar* rgbe = scanline.constData();
+    for (int x = 0; x < srcWidth; x++, rgbe += 4) {
+      rgbeToFloat(rgbe, rgb);
+      float* dst = image.pixel(colMap[x], ty);
+      dst[0] += rgb[0];
+      dst[1] += rgb[1];
+      dst[2] += rgb[2];
+    }
+  }
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      float w = 1.0f / (rowCount[y] * colCount[x]);
+      float* p = image.pixel(x, y);
+      p[0] *= w;
+      p[1] *= w;
+      p[2] *= w;
+    }
+  }
+  return true;
+}
+
+bool ReIBLMapCache::writeRadianceHDR( const QString& fileName, const FloatImage& image ) {
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    return false;
+  }
+  QByteArray header = QString("#?RADIANCE\n"
+                              "FORMAT=32-bit_rle_rgbe\n"
+                              "\n"
+                              "-Y %1 +X %2\n")
+                        .arg(image.height)
+                        .arg(image.width)
+                        .toAscii();
+  if (file.write(header) != header.size()) {
+    return false;
+  }
+
+  int width = image.width;
+  bool useRLE = width >= 8 && width <= 0x7fff;
+  QVector<uchar> rgbe(width*4);
+  QVector<uchar> component(width);
+  QByteArray out;
+  for (int y = 0; y < image.height; y++) {
+    for (int x = 0; x < width; x++) {
+      floatToRGBE(image.pixel(x, y), rgbe.data()+x*4);
+    }
+    out.clear();
+    if (useRLE) {
+      out.append(static_cast<char>(2));
+      out.append(static_cast<char>(2));
+      out.append(static_cast<char>(width >> 8));
+      out.append(static_cast<char>(width & 0xff));
+      for (int c = 0; c < 4; c++) {
+        for (int x = 0; x < width; x++) {
+          component[x] = rgbe[x*4+c];
+        }
+        encodeHDRComponent(component.constData(), width, out);
+      }
+    }
+    else {
+      out.append(reinterpret_cast<const char*>(rgbe.constData()), width*4);
+    }
+    if (file.write(out) != out.size()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * Angular to lat-long conversion
+ *
+ * The mappings are the ones used by Lux for the infinite lights:
+ *   - Lat-long: s = phi/2pi, t = theta/pi where theta is the angle from
+ *     the Z axis and phi is the angle on the XY plane, from the X axis
+ *   - Angular: the center of the light probe looks along the Y axis and
+ *     the distance from the center is proportional to the angle from Y
+ */
+static void sampleBilinear( const ReIBLMapCache::FloatImage& image,
+                            float s,
+                            float t,
+                            float* rgb )
+{
+  float x = s * image.width - 0.5f;
+  float y = t * image.height - 0.5f;
+  int x0 = qBound(0, static_cast<int>(floor(x)), image.width-1);
+  int y0 = qBound(0, static_cast<int>(floor(y)), image.height-1);
+  int x1 = qMin(x0+1, image.width-1);
+  int y1 = qMin(y0+1, image.height-1);
+  float fx = qBound(0.0f, x - x0, 1.0f);
+  float fy = qBound(0.0f, y - y0, 1.0f);
+  const float* p00 = image.pixel(x0, y0);
+  const float* p10 = image.pixel(x1, y0);
+  const float* p01 = image.pixel(x0, y1);
+  const float* p11 = image.pixel(x1, y1);
+  for (int c = 0; c < 3; c++) {
+    float top    = p00[c] + (p10[c]-p00[c]) * fx;
+    float bottom = p01[c] + (p11[c]-p01[c]) * fx;
+    rgb[c] = top + (bottom-top) * fy;
+  }
+}
+
+void ReIBLMapCache::angularToLatLong( const FloatImage& angular,
+                                      const int width,
+                                      FloatImage& latLong )
+{
+  RE_PROFILE_SCOPE("angularToLatLong");
+  int height = qMax(1, width/2);
+  latLong.resize(width, height);
+  for (int j = 0; j < height; j++) {
+    double theta = M_PI * (j+0.5) / height;
+    double sinTheta = sin(theta);
+    double dz = cos(theta);
+    for (int i = 0; i < width; i++) {
+      double phi = 2.0 * M_PI * (i+0.5) / width;
+      double dx = sinTheta * cos(phi);
+      double dy = sinTheta * sin(phi);
+      double len = sqrt(dx*dx + dz*dz);
+      float s = 1.0f, t = 0.5f;
+      if (len > 1e-9) {
+        double r = acos(qBound(-1.0, dy, 1.0)) / (M_PI * len);
+        s = 0.5 + 0.5 * r * dx;
+        t = 0.5 + 0.5 * r * dz;
+      }
+      else if (dy > 0) {
+        s = 0.5f;
+      }
+      sampleBilinear(angular, s, t, latLong.pixel(i, j));
+    }
+  }
+}
+
+/*
+ * Cache
+ */
+ReIBLMapCache::ReIBLMapCache() {
+  cacheDir = getRealityDataDir(RE_IBL_CACHE_DIR);
+}
+
+ReIBLMapCache* ReIBLMapCache::getInstance() {
+  if (!instance) {
+    instance = new ReIBLMapCache();
+  }
+  return instance;
+}
+
+int ReIBLMapCache::getMapWidth( const ReIBLMapSize mapSize ) {
+  switch( mapSize ) {
+    case IBL_1K:
+      return 1024;
+    case IBL_2K:
+      return 2048;
+    case IBL_4K:
+      return 4096;
+    case IBL_8K:
+      return 8192;
+    case IBL_ORIGINAL:
+      break;
+  }
+  return 0;
+}
+
+void ReIBLMapCache::setCacheDir( const QString& dirName ) {
+  QMutexLocker locker(&lock);
+  cacheDir = dirName;
+}
+
+void ReIBLMapCache::clear() {
+  QMutexLocker locker(&lock);
+  QDir dir(cacheDir);
+  foreach( QString fileName, dir.entryList(QDir::Files) ) {
+    dir.remove(fileName);
+  }
+}
+
+void ReIBLMapCache::removeStaleEntries( const QString& key, const QString& stamp ) {
+  QDir dir(cacheDir);
+  QStringList entries = dir.entryList(QStringList(QString("%1-*").arg(key)), QDir::Files);
+  foreach( QString entry, entries ) {
+    if (entry.section('-', 1, 1) != stamp) {
+      dir.remove(entry);
+    }
+  }
+}
+
+bool ReIBLMapCache::loadMap( const QString& fileName,
+                             const bool isHDR,
+                             const int maxWidth,
+                             FloatImage& image )
+{
+  if (isHDR) {
+    return readRadianceHDR(fileName, image, maxWidth);
+  }
+  QImageReader reader(fileName);
+  QSize imgSize = reader.size();
+  if (maxWidth > 0 && imgSize.width() > maxWidth) {
+    imgSize.scale(maxWidth, imgSize.height(), Qt::KeepAspectRatio);
+    reader.setScaledSize(imgSize);
+  }
+  QImage img = reader.read();
+  if (img.isNull()) {
+    return false;
+  }
+  image.resize(img.width(), img.height());
+  for (int y = 0; y < img.height(); y++) {
+    for (int x = 0; x < img.width(); x++) {
+      QRgb c = img.pixel(x, y);
+      float* p = image.pixel(x, y);
+      p[0] = qRed(c) / 255.0f;
+      p[1] = qGreen(c) / 255.0f;
+      p[2] = qBlue(c) / 255.0f;
+    }
+  }
+  return true;
+}
+
+static bool writePNG( const QString& fileName, const ReIBLMapCache::FloatImage& image ) {
+  QImage img(image.width, image.height, QImage::Format_RGB32);
+  for (int y = 0; y < image.height; y++) {
+    for (int x = 0; x < image.width; x++) {
+      const float* p = image.pixel(x, y);
+      img.setPixel(x, y, qRgb(qBound(0, qRound(p[0]*255.0f), 255),
+                              qBound(0, qRound(p[1]*255.0f), 255),
+                              qBound(0, qRound(p[2]*255.0f), 255)));
+    }
+  }
+  return img.save(fileName, "PNG");
+}
+
+QString ReIBLMapCache::prepareMap( const QString& fileName,
+                                   bool& isAngular,
+                                   const ReIBLMapSize mapSize,
+                                   const bool latLongOnly )
+{
+  RE_PROFILE_SCOPE("prepareIBLMap");
+  if (fileName.isEmpty()) {
+    return fileName;
+  }
+  int maxWidth = getMapWidth(mapSize);
+  bool convert = isAngular && latLongOnly;
+  if (!maxWidth && !convert) {
+    return fileName;
+  }
+  QFileInfo srcInfo(fileName);
+  if (!srcInfo.exists()) {
+    return fileName;
+  }
+
+  QString suffix = srcInfo.suffix().toLower();
+  bool isHDR = (suffix == "hdr");
+  if (!isHDR && !QImageReader::supportedImageFormats().contains(suffix.toAscii())) {
+    RE_LOG_INFO() << "The IBL map " << QSS(fileName)
+                  << " is in a format that cannot be converted, it's used unchanged";
+    return fileName;
+  }
+
+  int srcWidth = 0, srcHeight = 0;
+  if (isHDR) {
+    readRadianceHDRSize(fileName, srcWidth, srcHeight);
+  }
+  else {
+    QSize srcSize = ReTextureInfoCache::getInstance()->getImageSize(fileName);
+    srcWidth  = srcSize.width();
+    srcHeight = srcSize.height();
+  }
+  if (srcWidth <= 0 || srcHeight <= 0) {
+    RE_LOG_WARN() << "Cannot read the size of the IBL map " << QSS(fileName);
+    return fileName;
+  }
+  bool reduce = maxWidth > 0 && srcWidth > maxWidth;
+  if (!reduce && !convert) {
+    return fileName;
+  }
+  int targetWidth = reduce ? maxWidth : srcWidth;
+
+  QMutexLocker locker(&lock);
+
+  // The key identifies the original file, the stamp its version
+  QString key = QCryptographicHash::hash(srcInfo.absoluteFilePath().toUtf8(),
+                                         QCryptographicHash::Sha1)
+                  .toHex().left(16);
+  QString stamp = QString::number(srcInfo.lastModified().toTime_t());
+  QString cachedName = QString("%1/%2-%3-%4%5.%6")
+                         .arg(cacheDir)
+                         .arg(key)
+                         .arg(stamp)
+                         .arg(targetWidth)
+                         .arg(convert ? "-latlong" : "")
+                         .arg(isHDR ? "hdr" : "png");
+  if (QFile::exists(cachedName)) {
+    RE_PROFILE_COUNT("IBLCacheHits", 1);
+    if (convert) {
+      isAngular = false;
+    }
+    return cachedName;
+  }
+
+  QDir().mkpath(cacheDir);
+  removeStaleEntries(key, stamp);
+
+  FloatImage image;
+  if (!loadMap(fileName, isHDR, targetWidth, image)) {
+    RE_LOG_WARN() << "Cannot read the IBL map " << QSS(fileName);
+    return fileName;
+  }
+  if (convert) {
+    FloatImage latLong;
+    angularToLatLong(image, targetWidth, latLong);
+    image = latLong;
+  }
+
+  // Write to a temporary file first, so that an interrupted conversion
+  // doesn't leave a truncated map in the cache
+  QString tmpName = cachedName + ".tmp";
+  QFile::remove(tmpName);
+  bool written = isHDR ? writeRadianceHDR(tmpName, image) : writePNG(tmpName, image);
+  if (!written || !QFile::rename(tmpName, cachedName)) {
+    QFile::remove(tmpName);
+    RE_LOG_WARN() << "Cannot write the IBL map " << QSS(cachedName);
+    return fileName;
+  }
+  RE_LOG_INFO() << "IBL map " << QSS(fileName) << " prepared as " << QSS(cachedName);
+  if (convert) {
+    isAngular = false;
+  }
+  return cachedName;
+}
+
+} // namespace
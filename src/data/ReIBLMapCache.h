@@ -0,0 +1,154 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#ifndef RE_IBL_MAP_CACHE_H
+#define RE_IBL_MAP_CACHE_H
+
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include "reality_lib_export.h"
+#include "ReDefs.h"
+
+
+namespace Reality {
+
+/**
+ * Preparation of the IBL maps for rendering.
+ *
+ * IBL maps are often very large, 16K or 32K wide panoramas. The renderer
+ * loads the whole map and builds the sampling distribution for it at the
+ * beginning of every render, including quick test renders. This class
+ * creates reduced versions of the maps, at the width selected in the
+ * output options, and stores them in a cache directory so that they are
+ * computed only once. A cached map is identified by the path of the
+ * original file, its modification time and the target width, so editing
+ * the original map invalidates the cached copies.
+ *
+ * Angular maps (light probes) can also be converted to the lat-long
+ * format, for the renderers that don't support the angular mapping.
+ *
+ * Radiance HDR maps are read one scanline at the time and the reduced map
+ * is saved in the same format. The LDR formats supported by Qt are saved
+ * as PNG. Other formats, like OpenEXR, are passed to the renderer
+ * unchanged.
+ *
+ * Like ReSceneResources, this class is a singleton.
+ */
+class REALITY_LIB_EXPORT ReIBLMapCache {
+
+public:
+  //! A floating point RGB image, used for the conversion of the maps
+  struct FloatImage {
+    int width;
+    int height;
+    //! RGB triplets, stored by row
+    QVector<float> pixels;
+
+    FloatImage() : width(0), height(0) {
+    }
+
+    void resize( const int w, const int h ) {
+      width = w;
+      height = h;
+      pixels.fill(0.0f, w*h*3);
+    }
+
+    inline float* pixel( const int x, const int y ) {
+      return pixels.data()+(y*width+x)*3;
+    }
+
+    inline const float* pixel( const int x, const int y ) const {
+      return pixels.constData()+(y*width+x)*3;
+    }
+  };
+
+private:
+  static ReIBLMapCache* instance;
+
+  QString cacheDir;
+
+  //! Serializes the preparation of the maps, the exporters for different
+  //! renderers can run at the same time
+  QMutex lock;
+
+  ReIBLMapCache();
+
+  //! Reads the map, reduced so that it's not wider than maxWidth. If
+  //! maxWidth is zero the map is read at its original size.
+  bool loadMap( const QString& fileName,
+                const bool isHDR,
+                const int maxWidth,
+                FloatImage& image );
+
+  //! Removes the cached versions of a map that have been generated from
+  //! a previous version of the file.
+  void removeStaleEntries( const QString& key, const QString& stamp );
+
+public:
+
+  static ReIBLMapCache* getInstance();
+
+  //! Returns the width in pixels for a given map size, or zero for
+  //! IBL_ORIGINAL
+  static int getMapWidth( const ReIBLMapSize mapSize );
+
+  //! Location of the cached maps. By default the maps are stored in the
+  //! IBLCache directory next to the ACSEL database.
+  inline const QString& getCacheDir() const {
+    return cacheDir;
+  }
+
+  void setCacheDir( const QString& dirName );
+
+  /**
+   * Returns the name of the map to be used for rendering. The map is
+   * reduced and converted, if necessary, and the result is cached.
+   *
+   * \param fileName The map selected by the user
+   * \param isAngular Input: true if the map uses the angular mapping.
+   *                  Output: true if the map returned uses the angular
+   *                  mapping
+   * \param mapSize The maximum width of the map returned
+   * \param latLongOnly True if the renderer supports only the lat-long
+   *                    mapping. In that case angular maps are converted.
+   * \return The name of the prepared map, or fileName if the map doesn't
+   *         need to be changed or if it cannot be converted.
+   */
+  QString prepareMap( const QString& fileName,
+                      bool& isAngular,
+                      const ReIBLMapSize mapSize,
+                      const bool latLongOnly );
+
+  //! Deletes all the cached maps
+  void clear();
+
+  //! Reads a Radiance RGBE (.hdr) file. Only the standard orientation,
+  //! "-Y height +X width", is supported.
+  //! \param maxWidth If not zero, the image is reduced with a box filter
+  //!                 while reading it, so that it's not wider than this
+  //!                 value.
+  static bool readRadianceHDR( const QString& fileName,
+                               FloatImage& image,
+                               const int maxWidth = 0 );
+
+  //! Reads the size of a Radiance RGBE file without reading the pixels
+  static bool readRadianceHDRSize( const QString& fileName, int& width, int& height );
+
+  //! Writes a Radiance RGBE (.hdr) file with run-length encoded scanlines
+  static bool writeRadianceHDR( const QString& fileName, const FloatImage& image );
+
+  //! Converts an angular map, the light probe format, to the lat-long
+  //! format. The width of the result is twice its height.
+  static void angularToLatLong( const FloatImage& angular,
+                                const int width,
+                                FloatImage& latLong );
+};
+
+} // namespace
+
+#endif
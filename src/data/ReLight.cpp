@@ -622,9 +622,7 @@ void ReLight::setIBLMapFileName( QString newVal ) {
       if (!RealitySceneData->isInGUIMode()) {
         // Set the IBL preview in the host app
         RealityBase* rb = RealityBase::getRealityBase();
-        rb->commandStackPush(previewMap.toUtf8());
-        // sip => Set IBL Preview
-        rb->commandStackPush("sip");
+        rb->pushCommand(ReHostCommand::setIBLPreview(previewMap));
       }
     }
   }
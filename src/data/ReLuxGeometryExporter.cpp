@@ -12,10 +12,16 @@
 #include <cmath>
 #endif
 
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
 #include <QStringBuilder>
 
 #include "ply/rply.h"
+#include "ReProfiler.h"
 #include "ReLightMaterial.h"
+#include "ReLogger.h"
+#include "ReMeshRefiner.h"
 #include "ReModifiedMaterial.h"
 #include "ReSceneData.h"
 #include "ReSceneDataGlobal.h"
@@ -26,6 +32,7 @@
 #include "exporters/lux/ReLuxMaterialExporter.h"
 #include "exporters/lux/ReLuxMaterialExporterFactory.h"
 #include "exporters/lux/ReLuxTextureExporter.h"
+#include "textures/ReImageMap.h"
 
 
 // NAN checking
@@ -191,14 +198,14 @@ QString ReLuxGeometryExporter::writePLYObject( QString objectName,
                                                bool hasInvertedNormals, 
                                                bool writeBinary ) 
 {
-  ReSceneResources* srh = ReSceneResources::getInstance();
-  // Replaces the ":" that can be in some filenames and that can cause issues 
-  // with Windows
-  QString plyFileName = QString("%1/%2.ply")
-                        .arg(srh->getObjectsPath())
-                        .arg(sanitizeFileName(objectName));
+  RE_PROFILE_SCOPE("writePLYObject");
+  QString plyFileName = getPLYFileName(objectName);
 
   p_ply plyFile = ply_create(plyFileName.toUtf8(), (writeBinary ? PLY_LITTLE_ENDIAN : PLY_ASCII), NULL );
+  if (!plyFile) {
+    RE_LOG_WARN() << "Cannot create the PLY file " << QSS(plyFileName);
+    return QString();
+  }
   ply_add_comment(plyFile, "File created by Reality plug-in");
   // Write the header
   ply_add_element(plyFile, "vertex", geometryBuffer->numVertices);
@@ -219,7 +226,7 @@ QString ReLuxGeometryExporter::writePLYObject( QString objectName,
   }
   ply_add_element(plyFile, "face", geometryBuffer->numTriangles);
   ply_add_list_property(plyFile, "vertex_indices", PLY_UCHAR, PLY_UINT);
-  ply_write_header(plyFile);
+  bool written = ply_write_header(plyFile) != 0;
 
   // Write the vertices
   for (int i = 0; i < geometryBuffer->numVertices; ++i) {
@@ -250,10 +257,134 @@ QString ReLuxGeometryExporter::writePLYObject( QString objectName,
     ply_write(plyFile,geometryBuffer->triangles[i].a[2]);
   };
 
-  ply_close(plyFile);
+  // The data is flushed by ply_close(), a full disk is reported there
+  written = ply_close(plyFile) != 0 && written;
+  if (!written) {
+    RE_LOG_WARN() << "Cannot write the PLY file " << QSS(plyFileName);
+    QFile::remove(plyFileName);
+    return QString();
+  }
+  RE_PROFILE_COUNT("plyFiles", 1);
+  if (ReProfiler::isEnabled()) {
+    RE_PROFILE_COUNT("plyBytes", QFileInfo(plyFileName).size());
+  }
   return(plyFileName);
 }
 
+QString ReLuxGeometryExporter::getPLYFileName( const QString& objectName ) {
+  ReSceneResources* srh = ReSceneResources::getInstance();
+  // Replaces the ":" that can be in some filenames and that can cause issues 
+  // with Windows
+  return QString("%1/%2.ply")
+           .arg(srh->getObjectsPath())
+           .arg(sanitizeFileName(objectName));
+}
+
+QString ReLuxGeometryExporter::writeRefinedPLYObject( const QString& objectName,
+                                                      const ReModifiedMaterial* mat,
+                                                      ReGeometryBuffer* geometryBuffer, 
+                                                      HostAppID scale, 
+                                                      bool hasInvertedNormals )
+{
+  // Microdisplacement is computed by the renderer while rendering, it
+  // cannot be baked in the mesh
+  if (mat->usesMicrofacets()) {
+    return "";
+  }
+  int levels = mat->getSubdivisions();
+  ReTexturePtr dm = mat->getDisplacementMap();
+  bool displace = !dm.isNull() && RealitySceneData->isDisplacementEnabled();
+  if (levels == 0 && !displace) {
+    return "";
+  }
+  // Only UV-mapped image maps can be sampled by the exporter
+  if (displace && (dm->getType() != TexImageMap || geometryBuffer->uvmap == NULL)) {
+    return "";
+  }
+  if ( (static_cast<qint64>(geometryBuffer->numTriangles) << (2*levels)) > 
+       RE_REFINER_MAX_TRIANGLES ) 
+  {
+    RE_LOG_INFO() << "Mesh " << QSS(objectName) << " is too large to be "
+                     "subdivided by the exporter, using the renderer";
+    return "";
+  }
+
+  ReDisplacementSampler sampler;
+  if (displace) {
+    ReImageMapPtr map = dm.staticCast<ReImageMap>();
+    if (map->getMapping() != Re2DTexture::UV) {
+      return "";
+    }
+    // Same values written for the texture in the scene file
+    sampler.setMapping(map->getUTile(), -map->getVTile(), 
+                       map->getUOffset(), map->getVOffset());
+    sampler.setChannel(map->getRgbChannel());
+    sampler.setLevels(map->getGain(), map->getGamma());
+    sampler.setLimits(mat->getDmNegative(), mat->getDmPositive(), mat->getDmStrength());
+    if (!sampler.load(map->getFileName())) {
+      return "";
+    }
+  }
+
+  int numVertices = geometryBuffer->numVertices;
+  int numTriangles = geometryBuffer->numTriangles;
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  hash.addData(reinterpret_cast<const char*>(geometryBuffer->vertices), 
+               sizeof(ReVectorF) * numVertices);
+  hash.addData(reinterpret_cast<const char*>(geometryBuffer->normals), 
+               sizeof(ReVectorF) * numVertices);
+  if (geometryBuffer->uvmap) {
+    hash.addData(reinterpret_cast<const char*>(geometryBuffer->uvmap), 
+                 sizeof(ReUVPoint) * numVertices);
+  }
+  hash.addData(reinterpret_cast<const char*>(geometryBuffer->triangles), 
+               sizeof(ReTriangle) * numTriangles);
+  hash.addData(QString("%1|%2|%3|%4|%5")
+                 .arg(levels)
+                 .arg(mat->keepsSharpEdges())
+                 .arg(mat->isSmooth())
+                 .arg(scale)
+                 .arg(hasInvertedNormals)
+                 .toUtf8());
+  if (displace) {
+    hash.addData(sampler.getKey());
+  }
+  QByteArray key = hash.result().toHex();
+
+  QString meshName = sanitizeFileName(objectName);
+  QString plyFileName = getPLYFileName(objectName);
+  if (ReMeshRefiner::fetchCachedMesh(meshName, key, plyFileName)) {
+    RE_PROFILE_COUNT("refinedMeshCacheHits", 1);
+    return plyFileName;
+  }
+
+  ReMeshRefiner refiner;
+  refiner.setMesh(numVertices, 
+                  geometryBuffer->vertices, 
+                  geometryBuffer->normals,
+                  geometryBuffer->uvmap,
+                  numTriangles,
+                  geometryBuffer->triangles);
+  refiner.subdivide(levels, mat->keepsSharpEdges());
+  if (displace) {
+    // The displacement is in the units of the renderer
+    refiner.displace(sampler, valueToHostApp(1.0, scale));
+  }
+  else if (mat->isSmooth()) {
+    refiner.computeNormals();
+  }
+
+  ReGeometryBuffer refined;
+  refined.lend(geometryBuffer->name, refiner);
+  // If the file can't be written the refinement is left to the renderer
+  if (writePLYObject(objectName, &refined, scale, hasInvertedNormals, true).isEmpty()) {
+    return QString();
+  }
+  ReMeshRefiner::storeCachedMesh(meshName, key, plyFileName);
+  RE_PROFILE_COUNT("refinedMeshes", 1);
+  return plyFileName;
+}
+
 void ReLuxGeometryExporter::exportToLux( const QString materialName, 
                                          const QString objectName,
                                          const QString shapeName,
@@ -346,27 +477,49 @@ void ReLuxGeometryExporter::exportToLux( const QString materialName,
     meshType = "plymesh";
   }  
   materialData += QString("Shape \"%1\" \"string name\" [\"%2\"]\n").arg(meshType).arg(objectName);
+  // Normal maps are applied in tangent space. The PLY files don't store
+  // tangents, the renderer computes them from the normals and UVs.
+  if (!dmat.isNull() && geometryBuffer->uvmap != NULL) {
+    ReTexturePtr bumpMap = dmat->getBumpMap();
+    if (!bumpMap.isNull() && containsNormalMap(bumpMap)) {
+      materialData += "\"bool generatetangents\" [\"true\"]\n";
+    }
+  }
 
-  // Subdivision
-  auto matExporter = ReLuxMaterialExporterFactory::getExporter(mat.data());
-  materialData += matExporter->getSubdivision(mat.data());
-  // Displacement
-  materialData += matExporter->getDisplacementClause(mat.data());
+  // The subdivision and displacement can be computed by the exporter, in
+  // that case the renderer receives the refined mesh
+  QString plyObjectName = QString("%1-%2").arg(objectName).arg(materialName);
+  QString refinedFileName;
+  if ( gFileFormat == BinaryPLY && !dmat.isNull() &&
+       RealitySceneData->isSubdivisionBakingEnabled() ) 
+  {
+    refinedFileName = writeRefinedPLYObject(
+                        plyObjectName, dmat.data(), geometryBuffer, scale, hasInvertedNormals
+                      );
+  }
+  if (refinedFileName.isEmpty()) {
+    // Subdivision
+    auto matExporter = ReLuxMaterialExporterFactory::getExporter(mat.data());
+    materialData += matExporter->getSubdivision(mat.data());
+    // Displacement
+    materialData += matExporter->getDisplacementClause(mat.data());
+  }
 
   if (gFileFormat == LuxNative) {
     writeLuxObject(geometryBuffer, scale, hasInvertedNormals);    
   }
   else if ( gFileFormat == BinaryPLY || gFileFormat == TextPLY ) {
+    if (refinedFileName.isEmpty()) {
+      refinedFileName = writePLYObject( 
+                          plyObjectName, 
+                          geometryBuffer, 
+                          scale, 
+                          hasInvertedNormals, 
+                          gFileFormat == BinaryPLY 
+                        );
+    }
     materialData += QString("\"string filename\" [\"%1\"]\n")
-                      .arg(sceneResources->getRelativePath(
-                            writePLYObject( 
-                              QString("%1-%2").arg(objectName).arg(materialName), 
-                              geometryBuffer, 
-                              scale, 
-                              hasInvertedNormals, 
-                              gFileFormat == BinaryPLY 
-                            )
-                          ));
+                      .arg(sceneResources->getRelativePath(refinedFileName));
   }
 
   materialData += "AttributeEnd\n";
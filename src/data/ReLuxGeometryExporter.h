@@ -12,6 +12,7 @@
 
 namespace Reality {
   class ReMatrix;
+  class ReModifiedMaterial;
 }
 
 
@@ -24,29 +25,49 @@ namespace Reality {
 class REALITY_LIB_EXPORT ReLuxGeometryExporter : public ReBaseGeometryExporter {
 
 private:
-  // Constructor: ReLuxGeometryExporter
-  ReLuxGeometryExporter() {
-  };
-
   static ReLuxGeometryExporter* instance;
 
   void writeLuxObject( ReGeometryBuffer* geometryBuffer, HostAppID scale, bool hasInvertedNormal );
 
+  void exportToLux( const QString materialName, 
+                    const QString objectName,
+                    const QString shapeName,                         
+                    ReGeometryBuffer* geometryBuffer,
+                    HostAppID scale );
+
+protected:
+  // Constructor: ReLuxGeometryExporter
+  ReLuxGeometryExporter() {
+  };
+
+  //! Writes the geometry buffer to a PLY file in the objects directory.
+  //! Returns the absolute path of the file written, or an empty string
+  //! if the file could not be written.
   QString writePLYObject( QString objectName,
                           ReGeometryBuffer* geometryBuffer, 
                           HostAppID scale, 
                           bool hasInvertedNormals, 
                           bool writeBinary = true );
 
-  void exportToLux( const QString materialName, 
-                    const QString objectName,
-                    const QString shapeName,                         
-                    ReGeometryBuffer* geometryBuffer,
-                    HostAppID scale );
+  //! Returns the absolute path of the PLY file written for objectName
+  QString getPLYFileName( const QString& objectName );
+
+  /**
+   * Subdivides and displaces the geometry of a material, as set in the
+   * material, and writes the result to a binary PLY file. See
+   * ReMeshRefiner.
+   * \return The absolute path of the file written or an empty string if
+   *         the refinement must be done by the renderer.
+   */
+  QString writeRefinedPLYObject( const QString& objectName,
+                                 const ReModifiedMaterial* mat,
+                                 ReGeometryBuffer* geometryBuffer, 
+                                 HostAppID scale, 
+                                 bool hasInvertedNormals );
 
 public:
   // Destructor: ReLuxGeometryExporter
- ~ReLuxGeometryExporter() {
+ virtual ~ReLuxGeometryExporter() {
   };
 
   static ReLuxGeometryExporter* getInstance() {
@@ -70,7 +91,7 @@ public:
    *         used to export the object. This string needs to be
    *         written to a file.
    */
-  QString& exportObjectBegin( const QString objectID );
+  virtual QString& exportObjectBegin( const QString objectID );
 
   /**
    * This method closes the definition of an object and exports the object
@@ -81,7 +102,7 @@ public:
    *         used to export the object. This string needs to be
    *         written to a file.
    */
-  QString& exportObjectEnd( const QString objectID );
+  virtual QString& exportObjectEnd( const QString objectID );
 
   /**
    * Method used to export a material. It returns the material definition
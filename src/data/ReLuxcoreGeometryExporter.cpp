@@ -0,0 +1,279 @@
+/*
+  Reality plug-in
+  Copyright (c) Pret-a-3D/Paolo Ciccone 2012. All rights reserved.
+*/
+
+#include "ReLuxcoreGeometryExporter.h"
+
+#include <math.h>
+
+#include <QStringList>
+
+#include "ReLightMaterial.h"
+#include "ReMatrix.h"
+#include "ReModifiedMaterial.h"
+#include "ReSceneData.h"
+#include "ReSceneDataGlobal.h"
+#include "ReSceneResources.h"
+#include "ReTools.h"
+#include "exporters/ReLuxSceneExporter.h"
+#include "exporters/lux/ReLuxTextureExporter.h"
+#include "exporters/luxcore/ReLuxcoreLightExporter.h"
+#include "exporters/luxcore/ReLuxcoreSDLTranslator.h"
+
+
+namespace Reality {
+
+ReLuxcoreGeometryExporter* ReLuxcoreGeometryExporter::instance = NULL;
+
+void ReLuxcoreGeometryExporter::reset() {
+  instanceSources.clear();
+  currentInstanceSource.clear();
+}
+
+QString& ReLuxcoreGeometryExporter::exportMaterial( const QString materialName,
+                                                    const QString objectName,
+                                                    const QString UNUSED(shapeLabel),
+                                                    ReGeometryBuffer* geometryBuffer,
+                                                    const HostAppID scale )
+{
+  auto sceneResources = ReSceneResources::getInstance();
+  materialData.clear();
+  if (geometryBuffer->numVertices == 0) {
+    geometryBuffer->reset();
+    return materialData;
+  }
+
+  ReGeometryObjectPtr obj = RealitySceneData->getObject(objectName);
+  ReMaterialPtr mat = obj->getMaterial(materialName);
+  if (mat.isNull()) {
+    materialData += QString("#! Could not find data for material %1:%2\n")
+                      .arg(objectName).arg(materialName);
+    geometryBuffer->reset();
+    return materialData;
+  }
+
+  QString luxcoreName = ReLuxcoreSDLTranslator::sanitizeName(
+                          QString("%1-%2").arg(objectName).arg(materialName)
+                        );
+  QString matName = ReLuxcoreSDLTranslator::sanitizeName(mat->getUniqueName());
+  QString matPrefix = QString("scene.materials.%1").arg(matName);
+
+  materialData = QString("# Mat %1 (%2). %3 polys\n")
+                   .arg(materialName)
+                   .arg(mat->getTypeAsString())
+                   .arg(geometryBuffer->numTriangles);
+
+  // Mesh lights get their own emitting material
+  bool hasInvertedNormals = false;
+  ReLightMaterialPtr matLight = obj->getLight(materialName);
+  if (!matLight.isNull()) {
+    ReLightPtr meshLight = matLight->getLight();
+    if (meshLight->isLightOn()) {
+      hasInvertedNormals = meshLight->getInvertedNormals();
+      matName = luxcoreName + "_light";
+      matPrefix = QString("scene.materials.%1").arg(matName);
+      QString lightTextures;
+      QString emission = ReLuxcoreLightExporter::getInstance()->exportMeshLight(
+                           meshLight, matPrefix, lightTextures
+                         );
+      materialData += lightTextures;
+      materialData += QString("%1.type = \"matte\"\n"
+                              "%1.kd = 0 0 0\n").arg(matPrefix);
+      materialData += emission;
+    }
+  }
+
+  // Check if the material has the Light Emission flag on. In that case
+  // configure the material to be an emitter
+  ReModifiedMaterialPtr dmat = mat.dynamicCast<ReModifiedMaterial>();
+  if (!dmat.isNull() && dmat->isEmittingLight()) {
+    materialData += QString("%1.emission.gain = %2 %2 %2\n"
+                            "%1.emission.efficency = 17\n"
+                            "%1.emission.power = 100\n")
+                      .arg(matPrefix)
+                      .arg(dmat->getLightGain());
+    ReTexturePtr ambTex = ReLuxTextureExporter::getTextureFromCache(
+                            dmat->getAmbientMap()
+                          );
+    if (!ambTex.isNull()) {
+      materialData += QString("%1.emission = \"%2\"\n")
+                        .arg(matPrefix)
+                        .arg(ReLuxcoreSDLTranslator::sanitizeName(ambTex->getUniqueName()));
+    }
+  }
+
+  // LuxCore reads binary PLY files much faster than any text format, so
+  // we ignore the geometry format selected for Lux.
+  QString plyFileName = sceneResources->getRelativePath(
+                          writePLYObject(
+                            QString("%1-%2").arg(objectName).arg(materialName),
+                            geometryBuffer,
+                            scale,
+                            hasInvertedNormals,
+                            true
+                          )
+                        );
+  QString shapeName = luxcoreName;
+  materialData += QString("scene.shapes.%1.type = \"mesh\"\n"
+                          "scene.shapes.%1.ply = \"%2\"\n")
+                    .arg(shapeName)
+                    .arg(plyFileName);
+
+  if (!dmat.isNull()) {
+    int subdivisions = dmat->getSubdivisions();
+    if (subdivisions > 0) {
+      QString subdivShape = shapeName + "_subdiv";
+      materialData += QString("scene.shapes.%1.type = \"subdiv\"\n"
+                              "scene.shapes.%1.source = \"%2\"\n"
+                              "scene.shapes.%1.maxlevel = %3\n")
+                        .arg(subdivShape)
+                        .arg(shapeName)
+                        .arg(subdivisions);
+      shapeName = subdivShape;
+    }
+    ReTexturePtr dm = dmat->getDisplacementMap();
+    if (!dm.isNull() && RealitySceneData->isDisplacementEnabled()) {
+      QString dispShape = luxcoreName + "_disp";
+      materialData += QString("scene.shapes.%1.type = \"displacement\"\n"
+                              "scene.shapes.%1.source = \"%2\"\n"
+                              "scene.shapes.%1.map = \"%3\"\n"
+                              "scene.shapes.%1.scale = 1\n"
+                              "scene.shapes.%1.offset = 0\n"
+                              "scene.shapes.%1.normalsmooth = %4\n")
+                        .arg(dispShape)
+                        .arg(shapeName)
+                        .arg(ReLuxcoreSDLTranslator::sanitizeName(
+                               ReLuxTextureExporter::getFloatTextureUniqueName(dm) +
+                               "_dispmap"
+                             ))
+                        .arg(dmat->isSmooth() ? 1 : 0);
+      shapeName = dispShape;
+    }
+  }
+
+  materialData += QString("scene.objects.%1.shape = \"%2\"\n"
+                          "scene.objects.%1.material = \"%3\"\n")
+                    .arg(luxcoreName)
+                    .arg(shapeName)
+                    .arg(matName);
+
+  if (!currentInstanceSource.isEmpty()) {
+    InstanceShape instShape;
+    instShape.shape = shapeName;
+    instShape.material = matName;
+    instanceSources[currentInstanceSource] << instShape;
+  }
+  geometryBuffer->reset();
+  return materialData;
+}
+
+QString& ReLuxcoreGeometryExporter::exportObjectBegin( const QString objectID ) {
+  materialData.clear();
+  currentInstanceSource = objectID;
+  instanceSources.remove(objectID);
+  return materialData;
+}
+
+QString& ReLuxcoreGeometryExporter::exportObjectEnd( const QString UNUSED(objectID) ) {
+  materialData.clear();
+  currentInstanceSource.clear();
+  return materialData;
+}
+
+void ReLuxcoreGeometryExporter::writeInstance( const QString& objectName,
+                                               const QString& transformation )
+{
+  materialData.clear();
+  auto obj = RealitySceneData->getObject(objectName);
+  if (obj.isNull() || !obj->isInstance()) {
+    return;
+  }
+  QString instanceName = ReLuxcoreSDLTranslator::sanitizeName(objectName);
+  // The source object is already in the scene, the instance re-uses its
+  // shapes with a different transformation
+  int i = 0;
+  foreach(InstanceShape instShape, instanceSources.value(obj->getInstanceSourceID())) {
+    materialData += QString("scene.objects.%1_%2.shape = \"%3\"\n"
+                            "scene.objects.%1_%2.material = \"%4\"\n"
+                            "scene.objects.%1_%2.transformation = %5\n")
+                      .arg(instanceName)
+                      .arg(i++)
+                      .arg(instShape.shape)
+                      .arg(instShape.material)
+                      .arg(transformation);
+  }
+}
+
+QString& ReLuxcoreGeometryExporter::exportInstance( const QString& objectName,
+                                                    const ReMatrix& trans,
+                                                    const HostAppID appID )
+{
+  ReMatrix m = ReLuxSceneExporter::convertMatrix(trans, true);
+  QString transformation = QString("%1 %2 %3 0 %4 %5 %6 0 %7 %8 %9 0 %10 %11 %12 1")
+                             .arg(m.m[0][0]).arg(m.m[0][1]).arg(m.m[0][2])
+                             .arg(m.m[1][0]).arg(m.m[1][1]).arg(m.m[1][2])
+                             .arg(m.m[2][0]).arg(m.m[2][1]).arg(m.m[2][2])
+                             .arg(convertUnit(m.m[3][0], appID))
+                             .arg(convertUnit(m.m[3][1], appID))
+                             .arg(convertUnit(m.m[3][2], appID));
+  writeInstance(objectName, transformation);
+  return materialData;
+}
+
+QString& ReLuxcoreGeometryExporter::exportInstance( const QString& objectName,
+                                                    const QVariantMap& trans,
+                                                    const HostAppID appID )
+{
+  // Same sequence of transformations used by the Lux exporter:
+  // translate, rotate in the order set by the host and then scale.
+  float rotVal[3] = {
+     trans["xRot"].toFloat(),
+     trans["yRot"].toFloat(),
+    -trans["zRot"].toFloat()
+  };
+  // Rotation axes in the Lux coordinate system
+  int rotAxis[3] = { 0, 2, 1 };
+  int order[3] = {
+    trans["xOrder"].toInt(), trans["yOrder"].toInt(), trans["zOrder"].toInt()
+  };
+
+  float m[3][3] = { {1, 0, 0}, {0, 1, 0}, {0, 0, 1} };
+  for (int step = 0; step < 3; step++) {
+    for (int r = 0; r < 3; r++) {
+      if (order[r] != step || !rotVal[r]) {
+        continue;
+      }
+      float angle = rotVal[r] * M_PI / 180.0;
+      float c = cos(angle), s = sin(angle);
+      int a = (rotAxis[r]+1) % 3, b = (rotAxis[r]+2) % 3;
+      // m = m * R, where R is the rotation around the axis
+      for (int row = 0; row < 3; row++) {
+        float ma = m[row][a], mb = m[row][b];
+        m[row][a] =  c*ma + s*mb;
+        m[row][b] = -s*ma + c*mb;
+      }
+    }
+  }
+  float scale = trans["Scale"].toFloat();
+  float scales[3] = {
+    trans["xScale"].toFloat() * scale,
+    trans["zScale"].toFloat() * scale,
+    trans["yScale"].toFloat() * scale
+  };
+  QStringList values;
+  for (int col = 0; col < 3; col++) {
+    for (int row = 0; row < 3; row++) {
+      values << QString::number(m[row][col] * scales[col]);
+    }
+    values << "0";
+  }
+  values << QString::number(convertUnit(trans["xTran"].toFloat(), appID))
+         << QString::number(-convertUnit(trans["zTran"].toFloat(), appID))
+         << QString::number(convertUnit(trans["yTran"].toFloat(), appID))
+         << "1";
+  writeInstance(objectName, values.join(" "));
+  return materialData;
+}
+
+} // namespace
@@ -0,0 +1,89 @@
+/*
+  Reality plug-in
+  Copyright (c) Pret-a-3D/Paolo Ciccone 2012. All rights reserved.
+*/
+
+#ifndef LUXCORE_GEOMETRY_EXPORTER_H
+#define LUXCORE_GEOMETRY_EXPORTER_H
+
+#include <QHash>
+#include <QList>
+
+#include "reality_lib_export.h"
+#include "ReLuxGeometryExporter.h"
+
+
+namespace Reality {
+
+/**
+ * Exports the geometry using the LuxCore scene format. Each material is
+ * written to a binary PLY file and declared with a "scene.shapes.*"
+ * property. The shape is then connected to its material with a
+ * "scene.objects.*" property.
+ *
+ * Instances are exported by declaring new objects that reference the
+ * shapes of the source object with an additional transformation. LuxCore
+ * shares the mesh data between all the objects that use the same shape.
+ */
+class REALITY_LIB_EXPORT ReLuxcoreGeometryExporter : public ReLuxGeometryExporter {
+
+private:
+  static ReLuxcoreGeometryExporter* instance;
+
+  //! A LuxCore object that is part of an instance source
+  struct InstanceShape {
+    QString shape;
+    QString material;
+  };
+
+  //! The LuxCore objects exported for each instance source, indexed by
+  //! the ID of the source object.
+  QHash<QString, QList<InstanceShape> > instanceSources;
+
+  //! The ID of the instance source being exported, between the calls to
+  //! exportObjectBegin() and exportObjectEnd()
+  QString currentInstanceSource;
+
+  //! Writes the properties for a new instance of the source object.
+  //! \param transformation The 16 values of the transformation matrix,
+  //!                       in column-major order
+  void writeInstance( const QString& objectName, const QString& transformation );
+
+  ReLuxcoreGeometryExporter() {
+  };
+
+public:
+ ~ReLuxcoreGeometryExporter() {
+  };
+
+  static ReLuxcoreGeometryExporter* getInstance() {
+    if (!instance) {
+      instance = new ReLuxcoreGeometryExporter();
+    }
+    return instance;
+  }
+
+  //! Clears the instancing data. To be called at the start of each export.
+  void reset();
+
+  QString& exportObjectBegin( const QString objectID );
+  QString& exportObjectEnd( const QString objectID );
+
+  QString& exportMaterial( const QString materialName,
+                           const QString objectName,
+                           const QString shapeLabel,
+                           ReGeometryBuffer* geometryBuffer,
+                           const HostAppID scale );
+
+  QString& exportInstance( const QString& objectName,
+                           const QVariantMap& transform,
+                           const HostAppID scale );
+
+  QString& exportInstance( const QString& objectName,
+                           const ReMatrix& transform,
+                           const HostAppID scale );
+};
+
+} // namespace
+
+#endif
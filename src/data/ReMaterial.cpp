@@ -63,7 +63,8 @@ ReMaterial::ReMaterial( const QString name, const ReGeometryObject* parent ) :
   parent(parent),
   nullValue(NULL),
   edited(false),
-  visibleInRender(true)
+  visibleInRender(true),
+  textureOrderValid(false)
 {
     // Nothing
 }
@@ -251,7 +252,7 @@ float ReMaterial::getScatteringScale() const {
 
 void ReMaterial::findTextureDependencies( ReTexturePtr tex, 
                                           QHash<QString, bool>& visited, 
-                                          QStringList& texList ) const
+                                          QVector<ReTexturePtr>& texList ) const
 {
   QString texName = tex->getName();
   QStringList deps = tex->getDependencies();
@@ -260,22 +261,42 @@ void ReMaterial::findTextureDependencies( ReTexturePtr tex,
     foreach( QString tName, deps) {
       findTextureDependencies(nodeCatalog[tName], visited, texList);
     }
-    texList.append(texName);
+    texList.append(tex);
   } 
 }
 
-void ReMaterial::findDependencies( QStringList& texList ) const 
-{
+QVector<ReTexturePtr> ReMaterial::getTextureOrder() const {
+  QMutexLocker locker(&textureOrderLock);
+  // Textures can be added or removed by code that doesn't go through the
+  // catalog methods, like the texture constructors, so a different count
+  // is also a sign that the order is stale.
+  if (textureOrderValid && textureOrder.count() == nodeCatalog.count()) {
+    return textureOrder;
+  }
+  textureOrder.clear();
+  textureOrder.reserve(nodeCatalog.count());
   QHash<QString, bool> visited;
+  visited.reserve(nodeCatalog.count());
 
   ReNodeDictionaryIterator i(nodeCatalog);
   while( i.hasNext() ) {
     i.next();
     ReTexturePtr tex = i.value();
     if ( !tex.isNull() ) {
-      findTextureDependencies(tex, visited, texList);
+      findTextureDependencies(tex, visited, textureOrder);
     }
   }
+  textureOrderValid = true;
+  return textureOrder;
+}
+
+void ReMaterial::findDependencies( QStringList& texList ) const 
+{
+  const QVector<ReTexturePtr>& texOrder = getTextureOrder();
+  int numTextures = texOrder.count();
+  for (int i = 0; i < numTextures; i++) {
+    texList.append(texOrder[i]->getName());
+  }
 }
 
 
@@ -288,6 +309,7 @@ const QString ReMaterial::getUniqueName() const {
 void ReMaterial::setNodeCatalog( const ReNodeDictionary newNodeCatalog ) {
   nodeCatalog.clear();
   nodeCatalog = newNodeCatalog;
+  invalidateTextureOrder();
 };
 
 bool ReMaterial::makeNewTexture( const QString& channelName, 
@@ -651,6 +673,7 @@ void ReMaterial::setChannel( const QString& channelName, const QString& textureN
     }
   }
   channels[channelName] = nodeCatalog[textureName];
+  invalidateTextureOrder();
 }
 
 ReTexturePtr ReMaterial::changeTextureType( const QString& name, 
@@ -775,6 +798,7 @@ ReTexturePtr ReMaterial::changeTextureType( const QString& name,
       oneNode.value()->replaceInnerTexture( name, newTexPtr );    
     }
   }
+  invalidateTextureOrder();
 
   return newTexPtr;
 };
@@ -792,14 +816,13 @@ void ReMaterial::serialize( QDataStream& dataStream ) const {
   // with the ones included in compound textures before the
   // texture that contains them or the deserialization will
   // not work. 
-  QStringList texNames;
-  findDependencies(texNames);
+  const QVector<ReTexturePtr>& texOrder = getTextureOrder();
 
   // Number of textures in the catalog
-  int numTextures = texNames.count();
+  int numTextures = texOrder.count();
   dataStream << (quint16) nodeCatalog.count();
   for (int i = 0; i < numTextures; i++) {
-    nodeCatalog.value(texNames[i])->serialize(dataStream);
+    texOrder[i]->serialize(dataStream);
   }
 
   /*
@@ -979,12 +1002,14 @@ void ReMaterial::addTextureToCatalog( ReTexturePtr tex ) {
     return;
   }
   nodeCatalog.insert(tex->getName(), tex);
+  invalidateTextureOrder();
 }
 
 bool ReMaterial::removeTextureFromCatalog( ReTexturePtr tex ) {
   QString texName = tex->getName();
   if (nodeCatalog.contains(texName)) {
     nodeCatalog.remove(texName);
+    invalidateTextureOrder();
     return true;
   }
   return false;
@@ -1019,6 +1044,7 @@ bool ReMaterial::deleteTexture( const QString& texName ) {
     }
     nodeCatalog[texName].clear();
     nodeCatalog.remove( texName );
+    invalidateTextureOrder();
     return true;
   }
   return false;
@@ -6,6 +6,9 @@
 #ifndef RE_MATERIAL_H
 #define RE_MATERIAL_H
 
+#include <QMutex>
+#include <QVector>
+
 #include "reality_lib_export.h"
 #include "ReTextureContainer.h"
 
@@ -82,6 +85,19 @@ private:
 
   static QString typeNames[MatUndefined+1];
 
+  //! Cached list of the textures in nodeCatalog sorted so that each texture
+  //! follows the textures that it depends on. Rebuilt on demand by 
+  //! getTextureOrder() after the catalog or the links between the textures
+  //! have changed.
+  mutable QVector<ReTexturePtr> textureOrder;
+
+  //! False when textureOrder needs to be rebuilt
+  mutable bool textureOrderValid;
+
+  //! Serializes the access to textureOrder, which is rebuilt by the const
+  //! methods that can run at the same time, like serialize()
+  mutable QMutex textureOrderLock;
+
   /**
    * Companion method for <findDependencies>, it traverses the list
    * of textures and find all the dependencies recursively,
@@ -90,7 +106,13 @@ private:
    */
   void findTextureDependencies( ReTexturePtr tex, 
                                 QHash<QString, bool>& visited, 
-                                QStringList& texList ) const;
+                                QVector<ReTexturePtr>& texList ) const;
+
+  //! Marks the cached texture order as stale
+  inline void invalidateTextureOrder() {
+    QMutexLocker locker(&textureOrderLock);
+    textureOrderValid = false;
+  }
 
 public:
     ReMaterial( const QString name, const ReGeometryObject* parent );
@@ -141,6 +163,19 @@ public:
     //!   textures - Input, the list of textures linked to a given material.
     void findDependencies( QStringList& texList ) const;
 
+    //! Returns all the textures of the catalog sorted so that the textures
+    //! linked by compound textures are listed before the textures that link
+    //! to them. The order is computed once and cached until the catalog, or
+    //! the links between its textures, change. The list returned is a 
+    //! shared copy, so it stays valid if the cache is rebuilt by another
+    //! thread.
+    QVector<ReTexturePtr> getTextureOrder() const;
+
+    //! Reimplemented from ReTextureContainer
+    void textureLinksChanged() {
+      invalidateTextureOrder();
+    }
+
     //! Called whenever an external entity wants to notify the material that
     //! one of its textures has been modified.
     virtual void textureUpdated( const QString& /* textureName */ ) {
@@ -0,0 +1,104 @@
+/*
+  Reality plug-in
+  Copyright (c) Pret-a-3D/Paolo Ciccone 2012. All rights reserved.
+*/
+
+#include "ReMaterialBatchConverter.h"
+
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+#include "ReGeometryObject.h"
+#include "ReProfiler.h"
+#include "ReSceneData.h"
+#include "ReSceneDataGlobal.h"
+
+
+namespace Reality {
+
+//! Converts the materials of one object using its own conversion context
+class ReMaterialBatchConverter::ObjectTask : public QRunnable {
+
+private:
+  ReGeometryObjectPtr obj;
+  const MaterialSourceList& materials;
+
+public:
+  ObjectTask( ReGeometryObjectPtr obj, const MaterialSourceList& materials ) :
+    obj(obj),
+    materials(materials)
+  {
+  }
+
+  void run() {
+    RE_PROFILE_SCOPE("ConvertObjectMaterials");
+    ReMaterialConversionContext context;
+    foreach(const MaterialSource& src, materials) {
+      obj->addMaterial(context, src.matID, src.data);
+    }
+    RE_PROFILE_COUNT("MaterialsConverted", materials.count());
+  }
+};
+
+ReMaterialBatchConverter::ReMaterialBatchConverter() :
+  numMaterials(0),
+  maxThreads(0)
+{
+}
+
+void ReMaterialBatchConverter::addMaterial( const QString& objID,
+                                            const QString& matID,
+                                            const QVariantMap& matData )
+{
+  if (!sources.contains(objID)) {
+    objectIDs.append(objID);
+  }
+  MaterialSource src;
+  src.matID = matID;
+  src.data = matData;
+  sources[objID].append(src);
+  numMaterials++;
+}
+
+void ReMaterialBatchConverter::convert() {
+  RE_PROFILE_SCOPE("ConvertMaterialBatch");
+  // The objects are retrieved here, in the calling thread, so that
+  // the workers don't access the scene's object table
+  QList<ObjectTask*> tasks;
+  foreach(QString objID, objectIDs) {
+    ReGeometryObjectPtr obj = RealitySceneData->getObject(objID);
+    if (obj.isNull()) {
+      RE_LOG_WARN() << "Null object! " << QSS(objID);
+      continue;
+    }
+    ObjectTask* task = new ObjectTask(obj, sources[objID]);
+    task->setAutoDelete(false);
+    tasks.append(task);
+  }
+
+  int numThreads = maxThreads > 0 ? maxThreads : QThread::idealThreadCount();
+  if (numThreads <= 1 || tasks.count() == 1) {
+    foreach(ObjectTask* task, tasks) {
+      task->run();
+    }
+  }
+  else {
+    QThreadPool pool;
+    pool.setMaxThreadCount(numThreads);
+    foreach(ObjectTask* task, tasks) {
+      pool.start(task);
+    }
+    pool.waitForDone();
+  }
+  qDeleteAll(tasks);
+  clear();
+}
+
+void ReMaterialBatchConverter::clear() {
+  objectIDs.clear();
+  sources.clear();
+  numMaterials = 0;
+}
+
+} // namespace
@@ -0,0 +1,85 @@
+/*
+  Reality plug-in
+  Copyright (c) Pret-a-3D/Paolo Ciccone 2012. All rights reserved.
+*/
+
+#ifndef RE_MATERIAL_BATCH_CONVERTER_H
+#define RE_MATERIAL_BATCH_CONVERTER_H
+
+#include <QHash>
+#include <QStringList>
+#include <QVariantMap>
+
+#include "reality_lib_export.h"
+
+
+namespace Reality {
+
+/**
+ * Converts the materials of several objects in parallel.
+ *
+ * When a scene is loaded the host sends the data of all the materials of
+ * all the objects. The conversion of each material is independent from the
+ * others so the materials are queued here and then converted by a pool of
+ * threads, one object per thread. The materials of the same object are
+ * converted in the order in which they have been queued, by the same thread.
+ *
+ * The objects must be already in the scene when \ref convert() is called.
+ * The access to ACSEL and to the scene data is serialized by
+ * \ref ReGeometryObject, only the parsing of the material data and the
+ * creation of the textures run concurrently.
+ */
+class REALITY_LIB_EXPORT ReMaterialBatchConverter {
+
+private:
+  struct MaterialSource {
+    QString matID;
+    QVariantMap data;
+  };
+  typedef QList<MaterialSource> MaterialSourceList;
+
+  //! The IDs of the objects, in the order in which they have been queued
+  QStringList objectIDs;
+  QHash<QString, MaterialSourceList> sources;
+  int numMaterials;
+  int maxThreads;
+
+  class ObjectTask;
+
+public:
+  ReMaterialBatchConverter();
+
+  //! Queues a material for conversion. The data is the same passed to
+  //! \ref ReSceneData::addMaterial()
+  void addMaterial( const QString& objID,
+                    const QString& matID,
+                    const QVariantMap& matData );
+
+  //! Number of materials queued
+  inline int count() const {
+    return numMaterials;
+  }
+
+  //! The IDs of the objects that have materials in the queue
+  inline const QStringList& getObjectIDs() const {
+    return objectIDs;
+  }
+
+  //! Sets the maximum number of threads used by the conversion. Zero,
+  //! the default, uses one thread per core.
+  inline void setMaxThreads( const int newVal ) {
+    maxThreads = newVal;
+  }
+
+  //! Converts all the materials in the queue and adds them to their
+  //! objects. The method returns when all the materials have been
+  //! converted. The queue is then cleared.
+  void convert();
+
+  //! Discards all the materials in the queue
+  void clear();
+};
+
+} // namespace
+
+#endif
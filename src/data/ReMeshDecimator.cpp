@@ -0,0 +1,398 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#include "ReMeshDecimator.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <queue>
+
+#include "ReMeshRefiner.h"
+#include "ReProfiler.h"
+
+
+namespace Reality {
+
+//! Collapses that turn a face by more than 60 degrees are rejected
+#define RE_DECIMATOR_MIN_COS 0.5
+
+//! The quadric error of a vertex, a symmetric 4x4 matrix stored as its
+//! upper triangle
+struct ReQuadric {
+  double q[10];
+
+  void clear() {
+    for (int i = 0; i < 10; i++) {
+      q[i] = 0.0;
+    }
+  }
+
+  //! Adds the plane n.p + d = 0
+  void addPlane( const double nx, const double ny, const double nz, const double d ) {
+    q[0] += nx*nx; q[1] += nx*ny; q[2] += nx*nz; q[3] += nx*d;
+    q[4] += ny*ny; q[5] += ny*nz; q[6] += ny*d;
+    q[7] += nz*nz; q[8] += nz*d;
+    q[9] += d*d;
+  }
+
+  void add( const ReQuadric& other ) {
+    for (int i = 0; i < 10; i++) {
+      q[i] += other.q[i];
+    }
+  }
+
+  //! Sum of the squared distances of p from the planes
+  double evaluate( const float* p ) const {
+    double x = p[0], y = p[1], z = p[2];
+    return q[0]*x*x + 2*q[1]*x*y + 2*q[2]*x*z + 2*q[3]*x
+         + q[4]*y*y + 2*q[5]*y*z + 2*q[6]*y
+         + q[7]*z*z + 2*q[8]*z
+         + q[9];
+  }
+};
+
+//! Moves the vertex from to the position of the vertex to
+struct ReCollapse {
+  double cost;
+  int from;
+  int to;
+  //! Version of the vertex from when the collapse was computed
+  int stamp;
+
+  //! The queue returns the cheapest collapse first
+  bool operator <( const ReCollapse& other ) const {
+    return cost > other.cost;
+  }
+};
+
+static void cross( const float* a, const float* b, const float* c, double* n ) {
+  double e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+  double e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+  n[0] = e1[1]*e2[2] - e1[2]*e2[1];
+  n[1] = e1[2]*e2[0] - e1[0]*e2[2];
+  n[2] = e1[0]*e2[1] - e1[1]*e2[0];
+}
+
+/**
+ * The state of one decimation
+ */
+class ReDecimation {
+
+private:
+  const float* points;
+  int* tris;
+
+  QVector<ReQuadric> quadrics;
+  //! Faces that use each vertex. Faces removed by a collapse are left in
+  //! the lists and skipped.
+  QVector< QVector<int> > vertexFaces;
+  QVector<bool> locked;
+  QVector<bool> vertexAlive;
+  QVector<bool> faceAlive;
+  QVector<int> stamps;
+
+  bool hasVertex( const int f, const int v ) const {
+    return tris[f*3] == v || tris[f*3 + 1] == v || tris[f*3 + 2] == v;
+  }
+
+  void getNeighbors( const int v, QVector<int>& neighbors ) const {
+    neighbors.clear();
+    const QVector<int>& faces = vertexFaces[v];
+    for (int i = 0; i < faces.count(); i++) {
+      int f = faces[i];
+      if (!faceAlive[f]) {
+        continue;
+      }
+      for (int k = 0; k < 3; k++) {
+        int w = tris[f*3 + k];
+        if (w != v && !neighbors.contains(w)) {
+          neighbors.append(w);
+        }
+      }
+    }
+  }
+
+  //! Checks that collapsing from into to keeps the mesh manifold and
+  //! doesn't flip any face
+  bool canCollapse( const int from, const int to, const QVector<int>& fromNeighbors ) const {
+    // The two vertices can share only the vertices opposite to their edge
+    int sharedFaces = 0;
+    const QVector<int>& faces = vertexFaces[from];
+    for (int i = 0; i < faces.count(); i++) {
+      if (faceAlive[faces[i]] && hasVertex(faces[i], to)) {
+        sharedFaces++;
+      }
+    }
+    QVector<int> toNeighbors;
+    getNeighbors(to, toNeighbors);
+    int sharedNeighbors = 0;
+    for (int i = 0; i < fromNeighbors.count(); i++) {
+      if (toNeighbors.contains(fromNeighbors[i])) {
+        sharedNeighbors++;
+      }
+    }
+    if (sharedNeighbors != sharedFaces) {
+      return false;
+    }
+
+    for (int i = 0; i < faces.count(); i++) {
+      int f = faces[i];
+      if (!faceAlive[f] || hasVertex(f, to)) {
+        continue;
+      }
+      const float* p[3];
+      const float* moved[3];
+      for (int k = 0; k < 3; k++) {
+        int v = tris[f*3 + k];
+        p[k] = points + v*3;
+        moved[k] = v == from ? points + to*3 : p[k];
+      }
+      double n0[3], n1[3];
+      cross(p[0], p[1], p[2], n0);
+      cross(moved[0], moved[1], moved[2], n1);
+      double dot = n0[0]*n1[0] + n0[1]*n1[1] + n0[2]*n1[2];
+      double len0 = sqrt(n0[0]*n0[0] + n0[1]*n0[1] + n0[2]*n0[2]);
+      double len1 = sqrt(n1[0]*n1[0] + n1[1]*n1[1] + n1[2]*n1[2]);
+      if (len1 == 0.0 || dot < RE_DECIMATOR_MIN_COS * len0 * len1) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+public:
+
+  ReDecimation( const float* points,
+                const int numVertices,
+                int* tris,
+                const int numTriangles ) :
+    points(points),
+    tris(tris)
+  {
+    quadrics.resize(numVertices);
+    vertexFaces.resize(numVertices);
+    locked.fill(false, numVertices);
+    vertexAlive.fill(true, numVertices);
+    faceAlive.fill(true, numTriangles);
+    stamps.fill(0, numVertices);
+
+    for (int v = 0; v < numVertices; v++) {
+      quadrics[v].clear();
+    }
+    for (int f = 0; f < numTriangles; f++) {
+      double n[3];
+      const float* a = points + tris[f*3]*3;
+      cross(a, points + tris[f*3 + 1]*3, points + tris[f*3 + 2]*3, n);
+      double len = sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+      for (int k = 0; k < 3; k++) {
+        vertexFaces[tris[f*3 + k]].append(f);
+      }
+      if (len == 0.0) {
+        continue;
+      }
+      n[0] /= len;
+      n[1] /= len;
+      n[2] /= len;
+      double d = -(n[0]*a[0] + n[1]*a[1] + n[2]*a[2]);
+      for (int k = 0; k < 3; k++) {
+        quadrics[tris[f*3 + k]].addPlane(n[0], n[1], n[2], d);
+      }
+    }
+    findLockedVertices(numVertices, numTriangles);
+  }
+
+  //! Locks the vertices on the boundary of the mesh and the vertices that
+  //! the host app has split along the seams
+  void findLockedVertices( const int numVertices, const int numTriangles ) {
+    QVector<int> canonical;
+    ReMeshRefiner::weldVertices(points, numVertices, canonical);
+    for (int v = 0; v < numVertices; v++) {
+      if (canonical[v] != v) {
+        locked[v] = true;
+        locked[canonical[v]] = true;
+      }
+    }
+    // The edges that are not shared by exactly two faces are on the
+    // boundary
+    QVector<quint64> edges(numTriangles * 3);
+    for (int f = 0; f < numTriangles; f++) {
+      for (int k = 0; k < 3; k++) {
+        quint64 a = canonical[tris[f*3 + k]];
+        quint64 b = canonical[tris[f*3 + (k+1)%3]];
+        edges[f*3 + k] = a < b ? (a << 32) | b : (b << 32) | a;
+      }
+    }
+    std::sort(edges.begin(), edges.end());
+    int count = edges.count();
+    int i = 0;
+    while( i < count ) {
+      int j = i + 1;
+      while( j < count && edges[j] == edges[i] ) {
+        j++;
+      }
+      if (j - i != 2) {
+        locked[static_cast<int>(edges[i] >> 32)] = true;
+        locked[static_cast<int>(edges[i] & 0xFFFFFFFF)] = true;
+      }
+      i = j;
+    }
+    // The vertices split at the seams share the lock of their position
+    for (int v = 0; v < numVertices; v++) {
+      if (locked[canonical[v]]) {
+        locked[v] = true;
+      }
+    }
+  }
+
+  //! Finds the cheapest valid collapse of the vertex v
+  bool findCollapse( const int v, ReCollapse& collapse ) const {
+    if (locked[v] || !vertexAlive[v]) {
+      return false;
+    }
+    QVector<int> neighbors;
+    getNeighbors(v, neighbors);
+    bool found = false;
+    for (int i = 0; i < neighbors.count(); i++) {
+      int u = neighbors[i];
+      ReQuadric q = quadrics[v];
+      q.add(quadrics[u]);
+      double cost = q.evaluate(points + u*3);
+      if ( (!found || cost < collapse.cost) && canCollapse(v, u, neighbors) ) {
+        collapse.cost  = cost;
+        collapse.from  = v;
+        collapse.to    = u;
+        collapse.stamp = stamps[v];
+        found = true;
+      }
+    }
+    return found;
+  }
+
+  int run( const int numTriangles, const double maxCost, const int minTriangles ) {
+    std::priority_queue<ReCollapse> queue;
+    int numVertices = vertexAlive.count();
+    for (int v = 0; v < numVertices; v++) {
+      ReCollapse collapse;
+      if (findCollapse(v, collapse)) {
+        queue.push(collapse);
+      }
+    }
+
+    int liveTriangles = numTriangles;
+    QVector<int> affected;
+    while( !queue.empty() && liveTriangles > minTriangles ) {
+      ReCollapse collapse = queue.top();
+      queue.pop();
+      if (collapse.cost > maxCost) {
+        break;
+      }
+      int from = collapse.from;
+      int to   = collapse.to;
+      // The neighborhood has changed since the collapse was computed
+      if ( !vertexAlive[from] || !vertexAlive[to] || stamps[from] != collapse.stamp ) {
+        continue;
+      }
+
+      QVector<int>& faces = vertexFaces[from];
+      for (int i = 0; i < faces.count(); i++) {
+        int f = faces[i];
+        if (!faceAlive[f]) {
+          continue;
+        }
+        if (hasVertex(f, to)) {
+          faceAlive[f] = false;
+          liveTriangles--;
+          continue;
+        }
+        for (int k = 0; k < 3; k++) {
+          if (tris[f*3 + k] == from) {
+            tris[f*3 + k] = to;
+          }
+        }
+        vertexFaces[to].append(f);
+      }
+      faces.clear();
+      vertexAlive[from] = false;
+      quadrics[to].add(quadrics[from]);
+
+      // The collapses of the vertices around to must be computed again
+      getNeighbors(to, affected);
+      affected.append(to);
+      for (int i = 0; i < affected.count(); i++) {
+        int w = affected[i];
+        stamps[w]++;
+        ReCollapse next;
+        if (findCollapse(w, next)) {
+          queue.push(next);
+        }
+      }
+    }
+    return numTriangles - liveTriangles;
+  }
+
+  inline bool isFaceAlive( const int f ) const {
+    return faceAlive[f];
+  }
+};
+
+/*
+ * ReMeshDecimator
+ */
+ReMeshDecimator::ReMeshDecimator() {
+}
+
+int ReMeshDecimator::decimate( const float maxError, const int minTriangles ) {
+  RE_PROFILE_SCOPE("DecimateMesh");
+  int numVertices  = getNumVertices();
+  int numTriangles = getNumTriangles();
+  ReDecimation decimation(points.constData(), numVertices, triangles.data(), numTriangles);
+  int removed = decimation.run(numTriangles,
+                               static_cast<double>(maxError) * maxError,
+                               minTriangles);
+  if (removed == 0) {
+    return 0;
+  }
+
+  // Remove the collapsed faces and the vertices that are not used anymore
+  QVector<int> newIndex(numVertices, -1);
+  QVector<int> newTriangles;
+  newTriangles.reserve((numTriangles - removed) * 3);
+  int newNumVertices = 0;
+  for (int f = 0; f < numTriangles; f++) {
+    if (!decimation.isFaceAlive(f)) {
+      continue;
+    }
+    for (int k = 0; k < 3; k++) {
+      int v = triangles[f*3 + k];
+      if (newIndex[v] < 0) {
+        newIndex[v] = newNumVertices++;
+      }
+      newTriangles.append(newIndex[v]);
+    }
+  }
+  QVector<float> newPoints(newNumVertices*3);
+  QVector<float> newNormals(newNumVertices*3);
+  QVector<float> newUVs(uvs.isEmpty() ? 0 : newNumVertices*2);
+  for (int v = 0; v < numVertices; v++) {
+    int n = newIndex[v];
+    if (n < 0) {
+      continue;
+    }
+    memcpy(newPoints.data() + n*3, points.constData() + v*3, sizeof(float) * 3);
+    memcpy(newNormals.data() + n*3, normals.constData() + v*3, sizeof(float) * 3);
+    if (!uvs.isEmpty()) {
+      memcpy(newUVs.data() + n*2, uvs.constData() + v*2, sizeof(float) * 2);
+    }
+  }
+  points    = newPoints;
+  normals   = newNormals;
+  uvs       = newUVs;
+  triangles = newTriangles;
+  return removed;
+}
+
+} // namespace
@@ -0,0 +1,54 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#ifndef RE_MESH_DECIMATOR_H
+#define RE_MESH_DECIMATOR_H
+
+#include <QVector>
+
+#include "reality_lib_export.h"
+#include "ReDefs.h"
+#include "ReGeometry.h"
+
+
+namespace Reality {
+
+//! Meshes with fewer triangles than this are not decimated
+#define RE_LOD_MIN_TRIANGLES 512
+
+/**
+ * Reduces the number of triangles of a mesh, used to export a lighter
+ * version of the objects that are far from the camera.
+ *
+ * The decimation collapses edges in order of their quadric error, the
+ * sum of the squared distances from the planes of the original faces,
+ * and stops when the error of the next collapse is larger than the
+ * tolerance. The vertices on the boundary of the mesh and the vertices
+ * split by the host app along UV seams or hard edges are never moved, so
+ * the outline of the material, its UV layout and the seams with the
+ * nearby materials are preserved. Collapses that would flip a face are
+ * rejected.
+ */
+class REALITY_LIB_EXPORT ReMeshDecimator : public ReMeshData {
+
+public:
+
+  ReMeshDecimator();
+
+  /**
+   * Decimates the mesh.
+   * \param maxError The largest distance, in the units of the mesh, that
+   *                 the surface can move
+   * \param minTriangles The decimation stops when the mesh reaches this
+   *                     number of triangles
+   * \return The number of triangles removed
+   */
+  int decimate( const float maxError, const int minTriangles );
+};
+
+} // namespace
+
+#endif
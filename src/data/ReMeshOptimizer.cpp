@@ -0,0 +1,334 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#include "ReMeshOptimizer.h"
+
+#include <float.h>
+#include <algorithm>
+
+#include "ReParallel.h"
+#include "ReProfiler.h"
+
+
+namespace Reality {
+
+//! Bits per axis of the Morton codes
+#define RE_MORTON_BITS 10
+
+//! Spreads the lower 10 bits of v so that there are two zero bits
+//! between each of them
+static quint32 spreadBits( quint32 v ) {
+  v &= 0x3ff;
+  v = (v | (v << 16)) & 0x030000ff;
+  v = (v | (v << 8))  & 0x0300f00f;
+  v = (v | (v << 4))  & 0x030c30c3;
+  v = (v | (v << 2))  & 0x09249249;
+  return v;
+}
+
+class ReMortonCodeJob : public ReRangeJob {
+public:
+  const float* points;
+  float boxMin[3];
+  float scale[3];
+  quint32* codes;
+
+  void process( const int begin, const int end ) {
+    const float maxCell = static_cast<float>((1 << RE_MORTON_BITS) - 1);
+    for (int i = begin; i < end; i++) {
+      quint32 cell[3];
+      for (int k = 0; k < 3; k++) {
+        float c = (points[i*3 + k] - boxMin[k]) * scale[k];
+        cell[k] = static_cast<quint32>(c < 0.0f ? 0.0f : (c > maxCell ? maxCell : c));
+      }
+      codes[i] = spreadBits(cell[0]) | (spreadBits(cell[1]) << 1) | (spreadBits(cell[2]) << 2);
+    }
+  }
+};
+
+//! Sorts the vertices by Morton code, the index breaks the ties so that
+//! the result doesn't depend on the sort
+class ReMortonLess {
+  const quint32* codes;
+
+public:
+  ReMortonLess( const quint32* codes ) : codes(codes) {
+  }
+
+  bool operator()( const int a, const int b ) const {
+    return codes[a] != codes[b] ? codes[a] < codes[b] : a < b;
+  }
+};
+
+//! Copies the vertices to their new position
+class ReGatherVertexJob : public ReRangeJob {
+public:
+  const int* oldIndex;
+  const float* points;
+  const float* normals;
+  const float* uvs;
+  float* newPoints;
+  float* newNormals;
+  float* newUVs;
+
+  void process( const int begin, const int end ) {
+    for (int i = begin; i < end; i++) {
+      int v = oldIndex[i];
+      for (int k = 0; k < 3; k++) {
+        newPoints[i*3 + k]  = points[v*3 + k];
+        newNormals[i*3 + k] = normals[v*3 + k];
+      }
+      if (uvs) {
+        newUVs[i*2]     = uvs[v*2];
+        newUVs[i*2 + 1] = uvs[v*2 + 1];
+      }
+    }
+  }
+};
+
+//! Copies the triangles in their new order, with the new vertex indices
+class ReGatherTriangleJob : public ReRangeJob {
+public:
+  const int* order;
+  const int* newIndex;
+  const int* triangles;
+  int* newTriangles;
+
+  void process( const int begin, const int end ) {
+    for (int i = begin; i < end; i++) {
+      const int* t = triangles + order[i]*3;
+      for (int k = 0; k < 3; k++) {
+        newTriangles[i*3 + k] = newIndex[t[k]];
+      }
+    }
+  }
+};
+
+ReMeshOptimizer::ReMeshOptimizer() :
+  cacheSize(RE_MESH_OPTIMIZER_CACHE_SIZE),
+  mortonOrder(false),
+  maxThreads(0)
+{
+}
+
+void ReMeshOptimizer::getMortonOrder( QVector<int>& order ) const {
+  int numVertices = getNumVertices();
+  ReMortonCodeJob codeJob;
+  for (int k = 0; k < 3; k++) {
+    codeJob.boxMin[k] = FLT_MAX;
+  }
+  float boxMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+  for (int i = 0; i < numVertices; i++) {
+    for (int k = 0; k < 3; k++) {
+      codeJob.boxMin[k] = qMin(codeJob.boxMin[k], points[i*3 + k]);
+      boxMax[k] = qMax(boxMax[k], points[i*3 + k]);
+    }
+  }
+  for (int k = 0; k < 3; k++) {
+    float size = boxMax[k] - codeJob.boxMin[k];
+    codeJob.scale[k] = size > 0.0f ? ((1 << RE_MORTON_BITS) - 1) / size : 0.0f;
+  }
+  QVector<quint32> codes(numVertices);
+  codeJob.points = points.constData();
+  codeJob.codes  = codes.data();
+  runParallel(codeJob, numVertices, maxThreads);
+
+  order.resize(numVertices);
+  for (int i = 0; i < numVertices; i++) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), ReMortonLess(codes.constData()));
+}
+
+void ReMeshOptimizer::getTriangleOrder( const QVector<int>& seedOrder, 
+                                        QVector<int>& order ) const 
+{
+  int numVertices  = getNumVertices();
+  int numTriangles = getNumTriangles();
+  const int* tris  = triangles.constData();
+
+  // The triangles that use each vertex
+  QVector<int> adjStart(numVertices + 1, 0);
+  for (int i = 0; i < numTriangles * 3; i++) {
+    adjStart[tris[i] + 1]++;
+  }
+  for (int i = 0; i < numVertices; i++) {
+    adjStart[i+1] += adjStart[i];
+  }
+  QVector<int> adjTriangles(numTriangles * 3);
+  QVector<int> adjFill(adjStart);
+  for (int i = 0; i < numTriangles * 3; i++) {
+    adjTriangles[adjFill[tris[i]]++] = i / 3;
+  }
+
+  // Number of triangles of each vertex not yet emitted
+  QVector<int> live(numVertices);
+  for (int i = 0; i < numVertices; i++) {
+    live[i] = adjStart[i+1] - adjStart[i];
+  }
+  // Time at which each vertex entered the simulated cache
+  QVector<int> cacheTime(numVertices, 0);
+  QVector<char> emitted(numTriangles, 0);
+  QVector<int> deadEnd;
+  QVector<int> candidates;
+  int time = cacheSize + 1;
+  int seedCursor = 0;
+
+  order.clear();
+  order.reserve(numTriangles);
+  while (seedCursor < numVertices && live[seedOrder[seedCursor]] == 0) {
+    seedCursor++;
+  }
+  int fanVertex = seedCursor < numVertices ? seedOrder[seedCursor] : -1;
+
+  while (fanVertex >= 0) {
+    // Emits the triangles around the vertex
+    candidates.clear();
+    for (int j = adjStart[fanVertex]; j < adjStart[fanVertex + 1]; j++) {
+      int t = adjTriangles[j];
+      if (emitted[t]) {
+        continue;
+      }
+      emitted[t] = 1;
+      order << t;
+      for (int k = 0; k < 3; k++) {
+        int v = tris[t*3 + k];
+        deadEnd << v;
+        candidates << v;
+        live[v]--;
+        if (time - cacheTime[v] > cacheSize) {
+          cacheTime[v] = time++;
+        }
+      }
+    }
+    // The next fan is around the vertex that stays longest in the cache
+    // and whose triangles still fit in it
+    int best = -1;
+    int bestPriority = -1;
+    for (int i = 0; i < candidates.count(); i++) {
+      int v = candidates[i];
+      if (live[v] == 0) {
+        continue;
+      }
+      int priority = 0;
+      if (time - cacheTime[v] + 2 * live[v] <= cacheSize) {
+        priority = time - cacheTime[v];
+      }
+      if (priority > bestPriority) {
+        best = v;
+        bestPriority = priority;
+      }
+    }
+    // At a dead end the walk goes back to the most recent vertex with
+    // triangles left, or to the next one in the seed order
+    while (best < 0 && !deadEnd.isEmpty()) {
+      int v = deadEnd.last();
+      deadEnd.pop_back();
+      if (live[v] > 0) {
+        best = v;
+      }
+    }
+    while (best < 0 && seedCursor < numVertices) {
+      int v = seedOrder[seedCursor++];
+      if (live[v] > 0) {
+        best = v;
+      }
+    }
+    fanVertex = best;
+  }
+}
+
+void ReMeshOptimizer::optimize() {
+  int numVertices  = getNumVertices();
+  int numTriangles = getNumTriangles();
+  if (numTriangles == 0) {
+    return;
+  }
+  RE_PROFILE_SCOPE("OptimizeMesh");
+
+  QVector<int> seedOrder;
+  if (mortonOrder) {
+    getMortonOrder(seedOrder);
+  }
+  else {
+    seedOrder.resize(numVertices);
+    for (int i = 0; i < numVertices; i++) {
+      seedOrder[i] = i;
+    }
+  }
+  QVector<int> order;
+  getTriangleOrder(seedOrder, order);
+
+  // The vertices are numbered in the order of first use. The vertices not
+  // used by any triangle are kept at the end.
+  QVector<int> newIndex(numVertices, -1);
+  QVector<int> oldIndex(numVertices);
+  int nextIndex = 0;
+  for (int i = 0; i < numTriangles; i++) {
+    const int* t = triangles.constData() + order[i]*3;
+    for (int k = 0; k < 3; k++) {
+      if (newIndex[t[k]] < 0) {
+        oldIndex[nextIndex] = t[k];
+        newIndex[t[k]] = nextIndex++;
+      }
+    }
+  }
+  for (int i = 0; i < numVertices; i++) {
+    if (newIndex[i] < 0) {
+      oldIndex[nextIndex] = i;
+      newIndex[i] = nextIndex++;
+    }
+  }
+
+  QVector<float> newPoints(numVertices*3);
+  QVector<float> newNormals(numVertices*3);
+  QVector<float> newUVs(uvs.count());
+  ReGatherVertexJob vertexJob;
+  vertexJob.oldIndex   = oldIndex.constData();
+  vertexJob.points     = points.constData();
+  vertexJob.normals    = normals.constData();
+  vertexJob.uvs        = uvs.isEmpty() ? NULL : uvs.constData();
+  vertexJob.newPoints  = newPoints.data();
+  vertexJob.newNormals = newNormals.data();
+  vertexJob.newUVs     = newUVs.data();
+  runParallel(vertexJob, numVertices, maxThreads);
+
+  QVector<int> newTriangles(numTriangles*3);
+  ReGatherTriangleJob triangleJob;
+  triangleJob.order        = order.constData();
+  triangleJob.newIndex     = newIndex.constData();
+  triangleJob.triangles    = triangles.constData();
+  triangleJob.newTriangles = newTriangles.data();
+  runParallel(triangleJob, numTriangles, maxThreads);
+
+  points    = newPoints;
+  normals   = newNormals;
+  uvs       = newUVs;
+  triangles = newTriangles;
+}
+
+float ReMeshOptimizer::getACMR( const int* tris, const int numTriangles, const int cacheSize ) {
+  if (numTriangles == 0) {
+    return 0.0f;
+  }
+  int maxIndex = 0;
+  for (int i = 0; i < numTriangles * 3; i++) {
+    maxIndex = qMax(maxIndex, tris[i]);
+  }
+  // With a FIFO cache a vertex is still cached if fewer than cacheSize
+  // misses happened after the miss that loaded it
+  QVector<int> loadedAt(maxIndex + 1, -cacheSize - 1);
+  int misses = 0;
+  for (int i = 0; i < numTriangles * 3; i++) {
+    int v = tris[i];
+    if (misses - loadedAt[v] >= cacheSize) {
+      loadedAt[v] = misses++;
+    }
+  }
+  return static_cast<float>(misses) / numTriangles;
+}
+
+} // namespace
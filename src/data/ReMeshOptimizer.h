@@ -0,0 +1,90 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#ifndef RE_MESH_OPTIMIZER_H
+#define RE_MESH_OPTIMIZER_H
+
+#include <QVector>
+
+#include "reality_lib_export.h"
+#include "ReDefs.h"
+#include "ReGeometry.h"
+
+
+namespace Reality {
+
+//! Meshes with fewer triangles than this are not reordered
+#define RE_MESH_OPTIMIZER_MIN_TRIANGLES 256
+
+//! Size of the vertex cache targeted by the reordering
+#define RE_MESH_OPTIMIZER_CACHE_SIZE 32
+
+/**
+ * Reorders the triangles and the vertices of a mesh for locality.
+ *
+ * The host apps send the triangles in the order of their facets and the
+ * vertices in the order in which they are first seen, which for large
+ * figures scatters the data of nearby triangles across the buffers. The
+ * renderer reads the mesh, builds its acceleration structure and shades
+ * the hits through those buffers, so the scattering costs time when the
+ * scene is loaded and rendered.
+ *
+ * The triangles are reordered with the Tipsify algorithm, by Sander,
+ * Nehab and Barczak, which walks the mesh in fans around the vertices
+ * that are still in a simulated vertex cache. Then the vertices are
+ * renumbered in the order in which the triangles use them. Optionally,
+ * the walk restarts, when it reaches a dead end, from the next vertex
+ * along a Morton curve, so that also the clusters of triangles follow the
+ * layout of the mesh in space.
+ *
+ * Only the order changes: every triangle keeps its vertices, with the
+ * same winding, and every vertex keeps its position, normal and UV.
+ */
+class REALITY_LIB_EXPORT ReMeshOptimizer : public ReMeshData {
+
+private:
+  int cacheSize;
+  bool mortonOrder;
+  int maxThreads;
+
+  //! Returns the vertices sorted along a Morton curve
+  void getMortonOrder( QVector<int>& order ) const;
+
+  //! Returns the new order of the triangles
+  void getTriangleOrder( const QVector<int>& seedOrder, QVector<int>& order ) const;
+
+public:
+
+  ReMeshOptimizer();
+
+  void setCacheSize( const int newVal ) {
+    cacheSize = newVal;
+  }
+
+  //! If true the dead ends of the walk restart along a Morton curve
+  void setMortonOrder( const bool newVal ) {
+    mortonOrder = newVal;
+  }
+
+  //! Number of threads used, zero to use all the cores
+  void setMaxThreads( const int numThreads ) {
+    maxThreads = numThreads;
+  }
+
+  //! Reorders the triangles and the vertices
+  void optimize();
+
+  /**
+   * Simulates a FIFO vertex cache and returns the average number of
+   * misses per triangle, between 0.5, for an ideal order of a large
+   * regular mesh, and 3.
+   */
+  static float getACMR( const int* tris, const int numTriangles, const int cacheSize );
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,804 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#include "ReMeshRefiner.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#if defined(_WIN32)
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
+#include "ReDataDir.h"
+#include "ReLogger.h"
+#include "ReParallel.h"
+#include "ReProfiler.h"
+
+
+namespace Reality {
+
+#define RE_MESH_CACHE_DIR       "MeshCache"
+//! Length of the keys of the cached meshes, a SHA1 in hex
+#define RE_MESH_CACHE_KEY_SIZE  40
+
+/*
+ * Displacement
+ */
+ReDisplacementSampler::ReDisplacementSampler() :
+  fileTime(0),
+  channel(RGB_Mean),
+  gain(1.0f),
+  gamma(1.0f),
+  uScale(1.0f),
+  vScale(1.0f),
+  uDelta(0.0f),
+  vDelta(0.0f),
+  dmNegative(0.0f),
+  dmPositive(1.0f),
+  dmStrength(1.0f)
+{
+}
+
+bool ReDisplacementSampler::load( const QString& mapFileName ) {
+  RE_PROFILE_SCOPE("LoadDisplacementMap");
+  QImage img(mapFileName);
+  if (img.isNull()) {
+    RE_LOG_WARN() << "Cannot read the displacement map " << QSS(mapFileName);
+    return false;
+  }
+  setImage(img);
+  fileName = mapFileName;
+  fileTime = QFileInfo(mapFileName).lastModified().toTime_t();
+  return true;
+}
+
+void ReDisplacementSampler::setImage( const QImage& img ) {
+  image = img.convertToFormat(QImage::Format_RGB32);
+  fileName.clear();
+  fileTime = 0;
+}
+
+void ReDisplacementSampler::setMapping( const float newUScale,
+                                        const float newVScale,
+                                        const float newUDelta,
+                                        const float newVDelta )
+{
+  uScale = newUScale;
+  vScale = newVScale;
+  uDelta = newUDelta;
+  vDelta = newVDelta;
+}
+
+void ReDisplacementSampler::setLimits( const float negative,
+                                       const float positive,
+                                       const float strength )
+{
+  dmNegative = negative;
+  dmPositive = positive;
+  dmStrength = strength;
+}
+
+float ReDisplacementSampler::texel( const int x, const int y ) const {
+  QRgb c = reinterpret_cast<const QRgb*>(image.constScanLine(y))[x];
+  switch( channel ) {
+    case RGB_Red:
+      return qRed(c) / 255.0f;
+    case RGB_Green:
+      return qGreen(c) / 255.0f;
+    case RGB_Blue:
+      return qBlue(c) / 255.0f;
+    case RGB_Mean:
+      break;
+  }
+  return (qRed(c) + qGreen(c) + qBlue(c)) / (3 * 255.0f);
+}
+
+float ReDisplacementSampler::sample( const float u, const float v ) const {
+  int width  = image.width();
+  int height = image.height();
+  // Same mapping used by Lux, the image is repeated and the first row
+  // of the image is at t = 0
+  float s = uScale * u + uDelta;
+  float t = vScale * v + vDelta;
+  float x = (s - floor(s)) * width - 0.5f;
+  float y = (t - floor(t)) * height - 0.5f;
+  int x0 = static_cast<int>(floor(x));
+  int y0 = static_cast<int>(floor(y));
+  float fx = x - x0;
+  float fy = y - y0;
+  x0 = ((x0 % width) + width) % width;
+  y0 = ((y0 % height) + height) % height;
+  int x1 = (x0 + 1) % width;
+  int y1 = (y0 + 1) % height;
+
+  float top    = texel(x0, y0) + (texel(x1, y0) - texel(x0, y0)) * fx;
+  float bottom = texel(x0, y1) + (texel(x1, y1) - texel(x0, y1)) * fx;
+  float value  = top + (bottom - top) * fy;
+  if (gamma != 1.0f) {
+    value = pow(value, gamma);
+  }
+  value *= gain;
+  // The mix texture that clamps the map between the two limits
+  return ((1.0f - value) * dmNegative + value * dmPositive) * dmStrength;
+}
+
+QByteArray ReDisplacementSampler::getKey() const {
+  QString source;
+  if (fileName.isEmpty()) {
+    source = QCryptographicHash::hash(
+               QByteArray::fromRawData(reinterpret_cast<const char*>(image.constBits()),
+                                       image.byteCount()),
+               QCryptographicHash::Sha1
+             ).toHex();
+  }
+  else {
+    source = fileName + "@" + QString::number(fileTime);
+  }
+  // Concatenated, the file name can contain sequences like %1
+  QString key = source + "|" +
+                QString::number(channel) + "|" +
+                QString::number(gain) + "|" +
+                QString::number(gamma) + "|" +
+                QString::number(uScale) + "|" +
+                QString::number(vScale) + "|" +
+                QString::number(uDelta) + "|" +
+                QString::number(vDelta) + "|" +
+                QString::number(dmNegative) + "|" +
+                QString::number(dmPositive) + "|" +
+                QString::number(dmStrength) + "|" +
+                QString::number(image.width()) + "x" +
+                QString::number(image.height());
+  return key.toUtf8();
+}
+
+/*
+ * Subdivision
+ */
+
+//! A side of a triangle, identified by the indices of its two vertices
+struct ReEdgeRef {
+  quint64 key;
+  int faceEdge;
+
+  inline bool operator <( const ReEdgeRef& e ) const {
+    return key < e.key || (key == e.key && faceEdge < e.faceEdge);
+  }
+};
+
+static inline quint64 edgeKey( int a, int b ) {
+  if (a > b) {
+    qSwap(a, b);
+  }
+  return (static_cast<quint64>(a) << 32) | static_cast<quint32>(b);
+}
+
+//! An edge of the mesh with the vertices welded by position
+struct ReCanonicalEdge {
+  int v0, v1;
+  //! The vertices opposite to the edge in the first two faces
+  int opposite[2];
+  int numFaces;
+};
+
+//! Orders the vertices by position, and by index for the same position
+class RePositionLess {
+  const float* p;
+
+public:
+  RePositionLess( const float* p ) : p(p) {
+  }
+
+  inline bool operator()( const int a, const int b ) const {
+    const float* pa = p + a*3;
+    const float* pb = p + b*3;
+    for (int i = 0; i < 3; i++) {
+      if (pa[i] != pb[i]) {
+        return pa[i] < pb[i];
+      }
+    }
+    return a < b;
+  }
+};
+
+//! Computes the new position of the existing vertices
+class ReEvenVertexJob : public ReRangeJob {
+public:
+  const float* points;
+  const int* canonical;
+  const float* ringSum;
+  const int* valence;
+  const float* boundarySum;
+  const int* boundaryCount;
+  bool sharpBoundary;
+  float* newPoints;
+
+  void process( const int begin, const int end ) {
+    for (int i = begin; i < end; i++) {
+      // The duplicates of a vertex all use the data of the same vertex,
+      // so they get exactly the same position
+      int c = canonical[i];
+      const float* p = points + c*3;
+      float* np = newPoints + i*3;
+      if (boundaryCount[c] > 0) {
+        if (sharpBoundary || boundaryCount[c] != 2) {
+          np[0] = p[0];
+          np[1] = p[1];
+          np[2] = p[2];
+        }
+        else {
+          const float* bs = boundarySum + c*3;
+          for (int k = 0; k < 3; k++) {
+            np[k] = 0.75f * p[k] + 0.125f * bs[k];
+          }
+        }
+        continue;
+      }
+      int n = valence[c];
+      if (n == 0) {
+        np[0] = p[0];
+        np[1] = p[1];
+        np[2] = p[2];
+        continue;
+      }
+      float beta = n == 3 ? 3.0f/16.0f : 3.0f/(8.0f*n);
+      const float* rs = ringSum + c*3;
+      for (int k = 0; k < 3; k++) {
+        np[k] = (1.0f - n*beta) * p[k] + beta * rs[k];
+      }
+    }
+  }
+};
+
+//! Creates the vertices in the middle of the edges
+class ReOddVertexJob : public ReRangeJob {
+public:
+  int numVertices;
+  const float* points;
+  const float* normals;
+  const float* uvs;
+  const int* triangles;
+  const int* edgeFirst;
+  const int* edgeCanonical;
+  const int* canonicalRep;
+  const ReCanonicalEdge* canonicalEdges;
+  float* newPoints;
+  float* newNormals;
+  float* newUVs;
+  int* newCanonical;
+
+  void process( const int begin, const int end ) {
+    for (int e = begin; e < end; e++) {
+      int o = numVertices + e;
+      int fe = edgeFirst[e];
+      int f = fe / 3;
+      int k = fe % 3;
+      int a = triangles[f*3 + k];
+      int b = triangles[f*3 + (k+1)%3];
+      const ReCanonicalEdge& ce = canonicalEdges[edgeCanonical[e]];
+
+      const float* p0 = points + ce.v0*3;
+      const float* p1 = points + ce.v1*3;
+      float* np = newPoints + o*3;
+      if (ce.numFaces == 2 && ce.v0 != ce.v1) {
+        const float* q0 = points + ce.opposite[0]*3;
+        const float* q1 = points + ce.opposite[1]*3;
+        for (int i = 0; i < 3; i++) {
+          np[i] = 0.375f * (p0[i] + p1[i]) + 0.125f * (q0[i] + q1[i]);
+        }
+      }
+      else {
+        for (int i = 0; i < 3; i++) {
+          np[i] = 0.5f * (p0[i] + p1[i]);
+        }
+      }
+
+      const float* na = normals + a*3;
+      const float* nb = normals + b*3;
+      float* nn = newNormals + o*3;
+      float len = 0.0f;
+      for (int i = 0; i < 3; i++) {
+        nn[i] = na[i] + nb[i];
+        len += nn[i] * nn[i];
+      }
+      len = sqrt(len);
+      for (int i = 0; i < 3; i++) {
+        nn[i] = len > 0.0f ? nn[i] / len : na[i];
+      }
+
+      if (uvs) {
+        newUVs[o*2]   = 0.5f * (uvs[a*2]   + uvs[b*2]);
+        newUVs[o*2+1] = 0.5f * (uvs[a*2+1] + uvs[b*2+1]);
+      }
+      newCanonical[o] = numVertices + canonicalRep[edgeCanonical[e]];
+    }
+  }
+};
+
+//! Splits each triangle in four
+class ReSplitFaceJob : public ReRangeJob {
+public:
+  int numVertices;
+  const int* triangles;
+  const int* edgeOf;
+  int* newTriangles;
+
+  void process( const int begin, const int end ) {
+    for (int f = begin; f < end; f++) {
+      const int* t = triangles + f*3;
+      int mab = numVertices + edgeOf[f*3];
+      int mbc = numVertices + edgeOf[f*3 + 1];
+      int mca = numVertices + edgeOf[f*3 + 2];
+      int* nt = newTriangles + f*12;
+      nt[0]  = t[0]; nt[1]  = mab;  nt[2]  = mca;
+      nt[3]  = mab;  nt[4]  = t[1]; nt[5]  = mbc;
+      nt[6]  = mca;  nt[7]  = mbc;  nt[8]  = t[2];
+      nt[9]  = mab;  nt[10] = mbc;  nt[11] = mca;
+    }
+  }
+};
+
+//! Computes the normal of each face, weighted by the area of the face
+class ReFaceNormalJob : public ReRangeJob {
+public:
+  const float* points;
+  const int* triangles;
+  float* faceNormals;
+
+  void process( const int begin, const int end ) {
+    for (int f = begin; f < end; f++) {
+      const float* p0 = points + triangles[f*3]*3;
+      const float* p1 = points + triangles[f*3 + 1]*3;
+      const float* p2 = points + triangles[f*3 + 2]*3;
+      float e1[3], e2[3];
+      for (int i = 0; i < 3; i++) {
+        e1[i] = p1[i] - p0[i];
+        e2[i] = p2[i] - p0[i];
+      }
+      float* n = faceNormals + f*3;
+      n[0] = e1[1]*e2[2] - e1[2]*e2[1];
+      n[1] = e1[2]*e2[0] - e1[0]*e2[2];
+      n[2] = e1[0]*e2[1] - e1[1]*e2[0];
+    }
+  }
+};
+
+class ReVertexNormalJob : public ReRangeJob {
+public:
+  const int* canonical;
+  const float* accumulated;
+  float* normals;
+
+  void process( const int begin, const int end ) {
+    for (int i = begin; i < end; i++) {
+      const float* acc = accumulated + canonical[i]*3;
+      float len = sqrt(acc[0]*acc[0] + acc[1]*acc[1] + acc[2]*acc[2]);
+      if (len <= 0.0f) {
+        continue;
+      }
+      float* n = normals + i*3;
+      // Keep the orientation of the normals of the host app, the winding
+      // of the faces doesn't always agree with it
+      float sign = (acc[0]*n[0] + acc[1]*n[1] + acc[2]*n[2]) < 0.0f ? -1.0f : 1.0f;
+      for (int k = 0; k < 3; k++) {
+        n[k] = sign * acc[k] / len;
+      }
+    }
+  }
+};
+
+class ReDisplaceJob : public ReRangeJob {
+public:
+  const ReDisplacementSampler* sampler;
+  float scale;
+  const int* canonical;
+  const float* points;
+  const float* normals;
+  const float* uvs;
+  float* newPoints;
+
+  void process( const int begin, const int end ) {
+    for (int i = begin; i < end; i++) {
+      // The duplicates along the UV seams are moved by the same amount,
+      // so that the seams stay closed
+      int c = canonical[i];
+      float d = sampler->sample(uvs[c*2], uvs[c*2+1]) * scale;
+      for (int k = 0; k < 3; k++) {
+        newPoints[i*3 + k] = points[c*3 + k] + normals[c*3 + k] * d;
+      }
+    }
+  }
+};
+
+ReMeshRefiner::ReMeshRefiner() :
+  maxThreads(0)
+{
+}
+
+void ReMeshRefiner::setMesh( const int numVertices,
+                             const ReVectorF* vertices,
+                             const ReVectorF* vertexNormals,
+                             const ReUVPoint* uvMap,
+                             const int numTriangles,
+                             const ReTriangle* tris )
+{
+  ReMeshData::setMesh(numVertices, vertices, vertexNormals, uvMap, numTriangles, tris);
+  findCanonicalVertices();
+}
+
+void ReMeshRefiner::findCanonicalVertices() {
+  weldVertices(points.constData(), getNumVertices(), canonical);
+}
+
+void ReMeshRefiner::weldVertices( const float* p, 
+                                  const int numVertices, 
+                                  QVector<int>& canonical ) 
+{
+  RE_PROFILE_SCOPE("WeldVertices");
+  QVector<int> order(numVertices);
+  for (int i = 0; i < numVertices; i++) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), RePositionLess(p));
+
+  canonical.resize(numVertices);
+  for (int i = 0; i < numVertices; i++) {
+    int v = order[i];
+    if (i > 0) {
+      int prev = order[i-1];
+      if (p[v*3] == p[prev*3] && p[v*3+1] == p[prev*3+1] && p[v*3+2] == p[prev*3+2]) {
+        canonical[v] = canonical[prev];
+        continue;
+      }
+    }
+    canonical[v] = v;
+  }
+}
+
+void ReMeshRefiner::subdivide( const int levels, const bool sharpBoundary ) {
+  RE_PROFILE_SCOPE("SubdivideMesh");
+  for (int i = 0; i < levels; i++) {
+    subdivideOnce(sharpBoundary);
+  }
+}
+
+void ReMeshRefiner::subdivideOnce( const bool sharpBoundary ) {
+  const int numVertices  = getNumVertices();
+  const int numTriangles = getNumTriangles();
+  const int numFaceEdges = numTriangles * 3;
+  const int* tris  = triangles.constData();
+  const int* canon = canonical.constData();
+
+  // The edges of the mesh as it's stored. There is one new vertex for
+  // each edge.
+  QVector<ReEdgeRef> refs(numFaceEdges);
+  for (int fe = 0; fe < numFaceEdges; fe++) {
+    int f = fe / 3;
+    int k = fe % 3;
+    refs[fe].key = edgeKey(tris[f*3 + k], tris[f*3 + (k+1)%3]);
+    refs[fe].faceEdge = fe;
+  }
+  std::sort(refs.begin(), refs.end());
+  QVector<int> edgeOf(numFaceEdges);
+  QVector<int> edgeFirst;
+  edgeFirst.reserve(numFaceEdges/2 + 1);
+  for (int i = 0; i < numFaceEdges; i++) {
+    if (i == 0 || refs[i].key != refs[i-1].key) {
+      edgeFirst.append(refs[i].faceEdge);
+    }
+    edgeOf[refs[i].faceEdge] = edgeFirst.count() - 1;
+  }
+  const int numEdges = edgeFirst.count();
+
+  // The edges with the vertices welded by position. They define the
+  // topology used by the subdivision rules.
+  for (int fe = 0; fe < numFaceEdges; fe++) {
+    int f = fe / 3;
+    int k = fe % 3;
+    refs[fe].key = edgeKey(canon[tris[f*3 + k]], canon[tris[f*3 + (k+1)%3]]);
+    refs[fe].faceEdge = fe;
+  }
+  std::sort(refs.begin(), refs.end());
+  QVector<ReCanonicalEdge> canonicalEdges;
+  canonicalEdges.reserve(numFaceEdges/2 + 1);
+  QVector<int> canonicalEdgeOf(numFaceEdges);
+  for (int i = 0; i < numFaceEdges; i++) {
+    int fe = refs[i].faceEdge;
+    int f = fe / 3;
+    int k = fe % 3;
+    if (i == 0 || refs[i].key != refs[i-1].key) {
+      ReCanonicalEdge ce;
+      ce.v0 = canon[tris[f*3 + k]];
+      ce.v1 = canon[tris[f*3 + (k+1)%3]];
+      ce.opposite[0] = ce.opposite[1] = -1;
+      ce.numFaces = 0;
+      canonicalEdges.append(ce);
+    }
+    ReCanonicalEdge& ce = canonicalEdges.last();
+    if (ce.numFaces < 2) {
+      ce.opposite[ce.numFaces] = canon[tris[f*3 + (k+2)%3]];
+    }
+    ce.numFaces++;
+    canonicalEdgeOf[fe] = canonicalEdges.count() - 1;
+  }
+  const int numCanonicalEdges = canonicalEdges.count();
+
+  // The new vertices of the edges that are split by a UV seam use the
+  // first of them as their canonical vertex
+  QVector<int> edgeCanonical(numEdges);
+  QVector<int> canonicalRep(numCanonicalEdges, -1);
+  for (int e = 0; e < numEdges; e++) {
+    int ce = canonicalEdgeOf[edgeFirst[e]];
+    edgeCanonical[e] = ce;
+    if (canonicalRep[ce] < 0) {
+      canonicalRep[ce] = e;
+    }
+  }
+
+  // Sums of the neighbors of each vertex, used by the rules for the
+  // existing vertices
+  QVector<float> ringSum(numVertices*3, 0.0f);
+  QVector<float> boundarySum(numVertices*3, 0.0f);
+  QVector<int> valence(numVertices, 0);
+  QVector<int> boundaryCount(numVertices, 0);
+  const float* p = points.constData();
+  for (int e = 0; e < numCanonicalEdges; e++) {
+    const ReCanonicalEdge& ce = canonicalEdges[e];
+    if (ce.v0 == ce.v1) {
+      continue;
+    }
+    valence[ce.v0]++;
+    valence[ce.v1]++;
+    bool isBoundary = ce.numFaces != 2;
+    if (isBoundary) {
+      boundaryCount[ce.v0]++;
+      boundaryCount[ce.v1]++;
+    }
+    for (int k = 0; k < 3; k++) {
+      ringSum[ce.v0*3 + k] += p[ce.v1*3 + k];
+      ringSum[ce.v1*3 + k] += p[ce.v0*3 + k];
+      if (isBoundary) {
+        boundarySum[ce.v0*3 + k] += p[ce.v1*3 + k];
+        boundarySum[ce.v1*3 + k] += p[ce.v0*3 + k];
+      }
+    }
+  }
+
+  const int newNumVertices = numVertices + numEdges;
+  QVector<float> newPoints(newNumVertices*3);
+  QVector<float> newNormals(newNumVertices*3);
+  QVector<float> newUVs(uvs.isEmpty() ? 0 : newNumVertices*2);
+  QVector<int> newCanonical(newNumVertices);
+  QVector<int> newTriangles(numTriangles*12);
+
+  ReEvenVertexJob evenJob;
+  evenJob.points        = p;
+  evenJob.canonical     = canon;
+  evenJob.ringSum       = ringSum.constData();
+  evenJob.valence       = valence.constData();
+  evenJob.boundarySum   = boundarySum.constData();
+  evenJob.boundaryCount = boundaryCount.constData();
+  evenJob.sharpBoundary = sharpBoundary;
+  evenJob.newPoints     = newPoints.data();
+  runParallel(evenJob, numVertices, maxThreads);
+
+  // The existing vertices keep their normals, UVs and canonical vertex
+  memcpy(newNormals.data(), normals.constData(), sizeof(float) * numVertices * 3);
+  if (!uvs.isEmpty()) {
+    memcpy(newUVs.data(), uvs.constData(), sizeof(float) * numVertices * 2);
+  }
+  memcpy(newCanonical.data(), canon, sizeof(int) * numVertices);
+
+  ReOddVertexJob oddJob;
+  oddJob.numVertices    = numVertices;
+  oddJob.points         = p;
+  oddJob.normals        = normals.constData();
+  oddJob.uvs            = uvs.isEmpty() ? NULL : uvs.constData();
+  oddJob.triangles      = tris;
+  oddJob.edgeFirst      = edgeFirst.constData();
+  oddJob.edgeCanonical  = edgeCanonical.constData();
+  oddJob.canonicalRep   = canonicalRep.constData();
+  oddJob.canonicalEdges = canonicalEdges.constData();
+  oddJob.newPoints      = newPoints.data();
+  oddJob.newNormals     = newNormals.data();
+  oddJob.newUVs         = newUVs.data();
+  oddJob.newCanonical   = newCanonical.data();
+  runParallel(oddJob, numEdges, maxThreads);
+
+  ReSplitFaceJob faceJob;
+  faceJob.numVertices  = numVertices;
+  faceJob.triangles    = tris;
+  faceJob.edgeOf       = edgeOf.constData();
+  faceJob.newTriangles = newTriangles.data();
+  runParallel(faceJob, numTriangles, maxThreads);
+
+  points    = newPoints;
+  normals   = newNormals;
+  uvs       = newUVs;
+  canonical = newCanonical;
+  triangles = newTriangles;
+}
+
+void ReMeshRefiner::computeNormals() {
+  RE_PROFILE_SCOPE("ComputeMeshNormals");
+  int numVertices  = getNumVertices();
+  int numTriangles = getNumTriangles();
+  QVector<float> faceNormals(numTriangles*3);
+
+  ReFaceNormalJob faceJob;
+  faceJob.points      = points.constData();
+  faceJob.triangles   = triangles.constData();
+  faceJob.faceNormals = faceNormals.data();
+  runParallel(faceJob, numTriangles, maxThreads);
+
+  // The normals are accumulated on the welded vertices so that they are
+  // smooth across the UV seams
+  QVector<float> accumulated(numVertices*3, 0.0f);
+  const int* tris = triangles.constData();
+  const int* canon = canonical.constData();
+  const float* fn = faceNormals.constData();
+  for (int f = 0; f < numTriangles; f++) {
+    for (int j = 0; j < 3; j++) {
+      float* acc = accumulated.data() + canon[tris[f*3 + j]]*3;
+      acc[0] += fn[f*3];
+      acc[1] += fn[f*3 + 1];
+      acc[2] += fn[f*3 + 2];
+    }
+  }
+
+  ReVertexNormalJob vertexJob;
+  vertexJob.canonical   = canon;
+  vertexJob.accumulated = accumulated.constData();
+  vertexJob.normals     = normals.data();
+  runParallel(vertexJob, numVertices, maxThreads);
+}
+
+void ReMeshRefiner::displace( const ReDisplacementSampler& sampler, const float scale ) {
+  RE_PROFILE_SCOPE("DisplaceMesh");
+  if (uvs.isEmpty() || !sampler.isValid()) {
+    return;
+  }
+  // The vertices are moved along the smooth normals
+  computeNormals();
+  QVector<float> newPoints(points.count());
+  ReDisplaceJob job;
+  job.sampler   = &sampler;
+  job.scale     = scale;
+  job.canonical = canonical.constData();
+  job.points    = points.constData();
+  job.normals   = normals.constData();
+  job.uvs       = uvs.constData();
+  job.newPoints = newPoints.data();
+  runParallel(job, getNumVertices(), maxThreads);
+  points = newPoints;
+  computeNormals();
+}
+
+/*
+ * Cache
+ */
+QString ReMeshRefiner::cacheDir;
+qint64 ReMeshRefiner::cacheLimit = static_cast<qint64>(RE_MESH_CACHE_MAX_SIZE)*1024*1024;
+
+//! Sets the modification time of a file to now. The time is used to find
+//! the meshes used least recently, the access time is not updated by all
+//! the file systems.
+static void touchFile( const QString& fileName ) {
+#if defined(_WIN32)
+  _wutime(reinterpret_cast<const wchar_t*>(fileName.utf16()), NULL);
+#else
+  utime(QFile::encodeName(fileName).constData(), NULL);
+#endif
+}
+
+QString ReMeshRefiner::getCacheDir() {
+  if (cacheDir.isEmpty()) {
+    cacheDir = getRealityDataDir(RE_MESH_CACHE_DIR);
+  }
+  return cacheDir;
+}
+
+void ReMeshRefiner::setCacheDir( const QString& dirName ) {
+  cacheDir = dirName;
+}
+
+void ReMeshRefiner::setCacheLimit( const qint64 bytes ) {
+  cacheLimit = bytes;
+}
+
+void ReMeshRefiner::purgeCache() {
+  QDir dir(getCacheDir());
+  foreach( QString entry, dir.entryList(QStringList("*.ply"), QDir::Files) ) {
+    dir.remove(entry);
+  }
+}
+
+void ReMeshRefiner::trimCache( const QString& keepName ) {
+  QDir dir(getCacheDir());
+  // Most recently used first
+  QFileInfoList entries = dir.entryInfoList(QStringList("*.ply"), QDir::Files, QDir::Time);
+  qint64 size = 0;
+  foreach( QFileInfo entry, entries ) {
+    if (entry.fileName() == keepName) {
+      size += entry.size();
+    }
+  }
+  foreach( QFileInfo entry, entries ) {
+    if (entry.fileName() == keepName) {
+      continue;
+    }
+    size += entry.size();
+    if (size > cacheLimit) {
+      dir.remove(entry.fileName());
+      size -= entry.size();
+      RE_PROFILE_COUNT("refinedMeshCacheEvictions", 1);
+    }
+  }
+}
+
+bool ReMeshRefiner::fetchCachedMesh( const QString& meshName,
+                                     const QByteArray& key,
+                                     const QString& fileName )
+{
+  QString cachedName = QString("%1/%2-%3.ply")
+                         .arg(getCacheDir())
+                         .arg(meshName)
+                         .arg(QString(key));
+  if (!QFile::exists(cachedName)) {
+    return false;
+  }
+  QFile::remove(fileName);
+  if (!QFile::copy(cachedName, fileName)) {
+    return false;
+  }
+  touchFile(cachedName);
+  return true;
+}
+
+void ReMeshRefiner::storeCachedMesh( const QString& meshName,
+                                     const QByteArray& key,
+                                     const QString& fileName )
+{
+  QDir dir(getCacheDir());
+  dir.mkpath(".");
+  QString cachedName = QString("%1-%2.ply").arg(meshName).arg(QString(key));
+  // Remove the previous versions of the mesh. The length check skips the
+  // meshes of other materials whose name starts with meshName.
+  int entrySize = meshName.length() + 1 + RE_MESH_CACHE_KEY_SIZE + 4;
+  QStringList entries = dir.entryList(QStringList(QString("%1-*.ply").arg(meshName)),
+                                      QDir::Files);
+  foreach( QString entry, entries ) {
+    if (entry.length() == entrySize && entry != cachedName) {
+      dir.remove(entry);
+    }
+  }
+  // Copy to a temporary file first, so that an interrupted copy doesn't
+  // leave a truncated mesh in the cache
+  QString tmpName = dir.absoluteFilePath(cachedName + ".tmp");
+  QFile::remove(tmpName);
+  if (!QFile::copy(fileName, tmpName) ||
+      !QFile::rename(tmpName, dir.absoluteFilePath(cachedName)))
+  {
+    QFile::remove(tmpName);
+    RE_LOG_WARN() << "Cannot store the refined mesh " << QSS(fileName)
+                  << " in the cache";
+    return;
+  }
+  // The copy keeps the time of the source on some platforms
+  touchFile(dir.absoluteFilePath(cachedName));
+  trimCache(cachedName);
+}
+
+} // namespace
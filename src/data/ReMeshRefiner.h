@@ -0,0 +1,215 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#ifndef RE_MESH_REFINER_H
+#define RE_MESH_REFINER_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QString>
+#include <QVector>
+
+#include "reality_lib_export.h"
+#include "ReDefs.h"
+#include "ReGeometry.h"
+
+
+namespace Reality {
+
+//! Meshes that would have more triangles than this after the subdivision
+//! are left to the renderer
+#define RE_REFINER_MAX_TRIANGLES (16*1024*1024)
+
+//! Default size, in MB, of the cache of the refined meshes
+#define RE_MESH_CACHE_MAX_SIZE   2048
+
+/**
+ * An image map used as displacement map, sampled by the exporter.
+ *
+ * The sampler reproduces the chain of textures that the Lux exporter
+ * writes for a displacement map: the float version of the image map, with
+ * its channel, gain and gamma, the clamp between the negative and positive
+ * limits and the multiplication by the strength. The value returned is in
+ * the units of the renderer.
+ */
+class REALITY_LIB_EXPORT ReDisplacementSampler {
+
+private:
+  QImage image;
+  QString fileName;
+  uint fileTime;
+
+  RGBChannel channel;
+  float gain;
+  float gamma;
+
+  float uScale, vScale, uDelta, vDelta;
+
+  float dmNegative, dmPositive, dmStrength;
+
+  //! Value of one pixel, before gain and gamma
+  float texel( const int x, const int y ) const;
+
+public:
+
+  ReDisplacementSampler();
+
+  //! Reads the image map
+  bool load( const QString& fileName );
+
+  //! Uses an image already in memory
+  void setImage( const QImage& img );
+
+  inline bool isValid() const {
+    return !image.isNull();
+  }
+
+  void setChannel( const RGBChannel newVal ) {
+    channel = newVal;
+  }
+
+  void setLevels( const float newGain, const float newGamma ) {
+    gain  = newGain;
+    gamma = newGamma;
+  }
+
+  //! Sets the UV transform, with the same values written to the scene
+  //! file: s = uScale * u + uDelta, t = vScale * v + vDelta
+  void setMapping( const float uScale,
+                   const float vScale,
+                   const float uDelta,
+                   const float vDelta );
+
+  void setLimits( const float negative, const float positive, const float strength );
+
+  //! Returns the displacement at the given UV coordinates
+  float sample( const float u, const float v ) const;
+
+  //! Returns a string that identifies the map and its parameters, used
+  //! as part of the key of the cached meshes
+  QByteArray getKey() const;
+};
+
+/**
+ * Subdivision and displacement of meshes done by the exporter.
+ *
+ * With subdivision or displacement enabled in a material, LuxRender
+ * refines the mesh while loading the scene. That step runs in a single
+ * thread and for figures with displaced skin it can take minutes. This
+ * class does the same work in the exporter, using all the cores, and the
+ * refined mesh is written to the PLY file in place of the original one.
+ *
+ * The subdivision uses the Loop scheme. The host apps split the vertices
+ * along the UV seams, so the topology is computed on the vertices welded
+ * by position. That way the seams don't open when the mesh is subdivided
+ * or displaced. UVs are interpolated linearly.
+ *
+ * The refined meshes are kept in a cache directory, keyed by the hash of
+ * the original mesh and of the refinement parameters, so that exporting
+ * again a scene that has not changed reuses them. When the cache grows
+ * larger than its limit the meshes used least recently are removed.
+ */
+class REALITY_LIB_EXPORT ReMeshRefiner : public ReMeshData {
+
+private:
+  //! For each vertex, the index of the first vertex at the same position
+  QVector<int> canonical;
+
+  int maxThreads;
+
+  static QString cacheDir;
+  static qint64 cacheLimit;
+
+  //! Removes the meshes used least recently until the cache is not larger
+  //! than cacheLimit. The file keepName is never removed.
+  static void trimCache( const QString& keepName );
+
+  //! Welds the vertices that have the same position
+  void findCanonicalVertices();
+
+  //! Runs one level of subdivision
+  void subdivideOnce( const bool sharpBoundary );
+
+public:
+
+  ReMeshRefiner();
+
+  //! Number of threads used, zero to use all the cores
+  void setMaxThreads( const int numThreads ) {
+    maxThreads = numThreads;
+  }
+
+  //! Copies the mesh to refine and welds its vertices. Replaces
+  //! ReMeshData::setMesh().
+  //! \param uvMap Can be NULL if the mesh has no UVs
+  void setMesh( const int numVertices,
+                const ReVectorF* vertices,
+                const ReVectorF* vertexNormals,
+                const ReUVPoint* uvMap,
+                const int numTriangles,
+                const ReTriangle* tris );
+
+  //! Runs Loop subdivision. If sharpBoundary is true the vertices on the
+  //! boundary of the mesh don't move.
+  void subdivide( const int levels, const bool sharpBoundary );
+
+  /**
+   * Moves the vertices along their normals by the value of the
+   * displacement map. The mesh must have UVs.
+   * \param scale Converts the displacement from the units of the renderer
+   *              to the units of the mesh
+   */
+  void displace( const ReDisplacementSampler& sampler, const float scale );
+
+  //! Replaces the normals with smooth normals computed from the faces. The
+  //! new normals keep the orientation of the previous ones.
+  void computeNormals();
+
+  /**
+   * Finds the vertices that have the same position. 
+   * \param points XYZ of each vertex
+   * \param canonical Receives, for each vertex, the index of the first
+   *                  vertex at the same position
+   */
+  static void weldVertices( const float* points,
+                            const int numVertices,
+                            QVector<int>& canonical );
+
+  //! Location of the cached meshes. By default the meshes are stored in
+  //! the MeshCache directory next to the ACSEL database.
+  static QString getCacheDir();
+
+  static void setCacheDir( const QString& dirName );
+
+  //! Size limit of the cache, in bytes. It's checked every time a mesh
+  //! is stored.
+  static void setCacheLimit( const qint64 bytes );
+
+  //! Removes all the meshes from the cache
+  static void purgeCache();
+
+  /**
+   * Copies a cached mesh to fileName.
+   * \param meshName Identifies the mesh in the cache, it must be usable
+   *                 as a file name
+   * \param key The hash of the mesh and of the refinement parameters
+   * \return false if the mesh is not in the cache
+   */
+  static bool fetchCachedMesh( const QString& meshName,
+                               const QByteArray& key,
+                               const QString& fileName );
+
+  //! Stores a copy of fileName in the cache. The meshes cached for
+  //! meshName with a different key are removed, then the cache is trimmed
+  //! to its size limit.
+  static void storeCachedMesh( const QString& meshName,
+                               const QByteArray& key,
+                               const QString& fileName );
+};
+
+} // namespace
+
+#endif
@@ -23,9 +23,6 @@
 
 using namespace Reality;
 
-ReNodeDictionary ReNodeConverter::nodeCatalog;
-QVariantMap ReNodeConverter::nodes;
-
 void ReNodeConverter::init( const QVariantMap& _nodes ) {
   // Erase the node network catalog. This needs to be done at the
   // beginning of each conversion. The network will then be stored in the <Material> 
@@ -40,7 +37,7 @@ void ReNodeConverter::addNode( ReTexturePtr node ) {
   }
 }
 
-ReNodeDictionary ReNodeConverter::getNodeCatalog() {
+ReNodeDictionary ReNodeConverter::getNodeCatalog() const {
   return nodeCatalog;
 }
 
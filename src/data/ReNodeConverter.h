@@ -14,7 +14,12 @@
 namespace Reality {
 
 /**
- * Converts a node from the host importer to a ReTexture
+ * Converts a node from the host importer to a ReTexture.
+ *
+ * The converter holds the node table of the material being converted and
+ * the catalog of nodes already converted. Each conversion uses its own
+ * instance, normally the one in \ref ReMaterialConversionContext, so that
+ * materials can be converted by several threads at the same time.
  */
 class ReNodeConverter {
 public:
@@ -50,7 +55,7 @@ public:
 
 private:
 
-  static QVariantMap nodes;
+  QVariantMap nodes;
 
   /**
    All nodes for the material. 
@@ -69,26 +74,26 @@ private:
    For ReGeometryObject the nodeCatalog is only transient. Each material holds its own
    node catalog. The one employed in this class is only used to store the node network
    while the material is getting converted. The node network is then stored in the 
-   material and this class' copy is erased at the beginning of each conversion.
+   material and this object's copy is erased at the beginning of each conversion.
 
    */
-  static ReNodeDictionary nodeCatalog;
+  ReNodeDictionary nodeCatalog;
 
-  static ReTexturePtr convertBand(const QString& nodeName, const QVariantMap& node);
-  static ReTexturePtr convertClouds(const QString& nodeName, const QVariantMap& node, const NodeHint hint = NumericNode);
-  static ReTexturePtr convertFBM(const QString& nodeName, const QVariantMap& node, const NodeHint hint = NumericNode);
-  static ReTexturePtr convertWood(const QString& nodeName, const QVariantMap& node, const NodeHint hint = NumericNode);
-  static ReTexturePtr convertColorMath( const QString& nodeName, 
+  ReTexturePtr convertBand(const QString& nodeName, const QVariantMap& node);
+  ReTexturePtr convertClouds(const QString& nodeName, const QVariantMap& node, const NodeHint hint = NumericNode);
+  ReTexturePtr convertFBM(const QString& nodeName, const QVariantMap& node, const NodeHint hint = NumericNode);
+  ReTexturePtr convertWood(const QString& nodeName, const QVariantMap& node, const NodeHint hint = NumericNode);
+  ReTexturePtr convertColorMath( const QString& nodeName, 
                                         const QVariantMap& node,
                                         const NodeHint hint = NoHint,
                                         const bool makeUnique = false );
-  static ReTexturePtr convertComponent( const QString& nodeName, 
+  ReTexturePtr convertComponent( const QString& nodeName, 
                                         const QVariantMap& node,
                                         const NodeHint hint = NoHint );
-  static ReTexturePtr convertConstant(const QString& nodeName, const QVariantMap& node);
-  static ReTexturePtr convertDistortedNoise(const QString& nodeName, const QVariantMap& node, const NodeHint hint = NumericNode);
-  static ReTexturePtr convertFresnelColor(const QString& nodeName, const QVariantMap& node);
-  static ReTexturePtr convertImageMap(const QString& nodeName, 
+  ReTexturePtr convertConstant(const QString& nodeName, const QVariantMap& node);
+  ReTexturePtr convertDistortedNoise(const QString& nodeName, const QVariantMap& node, const NodeHint hint = NumericNode);
+  ReTexturePtr convertFresnelColor(const QString& nodeName, const QVariantMap& node);
+  ReTexturePtr convertImageMap(const QString& nodeName, 
                                       const QVariantMap& node, 
                                       const NodeHint hint = NoHint);
 
@@ -98,11 +103,11 @@ private:
   //! in one of its channels and if it's so it returns an ImageMap texture set to grayscale because
   //! that was the reason why the Poser Math node was used. Math nodes are often used as a simple
   //! way of turning an image map into a grayscale version.
-  static ReTexturePtr convertMath( const QString& nodeName, 
+  ReTexturePtr convertMath( const QString& nodeName, 
                                    const QVariantMap& node, 
                                    const NodeHint hint = NoHint,
                                    const bool makeUnique = false );
-  static ReTexturePtr convertMix( const QString& nodeName, 
+  ReTexturePtr convertMix( const QString& nodeName, 
                                   const QVariantMap& node, 
                                   const NodeHint hint = NoHint,
                                   const bool makeUnique = false );
@@ -119,7 +124,7 @@ public:
    Reset the state of the converter. This method must be called at the beginning of
    a material conversion.  
    */
-  static void init( const QVariantMap& nodes );
+  void init( const QVariantMap& nodes );
 
   /**
    Converts the node network received from the hosting application to 
@@ -135,11 +140,11 @@ public:
                   to create a copy of the node so that it is not affected by changes done
                   when the same texture is edited as the input for another channel.
    */            
-  static ReTexturePtr convertNode( const QString nodeName, const NodeHint hint = NoHint, const bool makeUnique = false );
+  ReTexturePtr convertNode( const QString nodeName, const NodeHint hint = NoHint, const bool makeUnique = false );
 
-  static void addNode( ReTexturePtr node );
+  void addNode( ReTexturePtr node );
 
-  static ReNodeDictionary getNodeCatalog();
+  ReNodeDictionary getNodeCatalog() const;
 };
 
 
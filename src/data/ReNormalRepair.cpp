@@ -0,0 +1,242 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#include "ReNormalRepair.h"
+
+#include <float.h>
+#include <math.h>
+
+#include <QVector>
+
+#include "ReMeshRefiner.h"
+#include "ReParallel.h"
+#include "ReProfiler.h"
+
+
+namespace Reality {
+
+//! Normals shorter than this are considered invalid
+#define RE_MIN_NORMAL_LENGTH 1e-6f
+
+ReNormalRepair::ReNormalRepair() :
+  creaseAngle(60.0f),
+  maxThreads(0)
+{
+}
+
+bool ReNormalRepair::isValidNormal( const ReVectorF& n ) {
+  for (int k = 0; k < 3; k++) {
+    // Also false for NaN
+    if ( !(fabs(n[k]) <= FLT_MAX) ) {
+      return false;
+    }
+  }
+  return n[0]*n[0] + n[1]*n[1] + n[2]*n[2] > 
+         RE_MIN_NORMAL_LENGTH * RE_MIN_NORMAL_LENGTH;
+}
+
+class ReInvalidNormalJob : public ReRangeJob {
+public:
+  const ReVectorF* normals;
+  char* invalid;
+
+  void process( const int begin, const int end ) {
+    for (int i = begin; i < end; i++) {
+      invalid[i] = !ReNormalRepair::isValidNormal(normals[i]);
+    }
+  }
+};
+
+/**
+ * Computes the normal of each face, with a length of twice the area of
+ * the face, and the angle of the face at each of its corners
+ */
+class ReFaceWeightJob : public ReRangeJob {
+public:
+  const float* points;
+  const int* triangles;
+  float* faceNormals;
+  float* cornerAngles;
+
+  void process( const int begin, const int end ) {
+    for (int f = begin; f < end; f++) {
+      const int* t = triangles + f*3;
+      float* n = faceNormals + f*3;
+      const float* p0 = points + t[0]*3;
+      const float* p1 = points + t[1]*3;
+      const float* p2 = points + t[2]*3;
+      float e1[3], e2[3];
+      for (int k = 0; k < 3; k++) {
+        e1[k] = p1[k] - p0[k];
+        e2[k] = p2[k] - p0[k];
+      }
+      n[0] = e1[1]*e2[2] - e1[2]*e2[1];
+      n[1] = e1[2]*e2[0] - e1[0]*e2[2];
+      n[2] = e1[0]*e2[1] - e1[1]*e2[0];
+      float doubleArea = sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+      for (int c = 0; c < 3; c++) {
+        const float* p  = points + t[c]*3;
+        const float* pa = points + t[(c+1) % 3]*3;
+        const float* pb = points + t[(c+2) % 3]*3;
+        float a[3], b[3];
+        for (int k = 0; k < 3; k++) {
+          a[k] = pa[k] - p[k];
+          b[k] = pb[k] - p[k];
+        }
+        // The length of the cross product is the same at every corner
+        float dot = a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+        cornerAngles[f*3 + c] = atan2(doubleArea, dot);
+      }
+    }
+  }
+};
+
+/**
+ * Computes the new normal of the invalid vertices. The faces are listed
+ * for each group of vertices welded by position, each entry is the index
+ * of the face times 3 plus the corner.
+ */
+class ReSmoothNormalJob : public ReRangeJob {
+public:
+  const int* repairList;
+  const int* canonical;
+  const int* groupStart;
+  const int* groupCorners;
+  const int* triangles;
+  const float* faceNormals;
+  const float* cornerAngles;
+  float minCos;
+  float* normals;
+
+  void process( const int begin, const int end ) {
+    for (int r = begin; r < end; r++) {
+      int v = repairList[r];
+      int group = canonical[v];
+      // The faces of the vertex itself give the reference direction
+      float ref[3] = { 0.0f, 0.0f, 0.0f };
+      for (int j = groupStart[group]; j < groupStart[group+1]; j++) {
+        int corner = groupCorners[j];
+        if (triangles[corner] != v) {
+          continue;
+        }
+        const float* fn = faceNormals + (corner / 3)*3;
+        for (int k = 0; k < 3; k++) {
+          ref[k] += fn[k] * cornerAngles[corner];
+        }
+      }
+      float refLength = sqrt(ref[0]*ref[0] + ref[1]*ref[1] + ref[2]*ref[2]);
+      float sum[3] = { ref[0], ref[1], ref[2] };
+      // The faces of the other copies of the vertex, across the seams,
+      // unless they are across a crease
+      for (int j = groupStart[group]; j < groupStart[group+1]; j++) {
+        int corner = groupCorners[j];
+        if (triangles[corner] == v) {
+          continue;
+        }
+        const float* fn = faceNormals + (corner / 3)*3;
+        float fnLength = sqrt(fn[0]*fn[0] + fn[1]*fn[1] + fn[2]*fn[2]);
+        if (fnLength <= 0.0f) {
+          continue;
+        }
+        if (refLength > 0.0f) {
+          float cosAngle = (fn[0]*ref[0] + fn[1]*ref[1] + fn[2]*ref[2]) / 
+                           (fnLength * refLength);
+          if (cosAngle < minCos) {
+            continue;
+          }
+        }
+        for (int k = 0; k < 3; k++) {
+          sum[k] += fn[k] * cornerAngles[corner];
+        }
+      }
+      float* n = normals + v*3;
+      float length = sqrt(sum[0]*sum[0] + sum[1]*sum[1] + sum[2]*sum[2]);
+      if (length > 0.0f) {
+        for (int k = 0; k < 3; k++) {
+          n[k] = sum[k] / length;
+        }
+      }
+      else {
+        // A vertex with no faces, or only degenerate ones. Any valid
+        // normal is better than a black spot.
+        n[0] = 0.0f;
+        n[1] = 0.0f;
+        n[2] = 1.0f;
+      }
+    }
+  }
+};
+
+int ReNormalRepair::repair( const int numVertices,
+                            const ReVectorF* vertices,
+                            ReVectorF* normals,
+                            const int numTriangles,
+                            const ReTriangle* triangles )
+{
+  if (numVertices == 0 || normals == NULL) {
+    return 0;
+  }
+  QVector<char> invalid(numVertices);
+  ReInvalidNormalJob invalidJob;
+  invalidJob.normals = normals;
+  invalidJob.invalid = invalid.data();
+  runParallel(invalidJob, numVertices, maxThreads);
+
+  QVector<int> repairList;
+  for (int i = 0; i < numVertices; i++) {
+    if (invalid[i]) {
+      repairList << i;
+    }
+  }
+  if (repairList.isEmpty()) {
+    return 0;
+  }
+  RE_PROFILE_SCOPE("RepairNormals");
+
+  const float* points = reinterpret_cast<const float*>(vertices);
+  const int* tris = reinterpret_cast<const int*>(triangles);
+  QVector<float> faceNormals(numTriangles * 3);
+  QVector<float> cornerAngles(numTriangles * 3);
+  ReFaceWeightJob faceJob;
+  faceJob.points       = points;
+  faceJob.triangles    = tris;
+  faceJob.faceNormals  = faceNormals.data();
+  faceJob.cornerAngles = cornerAngles.data();
+  runParallel(faceJob, numTriangles, maxThreads);
+
+  // Lists the corners of the faces for each group of welded vertices
+  QVector<int> canonical;
+  ReMeshRefiner::weldVertices(points, numVertices, canonical);
+  QVector<int> groupStart(numVertices + 1, 0);
+  int numCorners = numTriangles * 3;
+  for (int i = 0; i < numCorners; i++) {
+    groupStart[canonical[tris[i]] + 1]++;
+  }
+  for (int i = 0; i < numVertices; i++) {
+    groupStart[i+1] += groupStart[i];
+  }
+  QVector<int> groupCorners(numCorners);
+  QVector<int> groupFill(groupStart);
+  for (int i = 0; i < numCorners; i++) {
+    groupCorners[groupFill[canonical[tris[i]]]++] = i;
+  }
+
+  ReSmoothNormalJob smoothJob;
+  smoothJob.repairList   = repairList.constData();
+  smoothJob.canonical    = canonical.constData();
+  smoothJob.groupStart   = groupStart.constData();
+  smoothJob.groupCorners = groupCorners.constData();
+  smoothJob.triangles    = tris;
+  smoothJob.faceNormals  = faceNormals.constData();
+  smoothJob.cornerAngles = cornerAngles.constData();
+  smoothJob.minCos       = cos(creaseAngle * M_PI / 180.0);
+  smoothJob.normals      = reinterpret_cast<float*>(normals);
+  runParallel(smoothJob, repairList.count(), maxThreads);
+
+  return repairList.count();
+}
+
+} // namespace
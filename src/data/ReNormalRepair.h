@@ -0,0 +1,72 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#ifndef RE_NORMAL_REPAIR_H
+#define RE_NORMAL_REPAIR_H
+
+#include "reality_lib_export.h"
+#include "ReDefs.h"
+#include "ReGeometry.h"
+
+
+namespace Reality {
+
+/**
+ * Replaces the invalid vertex normals of a mesh with smooth normals
+ * computed from the faces.
+ *
+ * Some meshes reach the exporter with normals that are NaN or zero, for
+ * example after a morph or a geometry shell in the host app. The exporter
+ * used to write them as zero, which renders as black spots. The new normal
+ * of a vertex is the sum of the normals of the faces around it, weighted by
+ * the area of the face and by the angle of the face at the vertex. The host
+ * apps split the vertices along the UV seams and the hard edges, so the
+ * faces of the other copies of the vertex, found by welding the vertices
+ * by position, are included when they are within the crease angle. That
+ * way the seams stay smooth and the hard edges stay sharp.
+ *
+ * Only the invalid normals are changed, the others are kept as they come
+ * from the host app.
+ */
+class REALITY_LIB_EXPORT ReNormalRepair {
+
+private:
+  //! Faces that meet at a larger angle are not smoothed, in degrees
+  float creaseAngle;
+
+  int maxThreads;
+
+public:
+
+  ReNormalRepair();
+
+  //! \param degrees 180 smooths across all the copies of a vertex
+  void setCreaseAngle( const float degrees ) {
+    creaseAngle = degrees;
+  }
+
+  //! Number of threads used, zero to use all the cores
+  void setMaxThreads( const int numThreads ) {
+    maxThreads = numThreads;
+  }
+
+  //! Returns false if the normal is NaN, infinite or has zero length
+  static bool isValidNormal( const ReVectorF& n );
+
+  /**
+   * Repairs the normals of a mesh, in place.
+   * \return The number of normals that have been replaced
+   */
+  int repair( const int numVertices,
+              const ReVectorF* vertices,
+              ReVectorF* normals,
+              const int numTriangles,
+              const ReTriangle* triangles );
+};
+
+} // namespace
+
+#endif
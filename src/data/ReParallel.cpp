@@ -0,0 +1,56 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#include "ReParallel.h"
+
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+
+namespace Reality {
+
+class ReRangeTask : public QRunnable {
+
+private:
+  ReRangeJob& job;
+  int begin;
+  int end;
+
+public:
+  ReRangeTask( ReRangeJob& job, const int begin, const int end ) :
+    job(job),
+    begin(begin),
+    end(end)
+  {
+  }
+
+  void run() {
+    job.process(begin, end);
+  }
+};
+
+void runParallel( ReRangeJob& job, const int count, const int maxThreads ) {
+  int numThreads = maxThreads > 0 ? maxThreads : QThread::idealThreadCount();
+  if (numThreads <= 1 || count < RE_PARALLEL_MIN_CHUNK * 2) {
+    job.process(0, count);
+    return;
+  }
+  // A few chunks per thread balance the load when some chunks are slower
+  int numChunks = qMin(numThreads * 4, count / RE_PARALLEL_MIN_CHUNK);
+  QThreadPool pool;
+  pool.setMaxThreadCount(numThreads);
+  for (int i = 0; i < numChunks; i++) {
+    pool.start(new ReRangeTask(
+      job,
+      static_cast<int>(static_cast<qint64>(count) * i / numChunks),
+      static_cast<int>(static_cast<qint64>(count) * (i+1) / numChunks)
+    ));
+  }
+  pool.waitForDone();
+}
+
+} // namespace
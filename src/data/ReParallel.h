@@ -0,0 +1,44 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#ifndef RE_PARALLEL_H
+#define RE_PARALLEL_H
+
+#include "reality_lib_export.h"
+
+
+namespace Reality {
+
+//! Loops shorter than this are not split between threads
+#define RE_PARALLEL_MIN_CHUNK 1024
+
+/**
+ * The body of a loop that can be split between threads, used by the
+ * mesh processing done during the export. Each call of process() handles
+ * the elements from begin to end, excluded. The calls run at the same time
+ * on different ranges, so they must not write to shared data.
+ */
+class REALITY_LIB_EXPORT ReRangeJob {
+public:
+  virtual ~ReRangeJob() {
+  }
+  virtual void process( const int begin, const int end ) = 0;
+};
+
+/**
+ * Runs the job on the elements from 0 to count, split in chunks between
+ * a pool of threads. Returns when all the chunks have been processed.
+ * \param maxThreads The number of threads to use, zero to use all the
+ *                   cores. With one thread the job runs in the caller's
+ *                   thread.
+ */
+REALITY_LIB_EXPORT void runParallel( ReRangeJob& job, 
+                                     const int count, 
+                                     const int maxThreads = 0 );
+
+} // namespace
+
+#endif
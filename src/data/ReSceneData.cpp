@@ -7,18 +7,28 @@
 
 #include "ReSceneData.h"
 
+#include <QCryptographicHash>
 #include <QDir>
 #include <QFileInfo>
 #include <QSetIterator>
 #include <QSettings>
+#include <QTextStream>
 #include <QVariantMap>
 #include <QJson/Parser>
 #include <QJson/Serializer>
 
 #include "ReIPC.h"
 #include "ReOpenCL.h"
+#include "ReProfiler.h"
+#include "ReSceneResources.h"
+#include "ReLuxcoreGeometryExporter.h"
 #include "ReLuxGeometryExporter.h"
 #include "ReLuxRunner.h"
+#include "ReMeshDecimator.h"
+#include "ReMeshOptimizer.h"
+#include "ReMeshRefiner.h"
+#include "ReModifiedMaterial.h"
+#include "ReNormalRepair.h"
 #include "ReRenderContext.h"
 #include "exporters/ReLuxSceneExporter.h"
 #include "exporters/ReJSONSceneExporter.h"
@@ -82,6 +92,13 @@ void ReSceneData::initScene() {
 
   needsSaving     = false;
   inGUIMode       = false;
+  bakeSubdivision = false;
+  lodPixelError   = 0.0f;
+  frustumCulling  = false;
+  cullingMargin   = 0.0f;
+  normalsCreaseAngle = 60.0f;
+  optimizeMeshes  = false;
+  mortonOrder     = false;
   displayInterval = config->value(RE_CFG_LUX_DISPLAY_REFRESH).toInt();
   writeInterval   = config->value(RE_CFG_LUX_WRITE_INTERVAL).toInt();
   properties.sceneWidth      = 1280;
@@ -108,6 +125,7 @@ void ReSceneData::initScene() {
   properties.surfaceIntegrator  = ReSurfaceIntegratorPtr(new ReSIPath());
   properties.textureCollection = false;
   properties.textureSize       = T_ORIGINAL;
+  properties.IBLMapSize        = IBL_ORIGINAL;
   properties.useOpenCL         = false;
   properties.renderAsStatue    = false;
   properties.sampler           = sobol;
@@ -277,6 +295,14 @@ void ReSceneData::setTextureSize( const ReTextureSize newSize ) {
   properties.textureSize = newSize;
 }
 
+ReIBLMapSize ReSceneData::getIBLMapSize() const {
+  return properties.IBLMapSize;
+}
+
+void ReSceneData::setIBLMapSize( const ReIBLMapSize newSize ) {
+  properties.IBLMapSize = newSize;
+}
+
 /*
  Method: getDisplayInterval
  */
@@ -461,6 +487,7 @@ void ReSceneData::getOutputData( QVariantMap& data ) {
   data.insert(KEY_SCENE_USE_OCL, isOCLRenderingON());
   data.insert(KEY_SCENE_TEXTURE_COLLECTION, hasTextureCollection());
   data.insert(KEY_SCENE_TEXTURE_SIZE, getTextureSize());
+  data.insert(KEY_SCENE_IBL_MAP_SIZE, getIBLMapSize());
   // data.insert(KEY_SCENE_SELECTED_CAMERA, selectedCamera);
   data.insert(KEY_SCENE_CPU_ACCEL, cpuAccelerationEnabled());
   data.insert(KEY_SCENE_LOG_LEVEL, getLuxLogLevel());
@@ -571,6 +598,10 @@ void ReSceneData::setOutputData( QString jsonData ) {
                                        data.value(KEY_SCENE_TEXTURE_SIZE, 
                                                   T_ORIGINAL).toInt()
                                      );
+  properties.IBLMapSize            = static_cast<ReIBLMapSize>(
+                                       data.value(KEY_SCENE_IBL_MAP_SIZE, 
+                                                  IBL_ORIGINAL).toInt()
+                                     );
   QVariantMap si = data[KEY_SCENE_SURFACE_INTEGRATOR].toMap();
 
   auto siType = static_cast<ReSurfaceIntegratorType>(si.value("type").toInt());
@@ -1459,7 +1490,11 @@ void ReSceneData::newScene() {
 // Static member
 ReGeometryBuffer ReSceneData::geometryBuffer;
 
-void ReSceneData::newGeometryBuffer( const QString& bufferName,
+// Time at which the host started filling the geometry buffer. Used to
+// profile the extraction of the geometry from the host.
+static qint64 geometryStartTime = -1;
+
+bool ReSceneData::newGeometryBuffer( const QString& bufferName,
                                      const int numVertices, 
                                      const int numTriangles, 
                                      const bool hasUVs ) 
@@ -1467,7 +1502,39 @@ void ReSceneData::newGeometryBuffer( const QString& bufferName,
   if (geometryBuffer.numTriangles) {
     geometryBuffer.reset();
   }
-  geometryBuffer.allocate(bufferName, numVertices, numTriangles, hasUVs);
+  if ( !geometryBuffer.allocate(bufferName, numVertices, numTriangles, hasUVs) ) {
+    RE_LOG_WARN() << "Not enough memory for the geometry of " << QSS(bufferName)
+                  << ". The material is not exported";
+    return false;
+  }
+  if (ReProfiler::isEnabled()) {
+    geometryStartTime = ReProfiler::now();
+    RE_PROFILE_COUNT("vertices", numVertices);
+    RE_PROFILE_COUNT("triangles", numTriangles);
+  }
+  return true;
+}
+
+void ReSceneData::lendGeometryBuffer( const QString& bufferName,
+                                      const int numVertices,
+                                      const int numTriangles,
+                                      float* vertices,
+                                      float* normals,
+                                      float* uvs,
+                                      int* triangles )
+{
+  geometryBuffer.lend(bufferName,
+                      numVertices,
+                      numTriangles,
+                      reinterpret_cast<ReVectorF*>(vertices),
+                      reinterpret_cast<ReVectorF*>(normals),
+                      reinterpret_cast<ReUVPoint*>(uvs),
+                      reinterpret_cast<ReTriangle*>(triangles));
+  if (ReProfiler::isEnabled()) {
+    geometryStartTime = ReProfiler::now();
+    RE_PROFILE_COUNT("vertices", numVertices);
+    RE_PROFILE_COUNT("triangles", numTriangles);
+  }
 }
 
 float* ReSceneData::getGeometryVertexBuffer() {
@@ -1577,12 +1644,48 @@ void ReSceneData::restoreScene( const QVariantMap& sceneData, const bool mergeSc
   }
 }
 
+ReLuxGeometryExporter* ReSceneData::getGeometryExporter() {
+  if (getRenderer() == SLG) {
+    return ReLuxcoreGeometryExporter::getInstance();
+  }
+  return ReLuxGeometryExporter::getInstance();
+}
+
 QString& ReSceneData::exportMaterial( const QString& materialName, 
                                       const QString& objectName,
                                       const QString& shapeName,
                                       HostAppID scale ) 
 {
-  auto geometryExporter = ReLuxGeometryExporter::getInstance();
+  auto geometryExporter = getGeometryExporter();
+  ReMeshDecimator decimator;
+  if (lodPixelError > 0.0f) {
+    decimateGeometry(materialName, objectName, decimator);
+  }
+  // Invalid normals would be written as zero and render as black spots
+  ReNormalRepair normalRepair;
+  normalRepair.setCreaseAngle(normalsCreaseAngle);
+  int repaired = normalRepair.repair(geometryBuffer.numVertices,
+                                     geometryBuffer.vertices,
+                                     geometryBuffer.normals,
+                                     geometryBuffer.numTriangles,
+                                     geometryBuffer.triangles);
+  if (repaired > 0) {
+    RE_PROFILE_COUNT("repairedNormals", repaired);
+  }
+  // Like the decimator, the optimizer holds the new geometry until the
+  // material has been exported
+  ReMeshOptimizer optimizer;
+  if (optimizeMeshes && geometryBuffer.numTriangles >= RE_MESH_OPTIMIZER_MIN_TRIANGLES) {
+    optimizer.setMortonOrder(mortonOrder);
+    optimizer.setMesh(geometryBuffer.numVertices,
+                      geometryBuffer.vertices,
+                      geometryBuffer.normals,
+                      geometryBuffer.uvmap,
+                      geometryBuffer.numTriangles,
+                      geometryBuffer.triangles);
+    optimizer.optimize();
+    geometryBuffer.lend(geometryBuffer.name, optimizer);
+  }
   return geometryExporter->exportMaterial(materialName, 
                                           objectName,
                                           shapeName,
@@ -1590,12 +1693,57 @@ QString& ReSceneData::exportMaterial( const QString& materialName,
                                           scale);
 }
 
+void ReSceneData::decimateGeometry( const QString& materialName,
+                                    const QString& objectName,
+                                    ReMeshDecimator& decimator )
+{
+  if ( geometryBuffer.numTriangles <= RE_LOD_MIN_TRIANGLES || 
+       !cameraView.isValid() ) 
+  {
+    return;
+  }
+  // The subdivision and the displacement need the full mesh
+  ReGeometryObjectPtr obj = getObject(objectName);
+  if (obj.isNull()) {
+    return;
+  }
+  ReModifiedMaterialPtr mat = obj->getMaterial(materialName)
+                                .dynamicCast<ReModifiedMaterial>();
+  if ( !mat.isNull() && 
+       (mat->getSubdivisions() > 0 || !mat->getDisplacementMap().isNull()) ) 
+  {
+    return;
+  }
+  // The error allowed is measured at the point of the mesh closest to the
+  // camera. A camera inside the bounding box gives a distance of zero and
+  // no decimation.
+  ReVectorF boxMin, boxMax;
+  geometryBuffer.getBounds(boxMin, boxMax);
+  float maxError = lodPixelError * 
+                   cameraView.getPixelSize(cameraView.getDistance(boxMin, boxMax));
+  if (maxError <= 0.0f) {
+    return;
+  }
+  decimator.setMesh(geometryBuffer.numVertices,
+                    geometryBuffer.vertices,
+                    geometryBuffer.normals,
+                    geometryBuffer.uvmap,
+                    geometryBuffer.numTriangles,
+                    geometryBuffer.triangles);
+  int removed = decimator.decimate(maxError, RE_LOD_MIN_TRIANGLES);
+  if (removed == 0) {
+    return;
+  }
+  RE_PROFILE_COUNT("decimatedTriangles", removed);
+  geometryBuffer.lend(geometryBuffer.name, decimator);
+}
+
 void ReSceneData::renderSceneExportInstance( const QString& objectName, 
                                              const QVariantMap& transform,
                                              const HostAppID scale ) 
 {
-  auto geometryExporter = ReLuxGeometryExporter::getInstance();
-  sceneIncludeFile.write(
+  auto geometryExporter = getGeometryExporter();
+  exportSession.writeInclude(
     geometryExporter->exportInstance( objectName, transform, scale ).toUtf8()
   );
 }
@@ -1605,8 +1753,8 @@ void ReSceneData::renderSceneExportInstance( const QString& objectName,
                                              const HostAppID scale ) 
 {
   ReBaseGeometryExporter* geometryExporter;
-  geometryExporter = ReLuxGeometryExporter::getInstance();
-  sceneIncludeFile.write(
+  geometryExporter = getGeometryExporter();
+  exportSession.writeInclude(
     geometryExporter->exportInstance( objectName, transform, scale ).toUtf8()
   );
 }
@@ -1615,71 +1763,126 @@ void ReSceneData::renderSceneExportInstance( const QString& objectName,
 void ReSceneData::renderSceneStart( const QString& fName, 
                                     const unsigned int frameNo ) 
 {
+  if (RealityBase::getConfiguration()->value(RE_CFG_EXPORT_PROFILING).toBool()) {
+    ReProfiler::beginSession();
+  }
+  RE_PROFILE_SCOPE("renderSceneStart");
   QString sceneFileName = fName;
   if (sceneFileName.isEmpty()) {
     sceneFileName = getSceneFileName();
   }
+  // LuxCore uses a render configuration file and a scene file in place
+  // of the Lux scene and include files
+  bool isLuxcore = getRenderer() == SLG;
   QFileInfo sceneInfo(sceneFileName);
+  if (isLuxcore) {
+    sceneInfo.setFile(
+      QString("%1/%2.cfg").arg(sceneInfo.absolutePath()).arg(sceneInfo.baseName())
+    );
+    sceneFileName = sceneInfo.absoluteFilePath();
+  }
   QFileInfo sceneIncludeInfo(
-              QString("%1/%2.lxi")
+              QString("%1/%2.%3")
                 .arg(sceneInfo.absolutePath())
                 .arg(sceneInfo.baseName())
+                .arg(isLuxcore ? "scn" : LUX_INCLUDE_EXTENSION)
   );
-  sceneFile.setFileName(sceneFileName);
-  sceneIncludeFile.setFileName(sceneIncludeInfo.absoluteFilePath());
-
-  if (sceneInfo.exists()) {
-    if (!sceneFile.remove()) {
-      RE_LOG_WARN() << "Warning: cannot delete file " 
-                    << sceneFileName.toStdString() 
-                    << ". Rendering aborted";
-      return;
-    }
-  }
-  if (sceneIncludeInfo.exists()) {
-    if (!sceneIncludeFile.remove()) {
-      RE_LOG_WARN() << "Warning: cannot delete file " 
-                    << sceneIncludeInfo.absoluteFilePath().toStdString()
-                    << ". Rendering aborted";
-      return;
-    }
+  exportObjectID.clear();
+  exportObjectHash.clear();
+
+  // Large meshes are stored in a memory-mapped geometry buffer
+  ReConfigurationPtr config = RealityBase::getConfiguration();
+  ReGeometryArena& arena = geometryBuffer.getArena();
+  int mapSize = config->value(RE_CFG_GEOMETRY_MAP_SIZE, 0).toInt();
+  if (mapSize > 0) {
+    arena.setMappingThreshold(static_cast<size_t>(mapSize) * 1024 * 1024);
   }
-  QFile flmFile(QString("%1/%2.flm")
-                  .arg(sceneInfo.absolutePath())
-                  .arg(sceneInfo.baseName())
+  arena.setMappingDir(
+    config->value(RE_CFG_GEOMETRY_MAP_TO_FILE, false).toBool() ? QDir::tempPath() : ""
   );
-  if (flmFile.exists()) {
-    if ( !flmFile.remove() ) {
-      RE_LOG_WARN() << "Warning: could not delete file "
-                    << flmFile.fileName().toStdString()
-                    << ". Rendering aborted";
-      return;
-    };
+  bakeSubdivision = config->value(RE_CFG_BAKE_SUBDIVISION, false).toBool();
+  ReMeshRefiner::setCacheLimit(
+    config->value(RE_CFG_MESH_CACHE_SIZE, RE_MESH_CACHE_MAX_SIZE).toLongLong()*1024*1024
+  );
+  normalsCreaseAngle = config->value(RE_CFG_NORMALS_CREASE_ANGLE, 60.0).toFloat();
+  optimizeMeshes = config->value(RE_CFG_MESH_OPTIMIZATION, false).toBool();
+  mortonOrder    = config->value(RE_CFG_MESH_MORTON_ORDER, false).toBool();
+  // The meshes that are small in the frame are decimated, see
+  // decimateGeometry()
+  lodPixelError = 0.0f;
+  // The materials out of the view are skipped, see isOutOfView()
+  frustumCulling = false;
+  cullingMargin  = 0.0f;
+  cullableObjects.clear();
+  culledMaterials.clear();
+  cameraView.clear();
+  ReCameraPtr camera = getSelectedCamera();
+  if (!camera.isNull()) {
+    if (config->value(RE_CFG_LOD_DECIMATION, false).toBool()) {
+      lodPixelError = config->value(RE_CFG_LOD_PIXEL_ERROR, 1.0).toFloat();
+    }
+    frustumCulling = config->value(RE_CFG_FRUSTUM_CULLING, false).toBool();
+    if (frustumCulling) {
+      cullingMargin = config->value(RE_CFG_CULLING_MARGIN, 0.5).toFloat();
+    }
+    uint width  = getWidth() * getFrameMultiplier();
+    uint height = getHeight() * getFrameMultiplier();
+    cameraView.set(*camera->getMatrix(), camera->getFOV(width, height), width, height);
   }
-
-  if ( !sceneFile.open(QIODevice::WriteOnly) ) {
-    RE_LOG_WARN() << "Error: could not open the file "
-                  << sceneInfo.absoluteFilePath().toStdString()
-                  << " for writing. Rendering aborted";
+  // The files of the previous export are replaced only when this export
+  // is completed, see renderSceneFinish()
+  if ( !exportSession.begin(sceneFileName, sceneIncludeInfo.absoluteFilePath()) ) {
     return;
   }
-  if ( !sceneIncludeFile.open(QIODevice::WriteOnly) ) {
-    RE_LOG_WARN() << "Error: could not open the file "
-                  << sceneIncludeInfo.absoluteFilePath().toStdString()
-                  << " for writing. Rendering aborted";
-    return;
+  // The objects of the interrupted export reference their PLY files
+  if (exportSession.canResume()) {
+    ReSceneResources::getInstance()->setPreserveObjects(true);
   }
   // Initialize the texture cache
   ReLuxTextureExporter::initializeTextureCache();
   ReLuxTextureExporter::enableTextureCache(true);
 
-  QString sceneText = exportScene("lux", frameNo);
-  sceneFile.write(sceneText.toUtf8());
-  sceneIncludeFile.write(
+  // The data of an interrupted export can be reused only if it has been
+  // exported with the same scene settings
+  QCryptographicHash sceneKey(QCryptographicHash::Sha1);
+  QByteArray optionsData;
+  QDataStream optionsStream(&optionsData, QIODevice::WriteOnly);
+  optionsStream << properties << (quint32) frameNo << lodPixelError
+                << frustumCulling << cullingMargin << normalsCreaseAngle
+                << optimizeMeshes << mortonOrder << bakeSubdivision;
+  sceneKey.addData(optionsData);
+
+  if (isLuxcore) {
+    // The scene description goes at the top of the .scn file and it's
+    // followed by the geometry
+    QByteArray sceneText = exportScene("slg", frameNo).toUtf8();
+    sceneKey.addData(sceneText);
+    qint64 bytes = exportSession.writeInclude(sceneText);
+    auto slgExporter = static_cast<ReSLGSceneExporter*>(getSceneExporter("slg"));
+    bytes += exportSession.writeScene(
+      slgExporter->getRenderConfig(sceneIncludeInfo.fileName(), frameNo).toUtf8()
+    );
+    RE_PROFILE_COUNT("bytesWritten", bytes);
+    exportSession.setSceneKey(sceneKey.result());
+    exportSession.stageDirectory(
+      ReSceneResources::getInstance()->getFinalObjectsPath()
+    );
+    return;
+  }
+  QByteArray sceneText = exportScene("lux", frameNo).toUtf8();
+  sceneKey.addData(sceneText);
+  RE_PROFILE_COUNT("bytesWritten", exportSession.writeScene(sceneText));
+  exportSession.writeInclude(
     "#\n"
     "# LuxRender include file. Generated by Reality plugin\n"
     "#\n"
   );
+  exportSession.setSceneKey(sceneKey.result());
+  // The PLY and hair files are written in a staging directory, see
+  // ReSceneResources::getObjectsPath()
+  exportSession.stageDirectory(
+    ReSceneResources::getInstance()->getFinalObjectsPath()
+  );
 };
 
 void ReSceneData::renderSceneExportMaterial( const QString& matName,  
@@ -1687,22 +1890,64 @@ void ReSceneData::renderSceneExportMaterial( const QString& matName,
                                              const QString& shapeName,
                                              const HostAppID scale ) 
 {
-  sceneIncludeFile.write(
+  if (ReProfiler::isEnabled() && geometryStartTime >= 0) {
+    ReProfiler::addEvent("hostGeometry", geometryStartTime, ReProfiler::now());
+    geometryStartTime = -1;
+  }
+  RE_PROFILE_SCOPE("renderSceneExportMaterial");
+  if (!geometryBuffer.isValid()) {
+    RE_LOG_WARN() << "No geometry for material " << QSS(matName) 
+                  << " of " << QSS(objName) << ", the material is skipped";
+    geometryBuffer.reset();
+    return;
+  }
+  if (frustumCulling && isOutOfView(matName, objName)) {
+    culledMaterials << QString("%1:%2 %3")
+                         .arg(objName)
+                         .arg(matName)
+                         .arg(geometryBuffer.numTriangles);
+    RE_PROFILE_COUNT("culledTriangles", geometryBuffer.numTriangles);
+    geometryBuffer.reset();
+    return;
+  }
+  RE_PROFILE_COUNT("materials", 1);
+  // The exporters reset the geometry buffer
+  int numTriangles = geometryBuffer.numTriangles;
+  qint64 bytes = exportSession.writeInclude(
     QString(
       exportMaterial( matName, objName, shapeName, scale )
     ).toUtf8()
   );
+  exportSession.addMaterial(numTriangles);
+  RE_PROFILE_COUNT("bytesWritten", bytes);
 };
 
 void ReSceneData::renderSceneFinish( const bool runRenderer ) {
-  sceneFile.write("# End of scene\n");
-  sceneIncludeFile.write("# End of include file\n");
-  sceneFile.close();
-  sceneIncludeFile.close();
+  exportSession.writeScene("# End of scene\n");
+  exportSession.writeInclude("# End of include file\n");
   // Clear the cache
   ReLuxTextureExporter::initializeTextureCache();
+  geometryBuffer.release();
+  bool committed = exportSession.commit();
+  if (committed && frustumCulling) {
+    writeCullingReport();
+  }
+
+  QFileInfo sceneInfo(exportSession.getSceneFileName());
+  // The film of the previous render doesn't match the new scene
+  QFile flmFile(QString("%1/%2.flm")
+                  .arg(sceneInfo.absolutePath())
+                  .arg(sceneInfo.baseName())
+  );
+  if (committed && flmFile.exists() && !flmFile.remove()) {
+    RE_LOG_WARN() << "Warning: could not delete file "
+                  << flmFile.fileName().toStdString()
+                  << ". Rendering aborted";
+    committed = false;
+  }
   
-  if (runRenderer) {
+  if (runRenderer && committed) {
+    RE_PROFILE_SCOPE("rendererLaunch");
     switch(getRenderer()) {
       case LuxRender: {
         ReLuxRunner rr;
@@ -1715,16 +1960,142 @@ void ReSceneData::renderSceneFinish( const bool runRenderer ) {
       }
       case SLG: {
         ReLuxRunner luxRunner;
-        if ( luxRunner.runSLG(getSceneFileName()) == ReLuxRunner::LR_COULD_NOT_START ) {
+        if ( luxRunner.runSLG(exportSession.getSceneFileName()) == ReLuxRunner::LR_COULD_NOT_START ) {
           RE_LOG_WARN() << "Could not start SLG!";
         }
         break;
       }
     }
   }
+  if (ReProfiler::isEnabled()) {
+    writeProfilingReport();
+  }
 };
 
+void ReSceneData::renderSceneAbort() {
+  exportSession.abort();
+  ReLuxTextureExporter::initializeTextureCache();
+  geometryBuffer.release();
+  if (ReProfiler::isEnabled()) {
+    writeProfilingReport();
+  }
+}
+
+bool ReSceneData::renderSceneResumeObject( const QString& objName, 
+                                           const QByteArray& geometryHash ) 
+{
+  exportObjectID = objName;
+  exportObjectHash.clear();
+  auto obj = objects.value(objName);
+  if (geometryHash.isEmpty() || obj.isNull()) {
+    return false;
+  }
+  // The content of the object is its geometry plus all the Reality data:
+  // materials, visibility, lights etc.
+  QByteArray objectData;
+  QDataStream objectStream(&objectData, QIODevice::WriteOnly);
+  obj->serialize(objectStream);
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  hash.addData(geometryHash);
+  hash.addData(objectData);
+  exportObjectHash = hash.result();
+
+  // The sources of instances are always exported, the instances need the
+  // data collected by the geometry exporter
+  if ( !isOCLRenderingON() && 
+       ReRenderContext::getInstance()->isInstantiator(objName) ) 
+  {
+    return false;
+  }
+  return exportSession.reuseObject(objName, exportObjectHash);
+}
+
+bool ReSceneData::isOutOfView( const QString& materialName, const QString& objectName ) {
+  if (!cameraView.isValid() || geometryBuffer.numVertices == 0) {
+    return false;
+  }
+  if (!cullableObjects.contains(objectName)) {
+    // Objects that emit light, or that can show other objects by reflection
+    // or refraction, affect the image even when they are out of the frame.
+    // The sources of instances are needed by the instances.
+    bool cullable = false;
+    ReGeometryObjectPtr obj = getObject(objectName);
+    if ( !obj.isNull() && !obj->isLight() && !obj->isLightEmitter() &&
+         !ReRenderContext::getInstance()->isInstantiator(objectName) ) 
+    {
+      cullable = true;
+      ReMaterialIterator i(obj->getMaterials());
+      while( i.hasNext() && cullable ) {
+        i.next();
+        ReMaterialPtr mat = i.value();
+        switch( mat->getType() ) {
+          case MatGlass:
+          case MatMetal:
+          case MatMirror:
+          case MatWater:
+          case MatLight:
+            cullable = false;
+            break;
+          default: {
+            ReModifiedMaterialPtr dmat = mat.dynamicCast<ReModifiedMaterial>();
+            if (!dmat.isNull() && dmat->isEmittingLight()) {
+              cullable = false;
+            }
+          }
+        }
+      }
+    }
+    cullableObjects[objectName] = cullable;
+  }
+  if (!cullableObjects.value(objectName)) {
+    return false;
+  }
+  // The margin keeps the meshes near the frame, that can cast shadows
+  // in it
+  ReVectorF boxMin, boxMax;
+  geometryBuffer.getBounds(boxMin, boxMax);
+  return cameraView.isOutside(boxMin, boxMax, cullingMargin);
+}
+
+void ReSceneData::writeCullingReport() {
+  QFileInfo sceneInfo(exportSession.getSceneFileName());
+  QFile report(QString("%1/%2_culled.txt")
+                 .arg(sceneInfo.absolutePath())
+                 .arg(sceneInfo.baseName()));
+  if (!report.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+    RE_LOG_WARN() << "Could not write the culling report " << QSS(report.fileName());
+    return;
+  }
+  QTextStream out(&report);
+  out << "# Materials out of the view of the camera, not exported\n"
+      << "# object:material triangles\n";
+  foreach( QString entry, culledMaterials ) {
+    out << entry << "\n";
+  }
+  RE_LOG_INFO() << "Culled " << culledMaterials.count() << " materials out of the view";
+}
+
+void ReSceneData::writeProfilingReport() {
+  QVariantMap report = ReProfiler::endSession();
+  QFileInfo sceneInfo(exportSession.getSceneFileName());
+  report["scene"] = sceneInfo.absoluteFilePath();
+  report["numObjects"] = objects.count();
+
+  QString baseName = QString("%1/%2")
+                       .arg(sceneInfo.absolutePath())
+                       .arg(sceneInfo.baseName());
+  if (!ReProfiler::writeReport(baseName + "_profile.json", report)) {
+    RE_LOG_WARN() << "Could not write the export profile for " << QSS(baseName);
+  }
+  if (RealityBase::getConfiguration()->value(RE_CFG_EXPORT_TRACE).toBool()) {
+    ReProfiler::writeTrace(baseName + "_trace.json");
+  }
+}
+
 void ReSceneData::renderSceneObjectBegin( const QString objName ) {
+  exportSession.beginObject(
+    objName, objName == exportObjectID ? exportObjectHash : QByteArray()
+  );
   // Lux does not support instancing for all objects when using 
   // the GPU. In particular, it does not support instancing for 
   // emitters. So we find out if the object emits light. If so, then
@@ -1737,8 +2108,8 @@ void ReSceneData::renderSceneObjectBegin( const QString objName ) {
 
   bool isInstanceSource = ReRenderContext::getInstance()->isInstantiator(objName);
   if (isInstanceSource) {        
-    auto geometryExporter = ReLuxGeometryExporter::getInstance();
-    sceneIncludeFile.write( geometryExporter->exportObjectBegin(objName).toUtf8() );
+    auto geometryExporter = getGeometryExporter();
+    exportSession.writeInclude( geometryExporter->exportObjectBegin(objName).toUtf8() );
   }
 }
 
@@ -1748,19 +2119,19 @@ void ReSceneData::renderSceneObjectEnd( const QString objName ) {
   // emitters.
 
   // The GPU-acceleration does not support instancing
-  if ( isOCLRenderingON() ) {
-    return;
-  }
-  bool isInstanceSource = ReRenderContext::getInstance()->isInstantiator(objName);
+  if ( !isOCLRenderingON() ) {
+    bool isInstanceSource = ReRenderContext::getInstance()->isInstantiator(objName);
 
-  if (isInstanceSource) {
-    auto geometryExporter = ReLuxGeometryExporter::getInstance();
-    sceneIncludeFile.write( geometryExporter->exportObjectEnd(objName).toUtf8() );
+    if (isInstanceSource) {
+      auto geometryExporter = getGeometryExporter();
+      exportSession.writeInclude( geometryExporter->exportObjectEnd(objName).toUtf8() );
+    }
   }
+  exportSession.endObject();
 }
 
 void ReSceneData::renderSceneIncludeFileCustomData( const QString str ) {
-  sceneIncludeFile.write(str.toUtf8());
+  exportSession.writeInclude(str.toUtf8());
 }
 
 void ReSceneData::notifyGUI( const QString msg, const QString id ) {
@@ -11,13 +11,18 @@
 #ifndef RESCENEDATA_H
 #define RESCENEDATA_H
 
+#include <float.h>
+
 #include <QHash>
 #include <QMap>
 #include <QSet>
 
 #include "reality_lib_export.h"
 #include "ReCamera.h"
+#include "ReCameraView.h"
+#include "ReExportSession.h"
 #include "ReGeometry.h"
+#include "ReGeometryArena.h"
 #include "ReGeometryObject.h"
 #include "ReLight.h"
 #include "ReSurfaceIntegrator.h"
@@ -53,6 +58,7 @@
 #define KEY_SCENE_VOLUME_LINKAGE      "volumeLinkage"
 #define KEY_SCENE_TEXTURE_COLLECTION  "textureCollection"
 #define KEY_SCENE_TEXTURE_SIZE        "textureSize"
+#define KEY_SCENE_IBL_MAP_SIZE        "IBLMapSize"
 //! Deprecated
 #define KEY_SCENE_TURBO_MODE          "turboMode"
 
@@ -68,11 +74,19 @@
 
 namespace Reality {
 
+class ReLuxGeometryExporter;
+class ReMeshDecimator;
+
 /**
  A class used to communicate with the host app-side plugin. The class is allocated by Reality's library 
  and it provides storage for the geometry and all the other data components used to push the geometry from
  the host app into Reality's exporter. For example, the Poser Python classes use this class to pass
  the geometry, UV maps, normal maps and material associations. 
+
+ The arrays are stored in a ReGeometryArena that is reused for all the
+ materials of the export. A host app that already has the data in
+ contiguous arrays can lend them to the buffer, with lend(), to avoid the
+ copy. The exporter can change the normals of lent arrays.
  */
 class ReGeometryBuffer {
 
@@ -96,6 +110,10 @@ class ReGeometryBuffer {
     // Normal  vectors
     ReVectorF* normals;
 
+  private:
+    ReGeometryArena arena;
+
+  public:
 
     ReGeometryBuffer() {
       init();
@@ -110,33 +128,99 @@ class ReGeometryBuffer {
       triangles    = NULL;
     }
 
+    //! Called when the geometry of a material has been exported. The
+    //! memory is kept for the next material.
     void reset() {
-      delete[] vertices;
-      delete[] uvmap;
-      delete[] normals;
-      delete[] triangles;
+      arena.clear();
+      init();
+    }
+
+    //! Frees the memory used by the buffer, at the end of the export
+    void release() {
+      arena.release();
       init();
     }
 
-    void allocate( const QString& bufferName,
+    //! Returns false if there is no geometry to export, for example 
+    //! because allocate() has failed
+    inline bool isValid() const {
+      return vertices && normals && triangles;
+    }
+
+    bool allocate( const QString& bufferName,
                    const int requestedVertices, 
                    const int requestedTriangles,
                    const bool hasUVs ) 
     {
       name = bufferName;
+      size_t vectorsSize   = ReGeometryArena::alignedSize(sizeof(ReVectorF) * requestedVertices);
+      size_t uvsSize       = hasUVs ? 
+                               ReGeometryArena::alignedSize(sizeof(ReUVPoint) * requestedVertices) : 0;
+      size_t trianglesSize = ReGeometryArena::alignedSize(sizeof(ReTriangle) * requestedTriangles);
+      init();
+      if ( !arena.reserve(vectorsSize * 2 + uvsSize + trianglesSize) ) {
+        return false;
+      }
       numVertices  = requestedVertices;
       numTriangles = requestedTriangles;
 
-      vertices    = new ReVectorF[numVertices];
-      normals     = new ReVectorF[numVertices];
+      vertices  = static_cast<ReVectorF*>(arena.allocate(vectorsSize));
+      normals   = static_cast<ReVectorF*>(arena.allocate(vectorsSize));
       if (hasUVs) {
-        uvmap       = new ReUVPoint[numVertices];      
+        uvmap   = static_cast<ReUVPoint*>(arena.allocate(uvsSize));
+      }
+      triangles = static_cast<ReTriangle*>(arena.allocate(trianglesSize));
+      return true;
+    }
+
+    //! Uses arrays owned by the caller in place of the buffer's storage.
+    //! The arrays must stay valid until the material has been exported.
+    //! \param lentUVs Can be NULL if the geometry has no UVs
+    void lend( const QString& bufferName,
+               const int lentVertices,
+               const int lentTriangles,
+               ReVectorF* lentVerts,
+               ReVectorF* lentNormals,
+               ReUVPoint* lentUVs,
+               ReTriangle* lentTriangleList )
+    {
+      arena.clear();
+      name         = bufferName;
+      numVertices  = lentVertices;
+      numTriangles = lentTriangles;
+      vertices     = lentVerts;
+      normals      = lentNormals;
+      uvmap        = lentUVs;
+      triangles    = lentTriangleList;
+    }
+
+    //! Lends the arrays of a mesh rebuilt by the exporter, see ReMeshData
+    void lend( const QString& bufferName, ReMeshData& mesh ) {
+      lend(bufferName,
+           mesh.getNumVertices(),
+           mesh.getNumTriangles(),
+           mesh.getVertices(),
+           mesh.getNormals(),
+           mesh.getUVs(),
+           mesh.getTriangles());
+    }
+
+    inline ReGeometryArena& getArena() {
+      return arena;
+    }
+
+    //! Computes the bounding box of the vertices
+    void getBounds( ReVectorF& boxMin, ReVectorF& boxMax ) const {
+      for (int k = 0; k < 3; k++) {
+        boxMin[k] = FLT_MAX;
+        boxMax[k] = -FLT_MAX;
       }
-      else {
-        uvmap = NULL;
+      for (int i = 0; i < numVertices; i++) {
+        for (int k = 0; k < 3; k++) {
+          boxMin[k] = qMin(boxMin[k], vertices[i][k]);
+          boxMax[k] = qMax(boxMax[k], vertices[i][k]);
+        }
       }
-      // memset(uvmap, 0 , numVertices * sizeof(ReUVPoint));
-      triangles   = new ReTriangle[numTriangles];
     }
 };
 
@@ -291,6 +375,9 @@ struct ReSceneRenderOptions {
   bool textureCollection;
   ReTextureSize textureSize;
 
+  //! Maximum width of the IBL map used for rendering
+  ReIBLMapSize IBLMapSize;
+
   //! Flag that indicates if we are using cpu acceleration
   bool cpuAcceleration;
 
@@ -328,7 +415,8 @@ inline QDataStream& operator <<( QDataStream& strm, ReSceneRenderOptions& opt )
        << opt.cpuAcceleration
        << (quint16)opt.luxLogLevel
        << opt.volumeMaterialLinks
-       << opt.surfaceIntegrator;
+       << opt.surfaceIntegrator
+       << (quint16)opt.IBLMapSize;
 
   return strm;
 }
@@ -339,7 +427,8 @@ inline QDataStream& operator >>( QDataStream& strm, ReSceneRenderOptions& opt )
           geometryFormatInt,
           samplerInt,
           textureSizeInt,
-          luxLogLevelInt;
+          luxLogLevelInt,
+          IBLMapSizeInt;
 
   strm >> opt.sceneWidth          >> opt.sceneHeight
        >> opt.outputSceneFileName >> opt.renderedImageFileName
@@ -359,7 +448,8 @@ inline QDataStream& operator >>( QDataStream& strm, ReSceneRenderOptions& opt )
        >> textureSizeInt          >> opt.cpuAcceleration
        >> luxLogLevelInt
        >> opt.volumeMaterialLinks       
-       >> opt.surfaceIntegrator;
+       >> opt.surfaceIntegrator
+       >> IBLMapSizeInt;
 
   opt.imageFileFormat   = static_cast<ExportImageFileFormat>(imageFileFormatInt);
   opt.renderer          = static_cast<ReRenderers>(rendererInt);
@@ -367,6 +457,7 @@ inline QDataStream& operator >>( QDataStream& strm, ReSceneRenderOptions& opt )
   opt.sampler           = static_cast<RenderSampler>(samplerInt);
   opt.textureSize       = static_cast<ReTextureSize>(textureSizeInt);
   opt.luxLogLevel       = static_cast<LUX_LOG_LEVEL>(luxLogLevelInt);
+  opt.IBLMapSize        = static_cast<ReIBLMapSize>(IBLMapSizeInt);
 
   return strm;
 }
@@ -487,11 +578,70 @@ protected:
    */
   QStringList objectsToDelete;
 
-  //! File object used to write the Lux scene
-  QFile sceneFile;
+  //! Writes the scene and include files, see ReExportSession
+  ReExportSession exportSession;
+
+  //! The object for which the content hash has been computed by
+  //! renderSceneResumeObject(), and its hash
+  QString exportObjectID;
+  QByteArray exportObjectHash;
+
+  //! If true the subdivision and displacement of the meshes are computed
+  //! by the exporter, see ReMeshRefiner. Read from the configuration at
+  //! the start of each export.
+  bool bakeSubdivision;
+
+  //! The largest error, in pixels, allowed when the meshes are decimated
+  //! for their size in the frame. Zero if the decimation is disabled.
+  float lodPixelError;
+
+  //! The selected camera, used to find the size of the meshes in the frame
+  //! and the meshes that are out of the frame
+  ReCameraView cameraView;
+
+  //! If true the materials out of the view are not exported
+  bool frustumCulling;
 
-  //! The include file used in the main Lux scene
-  QFile sceneIncludeFile;
+  //! Enlarges the view used for the culling, see ReCameraView::isOutside()
+  float cullingMargin;
+
+  //! Crease angle used to rebuild the invalid normals, see ReNormalRepair
+  float normalsCreaseAngle;
+
+  //! If true the meshes are reordered for locality, see ReMeshOptimizer
+  bool optimizeMeshes;
+
+  //! If true the reordering follows a Morton curve
+  bool mortonOrder;
+
+  //! For each object, true if its materials can be culled. Computed once
+  //! per export.
+  QHash<QString, bool> cullableObjects;
+
+  //! The materials culled by the current export, with their number of
+  //! triangles
+  QStringList culledMaterials;
+
+  //! Returns true if the material in the geometry buffer is out of the
+  //! view and cannot be seen in reflections or emit light
+  bool isOutOfView( const QString& materialName, const QString& objectName );
+
+  //! Writes the list of the culled materials next to the scene file
+  void writeCullingReport();
+
+  //! Replaces the geometry in the buffer with a decimated version, if the
+  //! material is small enough in the frame. The decimator holds the new
+  //! geometry, it must be kept until the material has been exported.
+  void decimateGeometry( const QString& materialName,
+                         const QString& objectName,
+                         ReMeshDecimator& decimator );
+
+  //! Returns the geometry exporter for the selected renderer
+  ReLuxGeometryExporter* getGeometryExporter();
+
+  //! Ends the profiling session started by renderSceneStart() and writes
+  //! the report next to the scene file
+  void writeProfilingReport();
 
 public:
 
@@ -690,6 +840,11 @@ public:
   ReTextureSize getTextureSize() const;
   void setTextureSize( const ReTextureSize newSize );
 
+  //! The IBL map is downsampled to this size before rendering, see
+  //! ReIBLMapCache. IBL_ORIGINAL uses the map selected by the user.
+  ReIBLMapSize getIBLMapSize() const;
+  void setIBLMapSize( const ReIBLMapSize newSize );
+
   /*
    Method: getImageFileFormat
    */
@@ -1259,11 +1414,32 @@ public:
   /*
    * Geometry export
    */
-  void newGeometryBuffer( const QString& bufferName,
+  /**
+   * Allocates the buffer for the geometry of a material. 
+   * \return false if there is not enough memory. In that case the host
+   *         must skip the material, the buffer has no storage.
+   */
+  bool newGeometryBuffer( const QString& bufferName,
                           const int numVertices, 
                           const int numTriangles, 
                           const bool hasUVs );
 
+  /**
+   * Uses the geometry stored by the host app instead of copying it in the
+   * geometry buffer. The host app keeps the ownership of the arrays.
+   * \param vertices 3 floats per vertex
+   * \param normals 3 floats per vertex
+   * \param uvs 2 floats per vertex, or NULL
+   * \param triangles 3 indices per triangle
+   */
+  void lendGeometryBuffer( const QString& bufferName,
+                           const int numVertices,
+                           const int numTriangles,
+                           float* vertices,
+                           float* normals,
+                           float* uvs,
+                           int* triangles );
+
   float* getGeometryVertexBuffer();
   float* getGeometryNormalBuffer();
   ReUVPoint* getGeometryUVPointBuffer();
@@ -1307,6 +1483,44 @@ public:
   void renderSceneObjectBegin( const QString objName );
   void renderSceneObjectEnd( const QString objName );
 
+  /**
+   * Checks if an object can be copied from an interrupted export of the
+   * same scene. The host app calls this method before exporting each
+   * object. If the method returns true the object has been added to the
+   * scene and it must not be exported.
+   * \param objName The ID of the object
+   * \param geometryHash A hash of the geometry of the object, computed by
+   *                     the host app. If empty the object is always
+   *                     exported.
+   */
+  bool renderSceneResumeObject( const QString& objName, const QByteArray& geometryHash );
+
+  //! Stops the export started by renderSceneStart(). The files of the
+  //! previous export are left untouched and the next export resumes from
+  //! the last object completed.
+  void renderSceneAbort();
+
+  //! Asks the host app to stop the export at the next object. It can be
+  //! called from the IPC thread.
+  inline void renderSceneRequestCancel() {
+    exportSession.requestCancel();
+  }
+
+  inline bool renderSceneIsCancelled() const {
+    return exportSession.isCancelRequested();
+  }
+
+  //! Counters of the data exported so far by the current export
+  inline const ReExportProgress& getExportProgress() const {
+    return exportSession.getProgress();
+  }
+
+  //! Returns true if the meshes with subdivision or displacement are
+  //! refined by the exporter instead of the renderer
+  inline bool isSubdivisionBakingEnabled() const {
+    return bakeSubdivision;
+  }
+
   inline void setAnimationLimits( const int startFrame, const int endFrame, const int fps ) {
     animationStartFrame = startFrame;
     animationEndFrame = endFrame;
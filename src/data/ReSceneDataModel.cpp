@@ -57,6 +57,47 @@ int ReSceneDataModel::columnCount(const QModelIndex& parent ) const {
   return RE_MB_NUM_COLUMS;
 }
 
+bool ReSceneDataModel::hasChildren( const QModelIndex& parent ) const {
+  if (!parent.isValid()) {
+    return rootNode->getNumChildren() > 0;
+  }
+  if (parent.column() > 0) {
+    return false;
+  }
+  TreeItem* node = static_cast<TreeItem*>(parent.internalPointer());
+  // The materials of an object are known before its node is populated
+  if (!node->populated) {
+    return node->countMaterials() > 0;
+  }
+  return node->getNumChildren() > 0;
+}
+
+bool ReSceneDataModel::canFetchMore( const QModelIndex& parent ) const {
+  if (!parent.isValid()) {
+    return false;
+  }
+  TreeItem* node = static_cast<TreeItem*>(parent.internalPointer());
+  return !node->populated;
+}
+
+void ReSceneDataModel::fetchMore( const QModelIndex& parent ) {
+  if (!parent.isValid()) {
+    return;
+  }
+  TreeItem* node = static_cast<TreeItem*>(parent.internalPointer());
+  if (node->populated) {
+    return;
+  }
+  int numMats = node->countMaterials();
+  if (numMats == 0) {
+    node->populated = true;
+    return;
+  }
+  beginInsertRows(parent, 0, numMats-1);
+  node->populate();
+  endInsertRows();
+}
+
 
 void ReSceneDataModel::setSceneData( RealityDataRelay* _data ) {
   dataServerConnector = _data;
@@ -81,7 +122,16 @@ void ReSceneDataModel::updateMaterial( const QString objectID,
                                        const QString materialName, 
                                        const bool isLightMaterial ) 
 {
-  rootNode->removeMaterial(objectID, materialName);
+  TreeItem* objNode = rootNode->findChild(objectID);
+  if (objNode) {
+    TreeItem* matNode = objNode->findChild(materialName);
+    if (matNode) {
+      int row = matNode->getRow();
+      beginRemoveRows(createIndex(objNode->getRow(), 0, objNode), row, row);
+      objNode->removeChild(row);
+      endRemoveRows();
+    }
+  }
   QVariantMap args;
   args["objectID"] = objectID;
   args["materialName"] = materialName;
@@ -92,30 +142,20 @@ void ReSceneDataModel::updateMaterial( const QString objectID,
 }
 
 void ReSceneDataModel::deleteObject( const QString& objectID ) {
-  beginResetModel();
-  TreeItem* theNode; 
-  bool found = false;
-  int index;
-  int numChildren = rootNode->children.count();
-  for (index = 0; index < numChildren; ++index) {
-    theNode = rootNode->children[index];
-    if (theNode->nodeType == TreeItem::NodeIsObject) {
-      ReGeometryObject* obj = static_cast<ReGeometryObject*>(theNode->pointer);
-      if (!obj) {
-        continue;
-      }
-      if (obj->getInternalName() == objectID ) {
-        found = true;
-        break;
-      }
-    }
-  }
-  if (found) {
-    delete theNode;
-    rootNode->children.removeAt(index);
+  TreeItem* theNode = rootNode->findChild(objectID);
+  if (theNode) {
+    int row = theNode->getRow();
+    beginRemoveRows(QModelIndex(), row, row);
+    rootNode->removeChild(row);
     RealitySceneData->deleteObject(objectID);
+    endRemoveRows();
+  }
+}
+
+void ReSceneDataModel::objectIDChanged( const QString& oldID ) {
+  if (rootNode) {
+    rootNode->rekeyChild(oldID);
   }
-  endResetModel();
 }
 
 QModelIndex ReSceneDataModel::findMaterial( const QString& objectID, 
@@ -125,28 +165,16 @@ QModelIndex ReSceneDataModel::findMaterial( const QString& objectID,
     RE_LOG_DEBUG() <<  "Error: rootNode of the data model is NULL";
     return createIndex(0, 0);
   }
-  TreeItem* theNode; 
-  bool found = false;
-  int index = 0;
-  int numChildren = rootNode->getNumChildren();
-  for (index = 0; index < numChildren; index++) {
-    theNode = rootNode->children[index];
-    if (theNode->nodeType == TreeItem::NodeIsObject) {
-      ReGeometryObject* obj = static_cast<ReGeometryObject*>(theNode->pointer);
-      if (obj->getInternalName() == objectID ) {
-        found = true;
-        break;
-      }
-    }
+  TreeItem* theNode = rootNode->findChild(objectID);
+  if (!theNode) {
+    return QModelIndex();
   }
-  if (found) {
-    int numMats = theNode->children.count();
-    for (int i = 0; i < numMats; i++) {
-      ReMaterial* mat = static_cast<ReMaterial*>(theNode->children[i]->pointer);
-      if (mat->getName() == matID) {
-        return createIndex(i, 0, theNode);
-      }
-    }
+  if (!theNode->populated) {
+    fetchMore(createIndex(theNode->getRow(), 0, theNode));
+  }
+  TreeItem* matNode = theNode->findChild(matID);
+  if (matNode) {
+    return createIndex(matNode->getRow(), 0, matNode);
   }
   return QModelIndex();
 }
@@ -156,20 +184,7 @@ TreeItem* ReSceneDataModel::findObject( const QString& objectID ) {
     RE_LOG_DEBUG() <<  "Error: rootNode of the data model is NULL";
     return NULL;
   }
-  TreeItem* theNode; 
-  int index = 0;
-  int numChildren = rootNode->getNumChildren();
-  for (index = 0; index < numChildren; index++) {
-    theNode = rootNode->children[index];
-    if (theNode->nodeType == TreeItem::NodeIsObject) {
-      ReGeometryObject* obj = static_cast<ReGeometryObject*>(theNode->pointer);
-      if (obj->getInternalName() == objectID ) {
-        return theNode;
-        break;
-      }
-    }
-  }
-  return NULL;
+  return rootNode->findChild(objectID);
 }
 
 Qt::ItemFlags ReSceneDataModel::flags( const QModelIndex& index ) const {
@@ -394,32 +409,36 @@ void ReSceneDataModel::setNewScene() {
 void ReSceneDataModel::addObjectToModel(ReGeometryObject* newObj,
                                         const bool resetModelFlag )  
 {
+  // If the object is already in the tree we drop the old node, it points
+  // to the version of the object that is being replaced.
+  TreeItem* oldNode = rootNode->findChild(newObj->getInternalName());
+  if (oldNode) {
+    int row = oldNode->getRow();
+    if (resetModelFlag) {
+      beginRemoveRows(QModelIndex(), row, row);
+    }
+    rootNode->removeChild(row);
+    if (resetModelFlag) {
+      endRemoveRows();
+    }
+  }
   RealitySceneData->addObject(newObj);
   // Skip mesh lights
   if (newObj->isLight()) {
     return;
   }
+  int row = rootNode->getNumChildren();
   if (resetModelFlag) {
-    beginResetModel();
+    beginInsertRows(QModelIndex(), row, row);
   }
 
+  // The material nodes are created when the view expands the object.
+  // See fetchMore()
   TreeItem* item = new TreeItem(TreeItem::NodeIsObject,(void *) newObj, rootNode);
   rootNode->addChild(item);
-  
-  QHashIterator<QString, ReMaterialPtr> i(newObj->getMaterials());
-  while (i.hasNext()) {
-    i.next();
-    // Skip Light materials
-    if (i.value()->getType() == MatLight) {
-      continue;
-    }
-    TreeItem* matItem = new TreeItem(TreeItem::NodeIsMaterial,
-                                     (void*) i.value().data(),
-                                     item);
-    item->addChild(matItem);
-  }
+
   if (resetModelFlag) {  
-    endResetModel();
+    endInsertRows();
   }
 }
 
@@ -438,28 +457,28 @@ void ReSceneDataModel::addObjectsToModel(ReGeometryObjectDictionary list) {
 }
 
 void ReSceneDataModel::updatedMaterialReady( const QString objectID, const QString matName ) {
-  // Scan the tree finding all the parent nodes which point to objects
-  TreeItem* node;
-  TreeItem* matItem;
-  bool added = false;
-  foreach( node, rootNode->children ) {
-    ReGeometryObject* obj = static_cast<ReGeometryObject*>(node->pointer);
-    if (obj->getInternalName() == objectID ) {
-      auto mat = obj->getMaterial(matName).data();
-      if (mat->getType() == MatLight) {
-        continue;
-      }
-      matItem = new TreeItem( TreeItem::NodeIsMaterial, (void*) mat, node );
-      node->addChild(matItem);
-      added = true;
-      break;
-    }
+  TreeItem* node = rootNode->findChild(objectID);
+  if (!node) {
+    return;
+  }
+  ReGeometryObject* obj = static_cast<ReGeometryObject*>(node->pointer);
+  auto mat = obj->getMaterial(matName).data();
+  if (!mat || mat->getType() == MatLight) {
+    return;
+  }
+  // If the object has not been expanded yet the new material will be
+  // picked up when the node is populated
+  if (node->populated && !node->findChild(matName)) {
+    int row = node->getNumChildren();
+    beginInsertRows(createIndex(node->getRow(), 0, node), row, row);
+    node->addChild(new TreeItem( TreeItem::NodeIsMaterial, (void*) mat, node ));
+    endInsertRows();
   }
-  if (added) {
-    QModelIndex matIndex = createIndex(matItem->getRow(), 0, matItem->parent); //findMaterial(objectID, matName);
+  if (node->populated) {
+    QModelIndex matIndex = findMaterial(objectID, matName);
     emit dataChanged(matIndex, matIndex);      
-    emit materialTypeChanged(objectID, matName);
   }
+  emit materialTypeChanged(objectID, matName);
 }
 
 
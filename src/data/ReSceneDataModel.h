@@ -50,10 +50,22 @@ public:
   void* pointer;
   TreeItem* parent;
 
+  //! Position of this node in the parent's list of children. It is kept
+  //! up to date by addChild() and removeChild() so that getRow(), which
+  //! is called by the view for every parent() lookup, is O(1).
+  int row;
+
+  //! Flag used to implement the lazy population of the tree. Object nodes
+  //! receive their material nodes only when the view expands them.
+  //! See ReSceneDataModel::fetchMore()
+  bool populated;
+
   TreeItem( NodeType nType, void* dataPointer, TreeItem* parent = 0 ) :
     nodeType(nType), 
     pointer(dataPointer), 
-    parent(parent) 
+    parent(parent),
+    row(0),
+    populated(nType == NodeIsMaterial)
   {
     // Nothing
   }
@@ -63,12 +75,55 @@ public:
     children.clear();
   }
 
+  //! Returns the key used to index this node in the parent. Objects are
+  //! indexed by their internal name, materials by their name.
+  QString getKey() const {
+    if (!pointer) {
+      return QString();
+    }
+    if (nodeType == NodeIsObject) {
+      return static_cast<ReGeometryObject*>(pointer)->getInternalName();
+    }
+    return static_cast<ReMaterial*>(pointer)->getName();
+  }
+
   void addChild( TreeItem* child ) {
+    child->row = children.count();
     children.append(child);
+    child->key = child->getKey();
+    childIndex[child->key] = child;
   }
 
   void removeChild( const quint16 i ) {
-    delete children.takeAt(i);
+    TreeItem* child = children.takeAt(i);
+    if (childIndex.value(child->key) == child) {
+      childIndex.remove(child->key);
+    }
+    int numChildren = children.count();
+    for (int k = i; k < numChildren; k++) {
+      children[k]->row = k;
+    }
+    delete child;
+  }
+
+  //! Returns the child node with the given key, the internal name for
+  //! objects or the name for materials, or NULL if it's not found
+  inline TreeItem* findChild( const QString& key ) const {
+    return childIndex.value(key, NULL);
+  }
+
+  //! Indexes again a child whose key has changed, for example an object
+  //! that has received a new internal name. Returns the child or NULL if
+  //! no child was indexed with oldKey.
+  TreeItem* rekeyChild( const QString& oldKey ) {
+    TreeItem* child = findChild(oldKey);
+    if (!child) {
+      return NULL;
+    }
+    childIndex.remove(oldKey);
+    child->key = child->getKey();
+    childIndex[child->key] = child;
+    return child;
   }
 
   inline TreeItem* getChild(const qint16 num) {
@@ -83,37 +138,63 @@ public:
     return parent;
   }
   
-  quint16 getRow() const {
-    if (parent) {
-      if (parent->children.count() == 0) {
-        return 0;
+  inline quint16 getRow() const {
+    return row;
+  }
+
+  //! Creates the nodes for the materials of an object node. Light 
+  //! materials are not listed in the tree.
+  void populate() {
+    populated = true;
+    if (nodeType != NodeIsObject || !pointer) {
+      return;
+    }
+    ReMaterialIterator i(static_cast<ReGeometryObject*>(pointer)->getMaterials());
+    while (i.hasNext()) {
+      i.next();
+      if (i.value()->getType() == MatLight) {
+        continue;
       }
-      return parent->children.indexOf(const_cast<TreeItem*>(this));
+      addChild(new TreeItem(NodeIsMaterial, (void*) i.value().data(), this));
     }
-    return 0;
+  }
+
+  //! Returns the number of material nodes that populate() will create
+  int countMaterials() const {
+    if (nodeType != NodeIsObject || !pointer) {
+      return 0;
+    }
+    int count = 0;
+    ReMaterialIterator i(static_cast<ReGeometryObject*>(pointer)->getMaterials());
+    while (i.hasNext()) {
+      i.next();
+      if (i.value()->getType() != MatLight) {
+        count++;
+      }
+    }
+    return count;
   }
 
   // Method: removeMaterial
   //   Removes a node that corresponds to a give material. Used when
   //   a material is changed in the host app while Reality is running
   void removeMaterial( const QString& objectID, const QString& materialName ) {
-    QListIterator<TreeItem*> i(children);
-    while(i.hasNext()) {
-      TreeItem* node = i.next();
-      ReGeometryObject* obj = static_cast<ReGeometryObject*>(node->pointer);
-      if (obj->getInternalName() == objectID ) {
-        // Found the right parent node, remove the node that links to the material
-        int matCount = node->getNumChildren();
-        for (int i = 0; i < matCount; ++i) {
-          TreeItem* matNode = node->getChild(i);
-          if (static_cast<ReMaterial*>(matNode->pointer)->getName() == materialName) {
-            node->removeChild(i);
-            break;
-          }
-        }
-      }
+    TreeItem* node = findChild(objectID);
+    if (!node) {
+      return;
+    }
+    TreeItem* matNode = node->findChild(materialName);
+    if (matNode) {
+      node->removeChild(matNode->row);
     }
   }
+
+private:
+  //! The key under which this node is indexed by its parent
+  QString key;
+
+  //! Lookup table from key to child node. See getKey()
+  QHash<QString, TreeItem*> childIndex;
 };
 
 /**
@@ -148,6 +229,16 @@ public:
 
   int rowCount(const QModelIndex& index) const;
   int columnCount(const QModelIndex& parent ) const;
+
+  //! Object nodes that have not been expanded yet report that they have
+  //! children without creating the material nodes.
+  bool hasChildren( const QModelIndex& parent = QModelIndex() ) const;
+
+  //! The material nodes of an object are created only when the view 
+  //! needs them. This keeps the loading of scenes with thousands of 
+  //! materials fast.
+  bool canFetchMore( const QModelIndex& parent ) const;
+  void fetchMore( const QModelIndex& parent );
   
   void setSceneData( RealityDataRelay* _data );
 
@@ -184,7 +275,16 @@ public:
    */
   void deleteObject( const QString& objectID );
 
+  /**
+   Updates the node of an object after the object has received a new ID,
+   see ReSceneData::renameObjectID(). Must be called after the object has
+   been renamed.
+   */
+  void objectIDChanged( const QString& oldID );
+
   //! Returns the model index for a match based on object id and material id.
+  //! If the object node has not been populated yet it is populated by this
+  //! call.
   QModelIndex findMaterial( const QString& objectID, const QString& matID );
 
   //! Returns the pointer to the node that holds a reference to the object 
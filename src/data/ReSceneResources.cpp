@@ -11,6 +11,10 @@
 #include <QImageReader>
 #include <QImageWriter>
 
+#include "ReExportSession.h"
+#include "ReProfiler.h"
+#include "ReTextureInfoCache.h"
+
 
 namespace Reality {
 
@@ -82,13 +86,15 @@ void ReSceneResources::initialize() {
       return;
     }
   };
-  // Create the directory to store the PLY objects
+  // Create the directory to store the PLY objects. The files of the 
+  // previous export are replaced only when this export is committed.
   objectsPath = QString("%1/%2").arg(resDirPath).arg(RE_SCENE_OBJECTS);
-  QDir objectsDir(objectsPath);
+  stagingPath = ReExportSession::getStagingDir(objectsPath);
+  QDir objectsDir(stagingPath);
   if (!objectsDir.exists()) {
-    objectsDir.mkdir(objectsPath);
+    objectsDir.mkdir(stagingPath);
   }
-  else {
+  else if (!preserveObjects) {
     // Remove the old PLYs
     QStringList oldPlys = objectsDir.entryList(QStringList("*.ply"));
     foreach( QString onePly, oldPlys ) {
@@ -106,11 +112,19 @@ void ReSceneResources::initialize() {
     texturesDir.mkdir(texturesPath);
   }
   textureSet.clear();
+  preserveObjects = false;
   initialized = true;
 }
 
 
 QString ReSceneResources::getObjectsPath()  {
+  if (!initialized) {
+    initialize();
+  }
+  return(this->stagingPath);
+};
+
+QString ReSceneResources::getFinalObjectsPath()  {
   if (!initialized) {
     initialize();
   }
@@ -148,6 +162,7 @@ void ReSceneResources::emptySLGKernelCache( const QString dirName ) {
 QString ReSceneResources::collectTexture( const QString fileName, 
                                           const ReTextureSize targetSize  ) 
 {
+  RE_PROFILE_SCOPE("collectTexture");
   if (!initialized) {
     initialize();
   }
@@ -167,6 +182,7 @@ QString ReSceneResources::collectTexture( const QString fileName,
     return(textureSet[fileName]);
   };
   
+  RE_PROFILE_COUNT("texturesCollected", 1);
   QFileInfo finfo(fileName);
   QString filePathStr = QString("%1/%2").arg(texturesPath).arg(finfo.dir().dirName());
   QDir filePath;
@@ -207,18 +223,20 @@ QString ReSceneResources::collectTexture( const QString fileName,
       default:
         break;
     };
-    QImageReader reader(fileName);
-    QSize imgSize = reader.size();       
+    // The sizes come from the texture index, the images are opened only
+    // when they need to be resized
+    ReTextureInfoCache* textureInfo = ReTextureInfoCache::getInstance();
+    QSize imgSize = textureInfo->getImageSize(fileName);
     if (imgSize.width() > newWidth) {
       // Let's first check if the image is already there and already scaled, it will save us a lot of time to not 
       // redo what has been done before.
       bool needsResizing = true;
       QFileInfo newImageChecker(resizedName);
       if (newImageChecker.exists()) {
-        QImageReader sizeChecker(resizedName);
-        needsResizing = (sizeChecker.size().width() != newWidth);
+        needsResizing = (textureInfo->getImageSize(resizedName).width() != newWidth);
       }
       if (needsResizing) {
+        QImageReader reader(fileName);
         imgSize.scale(newWidth,newWidth,Qt::KeepAspectRatio);
         reader.setScaledSize(imgSize);
         writer.write(reader.read());
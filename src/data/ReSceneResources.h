@@ -32,6 +32,7 @@ private:
   // externally. This enforces the use of the <getInstance> method.
   ReSceneResources() {
     initialized = false;
+    preserveObjects = false;
   };
 
 public:
@@ -52,6 +53,14 @@ public:
    * Returns a boolean that signals if the resource helper has been initialized
    */
   bool isInitialized() { return(initialized); };
+
+  //! When set, the next call to initialize() keeps the PLY and hair files
+  //! of the interrupted export in the staging directory. Used when the
+  //! export is resumed and the include file still references those files.
+  //! The flag is cleared by initialize().
+  void setPreserveObjects( const bool onOff ) {
+    preserveObjects = onOff;
+  }
   /**
    * Reset the resource helper. Usually called after a render has been exported. It's useful
    * to avoid bugs caused by a previous initialization being out of sync with the current scene.
@@ -62,7 +71,13 @@ public:
   }
 
   QString collectTexture( const QString fileName, const ReTextureSize targetSize = T_ORIGINAL );
+  //! Returns the directory where the PLY and hair files are written. It's
+  //! the staging directory of the export, see ReExportSession, and it
+  //! replaces the one returned by getFinalObjectsPath() when the export
+  //! is committed. The paths returned by getRelativePath() point to the
+  //! final directory.
   QString getObjectsPath();
+  QString getFinalObjectsPath();
   QString getTexturesPath();
   QString getResourcePath();
   QString getResourceDirName();
@@ -70,7 +85,14 @@ public:
   QString _newPath;
   inline QString getRelativePath( const QString& path ) {
     QDir d(sceneDir);
-    _newPath = d.relativeFilePath(path);
+    // The files written in the staging directory are referenced where 
+    // they will be after the export
+    if (!stagingPath.isEmpty() && path.startsWith(stagingPath + "/")) {
+      _newPath = d.relativeFilePath(objectsPath + path.mid(stagingPath.length()));
+    }
+    else {
+      _newPath = d.relativeFilePath(path);
+    }
     return _newPath;
   }
 
@@ -85,10 +107,12 @@ private:
   QString sceneDir;
   QFileInfo sceneResourceInfo;
   QString objectsPath;
+  QString stagingPath;
   QString texturesPath;
   QString resourceDirName;  // The relative name of the actual resource dir
 
   bool initialized;
+  bool preserveObjects;
   QHash<QString,QString> textureSet;
 };
 
@@ -5,6 +5,9 @@
 
 #include "ReTexture.h"
 
+#include <QBuffer>
+#include <QCryptographicHash>
+
 #include "ReTextureContainer.h"
 
 
@@ -81,8 +84,40 @@ void ReTexture::reparent( ReTextureContainer* newParent ) {
   parent = newParent;
 }
 
+void ReTexture::linksChanged() {
+  if (parent) {
+    parent->textureLinksChanged();
+  }
+}
+
+//! Device used by getGUID(). It's only a marker that tells the serialize()
+//! methods that the stream is used to compute the GUID.
+class ReGUIDBuffer : public QBuffer {
+public:
+  ReGUIDBuffer( QByteArray* data ) : QBuffer(data) {
+  }
+};
+
+bool ReTexture::isGUIDStream( const QDataStream& dataStream ) {
+  return dynamic_cast<ReGUIDBuffer*>(dataStream.device()) != NULL;
+}
+
+const QString ReTexture::getGUID() {
+  QByteArray data;
+  ReGUIDBuffer buffer(&data);
+  buffer.open(QIODevice::WriteOnly);
+  QDataStream dataStream(&buffer);
+  serialize(dataStream);
+  return QString(
+           QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex()
+         );
+}
+
 void ReTexture::serialize( QDataStream& dataStream ) {
-  dataStream << (quint16) type << name << (quint16)textureDataType;
+  // The name is local to the material and it's not part of the GUID
+  dataStream << (quint16) type 
+             << (isGUIDStream(dataStream) ? QString() : name) 
+             << (quint16)textureDataType;
 };
 
 void ReTexture::deserialize( QDataStream& dataStream ) {
@@ -64,6 +64,10 @@ protected:
   //! See <getNamedvalue()>
   QVariant val;
 
+  //! Tells the parent that a channel of this texture has been linked to 
+  //! a different texture. Called by the setters of the channels.
+  void linksChanged();
+
 public:
   //! Creates a texture with name and parented to the material passed in parent 
   ReTexture(const QString& name, ReTextureContainer* parent = 0);
@@ -99,10 +103,15 @@ public:
   const QString getUniqueName() const;
 
   //! Returns a Globally Unique ID for this texture for the purpose of
-  //! caching.
-  virtual const QString getGUID() {
-    return getUniqueName();
-  };
+  //! caching. The ID is a hash of the type and parameters of the texture
+  //! and of the IDs of the textures linked to it. Names are not part of
+  //! the ID, two textures with the same settings in different materials
+  //! have the same ID and can be exported only once.
+  virtual const QString getGUID();
+
+  //! Returns true if the stream is the one used by getGUID(). In that case
+  //! serialize() omits the names and refers to linked textures by GUID.
+  static bool isGUIDStream( const QDataStream& dataStream );
 
   inline ReTextureDataType getDataType() const {
     return textureDataType;
@@ -64,6 +64,11 @@ public:
   //! Removes a texture from the catalog and deletes it if not in use anymore
   virtual bool deleteTexture( const QString& tex ) = 0;
 
+  //! Called by the compound textures held by this container when one of
+  //! their channels is linked to a different texture.
+  virtual void textureLinksChanged() {
+  };
+
 };
 
 
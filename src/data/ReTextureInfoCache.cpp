@@ -0,0 +1,356 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#include "ReTextureInfoCache.h"
+
+#include <string.h>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+
+#include "ReDataDir.h"
+#include "ReLogger.h"
+#include "ReProfiler.h"
+
+
+namespace Reality {
+
+#define RE_TEXTURE_INFO_FILE      "TextureInfo.idx"
+#define RE_TEXTURE_INFO_MAGIC     "RETI"
+//! Change when the layout of the records changes
+#define RE_TEXTURE_INFO_VERSION   2
+//! Number of entries of the index, 2MB
+#define RE_TEXTURE_INFO_SLOTS     32768
+//! Entries checked for a path before the oldest one is replaced
+#define RE_TEXTURE_INFO_MAX_PROBE 16
+//! Seconds after which an entry that is still being written is considered
+//! abandoned by a writer that crashed
+#define RE_TEXTURE_INFO_STALE_TIME 10
+//! Size of the reduced copy read to find if an image is gray or has alpha
+#define RE_TEXTURE_INFO_SAMPLE    64
+
+#define RE_TEXTURE_INFO_HAS_ALPHA    0x01
+#define RE_TEXTURE_INFO_GRAYSCALE    0x02
+#define RE_TEXTURE_INFO_CONTENT_HASH 0x04
+
+//! The header at the beginning of the index file
+struct ReTextureInfoHeader {
+  char magic[4];
+  quint32 version;
+  quint32 numSlots;
+  quint32 recordSize;
+  quint32 reserved[12];
+};
+
+//! One entry of the index, 64 bytes
+struct ReTextureInfoCache::Record {
+  //! Odd while the record is being written, see claimSequence()
+  QBasicAtomicInt sequence;
+  quint32 modified;
+  //! Zero for the empty records
+  quint64 pathHash;
+  quint64 fileSize;
+  quint64 contentHash;
+  quint32 width;
+  quint32 height;
+  quint8  channels;
+  quint8  bitDepth;
+  quint16 flags;
+  quint32 reserved[5];
+};
+
+ReTextureInfoCache* ReTextureInfoCache::instance = NULL;
+
+//! The odd sequence of a record being written holds the time of the
+//! claim, in seconds, so that the claim and its time are set by the same
+//! atomic operation
+static inline int claimSequence( const quint32 seconds ) {
+  return static_cast<int>((seconds << 1) | 1);
+}
+
+//! Seconds since a record has been claimed, 31 bits are enough
+static inline quint32 claimAge( const int sequence, const quint32 seconds ) {
+  return (seconds - (static_cast<quint32>(sequence) >> 1)) & 0x7fffffff;
+}
+
+//! The even sequence published when a record has been written
+static inline int nextSequence( const int sequence ) {
+  return static_cast<int>((static_cast<quint32>(sequence) + 2) & ~1u);
+}
+
+//! FNV-1a hash of the path, never zero
+static quint64 hashPath( const QString& fileName ) {
+  QString path = QFileInfo(fileName).absoluteFilePath();
+#if defined(_WIN32)
+  path = path.toLower();
+#endif
+  QByteArray bytes = path.toUtf8();
+  quint64 hash = Q_UINT64_C(14695981039346656037);
+  for (int i = 0; i < bytes.size(); i++) {
+    hash ^= static_cast<uchar>(bytes[i]);
+    hash *= Q_UINT64_C(1099511628211);
+  }
+  return hash ? hash : 1;
+}
+
+ReTextureInfoCache::ReTextureInfoCache() :
+  data(NULL),
+  numProbes(0)
+{
+  indexFile.setFileName(getRealityDataDir(RE_TEXTURE_INFO_FILE));
+  openIndex();
+}
+
+ReTextureInfoCache::~ReTextureInfoCache() {
+  closeIndex();
+}
+
+ReTextureInfoCache* ReTextureInfoCache::getInstance() {
+  if (!instance) {
+    instance = new ReTextureInfoCache();
+  }
+  return instance;
+}
+
+void ReTextureInfoCache::setIndexFileName( const QString& fileName ) {
+  closeIndex();
+  indexFile.setFileName(fileName);
+  openIndex();
+}
+
+void ReTextureInfoCache::openIndex() {
+  QDir().mkpath(QFileInfo(indexFile.fileName()).absolutePath());
+  if (!indexFile.open(QIODevice::ReadWrite)) {
+    RE_LOG_WARN() << "Cannot open the texture index " << QSS(indexFile.fileName());
+    return;
+  }
+  qint64 indexSize = sizeof(ReTextureInfoHeader) + 
+                     static_cast<qint64>(sizeof(Record)) * RE_TEXTURE_INFO_SLOTS;
+  bool isNew = indexFile.size() != indexSize;
+  if (isNew && !indexFile.resize(indexSize)) {
+    RE_LOG_WARN() << "Cannot resize the texture index " << QSS(indexFile.fileName());
+    indexFile.close();
+    return;
+  }
+  data = indexFile.map(0, indexSize);
+  if (!data) {
+    RE_LOG_WARN() << "Cannot map the texture index " << QSS(indexFile.fileName());
+    indexFile.close();
+    return;
+  }
+  // An index written by a different version is discarded. If two
+  // processes do this at the same time the index is only cleared twice.
+  ReTextureInfoHeader* header = reinterpret_cast<ReTextureInfoHeader*>(data);
+  if ( isNew ||
+       memcmp(header->magic, RE_TEXTURE_INFO_MAGIC, 4) != 0 ||
+       header->version != RE_TEXTURE_INFO_VERSION ||
+       header->numSlots != RE_TEXTURE_INFO_SLOTS ||
+       header->recordSize != sizeof(Record) )
+  {
+    memset(header, 0, sizeof(ReTextureInfoHeader));
+    clear();
+    header->version    = RE_TEXTURE_INFO_VERSION;
+    header->numSlots   = RE_TEXTURE_INFO_SLOTS;
+    header->recordSize = sizeof(Record);
+    memcpy(header->magic, RE_TEXTURE_INFO_MAGIC, 4);
+  }
+}
+
+void ReTextureInfoCache::closeIndex() {
+  if (data) {
+    indexFile.unmap(data);
+    data = NULL;
+  }
+  indexFile.close();
+}
+
+inline ReTextureInfoCache::Record* ReTextureInfoCache::getRecords() const {
+  return reinterpret_cast<Record*>(data + sizeof(ReTextureInfoHeader));
+}
+
+void ReTextureInfoCache::clear() {
+  if (data) {
+    memset(getRecords(), 0, sizeof(Record) * RE_TEXTURE_INFO_SLOTS);
+  }
+}
+
+bool ReTextureInfoCache::lookup( const quint64 pathHash, Record& rec ) const {
+  if (!data) {
+    return false;
+  }
+  Record* records = getRecords();
+  for (int i = 0; i < RE_TEXTURE_INFO_MAX_PROBE; i++) {
+    Record* slot = records + (pathHash + i) % RE_TEXTURE_INFO_SLOTS;
+    // The atomic operations order the copy between the two reads of the
+    // sequence number. A busy entry can belong to another path, or have
+    // been abandoned by a writer, so the search goes on.
+    int before = slot->sequence.fetchAndAddAcquire(0);
+    if (before & 1) {
+      continue;
+    }
+    memcpy(&rec, slot, sizeof(Record));
+    int after = slot->sequence.fetchAndAddOrdered(0);
+    if (before != after) {
+      continue;
+    }
+    if (rec.pathHash == pathHash) {
+      return true;
+    }
+    if (rec.pathHash == 0) {
+      return false;
+    }
+  }
+  return false;
+}
+
+void ReTextureInfoCache::store( const quint64 pathHash, const ReTextureInfo& info ) {
+  if (!data) {
+    return;
+  }
+  Record* records = getRecords();
+  quint32 now = QDateTime::currentMSecsSinceEpoch() / 1000;
+  int claim = claimSequence(now);
+  for (int i = 0; i < RE_TEXTURE_INFO_MAX_PROBE; i++) {
+    Record* slot = records + (pathHash + i) % RE_TEXTURE_INFO_SLOTS;
+    // The last entry checked is replaced if all the others are taken
+    bool isLast = i == RE_TEXTURE_INFO_MAX_PROBE - 1;
+    int sequence = slot->sequence.fetchAndAddAcquire(0);
+    // A writer that crashed leaves its entry odd forever. Once the entry
+    // has been claimed for too long it's taken over and its content is
+    // replaced, whatever path it was for.
+    bool isStale = false;
+    if (sequence & 1) {
+      if (claimAge(sequence, now) < RE_TEXTURE_INFO_STALE_TIME) {
+        continue;
+      }
+      isStale = true;
+    }
+    if (!slot->sequence.testAndSetOrdered(sequence, claim)) {
+      return;
+    }
+    // If the entry has been taken over in the meantime the release fails
+    // and the new owner publishes the entry
+    int released = nextSequence(isStale ? claim : sequence);
+    if ( !isStale && slot->pathHash != pathHash && slot->pathHash != 0 && !isLast ) {
+      slot->sequence.testAndSetOrdered(claim, released);
+      continue;
+    }
+    slot->pathHash    = pathHash;
+    slot->modified    = info.modified;
+    slot->fileSize    = info.fileSize;
+    slot->contentHash = info.contentHash;
+    slot->width       = info.width;
+    slot->height      = info.height;
+    slot->channels    = info.channels;
+    slot->bitDepth    = info.bitDepth;
+    slot->flags       = (info.hasAlpha    ? RE_TEXTURE_INFO_HAS_ALPHA : 0) |
+                        (info.isGrayscale ? RE_TEXTURE_INFO_GRAYSCALE : 0) |
+                        (info.contentHash ? RE_TEXTURE_INFO_CONTENT_HASH : 0);
+    slot->sequence.testAndSetOrdered(claim, released);
+    return;
+  }
+}
+
+bool ReTextureInfoCache::probe( const QString& fileName, ReTextureInfo& info ) {
+  QImageReader reader(fileName);
+  QSize imgSize = reader.size();
+  if (!imgSize.isValid()) {
+    return false;
+  }
+  QImage::Format format = reader.imageFormat();
+  // A reduced copy is enough to find if the image has alpha or only grays
+  QSize sampleSize = imgSize;
+  if ( sampleSize.width() > RE_TEXTURE_INFO_SAMPLE || 
+       sampleSize.height() > RE_TEXTURE_INFO_SAMPLE ) 
+  {
+    sampleSize.scale(RE_TEXTURE_INFO_SAMPLE, RE_TEXTURE_INFO_SAMPLE, Qt::KeepAspectRatio);
+    reader.setScaledSize(sampleSize);
+  }
+  QImage sample = reader.read();
+  if (sample.isNull()) {
+    return false;
+  }
+  info.width       = imgSize.width();
+  info.height      = imgSize.height();
+  info.hasAlpha    = sample.hasAlphaChannel();
+  info.isGrayscale = sample.allGray();
+  info.channels    = (info.isGrayscale ? 1 : 3) + (info.hasAlpha ? 1 : 0);
+  info.bitDepth    = (format == QImage::Format_Mono || format == QImage::Format_MonoLSB) ? 1 : 8;
+  return true;
+}
+
+quint64 ReTextureInfoCache::hashContent( const QString& fileName ) {
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return 0;
+  }
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  while (!file.atEnd()) {
+    hash.addData(file.read(1024*1024));
+  }
+  QByteArray digest = hash.result();
+  quint64 value = 0;
+  for (int i = 0; i < 8; i++) {
+    value = (value << 8) | static_cast<uchar>(digest[i]);
+  }
+  return value ? value : 1;
+}
+
+bool ReTextureInfoCache::getInfo( const QString& fileName, 
+                                  ReTextureInfo& info,
+                                  const bool withContentHash )
+{
+  QFileInfo fileInfo(fileName);
+  if (!fileInfo.exists()) {
+    return false;
+  }
+  quint32 modified = fileInfo.lastModified().toTime_t();
+  quint64 fileSize = fileInfo.size();
+  quint64 pathHash = hashPath(fileName);
+
+  Record rec;
+  if (lookup(pathHash, rec) && rec.modified == modified && rec.fileSize == fileSize) {
+    info.modified    = rec.modified;
+    info.fileSize    = rec.fileSize;
+    info.width       = rec.width;
+    info.height      = rec.height;
+    info.channels    = rec.channels;
+    info.bitDepth    = rec.bitDepth;
+    info.hasAlpha    = (rec.flags & RE_TEXTURE_INFO_HAS_ALPHA) != 0;
+    info.isGrayscale = (rec.flags & RE_TEXTURE_INFO_GRAYSCALE) != 0;
+    info.contentHash = rec.contentHash;
+    if (withContentHash && !(rec.flags & RE_TEXTURE_INFO_CONTENT_HASH)) {
+      info.contentHash = hashContent(fileName);
+      store(pathHash, info);
+    }
+    return true;
+  }
+
+  RE_PROFILE_SCOPE("ProbeTexture");
+  numProbes.fetchAndAddRelaxed(1);
+  if (!probe(fileName, info)) {
+    return false;
+  }
+  info.modified    = modified;
+  info.fileSize    = fileSize;
+  info.contentHash = withContentHash ? hashContent(fileName) : 0;
+  store(pathHash, info);
+  return true;
+}
+
+QSize ReTextureInfoCache::getImageSize( const QString& fileName ) {
+  ReTextureInfo info;
+  if (!getInfo(fileName, info)) {
+    return QSize();
+  }
+  return info.getSize();
+}
+
+} // namespace
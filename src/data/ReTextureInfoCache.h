@@ -0,0 +1,157 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#ifndef RE_TEXTURE_INFO_CACHE_H
+#define RE_TEXTURE_INFO_CACHE_H
+
+#include <QAtomicInt>
+#include <QFile>
+#include <QSize>
+#include <QString>
+
+#include "reality_lib_export.h"
+#include "ReDefs.h"
+
+
+namespace Reality {
+
+//! What is known about an image file
+struct ReTextureInfo {
+  //! Modification time of the file, in seconds since the epoch
+  quint32 modified;
+  quint64 fileSize;
+  quint32 width;
+  quint32 height;
+  //! 1 or 3 channels, plus one for the alpha
+  quint8 channels;
+  //! Bits per channel
+  quint8 bitDepth;
+  bool hasAlpha;
+  bool isGrayscale;
+  //! Hash of the content of the file, zero if not computed
+  quint64 contentHash;
+
+  ReTextureInfo() :
+    modified(0),
+    fileSize(0),
+    width(0),
+    height(0),
+    channels(0),
+    bitDepth(0),
+    hasAlpha(false),
+    isGrayscale(false),
+    contentHash(0)
+  {
+  }
+
+  inline QSize getSize() const {
+    return QSize(width, height);
+  }
+};
+
+/**
+ * A persistent index of the size and format of the image maps.
+ *
+ * The exporter, the texture proxies and the image map editor used to open
+ * every image to find its size, and the information was lost at the end
+ * of the session. This class keeps it in an index file next to the ACSEL
+ * database, so that the probe of an image is done once per version of
+ * the file. The entries are identified by the path of the file and
+ * checked against its modification time and size, so a changed file is
+ * probed again the first time it's used.
+ *
+ * The index is a fixed-size hash table in a memory-mapped file, shared by
+ * all the processes that use Reality, the host plugin, the GUI and the
+ * preview renderer. Each entry is protected by a sequence number: a writer
+ * makes it odd while it updates the entry and a reader discards the copy
+ * of an entry if the number changed while it was reading. Lookups never
+ * take a lock and never wait for a writer, a busy entry is simply
+ * treated as missing. An entry left odd by a writer that crashed is
+ * reclaimed by the next store() of a path that hashes to it, after a few
+ * seconds.
+ *
+ * If the index cannot be mapped the images are probed every time.
+ *
+ * Like ReTextureProxyCache, this class is a singleton.
+ */
+class REALITY_LIB_EXPORT ReTextureInfoCache {
+
+private:
+  static ReTextureInfoCache* instance;
+
+  struct Record;
+
+  QFile indexFile;
+  //! The mapped index, NULL if it could not be mapped
+  uchar* data;
+
+  //! Number of images probed by this process, for the statistics
+  QAtomicInt numProbes;
+
+  ReTextureInfoCache();
+
+  void openIndex();
+
+  void closeIndex();
+
+  inline Record* getRecords() const;
+
+  //! Copies the entry of a path. Returns false if the path is not in the
+  //! index or if its entry is being written.
+  bool lookup( const quint64 pathHash, Record& rec ) const;
+
+  //! Stores the entry of a path. Nothing is stored if another thread or
+  //! process is writing the same entry.
+  void store( const quint64 pathHash, const ReTextureInfo& info );
+
+public:
+
+  ~ReTextureInfoCache();
+
+  static ReTextureInfoCache* getInstance();
+
+  //! Location of the index. By default the index is the TextureInfo.idx
+  //! file next to the ACSEL database.
+  inline QString getIndexFileName() const {
+    return indexFile.fileName();
+  }
+
+  void setIndexFileName( const QString& fileName );
+
+  /**
+   * Returns the information about an image, probing the image only if the
+   * index doesn't have it or if the file changed.
+   * \param withContentHash If true the hash of the content of the file is
+   *                        computed too, which means reading the whole
+   *                        file the first time.
+   * \return false if the file doesn't exist or is in a format that cannot
+   *         be read
+   */
+  bool getInfo( const QString& fileName, 
+                ReTextureInfo& info, 
+                const bool withContentHash = false );
+
+  //! Returns the size of an image, or an invalid size if it cannot be read
+  QSize getImageSize( const QString& fileName );
+
+  inline int getNumProbes() const {
+    return numProbes;
+  }
+
+  //! Removes all the entries
+  void clear();
+
+  //! Reads the information about an image from the file. The content
+  //! hash is not computed.
+  static bool probe( const QString& fileName, ReTextureInfo& info );
+
+  //! Computes the hash of the content of a file
+  static quint64 hashContent( const QString& fileName );
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,213 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#include "ReTextureProxyCache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+#include <QRunnable>
+
+#include "ReDataDir.h"
+#include "ReLogger.h"
+#include "ReProfiler.h"
+#include "ReTextureInfoCache.h"
+
+
+namespace Reality {
+
+#define RE_TEXTURE_PROXY_DIR     "TextureProxies"
+//! The proxies are generated while the user edits the materials, two
+//! threads are enough and leave the CPU to the host app
+#define RE_TEXTURE_PROXY_THREADS 2
+
+ReTextureProxyCache* ReTextureProxyCache::instance = NULL;
+
+//! Generates one proxy in the thread pool
+class ReTextureProxyCache::ProxyTask : public QRunnable {
+
+private:
+  QString fileName;
+  RGBChannel channel;
+  int maxSize;
+  QString proxyName;
+
+public:
+  ProxyTask( const QString& fileName,
+             const RGBChannel channel,
+             const int maxSize,
+             const QString& proxyName ) :
+    fileName(fileName),
+    channel(channel),
+    maxSize(maxSize),
+    proxyName(proxyName)
+  {
+  }
+
+  void run() {
+    RE_PROFILE_SCOPE("MakeTextureProxy");
+    ProxyResult result = makeProxy(fileName, channel, maxSize, proxyName);
+    ReTextureProxyCache::getInstance()->proxyDone(proxyName, result);
+  }
+};
+
+ReTextureProxyCache::ReTextureProxyCache() :
+  maxSize(RE_TEXTURE_PROXY_SIZE)
+{
+  cacheDir = getRealityDataDir(RE_TEXTURE_PROXY_DIR);
+  pool.setMaxThreadCount(RE_TEXTURE_PROXY_THREADS);
+  // The index is created here, before the threads of the pool use it
+  ReTextureInfoCache::getInstance();
+}
+
+ReTextureProxyCache* ReTextureProxyCache::getInstance() {
+  if (!instance) {
+    instance = new ReTextureProxyCache();
+  }
+  return instance;
+}
+
+void ReTextureProxyCache::setCacheDir( const QString& dirName ) {
+  waitForDone();
+  QMutexLocker locker(&lock);
+  cacheDir = dirName;
+  unneeded.clear();
+}
+
+void ReTextureProxyCache::setMaxSize( const int size ) {
+  waitForDone();
+  QMutexLocker locker(&lock);
+  maxSize = size;
+  unneeded.clear();
+}
+
+void ReTextureProxyCache::waitForDone() {
+  pool.waitForDone();
+}
+
+void ReTextureProxyCache::clear() {
+  waitForDone();
+  QMutexLocker locker(&lock);
+  QDir dir(cacheDir);
+  foreach( QString fileName, dir.entryList(QDir::Files) ) {
+    dir.remove(fileName);
+  }
+  unneeded.clear();
+}
+
+void ReTextureProxyCache::removeStaleEntries( const QString& key, const QString& stamp ) {
+  QDir dir(cacheDir);
+  QStringList entries = dir.entryList(QStringList(QString("%1-*").arg(key)), QDir::Files);
+  foreach( QString entry, entries ) {
+    if (entry.section('-', 1, 1) != stamp) {
+      dir.remove(entry);
+    }
+  }
+}
+
+void ReTextureProxyCache::proxyDone( const QString& proxyName, const ProxyResult result ) {
+  QMutexLocker locker(&lock);
+  pending.remove(proxyName);
+  if (result != ProxyCreated) {
+    unneeded.insert(proxyName);
+  }
+}
+
+ReTextureProxyCache::ProxyResult ReTextureProxyCache::makeProxy(
+                                   const QString& fileName,
+                                   const RGBChannel channel,
+                                   const int maxSize,
+                                   const QString& proxyName )
+{
+  QSize imgSize = ReTextureInfoCache::getInstance()->getImageSize(fileName);
+  if (!imgSize.isValid()) {
+    RE_LOG_WARN() << "Cannot read the size of the texture " << QSS(fileName);
+    return ProxyFailed;
+  }
+  // The renderer extracts the channel of small maps without any cost
+  if (imgSize.width() <= maxSize && imgSize.height() <= maxSize) {
+    return ProxyNotNeeded;
+  }
+  QImageReader reader(fileName);
+  imgSize.scale(maxSize, maxSize, Qt::KeepAspectRatio);
+  reader.setScaledSize(imgSize);
+  QImage img = reader.read();
+  if (img.isNull()) {
+    RE_LOG_WARN() << "Cannot read the texture " << QSS(fileName);
+    return ProxyFailed;
+  }
+
+  if (channel != RGB_Mean) {
+    QImage gray(img.width(), img.height(), QImage::Format_RGB32);
+    for (int y = 0; y < img.height(); y++) {
+      for (int x = 0; x < img.width(); x++) {
+        QRgb c = img.pixel(x, y);
+        int v = channel == RGB_Red ? qRed(c) : channel == RGB_Green ? qGreen(c) : qBlue(c);
+        gray.setPixel(x, y, qRgb(v, v, v));
+      }
+    }
+    img = gray;
+  }
+
+  // Write to a temporary file first, so that the preview never picks
+  // up a truncated proxy
+  QString tmpName = proxyName + ".tmp";
+  QFile::remove(tmpName);
+  if (!img.save(tmpName, "PNG") || !QFile::rename(tmpName, proxyName)) {
+    QFile::remove(tmpName);
+    RE_LOG_WARN() << "Cannot write the texture proxy " << QSS(proxyName);
+    return ProxyFailed;
+  }
+  return ProxyCreated;
+}
+
+QString ReTextureProxyCache::getProxy( const QString& fileName, const RGBChannel channel ) {
+  if (fileName.isEmpty()) {
+    return fileName;
+  }
+  QFileInfo srcInfo(fileName);
+  if (!srcInfo.exists()) {
+    return fileName;
+  }
+  if (!QImageReader::supportedImageFormats().contains(srcInfo.suffix().toLower().toAscii())) {
+    return fileName;
+  }
+
+  // The key identifies the original file, the stamp its version
+  QString key = QCryptographicHash::hash(srcInfo.absoluteFilePath().toUtf8(),
+                                         QCryptographicHash::Sha1)
+                  .toHex().left(16);
+  QString stamp = QString::number(srcInfo.lastModified().toTime_t());
+
+  QMutexLocker locker(&lock);
+  QString proxyName = QString("%1/%2-%3-%4%5.png")
+                        .arg(cacheDir)
+                        .arg(key)
+                        .arg(stamp)
+                        .arg(maxSize)
+                        .arg(channel == RGB_Red   ? "-r" :
+                             channel == RGB_Green ? "-g" :
+                             channel == RGB_Blue  ? "-b" : "");
+  if (unneeded.contains(proxyName) || pending.contains(proxyName)) {
+    return fileName;
+  }
+  if (QFile::exists(proxyName)) {
+    RE_PROFILE_COUNT("TextureProxyHits", 1);
+    return proxyName;
+  }
+
+  QDir().mkpath(cacheDir);
+  removeStaleEntries(key, stamp);
+  pending.insert(proxyName);
+  pool.start(new ProxyTask(fileName, channel, maxSize, proxyName));
+  return fileName;
+}
+
+} // namespace
@@ -0,0 +1,131 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#ifndef RE_TEXTURE_PROXY_CACHE_H
+#define RE_TEXTURE_PROXY_CACHE_H
+
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+
+#include "reality_lib_export.h"
+#include "ReDefs.h"
+
+
+namespace Reality {
+
+//! Default size, in pixels, of the longest side of the proxies
+#define RE_TEXTURE_PROXY_SIZE 512
+
+/**
+ * Reduced copies of the image maps, used only for the material previews.
+ *
+ * The material preview renders a small sphere or plane, yet the preview
+ * scene points the renderer to the original image maps, which are often
+ * 4K or 8K images. Loading them takes most of the time of a preview. This
+ * class creates copies of the maps, reduced so that their longest side is
+ * not larger than the proxy size, and stores them in a cache directory.
+ *
+ * A proxy is identified by the path of the original file, its
+ * modification time and the channel used by the texture. When a texture
+ * selects a single channel of the map the proxy stores only that channel,
+ * as a gray image. Proxies are generated in the background: until a proxy
+ * is ready the preview uses the original map, so asking for a proxy never
+ * delays the preview.
+ *
+ * Maps that are already small, and formats that Qt cannot read, like
+ * OpenEXR, are always used unchanged.
+ *
+ * Like ReIBLMapCache, this class is a singleton.
+ */
+class REALITY_LIB_EXPORT ReTextureProxyCache {
+
+public:
+  enum ProxyResult {
+    ProxyCreated,
+    //! The map is small enough to be used as it is
+    ProxyNotNeeded,
+    ProxyFailed
+  };
+
+private:
+  static ReTextureProxyCache* instance;
+
+  class ProxyTask;
+
+  QString cacheDir;
+  int maxSize;
+
+  //! Protects the sets of proxies and the cache directory, the proxies
+  //! are generated by the threads of the pool
+  QMutex lock;
+
+  //! Proxies being generated
+  QSet<QString> pending;
+
+  //! Proxies that don't need to be generated, or that cannot be
+  //! generated. The original map is used for them.
+  QSet<QString> unneeded;
+
+  QThreadPool pool;
+
+  ReTextureProxyCache();
+
+  //! Called by the background tasks when a proxy has been processed
+  void proxyDone( const QString& proxyName, const ProxyResult result );
+
+  //! Removes the proxies that have been generated from a previous
+  //! version of the file.
+  void removeStaleEntries( const QString& key, const QString& stamp );
+
+public:
+
+  static ReTextureProxyCache* getInstance();
+
+  //! Location of the proxies. By default the proxies are stored in the
+  //! TextureProxies directory next to the ACSEL database.
+  inline const QString& getCacheDir() const {
+    return cacheDir;
+  }
+
+  void setCacheDir( const QString& dirName );
+
+  inline int getMaxSize() const {
+    return maxSize;
+  }
+
+  void setMaxSize( const int size );
+
+  /**
+   * Returns the name of the map to be used by the material preview.
+   *
+   * If the proxy of the map is ready its name is returned. Otherwise the
+   * generation of the proxy is started in the background and fileName is
+   * returned.
+   *
+   * \param fileName The map used by the texture
+   * \param channel The channel of the map used by the texture
+   */
+  QString getProxy( const QString& fileName, const RGBChannel channel );
+
+  //! Waits for the proxies being generated
+  void waitForDone();
+
+  //! Deletes all the proxies
+  void clear();
+
+  //! Creates the proxy of a map, reduced so that its longest side is not
+  //! larger than maxSize.
+  static ProxyResult makeProxy( const QString& fileName,
+                                const RGBChannel channel,
+                                const int maxSize,
+                                const QString& proxyName );
+};
+
+} // namespace
+
+#endif
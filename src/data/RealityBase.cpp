@@ -34,7 +34,8 @@ using namespace Reality;
   }
 
 // Static variables definitions
-QStack<QString> RealityBase::commands;
+ReHostCommandQueue RealityBase::commands;
+QStringList RealityBase::pendingTokens;
 ReConfigurationPtr RealityBase::configuration;
 QStringList RealityBase::libraryPaths;
 // LuxLibraryLoaderPtr RealityBase::luxLib;
@@ -154,6 +155,8 @@ void RealityBase::main() {
   SET_DEFAULT_CONFIG(RE_CFG_LUX_WRITE_INTERVAL,  60)
   SET_DEFAULT_CONFIG(RE_CFG_OVERWRITE_WARNING,   true)
   SET_DEFAULT_CONFIG(RE_CFG_MAT_PREVIEW_CACHE_SIZE, 5)
+  SET_DEFAULT_CONFIG(RE_CFG_MAT_PREVIEW_DRAFT, true)
+  SET_DEFAULT_CONFIG(RE_CFG_MAT_PREVIEW_IN_PROCESS, true)
   // SET_DEFAULT_CONFIG(RE_CFG_USE_GPU, false)
   SET_DEFAULT_CONFIG(RE_CFG_OCL_GROUP_SIZE, 0)
   SET_DEFAULT_CONFIG(RE_CFG_KEEP_UI_RESPONSIVE, false)
@@ -203,6 +206,8 @@ void RealityBase::stopHostSideServices() {
     ReAcsel::getInstance()->eraseTempData();
     delete realityIPC;
   }
+  // The plugin is being unloaded, RealityBase is never deleted
+  RE_stopLogger();
 }
 
 QStringList& RealityBase::getLibraryPaths() {
@@ -218,16 +223,34 @@ ReConfigurationPtr RealityBase::getConfiguration() {
   return configuration;
 }
 
-void RealityBase::commandStackPush( const QString cmd ) {
-  commands.push(cmd);
+void RealityBase::pushCommand( const ReHostCommand& cmd ) {
+  if (!commands.push(cmd)) {
+    RE_LOG_WARN() << "The host command queue is full, command " 
+                  << QSS(cmd.toTokens().value(0)) << " dropped";
+  }
+}
+
+bool RealityBase::popCommand( ReHostCommand& cmd ) {
+  return commands.pop(cmd);
+}
+
+ReHostCommandQueue* RealityBase::getCommandQueue() {
+  return &commands;
 }
 
 QString RealityBase::commandStackPop() {
-  return commands.pop();
+  if (pendingTokens.isEmpty()) {
+    ReHostCommand cmd;
+    if (!commands.pop(cmd)) {
+      return QString();
+    }
+    pendingTokens = cmd.toTokens();
+  }
+  return pendingTokens.takeFirst();
 }
 
 qint16 RealityBase::getNumCommands() {
-  return commands.count();
+  return pendingTokens.count() + commands.count();
 }
 
 void RealityBase::setHostAppID( const HostAppID _hostAppID ) {
@@ -8,10 +8,11 @@
 #define REALITYBASE_H
 
 #include <QSharedPointer>
-#include <QStack>
+#include <QStringList>
 
 #include "reality_lib_export.h"
 #include "ReDefs.h"
+#include "ReHostCommandQueue.h"
 
 class QSettings;
 class QUndoStack;
@@ -36,20 +37,17 @@ typedef QSharedPointer<QSettings> ReConfigurationPtr;
 class REALITY_LIB_EXPORT RealityBase {
 
 private:
-  //! A stack of commands for the host-side portion of Reality, like the Python-based
+  //! A queue of commands for the host-side portion of Reality, like the Python-based
   //! version that runs inside Poser. This is a way of communicating things like "start rendering"
   //! or "fetch a camera parameter" or other pieces of data that rely on the Python API.
-  //! A command is pushed on the stack and then it's popped when requested. If the command
-  //! has parameters then the parameters are pushed onto the stack in reversed order followed
-  //! by the command. For example, a pseudo-function call: render(width, height) will be
-  //! passed as:
-  //!
-  //!   - push height
-  //!   - push width
-  //!   - push "render"
-  //! 
-  //! That's why the stack uses QVariants for its data 
-  static QStack<QString> commands;
+  //! Commands are pushed by any thread, usually the IPC thread, and they are executed
+  //! by the main thread of the host. See <ReHostCommandQueue>.
+  static ReHostCommandQueue commands;
+
+  //! The Python code in Poser reads commands one token at a time, the
+  //! name of the command followed by its parameters. This holds the tokens
+  //! of the command being read. See <commandStackPop()>.
+  static QStringList pendingTokens;
 
   //! The application's Undo Stack
   QUndoStack* undoStack;
@@ -105,7 +103,21 @@ public:
     return osType;
   }
 
-  void commandStackPush( const QString cmd );
+  //! Queues a command for the host. Can be called by any thread.
+  void pushCommand( const ReHostCommand& cmd );
+
+  //! Retrieves the next command for the host. Returns false if there are
+  //! no commands. Must be called only by the main thread of the host.
+  bool popCommand( ReHostCommand& cmd );
+
+  //! Returns the queue of commands for the host. Used to set the object
+  //! that is notified when new commands are available.
+  static ReHostCommandQueue* getCommandQueue();
+
+  //! Returns the next token of the pending commands. This is the
+  //! interface used by the Python code in Poser, which reads the name of
+  //! the command and then one token for each parameter, in the format
+  //! returned by <ReHostCommand::toTokens()>.
   QString commandStackPop();
 
   //! Get the number of pending commands. Returns 0 if there are no
@@ -363,9 +363,8 @@ QString ReLuxSceneExporter::getLights() {
   return str;
 }
 
-QString ReLuxSceneExporter::getMatrixString( const ReMatrix& matrix, 
-                                             const HostAppID appID,
-                                             const bool forInstance ) 
+ReMatrix ReLuxSceneExporter::convertMatrix( const ReMatrix& matrix,
+                                            const bool forInstance )
 {
   ReMatrix tx1(
     1, 0,  0, 0,
@@ -381,13 +380,17 @@ QString ReLuxSceneExporter::getMatrixString( const ReMatrix& matrix,
     0,  0,  0, 1
   );
 
-  ReMatrix m2;
   if (forInstance) {
-    m2 = tx1 * matrix * tx2;
-  }
-  else {
-    m2 = matrix * tx2;
+    return tx1 * matrix * tx2;
   }
+  return matrix * tx2;
+}
+
+QString ReLuxSceneExporter::getMatrixString( const ReMatrix& matrix, 
+                                             const HostAppID appID,
+                                             const bool forInstance ) 
+{
+  ReMatrix m2 = convertMatrix(matrix, forInstance);
 
   return QString("Transform [\n" 
                  "%01  %02  %03  %04\n" 
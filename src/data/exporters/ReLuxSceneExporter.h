@@ -64,6 +64,10 @@ public:
                                   const HostAppID appID,
                                   const bool forInstance = false );
 
+  //! Returns the matrix converted to the LuxRender coordinate system, as
+  //! described for \ref getMatrixString(). The translation is not scaled.
+  static ReMatrix convertMatrix( const ReMatrix& matrix, const bool forInstance = false );
+
   void prepare() {
 
   }
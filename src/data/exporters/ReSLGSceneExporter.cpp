@@ -1,21 +1,296 @@
 /*
   Reality plug-in
-  Copyright (c) Pret-a-3D/Paolo Ciccone 2012. All rights reserved.    
+  Copyright (c) Pret-a-3D/Paolo Ciccone 2012. All rights reserved.
 */
 
 #include "ReSLGSceneExporter.h"
 
-#include <QVariant>
+#include <QFileInfo>
+#include <QStringBuilder>
+
+#include "RealityBase.h"
+#include "ReCamera.h"
+#include "ReLuxcoreGeometryExporter.h"
+#include "ReMatrix.h"
+#include "ReSceneData.h"
+#include "ReSceneDataGlobal.h"
+#include "ReSceneResources.h"
+#include "ReTools.h"
+#include "exporters/luxcore/ReLuxcoreLightExporter.h"
+#include "exporters/luxcore/ReLuxcoreMaterialExporterFactory.h"
+#include "exporters/luxcore/ReLuxcoreSDLTranslator.h"
 
 
 namespace Reality {
-  
+
+QString ReSLGSceneExporter::getCamera() {
+  ReCameraPtr cam = RealitySceneData->getSelectedCamera();
+  if (cam.isNull()) {
+    // Extreme case. Just failing gracefully.
+    return "# There is no selected camera!\n"
+           "scene.camera.lookat.orig = 1 1 1\n"
+           "scene.camera.lookat.target = 0 0 0\n";
+  }
+
+  HostAppID hostApp = RealityBase::getRealityBase()->getHostAppID();
+  ReVector position;
+  ReVector target;
+  ReVector up;
+  const ReMatrix* matrix = cam->getMatrix();
+
+  matrix->getPosition(position);
+  matrix->getTarget(target);
+  matrix->getUpVector(up);
+  vectorToLux(position);
+  vectorToLux(target);
+  vectorToLux(up);
+
+  uint width = RealitySceneData->getWidth();
+  uint height = RealitySceneData->getHeight();
+  float aspectRatio = static_cast<float>(width) / static_cast<float>(height);
+
+  QString str = QString("# Camera: %1\n"
+                        "scene.camera.type = \"perspective\"\n"
+                        "scene.camera.lookat.orig = %2 %3 %4\n"
+                        "scene.camera.lookat.target = %5 %6 %7\n"
+                        "scene.camera.up = %8 %9 %10\n"
+                        "scene.camera.fieldofview = %11\n"
+                        "scene.camera.screenwindow = -%12 %12 -1 1\n")
+                  .arg(cam->getName())
+                  .arg(convertUnit(position.X, hostApp))
+                  .arg(convertUnit(position.Y, hostApp))
+                  .arg(convertUnit(position.Z, hostApp))
+                  .arg(convertUnit(target.X, hostApp))
+                  .arg(convertUnit(target.Y, hostApp))
+                  .arg(convertUnit(target.Z, hostApp))
+                  .arg(convertUnit(up.X, hostApp))
+                  .arg(convertUnit(up.Y, hostApp))
+                  .arg(convertUnit(up.Z, hostApp))
+                  .arg(cam->getFOV(width, height))
+                  .arg(aspectRatio);
+
+  // Studio doesn't use hither and yon
+  if (hostApp == Poser) {
+    str += QString("scene.camera.cliphither = %1\n"
+                   "scene.camera.clipyon = %2\n")
+             .arg(cam->getHither())
+             .arg(cam->getYon());
+  }
+
+  if (cam->isDOFEnabled()) {
+    float lensRadius = (cam->getFocalLength()/1000)/(2.0*cam->getDOFStop());
+    str += QString("scene.camera.lensradius = %1\n"
+                   "scene.camera.focaldistance = %2\n")
+             .arg(lensRadius)
+             .arg(cam->getFocalDistance());
+  }
+  return str;
+}
+
+QString ReSLGSceneExporter::getLights() {
+  ReLuxcoreLightExporter* lightExporter = ReLuxcoreLightExporter::getInstance();
+  ReLightIterator i(RealitySceneData->getLights());
+
+  QString str;
+  while(i.hasNext()) {
+    i.next();
+    // Meshlights are handled by the geometry exporter
+    ReLightPtr light = i.value();
+    if (light->getType() == MeshLight) {
+      continue;
+    }
+    if (light->isLightOn()) {
+      str += lightExporter->exportLight(light);
+    }
+  }
+  return str;
+}
+
+QString ReSLGSceneExporter::getMaterials() {
+  // The material exporters generate Lux statements, which are then
+  // translated to LuxCore properties
+  QString materials;
+  ReGeometryObjectDictionary objs = scene->getObjects();
+  ReGeometryObjectIterator i(objs);
+  while( i.hasNext() ) {
+    i.next();
+    ReGeometryObjectPtr obj = i.value();
+
+    if (!obj->isVisible()) {
+      continue;
+    }
+
+    ReMaterialIterator mi(obj->getMaterials());
+    while( mi.hasNext() ) {
+      mi.next();
+
+      ReMaterialPtr mat = mi.value();
+      if (mat.isNull()) {
+        RE_LOG_DEBUG() << "Error: one material for " << QSS(obj->getName()) << " is null";
+        continue;
+      }
+      if (!mat->isVisibleInRender()) {
+        continue;
+      }
+
+      ReMaterialExporterPtr matExporter = ReLuxcoreMaterialExporterFactory::getExporter(
+                                            mat.data()
+                                          );
+      boost::any textureData;
+      matExporter->exportTextures(mat.data(), textureData);
+      boost::any exportedMats;
+      matExporter->exportMaterial(mat.data(), exportedMats);
+      try {
+        materials += ReLuxcoreSDLTranslator::translate(
+                       boost::any_cast<QString>(textureData) % "\n" %
+                       boost::any_cast<QString>(exportedMats)
+                     );
+      }
+      catch(...) {
+        RE_LOG_WARN() << "Error: cast operation invalid for material "
+                      << mat->getName().toStdString();
+      }
+    }
+  }
+  return materials;
+}
+
+QString ReSLGSceneExporter::getFilm( const int frameNo ) {
+  ReCameraPtr cam = RealitySceneData->getSelectedCamera();
+  float frameMultiplier = RealitySceneData->getFrameMultiplier();
+  QString str = QString("film.width = %1\n"
+                        "film.height = %2\n")
+                  .arg(RealitySceneData->getWidth()*frameMultiplier)
+                  .arg(RealitySceneData->getHeight()*frameMultiplier);
+
+  if (!cam.isNull() && cam->isExposureEnabled()) {
+    str += QString("film.imagepipeline.0.type = \"TONEMAP_LUXLINEAR\"\n"
+                   "film.imagepipeline.0.sensitivity = %1\n"
+                   "film.imagepipeline.0.exposure = %2\n"
+                   "film.imagepipeline.0.fstop = %3\n")
+             .arg(cam->getISO())
+             .arg(cam->getShutter())
+             .arg(cam->getFStop());
+  }
+  else {
+    str += "film.imagepipeline.0.type = \"TONEMAP_AUTOLINEAR\"\n";
+  }
+  str += QString("film.imagepipeline.1.type = \"GAMMA_CORRECTION\"\n"
+                 "film.imagepipeline.1.value = %1\n")
+           .arg(RealitySceneData->getGamma());
+
+  QString extension;
+  switch (RealitySceneData->getImageFileFormat()) {
+    case PNG:
+      extension = "png";
+      break;
+    case EXR:
+      extension = "exr";
+      break;
+    case TGA:
+      extension = "tga";
+      break;
+  }
+  QFileInfo imageFileInfo(RealitySceneData->getImageFileName());
+  QString imageFileName = QString("%1/%2.%3")
+                            .arg(imageFileInfo.absolutePath())
+                            .arg(imageFileInfo.baseName())
+                            .arg(extension);
+  str += QString("film.outputs.0.type = \"%1\"\n"
+                 "film.outputs.0.filename = \"%2\"\n")
+           .arg(RealitySceneData->hasAlphaChannel() ? "RGBA_TONEMAPPED" : "RGB_TONEMAPPED")
+           .arg(expandFrameNumber(imageFileName, frameNo));
+
+  if ( !RealitySceneData->isOCLRenderingON() ) {
+    str += "film.filter.type = \"BLACKMANHARRIS\"\n"
+           "film.filter.width = 1.5\n";
+  }
+  else {
+    str += "film.filter.type = \"MITCHELL_SS\"\n"
+           "film.filter.width = 1.5\n";
+  }
+  return str;
+}
+
+QString ReSLGSceneExporter::getRenderEngine() {
+  ReSurfaceIntegratorType siType = RealitySceneData->getSurfaceIntegrator()->getType();
+  QString engine;
+  QString str;
+  if (RealitySceneData->isOCLRenderingON()) {
+    engine = RealitySceneData->getOCLBias() == 1 ? "BIASPATHOCL" : "PATHOCL";
+
+    unsigned char deviceFlags = RealitySceneData->getOCLDeviceFlags();
+    unsigned int numDevices = RealitySceneData->getNumOCLDevices();
+    if (numDevices > 0) {
+      QString deviceFlagStr;
+      for (unsigned int i = 0; i < numDevices; i++) {
+        deviceFlagStr += ((deviceFlags >> i) & 1U) ? "1" : "0";
+      }
+      str += QString("opencl.devices.select = \"%1\"\n").arg(deviceFlagStr);
+    }
+  }
+  else if (RealitySceneData->getCPUBias()) {
+    engine = "BIASPATHCPU";
+  }
+  else {
+    engine = siType == SI_BIDIR ? "BIDIRCPU" : "PATHCPU";
+  }
+  str += QString("renderengine.type = \"%1\"\n").arg(engine);
+
+  switch( RealitySceneData->getSampler() ) {
+    case sobol:
+      str += "sampler.type = \"SOBOL\"\n";
+      break;
+    default:
+      str += "sampler.type = \"METROPOLIS\"\n"
+             "sampler.metropolis.largesteprate = 0.4\n";
+  }
+
+  int numThreads = RealitySceneData->getNumThreads();
+  if (numThreads > 0) {
+    str += QString("native.threads.count = %1\n").arg(numThreads);
+  }
+  quint32 maxSPX = RealitySceneData->getMaxSPX();
+  if (maxSPX > 0) {
+    str += QString("batch.haltspp = %1\n").arg(maxSPX);
+  }
+  return str;
+}
+
+QString ReSLGSceneExporter::getRenderConfig( const QString& sceneFileName,
+                                             const int frameNo )
+{
+  return QString("#\n# LuxCore render configuration created by Reality by Pret-a-3D\n#\n"
+                 "scene.file = \"%1\"\n")
+           .arg(sceneFileName) %
+         getFilm(frameNo) %
+         getRenderEngine();
+}
+
 void ReSLGSceneExporter::exportScene( const int frameNo, boost::any& sceneData ) {
-  sceneData = QVariant("SLG Scene");
+  QString sceneFileName = expandFrameNumber(RealitySceneData->getSceneFileName(), frameNo);
+  ReSceneResources* sceneResources = ReSceneResources::getInstance();
+  sceneResources->setSceneName(sceneFileName);
+  sceneResources->initialize();
+  ReLuxcoreGeometryExporter::getInstance()->reset();
+
+  QString sceneStr = QString(
+    "#\n# LuxCore Scene created by Reality by Pret-a-3D\n#\n"
+  );
+  sceneStr += getCamera()    %
+              "\n"           %
+              getLights()    %
+              "\n"           %
+              getMaterials() %
+              "\n";
+  // Volumes are not supported by the LuxCore exporter yet
+  sceneResources->reset();
+
+  sceneData = sceneStr;
 }
 
 void ReSLGSceneExporter::cleanup() {
 
 }
 
-}
\ No newline at end of file
+}
@@ -1,6 +1,6 @@
 /*
   Reality plug-in
-  Copyright (c) Pret-a-3D/Paolo Ciccone 2012. All rights reserved.    
+  Copyright (c) Pret-a-3D/Paolo Ciccone 2012. All rights reserved.
 */
 
 #ifndef ReSLGSceneExporter_H
@@ -14,14 +14,25 @@
 
 namespace Reality {
 
-/*
-  Class: ReSLGSceneExporter
+/**
+  This class exports a scene to LuxCore/SLG using the native property-based
+  scene format.
+
+  The scene is split in two files: the render configuration (.cfg) and the
+  scene description (.scn). exportScene() returns the camera, lights,
+  textures and materials for the .scn file. The geometry is appended
+  to the same file by \ref ReLuxcoreGeometryExporter and saved in binary
+  PLY files. getRenderConfig() returns the content of the .cfg file.
  */
 
 class REALITY_LIB_EXPORT ReSLGSceneExporter : public ReBaseSceneExporter {
 private:
+  QString getCamera();
+  QString getLights();
+  QString getMaterials();
+  QString getFilm( const int frameNo );
+  QString getRenderEngine();
 
-  QString sceneStr; 
 public:
   // Constructor: ReSLGSceneExporter
   ReSLGSceneExporter( ReSceneData* scene ) : ReBaseSceneExporter(scene) {
@@ -32,8 +43,14 @@ public:
 
   void exportScene( const int frameNo, boost::any& sceneData );
 
+  //! Returns the render configuration for the scene.
+  //! \param sceneFileName The name of the .scn file, relative to the
+  //!                      configuration file.
+  //! \param frameNo The frame number used to expand the name of the image
+  QString getRenderConfig( const QString& sceneFileName, const int frameNo );
+
   void prepare() {
-    
+
   }
   void cleanup();
 };
@@ -61,9 +61,15 @@ public:
            .arg(tex->getNamedValue("bevel").toFloat())
            .arg(tex->getNamedValue("offset").toFloat())
            .arg(tex->getNamedValue("mortarSize").toFloat())
-           .arg(tex->getBrickTexture()->getUniqueName())
-           .arg(tex->getMortarTexture()->getUniqueName())
-           .arg(tex->getBrickModulationTexture()->getUniqueName())
+           .arg(ReLuxTextureExporter::getTextureFromCache(
+                  tex->getBrickTexture()
+                )->getUniqueName())
+           .arg(ReLuxTextureExporter::getTextureFromCache(
+                  tex->getMortarTexture()
+                )->getUniqueName())
+           .arg(ReLuxTextureExporter::getTextureFromCache(
+                  tex->getBrickModulationTexture()
+                )->getUniqueName())
            .arg(mapType)
            .arg(mapScale)
            ;
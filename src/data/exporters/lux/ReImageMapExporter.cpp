@@ -7,6 +7,7 @@
 
 #include "ReTexture.h"
 #include "ReSceneResources.h"
+#include "ReTextureProxyCache.h"
 #include "textures/ReImageMap.h"
 
 
@@ -48,6 +49,12 @@ const QString ReLuxImageMapExporter::exportTexture( ReTexturePtr texbase,
   }
 
   QString imFileName = tex->getFileName();
+  // The preview uses reduced copies of the maps, when they are available
+  if (isForPreview) {
+    imFileName = ReTextureProxyCache::getInstance()->getProxy(
+                   imFileName, tex->getRgbChannel()
+                 );
+  }
 
 #if defined(_WIN32)
   imFileName.replace('\\', '/');
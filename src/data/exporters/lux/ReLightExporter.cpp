@@ -11,6 +11,7 @@
 
 #include "RealityBase.h"
 #include "ReLight.h"
+#include "ReIBLMapCache.h"
 #include "ReMatrix.h"
 #include "ReSceneData.h"
 #include "ReSceneDataGlobal.h"
@@ -243,7 +244,15 @@ QString ReLuxLightExporter::exportIBLLight( const ReLightPtr light ) {
   str += "LightGroup \"IBL\"\n"
          "LightSource \"infinitesample\" "; 
 
-  QString mapFileName = light->getIBLMapFileName();
+  // Lux supports both the lat-long and the angular mapping, the map is
+  // only reduced to the size selected in the output options
+  bool isAngular = light->getIBLMapFormat() == ReLight::Angular;
+  QString mapFileName = ReIBLMapCache::getInstance()->prepareMap(
+                          light->getIBLMapFileName(), 
+                          isAngular,
+                          RealitySceneData->getIBLMapSize(),
+                          false
+                        );
   if ((mapFileName != "") && RealitySceneData->hasTextureCollection()) {
     mapFileName = ReSceneResources::getInstance()->collectTexture(
                     mapFileName, ReTextureSize::T_ORIGINAL
@@ -261,7 +270,7 @@ QString ReLuxLightExporter::exportIBLLight( const ReLightPtr light ) {
            .arg(mapFileName)
 #endif
            .arg(light->getIntensity()*IBL_GAIN_MULTIPLIER)
-           .arg(light->getIBLMapFormat() == ReLight::LatLong ? "latlong" : "angular" )
+           .arg(isAngular ? "angular" : "latlong")
            .arg(light->getGamma());
   }
   else {
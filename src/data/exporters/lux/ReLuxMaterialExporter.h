@@ -145,7 +145,7 @@ public:
       actualTex = ReLuxTextureExporter::writeFloatVersion( bumpMap, str );
     }
     else {
-      actualTex = bumpMap;
+      actualTex = ReLuxTextureExporter::getTextureFromCache(bumpMap);
     }
     QString actualTexName = actualTex->getUniqueName();
     // If this is a normal map then we simply export the map and possibly
@@ -169,7 +169,7 @@ public:
                                  );
           LUX_DEBUG(str)
           str += textureExporter->exportTexture(nmScale);
-          ReLuxTextureExporter::addTextureToCache(nmScale);
+          ReLuxTextureExporter::addTextureToCache(bmTextureName, nmScale);
         }
         return bmTextureName;
       }
@@ -204,15 +204,19 @@ public:
     clampTex->setMixTexture(actualTex);
     clampTex->setTexture1(bmNegative);
     clampTex->setTexture2(bmPositive);
-
-    auto textureExporter = ReLuxTextureExporterFactory::getExporter(clampTex);
-    str += textureExporter->exportTexture(clampTex);
+    // Materials with the same bump map and the same settings share the
+    // textures created here
+    if (!ReLuxTextureExporter::isTextureInCache(clampTex)) {
+      auto textureExporter = ReLuxTextureExporterFactory::getExporter(clampTex);
+      str += textureExporter->exportTexture(clampTex);
+      ReLuxTextureExporter::addTextureToCache(clampTex);
+    }
     
     // The following texture applies the strength of the bump map using 
     // a multiplier.
     QString bmTextureName = QString("%1_bumpmap").arg(mat->getUniqueName());
     auto bumpScale = ReMathPtr( new ReMath(bmTextureName) );
-    bumpScale->setTexture1(clampTex);
+    bumpScale->setTexture1(ReLuxTextureExporter::getTextureFromCache(clampTex));
     bumpScale->setTexture2(ReTexturePtr());    
     bumpScale->setAmount2(bmStrength);
     bumpScale->setFunction(ReMath::multiply);
@@ -221,7 +225,7 @@ public:
       str += textureExporter->exportTexture(bumpScale, bmTextureName);
       ReLuxTextureExporter::addTextureToCache(bumpScale);
     }
-    return bmTextureName;
+    return ReLuxTextureExporter::getTextureFromCache(bumpScale)->getUniqueName();
   }
 
   /**
@@ -250,9 +254,8 @@ public:
       actualTex = ReLuxTextureExporter::writeFloatVersion( dispMap, str );
     }
     else {
-      actualTex = dispMap;
+      actualTex = ReLuxTextureExporter::getTextureFromCache(dispMap);
     }
-    QString baseMapName = actualTex->getUniqueName();
 
     // The following texture implements a clamping system. The Negative and Positive values
     // in the disp map texture designate the minimum and maximum limits of the disp map
@@ -270,21 +273,26 @@ public:
     clampTex->setMixTexture(actualTex);
     clampTex->setTexture1(dmNegative);
     clampTex->setTexture2(dmPositive);
-    auto textureExporter = ReLuxTextureExporterFactory::getExporter(clampTex);
-    str += textureExporter->exportTexture(clampTex);
+    if (!ReLuxTextureExporter::isTextureInCache(clampTex)) {
+      auto textureExporter = ReLuxTextureExporterFactory::getExporter(clampTex);
+      str += textureExporter->exportTexture(clampTex);
+      ReLuxTextureExporter::addTextureToCache(clampTex);
+    }
 
     // The following texture applies the strength of the disp map using a 
-    // multiplier.
-    QString dmTextureName = QString("%1_dispmap").arg(baseMapName);
+    // multiplier. The geometry exporter refers to it using the name of the
+    // disp map of the material, so it's cached by name and not shared.
+    QString dmTextureName = QString("%1_dispmap")
+                              .arg(ReLuxTextureExporter::getFloatTextureUniqueName(dispMap));
     ReMathPtr dmTex = ReMathPtr( new ReMath(dmTextureName) );
-    dmTex->setTexture1(clampTex);
+    dmTex->setTexture1(ReLuxTextureExporter::getTextureFromCache(clampTex));
     dmTex->setTexture2(ReTexturePtr());    
     dmTex->setAmount2(dmStrength);
     dmTex->setFunction(ReMath::multiply);
-    if (!ReLuxTextureExporter::isTextureInCache(dmTex)) {
+    if (!ReLuxTextureExporter::isTextureInCache(dmTextureName)) {
       auto textureExporter = ReLuxTextureExporterFactory::getExporter(dmTex);
       str += textureExporter->exportTexture(dmTex);
-      ReLuxTextureExporter::addTextureToCache(dmTex);
+      ReLuxTextureExporter::addTextureToCache(dmTextureName, dmTex);
     }
     return dmTextureName;
   }
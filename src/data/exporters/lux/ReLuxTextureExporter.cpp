@@ -106,5 +106,14 @@ void ReLuxTextureExporter::addTextureToCache( ReTexturePtr tex ) {
   }  
 }
 
+void ReLuxTextureExporter::addTextureToCache( const QString& key, ReTexturePtr tex ) {
+  if (!cachingEnabled) {
+    return;
+  }
+  if (!textureCache.contains(key)) {
+    textureCache[key] = tex;
+  }
+}
+
 } // namespace
 
@@ -19,7 +19,8 @@
 
 namespace Reality {
 
-//! The texture cache
+//! The texture cache, keyed by texture GUID. Textures with the same
+//! structure share one entry and are exported once.
 typedef QHash<QString, ReTexturePtr> ReTextureCache;
 
 /**
@@ -148,6 +149,9 @@ public:
 
   //! Add one texture to the cache
   static void addTextureToCache( ReTexturePtr tex );
+  //! Add one texture to the cache using an explicit key. Used for textures
+  //! that are referenced by name and that must not be shared.
+  static void addTextureToCache( const QString& key, ReTexturePtr tex );
 
   virtual const QString exportTexture( ReTexturePtr tex, 
                                        const QString& assignedName = "",
@@ -80,7 +80,7 @@ private:
       t1 = ReLuxTextureExporter::writeFloatVersion( tex, textures );
     }
     else {
-      t1 = tex;
+      t1 = ReLuxTextureExporter::getTextureFromCache(tex);
     }
 
     texName = t1->getUniqueName();
@@ -51,7 +51,9 @@ void ReMixLuxExporter::exportMaterial( const ReMaterial* basemat,
           "\"texture amount\" [\"%2\"] "
         )
         .arg(matName)
-        .arg(mat->getMixTexture()->getUniqueName());
+        .arg(ReLuxTextureExporter::getTextureFromCache(
+               mat->getMixTexture()
+             )->getUniqueName());
   }
   else {
     str += QString(
@@ -0,0 +1,331 @@
+/*
+  Reality plug-in
+  Copyright (c) Pret-a-3D/Paolo Ciccone 2012. All rights reserved.
+*/
+
+#include "ReLuxcoreLightExporter.h"
+
+#include <math.h>
+
+#include <QColor>
+#include <QStringBuilder>
+
+#include "RealityBase.h"
+#include "ReLight.h"
+#include "ReIBLMapCache.h"
+#include "ReMatrix.h"
+#include "ReSceneData.h"
+#include "ReSceneDataGlobal.h"
+#include "ReSceneResources.h"
+#include "ReTools.h"
+#include "exporters/ReLuxSceneExporter.h"
+#include "exporters/luxcore/ReLuxcoreSDLTranslator.h"
+
+
+namespace Reality {
+
+// Singleton support data
+ReLuxcoreLightExporter* ReLuxcoreLightExporter::instance = NULL;
+
+// Singleton implementation
+ReLuxcoreLightExporter* ReLuxcoreLightExporter::getInstance() {
+  if (instance == NULL) {
+    instance = new ReLuxcoreLightExporter();
+  }
+  return instance;
+}
+
+// Approximation of the blackbody color for a temperature between
+// 1000K and 40000K, from the curve fitting by Tanner Helland.
+static void temperatureToRGB( const float kelvin, float& r, float& g, float& b ) {
+  float t = kelvin / 100.0;
+  if (t <= 66) {
+    r = 255;
+    g = 99.4708025861 * log(t) - 161.1195681661;
+    b = (t <= 19 ? 0 : 138.5177312231 * log(t - 10) - 305.0447927307);
+  }
+  else {
+    r = 329.698727446 * pow(t - 60, -0.1332047592);
+    g = 288.1221695283 * pow(t - 60, -0.0755148492);
+    b = 255;
+  }
+  r = qBound(0.0f, r, 255.0f) / 255.0;
+  g = qBound(0.0f, g, 255.0f) / 255.0;
+  b = qBound(0.0f, b, 255.0f) / 255.0;
+}
+
+QString ReLuxcoreLightExporter::getLightColor( const ReLightPtr light ) {
+  switch(light->getColorModel()) {
+    case ReLight::Temperature: {
+      float r,g,b;
+      temperatureToRGB(light->getColorTemperature(), r, g, b);
+      return QString("%1 %2 %3").arg(r).arg(g).arg(b);
+    }
+    case ReLight::RGB: {
+      QColor clr = light->getColor();
+      return QString("%1 %2 %3").arg(clr.redF()).arg(clr.greenF()).arg(clr.blueF());
+    }
+    case ReLight::Preset:
+      break;
+  }
+  return "1 1 1";
+}
+
+QString ReLuxcoreLightExporter::getLightFile( const QString& fileName ) {
+  QString str = fileName;
+  if ((str != "") && RealitySceneData->hasTextureCollection()) {
+    str = ReSceneResources::getInstance()->collectTexture(
+            str, ReTextureSize::T_ORIGINAL
+          );
+  }
+  return str.replace('\\', '/');
+}
+
+QString ReLuxcoreLightExporter::exportMeshLight( const ReLightPtr light,
+                                                 const QString& matPrefix,
+                                                 QString& textures )
+{
+  QString str = QString("%1.emission.gain = %2 %2 %2\n"
+                        "%1.emission.power = %3\n"
+                        "%1.emission.efficency = %4\n")
+                  .arg(matPrefix)
+                  .arg(light->getIntensity())
+                  .arg(light->getPower())
+                  .arg(light->getEfficiency());
+
+  QString lightImagemap = getLightFile(light->getTexture());
+  if (lightImagemap == "") {
+    str += QString("%1.emission = %2\n").arg(matPrefix).arg(getLightColor(light));
+  }
+  else {
+    QString texName = ReLuxcoreSDLTranslator::sanitizeName(
+                        QString("%1_L").arg(light->getName())
+                      );
+    textures += QString("scene.textures.%1.type = \"imagemap\"\n"
+                        "scene.textures.%1.file = \"%2\"\n")
+                  .arg(texName)
+                  .arg(lightImagemap);
+    str += QString("%1.emission = \"%2\"\n").arg(matPrefix).arg(texName);
+  }
+
+  QString iesFile = getLightFile(light->getIesFileName());
+  if (iesFile != "") {
+    str += QString("%1.emission.iesfile = \"%2\"\n").arg(matPrefix).arg(iesFile);
+  }
+  return str;
+}
+
+QString ReLuxcoreLightExporter::exportSpotLight( const ReLightPtr light,
+                                                 const QString& prefix )
+{
+  auto appId = RealityBase::getRealityBase()->getHostAppID();
+  const ReMatrix* matrix = light->getMatrix();
+
+  ReVector position;
+  ReVector target;
+  matrix->getPosition(position);
+  matrix->getTarget(target);
+  vectorToLux(position);
+  vectorToLux(target);
+
+  QString str = QString("%1.position = %2 %3 %4\n"
+                        "%1.target = %5 %6 %7\n")
+                  .arg(prefix)
+                  .arg(convertUnit(position.X, appId))
+                  .arg(convertUnit(position.Y, appId))
+                  .arg(convertUnit(position.Z, appId))
+                  .arg(convertUnit(target.X, appId))
+                  .arg(convertUnit(target.Y, appId))
+                  .arg(convertUnit(target.Z, appId));
+
+  QString lightImagemap = getLightFile(light->getTexture());
+  if (lightImagemap != "") {
+    // If there is an imagemap texture attached then we convert the light
+    // to a projector
+    str += QString("%1.type = \"projection\"\n"
+                   "%1.mapfile = \"%2\"\n"
+                   "%1.fov = %3\n"
+                   "%1.gain = %4 %4 %4\n")
+             .arg(prefix)
+             .arg(lightImagemap)
+             .arg(light->getAngle()/2)
+             .arg(light->getIntensity());
+    return str;
+  }
+
+  // Lux works with the half angle. We add 1/2 of the edge feather just to
+  // give some more "room", the same as for the Lux exporter.
+  str += QString("%1.type = \"spot\"\n"
+                 "%1.coneangle = %2\n"
+                 "%1.conedeltaangle = %3\n"
+                 "%1.color = %4\n"
+                 "%1.gain = %5 %5 %5\n"
+                 "%1.power = %6\n"
+                 "%1.efficency = %7\n")
+           .arg(prefix)
+           .arg((light->getAngle()+(light->getFeather()/2))/2)
+           .arg(light->getFeather())
+           .arg(getLightColor(light))
+           .arg(light->getIntensity())
+           .arg(light->getPower())
+           .arg(light->getEfficiency());
+  return str;
+}
+
+QString ReLuxcoreLightExporter::exportPointLight( const ReLightPtr light,
+                                                  const QString& prefix )
+{
+  auto appID = RealityBase::getRealityBase()->getHostAppID();
+  ReVector pos;
+  light->getMatrix()->getPosition(pos);
+  vectorToLux(pos);
+
+  QString iesFile = getLightFile(light->getIesFileName());
+  QString lightImagemap = getLightFile(light->getTexture());
+  bool isMapped = iesFile != "" || lightImagemap != "";
+
+  QString str = QString("%1.type = \"%2\"\n"
+                        "%1.position = %3 %4 %5\n"
+                        "%1.color = %6\n"
+                        "%1.gain = %7 %7 %7\n"
+                        "%1.power = %8\n"
+                        "%1.efficency = %9\n")
+                  .arg(prefix)
+                  .arg(isMapped ? "mappoint" : "point")
+                  .arg(convertUnit(pos.X, appID))
+                  .arg(convertUnit(pos.Y, appID))
+                  .arg(convertUnit(pos.Z, appID))
+                  .arg(getLightColor(light))
+                  .arg(light->getIntensity())
+                  .arg(light->getPower())
+                  .arg(light->getEfficiency());
+  if (iesFile != "") {
+    str += QString("%1.iesfile = \"%2\"\n").arg(prefix).arg(iesFile);
+  }
+  if (lightImagemap != "") {
+    str += QString("%1.mapfile = \"%2\"\n").arg(prefix).arg(lightImagemap);
+  }
+  return str;
+}
+
+QString ReLuxcoreLightExporter::exportSunlight( const ReLightPtr light,
+                                                const QString& prefix )
+{
+  // See the Lux exporter for the use of the inverse matrix
+  ReMatrix mi = light->getMatrix()->inverse();
+  QString sunDir = QString("%1 %2 %3")
+                     .arg( mi.m[0][2])
+                     .arg(-mi.m[2][2])
+                     .arg( mi.m[1][2]);
+
+  QString str = QString("%1_sun.type = \"sun\"\n"
+                        "%1_sun.dir = %2\n"
+                        "%1_sun.turbidity = %3\n"
+                        "%1_sun.relsize = %4\n"
+                        "%1_sun.gain = %5 %5 %5\n")
+                  .arg(prefix)
+                  .arg(sunDir)
+                  .arg(light->getSunTurbidity())
+                  .arg(light->getSunScale())
+                  .arg(light->getIntensity());
+  str += QString("%1_sky.type = \"%2\"\n"
+                 "%1_sky.dir = %3\n"
+                 "%1_sky.turbidity = %4\n"
+                 "%1_sky.gain = %5 %5 %5\n")
+           .arg(prefix)
+           .arg(light->hasNewStyleSky() ? "sky2" : "sky")
+           .arg(sunDir)
+           .arg(light->getSkyTurbidity())
+           .arg(light->getSkyIntensity());
+  return str;
+}
+
+QString ReLuxcoreLightExporter::exportInfiniteLight( const ReLightPtr light,
+                                                     const QString& prefix )
+{
+  // The Lux exporter points the light at 0 -1 0 and then applies the
+  // light's matrix. We do the same by transforming the direction vector.
+  ReMatrix m = ReLuxSceneExporter::convertMatrix(*light->getMatrix());
+
+  return QString("%1.type = \"distant\"\n"
+                 "%1.direction = %2 %3 %4\n"
+                 "%1.color = %5\n"
+                 "%1.gain = %6 %6 %6\n")
+           .arg(prefix)
+           .arg(-m.m[1][0])
+           .arg(-m.m[1][1])
+           .arg(-m.m[1][2])
+           .arg(getLightColor(light))
+           .arg(light->getIntensity());
+}
+
+QString ReLuxcoreLightExporter::exportIBLLight( const ReLightPtr light,
+                                                const QString& prefix )
+{
+  float gain = light->getIntensity()*IBL_GAIN_MULTIPLIER;
+  // The infinite light of LuxCore uses only the lat-long mapping, angular
+  // maps are converted
+  bool isAngular = light->getIBLMapFormat() == ReLight::Angular;
+  QString mapFileName = getLightFile(
+                          ReIBLMapCache::getInstance()->prepareMap(
+                            light->getIBLMapFileName(), 
+                            isAngular,
+                            RealitySceneData->getIBLMapSize(),
+                            true
+                          )
+                        );
+  if (mapFileName == "") {
+    qreal r,g,b;
+    light->getColor().getRgbF(&r, &g, &b);
+    return QString("%1.type = \"constantinfinite\"\n"
+                   "%1.color = %2 %3 %4\n"
+                   "%1.gain = %5 %5 %5\n")
+             .arg(prefix)
+             .arg(r).arg(g).arg(b)
+             .arg(gain);
+  }
+
+  // Same transformation used for Lux: the map is flipped and the rotation
+  // is the opposite of Poser and DS
+  float angle = -light->getIBLRotationAngle() * M_PI / 180.0;
+  float c = cos(angle), s = sin(angle);
+  return QString("%1.type = \"infinite\"\n"
+                 "%1.file = \"%2\"\n"
+                 "%1.gamma = %3\n"
+                 "%1.gain = %4 %4 %4\n"
+                 "%1.transformation = %5 %6 0 0 %6 %7 0 0 0 0 1 0 0 0 0 1\n")
+           .arg(prefix)
+           .arg(mapFileName)
+           .arg(light->getGamma())
+           .arg(gain)
+           .arg(-c).arg(s).arg(c);
+}
+
+QString ReLuxcoreLightExporter::exportLight( const ReLightPtr light ) {
+  QString prefix = QString("scene.lights.%1")
+                     .arg(ReLuxcoreSDLTranslator::sanitizeName(light->getID()));
+  QString str = QString("# Light: %1\n").arg(light->getName());
+  switch( light->getType() ) {
+    case SpotLight:
+      str += exportSpotLight(light, prefix);
+      break;
+    case SunLight:
+      str += exportSunlight(light, prefix);
+      break;
+    case InfiniteLight:
+      str += exportInfiniteLight(light, prefix);
+      break;
+    case PointLight:
+      str += exportPointLight(light, prefix);
+      break;
+    case IBLLight:
+      str += exportIBLLight(light, prefix);
+      break;
+    case MeshLight:
+    case UndefinedLight:
+      break;
+  }
+  return str;
+}
+
+} // namespace
@@ -0,0 +1,70 @@
+/*
+  Reality plug-in
+  Copyright (c) Pret-a-3D/Paolo Ciccone 2012. All rights reserved.
+*/
+
+#ifndef RE_LUXCORE_LIGHT_EXPORTER_H
+#define RE_LUXCORE_LIGHT_EXPORTER_H
+
+#include "reality_lib_export.h"
+#include "exporters/ReBaseLightExporter.h"
+
+
+namespace Reality {
+
+/**
+  Exports a light using the LuxCore property format.
+  Implemented as a singleton. To call it use:
+
+    ReLuxcoreLightExporter::getInstance()
+ */
+class REALITY_LIB_EXPORT ReLuxcoreLightExporter : public ReBaseLightExporter {
+private:
+  static ReLuxcoreLightExporter* instance;
+
+  //! Returns the RGB value of the light's color model. LuxCore only
+  //! accepts RGB values for the light color so color temperatures are
+  //! converted and the lamp presets are returned as white.
+  QString getLightColor( const ReLightPtr light );
+
+  //! Returns the path of a file used by a light, collected with the
+  //! textures if texture collection is enabled.
+  QString getLightFile( const QString& fileName );
+
+  QString exportSpotLight( const ReLightPtr light, const QString& prefix );
+  QString exportPointLight( const ReLightPtr light, const QString& prefix );
+  QString exportSunlight( const ReLightPtr light, const QString& prefix );
+  QString exportInfiniteLight( const ReLightPtr light, const QString& prefix );
+  QString exportIBLLight( const ReLightPtr light, const QString& prefix );
+
+public:
+  // Constructor: ReLuxcoreLightExporter
+  ReLuxcoreLightExporter() {
+  };
+  // Destructor: ReLuxcoreLightExporter
+  ~ReLuxcoreLightExporter() {
+  };
+
+  //! Exports the light as a set of "scene.lights.*" properties. Mesh
+  //! lights are exported by the geometry exporter, see
+  //! \ref exportMeshLight()
+  QString exportLight( const ReLightPtr light );
+
+  //! Returns the emission properties for the material that is attached to
+  //! the geometry of a mesh light. Textures needed by the light are
+  //! added to the textures parameter.
+  //! \param light The mesh light
+  //! \param matPrefix The prefix of the material's properties, for example
+  //!                  "scene.materials.Figure_Light"
+  //! \param textures Receives the definition of the light's textures
+  QString exportMeshLight( const ReLightPtr light,
+                           const QString& matPrefix,
+                           QString& textures );
+
+  static ReLuxcoreLightExporter* getInstance();
+};
+
+} // namespace
+
+
+#endif
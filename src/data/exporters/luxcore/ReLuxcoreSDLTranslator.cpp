@@ -0,0 +1,401 @@
+/*
+  Reality plug-in
+  Copyright (c) Pret-a-3D/Paolo Ciccone 2012. All rights reserved.
+*/
+
+#include "ReLuxcoreSDLTranslator.h"
+
+#include <math.h>
+
+#include <QHash>
+#include <QStringBuilder>
+
+
+namespace Reality {
+
+// Lux texture classes that have a different name in LuxCore
+static QHash<QString, QString> initTextureClassMap() {
+  QHash<QString, QString> map;
+  map["checkerboard"] = "checkerboard2d";
+  map["normalmap"]    = "imagemap";
+  map["cauchy"]       = "fresnelconst";
+  map["sopra"]        = "fresnelsopra";
+  // LuxCore does not support spectral data for the lamps
+  map["lampspectrum"] = "constfloat3";
+  return map;
+}
+
+// Lux material types that have a different name in LuxCore
+static QHash<QString, QString> initMaterialTypeMap() {
+  QHash<QString, QString> map;
+  map["glossy"] = "glossy2";
+  map["metal"]  = "metal2";
+  return map;
+}
+
+// Parameters that are renamed in LuxCore. Parameters not listed here are
+// written with their name in lowercase.
+static QHash<QString, QString> initParamMap() {
+  QHash<QString, QString> map;
+  map["tex1"]           = "texture1";
+  map["tex2"]           = "texture2";
+  map["filename"]       = "file";
+  map["mapname"]        = "file";
+  map["bumpmap"]        = "bumptex";
+  map["namedmaterial1"] = "material1";
+  map["namedmaterial2"] = "material2";
+  map["presetname"]     = "preset";
+  map["film"]           = "filmthickness";
+  map["filmindex"]      = "filmior";
+  return map;
+}
+
+// Parameters that have no meaning for LuxCore
+static QHash<QString, bool> initSkippedParams() {
+  QHash<QString, bool> skipped;
+  skipped["separable"]       = true;
+  skipped["wrap"]            = true;
+  skipped["filtertype"]      = true;
+  skipped["dispersion"]      = true;
+  skipped["onesided"]        = true;
+  skipped["energyconserving"] = true;
+  skipped["architectural"]   = true;
+  skipped["displacementmap"] = true;
+  skipped["dmscale"]         = true;
+  skipped["dmoffset"]        = true;
+  return skipped;
+}
+
+static const QHash<QString, QString> textureClassMap = initTextureClassMap();
+static const QHash<QString, QString> materialTypeMap = initMaterialTypeMap();
+static const QHash<QString, QString> paramMap        = initParamMap();
+static const QHash<QString, bool>    skippedParams   = initSkippedParams();
+
+
+QString ReLuxcoreSDLTranslator::sanitizeName( const QString& name ) {
+  QString str = name;
+  int len = str.length();
+  for (int i = 0; i < len; i++) {
+    QChar c = str[i];
+    if (!c.isLetterOrNumber() && c != '_' && c != '-') {
+      str[i] = '_';
+    }
+  }
+  return str;
+}
+
+QStringList ReLuxcoreSDLTranslator::tokenize( const QString& luxSDL,
+                                              QList<bool>& isString )
+{
+  QStringList tokens;
+  isString.clear();
+  int len = luxSDL.length();
+  int i = 0;
+  while (i < len) {
+    QChar c = luxSDL[i];
+    if (c.isSpace()) {
+      i++;
+    }
+    else if (c == '#') {
+      while (i < len && luxSDL[i] != '\n') {
+        i++;
+      }
+    }
+    else if (c == '"') {
+      int end = luxSDL.indexOf('"', i+1);
+      if (end < 0) {
+        end = len;
+      }
+      tokens << luxSDL.mid(i+1, end-i-1);
+      isString << true;
+      i = end+1;
+    }
+    else if (c == '[' || c == ']') {
+      tokens << QString(c);
+      isString << false;
+      i++;
+    }
+    else {
+      int start = i;
+      while (i < len) {
+        c = luxSDL[i];
+        if (c.isSpace() || c == '"' || c == '[' || c == ']' || c == '#') {
+          break;
+        }
+        i++;
+      }
+      tokens << luxSDL.mid(start, i-start);
+      isString << false;
+    }
+  }
+  return tokens;
+}
+
+ReLuxcoreSDLTranslator::LuxParamList ReLuxcoreSDLTranslator::readParams(
+  const QStringList& tokens,
+  const QList<bool>& isString,
+  int& pos )
+{
+  LuxParamList params;
+  int numTokens = tokens.count();
+  while (pos < numTokens && isString[pos]) {
+    LuxParam param;
+    QStringList decl = tokens[pos].simplified().split(' ');
+    pos++;
+    if (decl.count() == 2) {
+      param.type = decl[0];
+      param.name = decl[1];
+    }
+    if (pos < numTokens && tokens[pos] == "[" && !isString[pos]) {
+      pos++;
+      while (pos < numTokens && (isString[pos] || tokens[pos] != "]")) {
+        param.values << tokens[pos];
+        pos++;
+      }
+      pos++;
+    }
+    else if (pos < numTokens) {
+      // Unbracketed single value
+      param.values << tokens[pos];
+      pos++;
+    }
+    if (!param.name.isEmpty()) {
+      params << param;
+    }
+  }
+  return params;
+}
+
+QString ReLuxcoreSDLTranslator::formatValues( const LuxParam& param ) {
+  if (param.type == "texture" || param.type == "string") {
+    QStringList values;
+    foreach(QString v, param.values) {
+      if (param.type == "texture" || param.name.startsWith("namedmaterial")) {
+        v = sanitizeName(v);
+      }
+      values << QString("\"%1\"").arg(v);
+    }
+    return values.join(" ");
+  }
+  if (param.type == "bool") {
+    QStringList values;
+    foreach(QString v, param.values) {
+      values << (v == "true" ? "1" : "0");
+    }
+    return values.join(" ");
+  }
+  return param.values.join(" ");
+}
+
+QString ReLuxcoreSDLTranslator::translateTexture( const QString& name,
+                                                  const QString& dataType,
+                                                  const QString& texClass,
+                                                  const LuxParamList& params )
+{
+  QString prefix = QString("scene.textures.%1").arg(sanitizeName(name));
+  QString luxcoreClass = textureClassMap.value(texClass, texClass);
+
+  if (texClass == "constant") {
+    luxcoreClass = (dataType == "color" ? "constfloat3" : "constfloat1");
+  }
+  else if (texClass == "checkerboard") {
+    foreach(LuxParam p, params) {
+      if (p.name == "dimension" && p.values.value(0) == "3") {
+        luxcoreClass = "checkerboard3d";
+      }
+    }
+  }
+  QString str = QString("%1.type = \"%2\"\n").arg(prefix).arg(luxcoreClass);
+  if (texClass == "lampspectrum") {
+    return str % prefix % ".value = 1 1 1\n";
+  }
+  if (texClass == "normalmap") {
+    // Normal maps must not be gamma corrected
+    str += prefix % ".gamma = 1\n";
+  }
+
+  // 2D mapping
+  QString uscale = "1", vscale = "1", udelta = "0", vdelta = "0";
+  bool has2DMapping = false;
+  // 3D mapping
+  QString coordinates;
+  float scale[3]     = {1, 1, 1},
+        rotate[3]    = {0, 0, 0},
+        translate[3] = {0, 0, 0};
+
+  foreach(LuxParam p, params) {
+    if (p.name == "mapping") {
+      has2DMapping = true;
+    }
+    else if (p.name == "uscale") {
+      uscale = p.values.value(0, "1");
+      has2DMapping = true;
+    }
+    else if (p.name == "vscale") {
+      vscale = p.values.value(0, "1");
+      has2DMapping = true;
+    }
+    else if (p.name == "udelta") {
+      udelta = p.values.value(0, "0");
+      has2DMapping = true;
+    }
+    else if (p.name == "vdelta") {
+      vdelta = p.values.value(0, "0");
+      has2DMapping = true;
+    }
+    else if (p.name == "coordinates") {
+      coordinates = p.values.value(0);
+    }
+    else if (p.name == "scale" || p.name == "rotate" || p.name == "translate") {
+      float* v = (p.name == "scale" ? scale : p.name == "rotate" ? rotate : translate);
+      for (int i = 0; i < 3 && i < p.values.count(); i++) {
+        v[i] = p.values[i].toFloat();
+      }
+    }
+    else if (p.name == "dimension" || skippedParams.contains(p.name)) {
+      continue;
+    }
+    else if (texClass == "cauchy" && p.name == "index") {
+      str += prefix % ".n = " % formatValues(p) % "\n";
+    }
+    else {
+      str += QString("%1.%2 = %3\n")
+               .arg(prefix)
+               .arg(paramMap.value(p.name, p.name.toLower()))
+               .arg(formatValues(p));
+    }
+  }
+
+  if (has2DMapping) {
+    str += QString("%1.mapping.type = \"uvmapping2d\"\n"
+                   "%1.mapping.uvscale = %2 %3\n"
+                   "%1.mapping.uvdelta = %4 %5\n")
+             .arg(prefix)
+             .arg(uscale).arg(vscale)
+             .arg(udelta).arg(vdelta);
+  }
+  else if (!coordinates.isEmpty()) {
+    QString mappingType = "uvmapping3d";
+    if (coordinates.startsWith("global")) {
+      mappingType = "globalmapping3d";
+    }
+    else if (coordinates.startsWith("local")) {
+      mappingType = "localmapping3d";
+    }
+    // Transform = Translate * RotateX * RotateY * RotateZ * Scale
+    float rx = rotate[0] * M_PI / 180.0,
+          ry = rotate[1] * M_PI / 180.0,
+          rz = rotate[2] * M_PI / 180.0;
+    float cx = cos(rx), sx = sin(rx),
+          cy = cos(ry), sy = sin(ry),
+          cz = cos(rz), sz = sin(rz);
+    float r[3][3] = {
+      { cy*cz,            -cy*sz,             sy    },
+      { sx*sy*cz + cx*sz, -sx*sy*sz + cx*cz, -sx*cy },
+      {-cx*sy*cz + sx*sz,  cx*sy*sz + sx*cz,  cx*cy }
+    };
+    // LuxCore reads the matrix in column-major order
+    QStringList m;
+    for (int col = 0; col < 3; col++) {
+      for (int row = 0; row < 3; row++) {
+        m << QString::number(r[row][col] * scale[col]);
+      }
+      m << "0";
+    }
+    m << QString::number(translate[0])
+      << QString::number(translate[1])
+      << QString::number(translate[2])
+      << "1";
+    str += QString("%1.mapping.type = \"%2\"\n"
+                   "%1.mapping.transformation = %3\n")
+             .arg(prefix)
+             .arg(mappingType)
+             .arg(m.join(" "));
+  }
+  return str;
+}
+
+QString ReLuxcoreSDLTranslator::translateMaterial( const QString& name,
+                                                   const LuxParamList& params )
+{
+  QString prefix = QString("scene.materials.%1").arg(sanitizeName(name));
+
+  // Find the type first, some parameters depend on it
+  QString luxType;
+  bool isArchitectural = false;
+  bool hasRoughness = false;
+  foreach(LuxParam p, params) {
+    if (p.name == "type") {
+      luxType = p.values.value(0);
+    }
+    else if (p.name == "architectural") {
+      isArchitectural = p.values.value(0) == "true";
+    }
+    else if (p.name == "uroughness" || p.name == "vroughness") {
+      hasRoughness = true;
+    }
+  }
+  QString luxcoreType = materialTypeMap.value(luxType, luxType);
+  if (luxType == "glass" || luxType == "glass2") {
+    luxcoreType = isArchitectural ? "archglass" : (hasRoughness ? "roughglass" : "glass");
+  }
+
+  QString str = QString("%1.type = \"%2\"\n").arg(prefix).arg(luxcoreType);
+  foreach(LuxParam p, params) {
+    if (p.name == "type" || skippedParams.contains(p.name)) {
+      continue;
+    }
+    QString paramName = paramMap.value(p.name, p.name.toLower());
+    if (luxType == "matte" && p.name == "sigma") {
+      if (p.values.value(0).toFloat() > 0) {
+        str.replace(QString("%1.type = \"matte\"").arg(prefix),
+                    QString("%1.type = \"roughmatte\"").arg(prefix));
+      }
+    }
+    else if (luxType == "metal" && p.name == "name") {
+      paramName = "preset";
+    }
+    else if (luxcoreType.endsWith("glass") && p.name == "index") {
+      paramName = "interiorior";
+    }
+    str += QString("%1.%2 = %3\n")
+             .arg(prefix)
+             .arg(paramName)
+             .arg(formatValues(p));
+  }
+  return str;
+}
+
+QString ReLuxcoreSDLTranslator::translate( const QString& luxSDL ) {
+  QList<bool> isString;
+  QStringList tokens = tokenize(luxSDL, isString);
+  int numTokens = tokens.count();
+  QString str;
+  int pos = 0;
+  while (pos < numTokens) {
+    if (isString[pos]) {
+      pos++;
+      continue;
+    }
+    const QString& keyword = tokens[pos];
+    if (keyword == "Texture" && pos+3 < numTokens) {
+      QString name     = tokens[pos+1];
+      QString dataType = tokens[pos+2];
+      QString texClass = tokens[pos+3];
+      pos += 4;
+      str += translateTexture(name, dataType, texClass, readParams(tokens, isString, pos));
+    }
+    else if (keyword == "MakeNamedMaterial" && pos+1 < numTokens) {
+      QString name = tokens[pos+1];
+      pos += 2;
+      str += translateMaterial(name, readParams(tokens, isString, pos));
+    }
+    else {
+      // Statement not supported by LuxCore, skip it and its parameters
+      pos++;
+    }
+  }
+  return str;
+}
+
+} // namespace
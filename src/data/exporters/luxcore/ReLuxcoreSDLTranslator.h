@@ -0,0 +1,72 @@
+/*
+  Reality plug-in
+  Copyright (c) Pret-a-3D/Paolo Ciccone 2012. All rights reserved.
+*/
+
+#ifndef RE_LUXCORE_SDL_TRANSLATOR_H
+#define RE_LUXCORE_SDL_TRANSLATOR_H
+
+#include <QString>
+#include <QStringList>
+
+#include "reality_lib_export.h"
+
+
+namespace Reality {
+
+/**
+ * Converts the texture and material declarations generated by the Lux
+ * exporters into the property-based scene description used by LuxCore.
+ *
+ * The Luxcore material exporters share most of their code with the
+ * classic Lux exporters and write "Texture" and "MakeNamedMaterial"
+ * statements. Instead of duplicating all the exporters we tokenize that
+ * output and write the equivalent "scene.textures.*" and
+ * "scene.materials.*" properties. Statements that don't have an
+ * equivalent in LuxCore are skipped.
+ */
+class REALITY_LIB_EXPORT ReLuxcoreSDLTranslator {
+
+private:
+  //! A parameter of a Lux statement, for example "float uscale" [1]
+  struct LuxParam {
+    QString type;
+    QString name;
+    QStringList values;
+  };
+  typedef QList<LuxParam> LuxParamList;
+
+  //! Splits the Lux scene text into tokens. Comments are removed, strings
+  //! are returned without the quotes and brackets are returned as
+  //! separate tokens.
+  static QStringList tokenize( const QString& luxSDL, QList<bool>& isString );
+
+  //! Reads the list of parameters starting at position pos. On exit pos
+  //! points to the first token after the list.
+  static LuxParamList readParams( const QStringList& tokens,
+                                  const QList<bool>& isString,
+                                  int& pos );
+
+  static QString translateTexture( const QString& name,
+                                   const QString& dataType,
+                                   const QString& texClass,
+                                   const LuxParamList& params );
+
+  static QString translateMaterial( const QString& name, const LuxParamList& params );
+
+  //! Returns the value list formatted for a LuxCore property
+  static QString formatValues( const LuxParam& param );
+
+public:
+  //! Translates a block of Lux statements to LuxCore properties
+  static QString translate( const QString& luxSDL );
+
+  //! Converts a name to a string that can be used as part of a property
+  //! key. LuxCore uses the dot as a separator and does not allow spaces
+  //! in the keys.
+  static QString sanitizeName( const QString& name );
+};
+
+} // namespace
+
+#endif
@@ -52,6 +52,11 @@ void ReQtSceneImporter::restoreSceneData( const QVariantMap& data,
       data.value(KEY_SCENE_TEXTURE_SIZE, T_ORIGINAL).toInt()
     )
   );
+  RealitySceneData->setIBLMapSize(
+    static_cast<ReIBLMapSize>(
+      data.value(KEY_SCENE_IBL_MAP_SIZE, IBL_ORIGINAL).toInt()
+    )
+  );
   // If we are loading a scene saved with Reality 3.0 then the geometry
   // file format was always set to LuxNative. We convert it automatically
   // to the PLY binary.
@@ -163,6 +163,7 @@ void ReBand::setNamedValue( const QString& vname , const QVariant& value ) {
   QRegExp offsetRE("offset(\\d)");
   if (textureRE.indexIn(vname) != -1) {
     channels[vname] = value.value<ReTexturePtr>();
+    linksChanged();
   }
   else if (offsetRE.indexIn(vname) != -1) {
     int texNum = offsetRE.cap(1).toInt();
@@ -170,6 +171,7 @@ void ReBand::setNamedValue( const QString& vname , const QVariant& value ) {
   }
   else if (vname == "map") {
     channels["map"] = value.value<ReTexturePtr>();
+    linksChanged();
   }
   else if (vname == "amount") {
     amount = value.toFloat();
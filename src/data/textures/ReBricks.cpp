@@ -137,6 +137,7 @@ void ReBricks::setBrickTexture( ReTexturePtr newVal ) {
     newVal->reparent(parent);
     parent->addTextureToCatalog(newVal);
   }
+  linksChanged();
 };
 
   //! Sets the texture for the mortar 
@@ -146,6 +147,7 @@ void ReBricks::setMortarTexture( ReTexturePtr newVal ) {
     newVal->reparent(parent);
     parent->addTextureToCatalog(newVal);
   }
+  linksChanged();
 };
 
 //! Sets the texture for the mortar 
@@ -155,6 +157,7 @@ void ReBricks::setBrickModulationTexture( ReTexturePtr newVal ){
     newVal->reparent(parent);
     parent->addTextureToCatalog(newVal);
   }
+  linksChanged();
 };
 
 const ReTexturePtr ReBricks::getBrickTexture() const {
@@ -102,6 +102,7 @@ public:
    */
   inline void setTex1( ReTexturePtr newVal ) {
     channels[RECH_TEX1] = newVal;
+    linksChanged();
   };
 
   /*
@@ -116,6 +117,7 @@ public:
    */
   inline void setTex2( ReTexturePtr newVal ) {
     channels[RECH_TEX2] = newVal;
+    linksChanged();
   };
 
   inline bool is3D() const {
@@ -128,10 +130,10 @@ public:
 
   inline void setNamedValue( const QString& name , const QVariant& value ) {
     if ( name == RECH_TEX1 ) {
-      channels[RECH_TEX1] = value.value<ReTexturePtr>();
+      setTex1(value.value<ReTexturePtr>());
     }
     else if ( name == RECH_TEX2 ) {
-      channels[RECH_TEX2] = value.value<ReTexturePtr>();
+      setTex2(value.value<ReTexturePtr>());
     }    
     else {
       ReTexture3D::setNamedValue(name, value);      
@@ -167,13 +167,13 @@ void ReColorMath::deserialize( QDataStream& dataStream ) {
 void ReColorMath::setNamedValue( const QString& vname, const QVariant& value ) {
 
   if (vname == "texture1") {
-    channels[CM_TEX1] = value.value<ReTexturePtr>();
+    setTexture1(value.value<ReTexturePtr>());
   }
   if (vname == "color1") {
     color1 = value.value<QColor>();
   }
   else if (vname == "texture2") {
-    channels[CM_TEX2] = value.value<ReTexturePtr>();
+    setTexture2(value.value<ReTexturePtr>());
   }
   if (vname == "color2") {
     color2 = value.value<QColor>();
@@ -77,16 +77,6 @@ public:
     return deps;
   };
 
-  virtual const QString getGUID() {
-    // This texture name : GUID of tex1 : GUID of tex2 : amount1 : amount 2
-    return QString("%1:%2:%3:%4:%5")
-             .arg(getTypeAsString())
-             .arg(channels[CM_TEX1].isNull() ? "" : channels[CM_TEX1]->getGUID())
-             .arg(channels[CM_TEX2].isNull() ? "" : channels[CM_TEX2]->getGUID())
-             .arg(color1.name())
-             .arg(color2.name());
-  };
-
   QString toString();
 
   inline virtual void setColor1( QColor clr1 ) {
@@ -107,6 +97,7 @@ public:
 
   inline virtual void setTexture1( ReTexturePtr tex1 ) {
     channels[CM_TEX1] = tex1;
+    linksChanged();
   }
 
   inline ReTexturePtr getTexture1() {
@@ -115,6 +106,7 @@ public:
 
   inline virtual void setTexture2( ReTexturePtr tex2 ) {
     channels[CM_TEX2] = tex2;
+    linksChanged();
   }
 
   inline ReTexturePtr getTexture2() {
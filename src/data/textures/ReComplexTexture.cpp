@@ -31,6 +31,7 @@ void ReComplexTexture::setChannel( const QString channelName, ReTexturePtr textu
     auto parentMat = texture->getParent();
     if (parentMat) {
       parentMat->addTextureToCatalog(texture);
+      parentMat->textureLinksChanged();
     }
   }
 };
@@ -40,6 +41,7 @@ void ReComplexTexture::deleteChannelTexture( const QString& channelName ) {
     auto mat = channels[channelName]->getParent();
     QString texName = channels[channelName]->getName();
     channels[channelName].clear();
+    mat->textureLinksChanged();
     // Try to delete the texture if it's not used by anybody else
     if ( mat->textureIsUnused(texName) ) {
       mat->deleteTexture(texName);
@@ -75,18 +77,20 @@ const QString ReComplexTexture::identifyChannel( const ReTexturePtr tex ) const
 void ReComplexTexture::serializeChannels( QDataStream& dataStream ) {
   // Number of channels
   dataStream << (quint16) channels.count();
-  ReNodeDictionaryIterator ic(channels);  
-  while(ic.hasNext()) {
-    ic.next();
-    
-    ReTexturePtr tex = ic.value();
+  // Sorted so that equivalent textures always produce the same stream
+  QStringList channelNames = channels.keys();
+  channelNames.sort();
+  foreach( QString channelName, channelNames ) {
+    ReTexturePtr tex = channels.value(channelName);
 
     // Name of the channel and a flag to declare if the texture exists
     bool texPresent = !tex.isNull();
-    dataStream << ic.key() << texPresent;
-    // Texture
+    dataStream << channelName << texPresent;
+    // Texture. For the GUID the linked texture is identified by its
+    // structure instead of its name
     if (texPresent) {
-      dataStream << tex->getName();   
+      dataStream << (ReTexture::isGUIDStream(dataStream) ? tex->getGUID() 
+                                                          : tex->getName());
     }
   }
 };
@@ -118,6 +122,7 @@ void ReComplexTexture::deserializeChannels( QDataStream& dataStream,
       channels[channelName] = ReTexturePtr();
     }
   }
+  cont->textureLinksChanged();
 };
 
 
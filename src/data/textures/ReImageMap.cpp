@@ -5,8 +5,6 @@
 
 #include "textures/ReImageMap.h"
 
-#include <QCryptographicHash>
-
 #include "ReTools.h"
 #include "textures/ReColorMath.h"
 #include "textures/ReGrayscale.h"
@@ -44,25 +42,6 @@ ReImageMap::ReImageMap( const ReImageMap& t2 ) :
   textureDataType = t2.textureDataType;  
 }
 
-const QString ReImageMap::getGUID() {
-  QString longForm = QString("%1|%2|%3|%4|%5|%6|%7|%8|%9")
-                       .arg(getTypeAsString())
-                       .arg(getDataTypeAsString())
-                       .arg(normalizeRuntimePath(fileName))
-                       .arg(gamma)
-                       .arg(gain)
-                       .arg(uTile)
-                       .arg(vTile)
-                       .arg(uOffset)
-                       .arg(vOffset);
-  return QString(
-           QCryptographicHash::hash(
-             longForm.toAscii(), 
-             QCryptographicHash::Sha1
-           ).toHex()
-         );  
-}
-
 // Conversion ctor
 ReImageMap::ReImageMap( const ReTexturePtr srcTex ) :
   Re2DTexture(srcTex)
@@ -192,8 +171,11 @@ QString ReImageMap::toString() {
 
 void ReImageMap::serialize( QDataStream& dataStream ) {
   Re2DTexture::serialize(dataStream);
+  // The same file can be referenced with different runtime paths
   dataStream << gain << gamma << (quint16) rgbChannel
-             << fileName << normalMap;
+             << (isGUIDStream(dataStream) ? normalizeRuntimePath(fileName) 
+                                          : fileName)
+             << normalMap;
 };
 
 void ReImageMap::deserialize( QDataStream& dataStream ) {
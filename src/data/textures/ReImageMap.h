@@ -42,8 +42,6 @@ public:
   // Conversion ctor
   ReImageMap( const ReTexturePtr srcTex );
 
-  virtual const QString getGUID();
-
   /**
    * Operators
    */
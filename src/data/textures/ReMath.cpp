@@ -189,10 +189,10 @@ void ReMath::reparent( ReTextureContainer* parentMat ) {
 
 void ReMath::setNamedValue( const QString& vname, const QVariant& value ) {
   if (vname == "texture1") {
-    channels[MT_TEX1] = value.value<ReTexturePtr>();
+    setTexture1(value.value<ReTexturePtr>());
   }
   else if (vname == "texture2") {
-    channels[MT_TEX2] = value.value<ReTexturePtr>();
+    setTexture2(value.value<ReTexturePtr>());
   }
   else if (vname == "amount1") {
     amountTex1 = value.toFloat();
@@ -76,16 +76,6 @@ public:
     // nothing
   }
 
-  virtual const QString getGUID() {
-    // This texture name : GUID of tex1 : GUID of tex2 : amount1 : amount 2
-    return QString("%1:%2:%3:%4:%5")
-             .arg(getTypeAsString())
-             .arg(channels[MT_TEX1].isNull() ? "" : channels[MT_TEX1]->getGUID())
-             .arg(channels[MT_TEX2].isNull() ? "" : channels[MT_TEX2]->getGUID())
-             .arg(amountTex1)
-             .arg(amountTex2);
-  };
-
   virtual void reparent( ReTextureContainer* parentMat );
 
   inline virtual void setAmount1( const float newVal ) {
@@ -98,6 +88,7 @@ public:
 
   inline virtual void setTexture1( ReTexturePtr tex1 ) {
     channels[MT_TEX1] = tex1;
+    linksChanged();
   }
   inline ReTexturePtr getTexture1() {
     return channels[MT_TEX1];
@@ -113,6 +104,7 @@ public:
 
   inline virtual void setTexture2( ReTexturePtr tex2 ) {
     channels[MT_TEX2] = tex2;
+    linksChanged();
   }
 
   inline ReTexturePtr getTexture2() {
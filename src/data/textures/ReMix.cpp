@@ -159,6 +159,7 @@ void ReMixTexture::setTexture1( ReTexturePtr newVal ) {
     }
     channels[RE_MIXT_TEX1]->setTextureDataType(textureDataType);
   }
+  linksChanged();
 };
 
 ReTexturePtr ReMixTexture::getTexture2() {
@@ -174,6 +175,7 @@ void ReMixTexture::setTexture2( ReTexturePtr newVal ) {
     }
     channels[RE_MIXT_TEX2]->setTextureDataType(textureDataType);
   }
+  linksChanged();
 };
 
 float ReMixTexture::getMixAmount() const {
@@ -215,6 +217,7 @@ void ReMixTexture::setMixTexture( const ReTexturePtr newVal ) {
     channels[RE_MIXT_MIXER]->reparent(parent);
     parent->addTextureToCatalog(channels[RE_MIXT_MIXER]);      
   }
+  linksChanged();
 };
 
 // The mixed textures must be of the same type of the Mix texture
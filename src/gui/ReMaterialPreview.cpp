@@ -8,10 +8,14 @@
 #include "ReMaterialPreview.h"
 
 #include <boost/atomic.hpp>
+#include <QRegExp>
 #include <QSettings>
+#include <QTime>
 
+#include "LuxApi.h"
 #include "RealityBase.h"
 #include "ReLogger.h"
+#include "ReLuxLibraryRenderer.h"
 #include "ReLuxRunner.h"
 
 
@@ -21,56 +25,66 @@ using namespace Reality;
 // the threads exists. 
 boost::atomic<bool> keepRunning;
 
-RePreviewProducer::RePreviewProducer( ReMaterialPreview* owner ) {
-  connect(owner, SIGNAL(previewRequested(PreviewRequest*)),
-          this, SLOT(processPreviewRequest(PreviewRequest*)) );
-}
-
-void RePreviewProducer::processPreviewRequest( PreviewRequest* req ) 
+RePreviewProducer::RePreviewProducer( ReMaterialPreview* owner ) :
+  owner(owner)
 {
-  if (req->sceneName != lastSceneName) {
-    QFile sceneFile;
-    if (req->isProceduralTexture) {
-      sceneFile.setFileName(":/textResources/ProceduralNoisePreviewer.lxs");
+  ReConfigurationPtr config = RealityBase::getConfiguration();
+  useDraftPass = config->value(RE_CFG_MAT_PREVIEW_DRAFT, true).toBool();
+  if ( config->value(RE_CFG_MAT_PREVIEW_IN_PROCESS, true).toBool() &&
+       LuxLibraryLoader::loadLuxLibrary(ReLuxRunner::getLuxLibraryName()) )
+  {
+    if (ReLuxLibraryRenderer::isAvailable()) {
+      luxLib = ReLuxLibraryRendererPtr(new ReLuxLibraryRenderer());
     }
     else {
-      sceneFile.setFileName(QString(":/textResources/%1_preview.lxs")
-                            .arg(req->sceneName));
+      RE_LOG_WARN() << "The Lux library doesn't provide the rendering API, "
+                    << "the material previews are rendered by luxconsole";
     }
-    sceneFile.open(QIODevice::ReadOnly);
-    previewSceneTemplate = sceneFile.readAll();
-    sceneFile.close();
-    lastSceneName = req->sceneName;
   }
-  QString previewScene;
-  if (!req->isProceduralTexture) {
-    previewScene = previewSceneTemplate
-                   .arg(req->materialDefinition)
-                   .arg(req->materialName);        
-  }
-  else {
-    previewScene = previewSceneTemplate.arg(req->materialDefinition);
+  connect(owner, SIGNAL(previewRequested(PreviewRequest*)),
+          this, SLOT(processPreviewRequest(PreviewRequest*)) );
+}
+
+RePreviewProducer::~RePreviewProducer() {
+  // Stops the rendering in progress, if any
+  luxLib.clear();
+}
+
+bool RePreviewProducer::makeDraftScene( const QString& scene,
+                                        QString& draftScene,
+                                        int& width,
+                                        int& height )
+{
+  QRegExp xRes("\"integer xresolution\"\\s*\\[\\s*(\\d+)\\s*\\]");
+  QRegExp yRes("\"integer yresolution\"\\s*\\[\\s*(\\d+)\\s*\\]");
+  QRegExp haltSpp("\"integer haltspp\"\\s*\\[\\s*\\d+\\s*\\]");
+  if (xRes.indexIn(scene) == -1 || yRes.indexIn(scene) == -1 ||
+      haltSpp.indexIn(scene) == -1)
+  {
+    return false;
   }
-  // RE_LOG_INFO() << "== Preview: " << req->materialName.toStdString()
-  //               << " " << req->previewID.toStdString();
-  // Write to stdin the scene definition
-  luxProc->writeToStdin(previewScene);
-  // Grab the result as a stream of bytes
-  luxProc->waitForFinished();
-  QByteArray frameBuffer = luxProc->readAllStandardOutput();
+  width  = qMax(1, xRes.cap(1).toInt() / MPM_DRAFT_SCALE);
+  height = qMax(1, yRes.cap(1).toInt() / MPM_DRAFT_SCALE);
+  draftScene = scene;
+  draftScene.replace(xRes, QString("\"integer xresolution\" [%1]").arg(width))
+            .replace(yRes, QString("\"integer yresolution\" [%1]").arg(height))
+            .replace(haltSpp, QString("\"integer haltspp\" [%1]").arg(MPM_DRAFT_SPP));
+  return true;
+}
 
-  QImage* preview;
-  // Size of the preview
-  quint16 pSize = req->isProceduralTexture ? MPM_PROCTEX_SIZE : MPM_MATPREVIEW_SIZE;
+QImage* RePreviewProducer::frameBufferToImage( const QByteArray& frameBuffer,
+                                               const int width,
+                                               const int height )
+{
   // Create the image, this is 32-bit aligned in format 0xAARRGGBB
-  preview = new QImage(pSize,pSize,QImage::Format_RGB32);
+  QImage* preview = new QImage(width, height, QImage::Format_RGB32);
 
   // Copy the pixels from the framebuffer to the image buffer setting up
   // an implicit alpha of 0xff. The framebuffer is formatted to be 0xRRGGBB
   int cursor = 0;          
-  for (int i = 0; i < pSize; ++i) {
+  for (int i = 0; i < height; ++i) {
     uchar* line = preview->scanLine(i);
-    for (int p = 0; p < pSize; ++p) {
+    for (int p = 0; p < width; ++p) {
       QRgb* pixel = (QRgb*)(line+p*4);
       *pixel = qRgb(
         frameBuffer[cursor],frameBuffer[cursor+1],frameBuffer[cursor+2]
@@ -78,11 +92,172 @@ void RePreviewProducer::processPreviewRequest( PreviewRequest* req )
       cursor += 3;
     }
   }
-  emit materialPreviewReady( 
-    req->materialName, req->previewID, req->isProceduralTexture, preview
-  );
+  return preview;
+}
+
+bool RePreviewProducer::renderLibraryPass( const PreviewRequest* req,
+                                           const QByteArray& scene,
+                                           const int numBytes,
+                                           QByteArray& frameBuffer,
+                                           bool& completed )
+{
+  completed = false;
+  if (!luxLib->start(scene)) {
+    return false;
+  }
+  QTime clock;
+  clock.start();
+  while( !luxLib->isDone() ) {
+    if (owner->hasNewerRequest(req)) {
+      luxLib->abort();
+      return true;
+    }
+    if (clock.elapsed() > RE_MP_PASS_TIMEOUT) {
+      // The image rendered so far is used
+      RE_LOG_WARN() << "Incomplete material preview for " 
+                    << QSS(req->materialName) << ": " 
+                    << luxLib->getSamplesPerPixel() << " samples per pixel";
+      break;
+    }
+    msleep(RE_MP_READ_INTERVAL);
+  }
+  if (!luxLib->getFrameBuffer(frameBuffer, numBytes)) {
+    return false;
+  }
+  completed = true;
+  return true;
+}
+
+bool RePreviewProducer::renderPass( const PreviewRequest* req,
+                                    const QByteArray& scene,
+                                    const int numBytes,
+                                    QByteArray& frameBuffer )
+{
+  if (!luxLib.isNull()) {
+    bool completed;
+    if (renderLibraryPass(req, scene, numBytes, frameBuffer, completed)) {
+      return completed;
+    }
+    RE_LOG_WARN() << "The Lux library could not render the preview of "
+                  << QSS(req->materialName) 
+                  << ", the material previews are rendered by luxconsole";
+    luxLib.clear();
+    startLuxProcess();
+  }
+  frameBuffer.clear();
+  // Write to stdin the scene definition
+  luxProc->writeToStdin(scene);
+  // Grab the result as a stream of bytes, as it arrives
+  QTime clock;
+  clock.start();
+  while( frameBuffer.size() < numBytes ) {
+    if (owner->hasNewerRequest(req)) {
+      luxProc->killProcess();
+      return false;
+    }
+    if (luxProc->waitForReadyRead(RE_MP_READ_INTERVAL)) {
+      frameBuffer.append(luxProc->readAllStandardOutput());
+      continue;
+    }
+    if (luxProc->isFinished() || clock.elapsed() > RE_MP_PASS_TIMEOUT) {
+      frameBuffer.append(luxProc->readAllStandardOutput());
+      break;
+    }
+  }
+  if (frameBuffer.size() < numBytes) {
+    RE_LOG_WARN() << "Incomplete material preview for " 
+                  << QSS(req->materialName) << ": " << frameBuffer.size()
+                  << " bytes of " << numBytes;
+    luxProc->killProcess();
+    frameBuffer.append(QByteArray(numBytes - frameBuffer.size(), 0));
+  }
+  return true;
+}
+
+const RePreviewProducer::DraftTemplate& RePreviewProducer::getDraftTemplate(
+                                           const QString& templateName,
+                                           const ReSceneTemplate& previewTemplate )
+{
+  DraftTemplate& draft = draftTemplates[templateName];
+  if (draft.source.isEmpty() || draft.source != previewTemplate.getText()) {
+    // The resolution and the samples are in the static part of the
+    // scene, so the draft scene can be derived from the template
+    QString draftScene;
+    draft.source  = previewTemplate.getText();
+    draft.isValid = makeDraftScene(QString::fromUtf8(draft.source),
+                                   draftScene,
+                                   draft.width,
+                                   draft.height);
+    draft.sceneTemplate.parse(draft.isValid ? draftScene.toUtf8() : QByteArray());
+  }
+  return draft;
+}
+
+void RePreviewProducer::processPreviewRequest( PreviewRequest* req ) 
+{
+  QString templateName = req->isProceduralTexture ? 
+    QString(":/textResources/ProceduralNoisePreviewer.lxs") :
+    QString(":/textResources/%1_preview.lxs").arg(req->sceneName);
+  const ReSceneTemplate& previewTemplate = sceneTemplates.get(templateName);
+  // The procedural texture scene has only the %1 placeholder
+  QList<QByteArray> values;
+  values << req->materialDefinition.toUtf8();
+  if (!req->isProceduralTexture) {
+    values << req->materialName.toUtf8();
+  }
+  QByteArray previewScene = previewTemplate.fill(values);
+  // RE_LOG_INFO() << "== Preview: " << req->materialName.toStdString()
+  //               << " " << req->previewID.toStdString();
+
+  // Size of the preview
+  quint16 pSize = req->isProceduralTexture ? MPM_PROCTEX_SIZE : MPM_MATPREVIEW_SIZE;
+  QByteArray frameBuffer;
+
+  // The draft pass gives a quick feedback to the user. The texture
+  // editors show only the first preview that they receive, so the
+  // procedural textures are always rendered in one pass.
+  const DraftTemplate* draftTemplate = NULL;
+  if (useDraftPass && !req->isProceduralTexture) {
+    draftTemplate = &getDraftTemplate(templateName, previewTemplate);
+  }
+  if (draftTemplate && draftTemplate->isValid) {
+    int draftWidth  = draftTemplate->width;
+    int draftHeight = draftTemplate->height;
+    bool completed = renderPass(
+                       req, 
+                       draftTemplate->sceneTemplate.fill(values), 
+                       draftWidth*draftHeight*3, 
+                       frameBuffer
+                     );
+    prepareNextPass();
+    if (!completed) {
+      delete req;
+      return;
+    }
+    QImage* draft = frameBufferToImage(frameBuffer, draftWidth, draftHeight);
+    QImage* preview = new QImage(
+      draft->scaled(pSize, pSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+    );
+    delete draft;
+    emit materialPreviewReady( 
+      req->materialName, req->previewID, req->isProceduralTexture, true, preview
+    );
+  }
+
+  if (renderPass(req, previewScene, pSize*pSize*3, frameBuffer)) {
+    QImage* preview = frameBufferToImage(frameBuffer, pSize, pSize);
+    emit materialPreviewReady( 
+      req->materialName, req->previewID, req->isProceduralTexture, false, preview
+    );
+  }
   delete req;
-  startLuxProcess();  
+  prepareNextPass();
+}
+
+void RePreviewProducer::prepareNextPass() {
+  if (luxLib.isNull()) {
+    startLuxProcess();
+  }
 }
 
 
@@ -96,11 +271,15 @@ bool RePreviewProducer::startLuxProcess() {
 }
 
 void RePreviewProducer::run() {
-  startLuxProcess();  
+  if (luxLib.isNull()) {
+    startLuxProcess();  
+  }
   while(keepRunning) {
     msleep(100);
   }
-  luxProc->killProcess();
+  if (!luxProc.isNull()) {
+    luxProc->killProcess();
+  }
 };
 
 // Static members
@@ -117,6 +296,7 @@ ReMaterialPreview* ReMaterialPreview::getInstance() {
 
 ReMaterialPreview::ReMaterialPreview() {
   previewProducer = NULL;
+  receiver = NULL;
   ReConfigurationPtr config = RealityBase::getConfiguration();
   maxCacheSize = config->value(RE_CFG_MAT_PREVIEW_CACHE_SIZE).toInt(); 
 };
@@ -193,10 +373,67 @@ void ReMaterialPreview::addRequestToQueue( zmqReadDataStream& data,
   ));
 };
 
+PreviewRequest* ReMaterialPreview::findNewerRequest( const PreviewRequest* req ) {
+  foreach( PreviewRequest* queued, requestQueue ) {
+    if (queued != req && 
+        queued->materialName == req->materialName &&
+        queued->previewID == req->previewID) 
+    {
+      return queued;
+    }
+  }
+  return NULL;
+}
+
+bool ReMaterialPreview::hasNewerRequest( const PreviewRequest* req ) {
+  readRequests(0);
+  PreviewRequest* newer = findNewerRequest(req);
+  if (!newer) {
+    return false;
+  }
+  // The preview being replaced might have been requested to bypass the
+  // cache, the new request must do the same
+  newer->forceRefresh = newer->forceRefresh || req->forceRefresh;
+  return true;
+}
+
+void ReMaterialPreview::readRequests( const unsigned int timeOut ) {
+  if (!receiver) {
+    return;
+  }
+  /*
+   * Communication with the client/handling the requests of new
+   * material previews
+   */     
+  try {
+    while ( zmqHasMessages(*receiver, timeOut) ) {
+      zmqReadDataStream requestStream(*receiver);
+
+      QString command;
+      requestStream >> command;
+      if (command == RE_MP_PREVIEW_REQUEST) {
+        // read the data and queue the request
+        addRequestToQueue(requestStream, *receiver);
+      }
+      else if ( command == RE_MP_PREVIEW_INIT ) {
+        initialized = true;
+      }
+    }
+  }
+  catch( zmq::error_t e ) {
+    RE_LOG_WARN() << "ZMQ exception: " << e.what();
+  }
+}
+
 void ReMaterialPreview::processPreviewQueue() 
 {
   while( requestQueue.count() > 0 ) {
     auto req = requestQueue.dequeue();
+    // Only the latest request for a preview needs to be rendered
+    if (hasNewerRequest(req)) {
+      delete req;
+      continue;
+    }
     bool isProceduralTexture = req->isProceduralTexture;
     // Check if we already have the preview in the cache
     if (!req->forceRefresh && 
@@ -234,8 +471,8 @@ void ReMaterialPreview::run() {
   keepRunning = true;
   initialized = false;
   // Configure the socket for the inbound requests from the client
-  zmq::socket_t receiver(ipcContext, ZMQ_PAIR);
-  receiver.bind(RE_MP_REQUEST_TRANSPORT);
+  receiver = new zmq::socket_t(ipcContext, ZMQ_PAIR);
+  receiver->bind(RE_MP_REQUEST_TRANSPORT);
   zmqSetNoLinger(receiver);
 
   previewProducer = new RePreviewProducer(this);
@@ -243,9 +480,9 @@ void ReMaterialPreview::run() {
   // a preview is ready
   connect(
     previewProducer, 
-    SIGNAL(materialPreviewReady(QString, QString, bool,QImage*)), 
+    SIGNAL(materialPreviewReady(QString, QString, bool, bool, QImage*)), 
     this, 
-    SLOT(previewDone(QString, QString, bool, QImage*))
+    SLOT(previewDone(QString, QString, bool, bool, QImage*))
   );
 
   previewProducer->start();
@@ -254,28 +491,7 @@ void ReMaterialPreview::run() {
   QTime clock;
   clock.start();
   while(keepRunning) {
-    /*
-     * Communication with the client/handling the requests of new
-     * material previews
-     */     
-    try {
-      if ( zmqHasMessages(receiver) ) {
-        zmqReadDataStream requestStream(receiver);
-
-        QString command;
-        requestStream >> command;
-        if (command == RE_MP_PREVIEW_REQUEST) {
-          // read the data and queue the request
-          addRequestToQueue(requestStream, receiver);
-        }
-        else if ( command == RE_MP_PREVIEW_INIT ) {
-          initialized = true;
-        }
-      }
-    }
-    catch( zmq::error_t e ) {
-      RE_LOG_WARN() << "ZMQ exception: " << e.what();
-    }
+    readRequests(100);
 
     if (clock.elapsed() >= RE_MP_CLOCK_INTERVAL) {
       if (requestQueue.count() > 0) {
@@ -286,15 +502,18 @@ void ReMaterialPreview::run() {
   }
   previewProducer->wait();
   delete previewProducer;
+  delete receiver;
+  receiver = NULL;
 }
 
 void ReMaterialPreview::previewDone(QString materialName, 
                                     QString previewID,
                                     bool isProceduralTexture,
+                                    bool isDraft,
                                     QImage* img) 
 {
-  // Procedural textures are not cached
-  if (!isProceduralTexture) {
+  // Procedural textures and drafts are not cached
+  if (!isProceduralTexture && !isDraft) {
     // Add the bitmap to the cache 
     previewCache[materialName] = ReImagePtr(img);
 
@@ -17,11 +17,14 @@
 #include <QThread>
 #include <zmq.hpp>
 
+#include "ReSceneTemplate.h"
 #include "zeromqTools.h"
 
 namespace Reality {
   class ReLuxRunner;
   typedef QSharedPointer<ReLuxRunner> ReLuxRunnerPtr;
+  class ReLuxLibraryRenderer;
+  typedef QSharedPointer<ReLuxLibraryRenderer> ReLuxLibraryRendererPtr;
 }
 
 
@@ -45,6 +48,18 @@ const unsigned short RE_MP_CLOCK_INTERVAL = 200;
 const quint8 MPM_PROCTEX_SIZE     = 144;
 const quint8 MPM_MATPREVIEW_SIZE  = 120;
 
+//! Samples per pixel of the draft pass of the material previews
+const quint8 MPM_DRAFT_SPP        = 4;
+//! The draft pass is rendered at the preview size divided by this factor
+const quint8 MPM_DRAFT_SCALE      = 2;
+
+//! Interval, in milliseconds, at which the output of luxconsole, or the
+//! progress of the Lux library, is read and the request queue is checked
+//! for newer requests
+const unsigned short RE_MP_READ_INTERVAL = 50;
+//! Maximum time, in milliseconds, for rendering one pass of a preview
+const int RE_MP_PASS_TIMEOUT = 30000;
+
 namespace Reality {
 
 /**
@@ -124,7 +139,9 @@ typedef QSharedPointer<QImage> ReImagePtr;
 class ReMaterialPreview;
 
 /**
- Class that runs the external luxconsole process to obtain the material previews.
+ Class that renders the material previews with the Lux library, loaded in
+ the process, or with the external luxconsole process if the library is 
+ not available.
 
  This thread is started by the <ReMaterialPreview> thread and it's stopped by that thread
  as well when the program ends. Communication between the two threads is done via a ZeroMQ
@@ -138,21 +155,94 @@ class RePreviewProducer : public QThread {
 
 private:
 
-  //! We keep the preview scene in this string variable. Often the same scene is used
-  //! for material preview. By caching it we avoid opening and loading the same resource
-  //! over and over again.
-  QString previewSceneTemplate;
-
-  //! To cache the scene used we need to store the name of the last scene and compare it
-  //! with the one from the current request.
-  QString lastSceneName;
+  //! The scene of the draft pass of a preview scene, see makeDraftScene()
+  struct DraftTemplate {
+    //! The text of the preview scene it has been derived from
+    QByteArray source;
+    ReSceneTemplate sceneTemplate;
+    int width;
+    int height;
+    bool isValid;
+  };
+
+  //! The preview scenes are parsed once and kept in memory. They can be
+  //! overridden by files in the PreviewScenes directory, which are 
+  //! reloaded when they change.
+  ReSceneTemplateCache sceneTemplates;
+
+  //! The draft scenes, by name of the preview scene
+  QHash<QString, DraftTemplate> draftTemplates;
+
+  //! Returns the draft scene of a preview scene, updated if the preview
+  //! scene has been reloaded
+  const DraftTemplate& getDraftTemplate( const QString& templateName,
+                                         const ReSceneTemplate& previewTemplate );
 
   //! Pointer to a Lux process object used to run the preview
   ReLuxRunnerPtr luxProc;
 
+  //! Renders the previews with the Lux library, NULL if luxconsole is 
+  //! used instead
+  ReLuxLibraryRendererPtr luxLib;
+
+  ReMaterialPreview* owner;
+
+  //! If true the material previews are rendered in two passes: a quick
+  //! draft, at low resolution and with few samples, followed by the
+  //! final preview.
+  bool useDraftPass;
+
+  /**
+   * Renders one pass of a preview with the running luxconsole. The output
+   * of --bindump is read while the renderer runs, so that the pass can be
+   * stopped as soon as a newer request for the same preview arrives.
+   *
+   * \param numBytes The size of the frame buffer, 3 bytes per pixel
+   * \return false if the pass has been cancelled
+   */
+  bool renderPass( const PreviewRequest* req,
+                   const QByteArray& scene,
+                   const int numBytes,
+                   QByteArray& frameBuffer );
+
+  /**
+   * Renders one pass of a preview with the Lux library. The progress is
+   * polled so that the pass can be stopped like in renderPass().
+   *
+   * \param completed Set to false if the pass has been cancelled
+   * \return false if the library could not render the scene
+   */
+  bool renderLibraryPass( const PreviewRequest* req,
+                          const QByteArray& scene,
+                          const int numBytes,
+                          QByteArray& frameBuffer,
+                          bool& completed );
+
+  //! Gets the renderer ready for the next pass. luxconsole renders one
+  //! scene per process while the library renderer is reused.
+  void prepareNextPass();
+
 public:
   RePreviewProducer( ReMaterialPreview* owner );
 
+  ~RePreviewProducer();
+
+  /**
+   * Creates the scene for the draft pass of a preview by reducing the
+   * resolution and the samples per pixel requested by the scene.
+   * \return false if the scene doesn't define its resolution or halt
+   *         condition in a way that can be changed.
+   */
+  static bool makeDraftScene( const QString& scene,
+                              QString& draftScene,
+                              int& width,
+                              int& height );
+
+  //! Converts the --bindump output of luxconsole, RGB bytes, to an image
+  static QImage* frameBufferToImage( const QByteArray& frameBuffer,
+                                     const int width,
+                                     const int height );
+
 protected:
   //! Starts a new process and returns true if the process has been
   //! started successfully. False otherwise.
@@ -167,10 +257,12 @@ protected slots:
 
 signals:
   // Signal emitted when a material preview has been created and is ready
-  // to be sent to the requester.
+  // to be sent to the requester. isDraft is true for the quick pass that
+  // is replaced by the final preview.
   void materialPreviewReady( QString matName, 
                              QString previewID, 
                              bool isProceduralTexture,
+                             bool isDraft,
                              QImage* img );
 };
 
@@ -199,8 +291,18 @@ private:
   //! The ZMQ context object needed for communication
   zmq::context_t ipcContext;
 
+  //! The socket that receives the requests, valid while the thread runs
+  zmq::socket_t* receiver;
+
   bool initialized;
 
+  //! Reads the messages received from the clients
+  void readRequests( const unsigned int timeOut );
+
+  //! Returns the request, in the queue, that replaces req or NULL if 
+  //! there is none
+  PreviewRequest* findNewerRequest( const PreviewRequest* req );
+
 public:
 
   //! ctor
@@ -235,6 +337,14 @@ public:
   inline bool isInitialized() {
     return initialized;
   }
+
+  /**
+   * Returns true if a request for the same preview as req has been
+   * received after req. Used by the producer to stop rendering previews
+   * that are out of date. This method must be called from the thread of
+   * this object.
+   */
+  bool hasNewerRequest( const PreviewRequest* req );
   
 public slots:
   
@@ -245,6 +355,7 @@ public slots:
   void previewDone(QString materialName, 
                    QString previewID,
                    bool isProceduralTexture,
+                   bool isDraft,
                    QImage* img);
   void previewFailed(QString materialName);
   void setCacheSize( const ushort newSize );
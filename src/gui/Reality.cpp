@@ -307,5 +307,7 @@ int main(int argc, char **argv) {
     RealityMainWindow->activateWindow();
 #endif  
 
-  return app.exec();
+  int retVal = app.exec();
+  RE_stopLogger();
+  return retVal;
 }
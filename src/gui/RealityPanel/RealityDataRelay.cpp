@@ -21,9 +21,52 @@ void RealityDataRelay::stop() {
   isActive = false;
 }
 
+void RealityDataRelay::queueMaterialEdit( const QString& objectID,
+                                          const QString& materialName,
+                                          const QString& propertyName,
+                                          const QVariant& value,
+                                          const QString& textureName ) 
+{
+  QString key = QString("%1|%2|%3|%4")
+                  .arg(objectID)
+                  .arg(materialName)
+                  .arg(textureName)
+                  .arg(propertyName);
+  if (pendingEditsIndex.contains(key)) {
+    pendingEdits[pendingEditsIndex.value(key)].value = value;
+  }
+  else {
+    MaterialEdit edit;
+    edit.objectID     = objectID;
+    edit.materialName = materialName;
+    edit.textureName  = textureName;
+    edit.propertyName = propertyName;
+    edit.value        = value;
+    pendingEditsIndex[key] = pendingEdits.count();
+    pendingEdits.append(edit);
+  }
+  if (!editBatchTimer->isActive()) {
+    editBatchTimer->start();
+  }
+}
+
+void RealityDataRelay::flushMaterialEdits() {
+  editBatchTimer->stop();
+  if (pendingEdits.isEmpty()) {
+    return;
+  }
+  sendMessageToServer(UI_MATERIAL_EDITED_BATCH);
+}
+
 void RealityDataRelay::sendMessageToServer( const IPC_MESSAGES msg, 
                                             const QVariantMap* args ) {
   
+  // The host must receive the edits in the same order in which they have
+  // been made by the user
+  if (msg != UI_MATERIAL_EDITED_BATCH && !pendingEdits.isEmpty()) {
+    flushMaterialEdits();
+  }
+
   // Send the message by converting the message code to a quint16 to determine the
   // size of the message code. This avoid ambiguities about how big the data is.
   QByteArray command;
@@ -88,6 +131,19 @@ void RealityDataRelay::sendMessageToServer( const IPC_MESSAGES msg,
       }
       break;
     }
+    case UI_MATERIAL_EDITED_BATCH: {
+      commandStream << (quint32) pendingEdits.count();
+      foreach( const MaterialEdit& edit, pendingEdits ) {
+        commandStream << edit.objectID
+                      << edit.materialName
+                      << edit.textureName
+                      << edit.propertyName
+                      << edit.value;
+      }
+      pendingEdits.clear();
+      pendingEditsIndex.clear();
+      break;
+    }
     case MAKE_NEW_TEXTURE: {
       commandStream << args->value("objectID").toString() 
                     << args->value("materialName").toString() 
@@ -640,6 +696,12 @@ void RealityDataRelay::forwardNotification( zmq::message_t& update ) {
       emit exportingObject(objName);
       break;
     }  
+    case EXP_EXPORT_PROGRESS: {
+      ReExportProgress progress;
+      dataStream >> progress;
+      emit exportProgress(progress);
+      break;
+    }  
     case EXP_EXPORT_FINISHED: {
       emit exportFinished();
       break;
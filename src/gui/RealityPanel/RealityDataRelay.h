@@ -8,6 +8,7 @@
 
 #include <QMutexLocker>
 #include <QThread>
+#include <QTimer>
 #include <zmq.hpp>
 
 #include "ReIPC.h"
@@ -16,6 +17,10 @@
 
 namespace Reality {  
 
+//! Time, in milliseconds, during which the material edits are collected
+//! before being sent to the host as one batch
+#define RE_MATERIAL_EDIT_BATCH_INTERVAL 30
+
 /**
  * This class implements a thread that communicates from the GUI to the data server and brokers
  * the data to and from the server.  
@@ -39,6 +44,26 @@ private:
   //! The IPC channel that uses shared memory
   ReSharedMemIPC shmChannel;
 
+  //! A material edit waiting to be sent to the host
+  struct MaterialEdit {
+    QString objectID;
+    QString materialName;
+    QString textureName;
+    QString propertyName;
+    QVariant value;
+  };
+
+  //! The material edits collected since the last batch was sent, in the
+  //! order in which they have been made
+  QList<MaterialEdit> pendingEdits;
+
+  //! Index of each property in pendingEdits, used to coalesce repeated
+  //! edits of the same property
+  QHash<QString, int> pendingEditsIndex;
+
+  //! Sends the pending material edits when the batch interval expires
+  QTimer* editBatchTimer;
+
   //! Used to create the socket used to communicate with the data server
   //! The method sets also the options necessary.
   void createDataServerSendingSocket() {
@@ -88,6 +113,11 @@ public:
     ipcContext(1)
   {
     serverAddress = _serverAddress;
+    editBatchTimer = new QTimer(this);
+    editBatchTimer->setSingleShot(true);
+    editBatchTimer->setInterval(RE_MATERIAL_EDIT_BATCH_INTERVAL);
+    connect(editBatchTimer, SIGNAL(timeout()), this, SLOT(flushMaterialEdits()));
+    qRegisterMetaType<ReExportProgress>("ReExportProgress");
   };
 
   ~RealityDataRelay() {
@@ -101,13 +131,33 @@ public:
 
   //! Sends a message to the data server and reads the reply. This reply is
   //! then send back to the caller of this method.
+  //! Pending material edits are sent before the message, to preserve the
+  //! order of the operations.
   void sendMessageToServer( const IPC_MESSAGES msg, const QVariantMap* args = 0);
 
+  //! Queues the edit of a material, or texture, property. The edits are 
+  //! sent to the host in batches, see \ref flushMaterialEdits(). If the 
+  //! same property is edited again before the batch is sent, like when 
+  //! dragging a slider, only the last value is sent.
+  //! \param textureName The name of the texture edited. If blank the 
+  //!                    property belongs to the material.
+  void queueMaterialEdit( const QString& objectID,
+                          const QString& materialName,
+                          const QString& propertyName,
+                          const QVariant& value,
+                          const QString& textureName = "" );
+
   bool isReady() {
     QMutexLocker locker(&lock);
     return isActive;
   }
 
+public slots:
+
+  //! Sends all the queued material edits to the host with one 
+  //! UI_MATERIAL_EDITED_BATCH message
+  void flushMaterialEdits();
+
 signals:
 
   //! Emitted when Reality needs to be moved to the foreground
@@ -214,6 +264,10 @@ signals:
   //! used to alert the GUI of the process so that it can inform the user
   void exportingObject( const QString objName );
 
+  //! Emitted after each object exported with the counters of the data
+  //! written so far
+  void exportProgress( const ReExportProgress progress );
+
   //! Emitted when the host-app side has finished exporting the scene to the renderer.
   void exportFinished();
 
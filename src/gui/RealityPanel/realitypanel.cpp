@@ -275,6 +275,10 @@ void RealityPanel::init() {
   connect(realityDataRelay, SIGNAL(exportingObject(const QString)),
           this, SLOT(exportingObject(const QString)));
 
+  // Counters of the data exported
+  connect(realityDataRelay, SIGNAL(exportProgress(const ReExportProgress)),
+          this, SLOT(exportProgress(const ReExportProgress)));
+
   // The export is complete
   connect(realityDataRelay, SIGNAL(exportFinished()),
           this, SLOT(exportFinished()));
@@ -980,6 +984,7 @@ void RealityPanel::objectRenamed(const QString objectID, const QString newName)
 
 void RealityPanel::objectIDRenamed(const QString objectID, const QString newID) {
   RealitySceneData->renameObjectID(objectID, newID);
+  sceneDataModel->objectIDChanged(objectID);
   sortedSceneDataModel->invalidate();
 }
 
@@ -1571,7 +1576,8 @@ void RealityPanel::updateServerCamera( const QString cameraID,
 }
 
 // Utility function used to send a message to the host side that
-// a property of a material has been updated. 
+// a property of a material has been updated. The edits are sent in
+// batches by the relay.
 void updateHostMaterialProperty( 
                                  const QString& objectID,
                                  const QString& materialName,
@@ -1579,12 +1585,7 @@ void updateHostMaterialProperty(
                                  const QVariant& value
                                )
 {
-  QVariantMap args;
-  args["objectID"]     = objectID;
-  args["materialName"] = materialName;
-  args["propertyName"] = propName;
-  args["value"]        = value;
-  realityDataRelay->sendMessageToServer(UI_MATERIAL_EDITED, &args);
+  realityDataRelay->queueMaterialEdit(objectID, materialName, propName, value);
 }
 
 void RealityPanel::updateServerMaterial( QString objectID, 
@@ -2562,6 +2563,7 @@ void RealityPanel::showObjectInformation() {
 void RealityPanel::exportStarted( int numObject ) {
   if (!exportProgressDlg) {
     exportProgressDlg = new ReExportProgressDialog(this);
+    connect(exportProgressDlg, SIGNAL(cancelRequested()), this, SLOT(cancelExport()));
   }
   exportProgressDlg->reset();
   exportProgressDlg->setUpperLimit(numObject);
@@ -2577,6 +2579,18 @@ void RealityPanel::exportingObject(const QString msg) {
   exportProgressDlg->increment();
 }
 
+void RealityPanel::exportProgress( const ReExportProgress progress ) {
+  if (exportProgressDlg) {
+    exportProgressDlg->showProgress(progress);
+  }
+}
+
+void RealityPanel::cancelExport() {
+  exportProgressDlg->btnCancel->setEnabled(false);
+  exportProgressDlg->showMessage(tr("Stopping the export..."));
+  realityDataRelay->sendMessageToServer(CANCEL_EXPORT);
+}
+
 void RealityPanel::exportFinished() {
   exportProgressDlg->close();
 }
@@ -11,6 +11,7 @@
 #include <QVariantMap>
 #include <QWidget>
 
+#include "ReExportSession.h"
 #include "ReTexture.h"
 #include "importers/qt/REQtMaterialImporter.h"
 #include "ui_realitypanel.h"
@@ -455,7 +456,10 @@ private slots:
   //! Provides information to the user about the status of the export process
   void exportStarted(int);
   void exportingObject(const QString);
+  void exportProgress(const ReExportProgress);
   void exportFinished();
+  //! Asks the host-app to stop the export
+  void cancelExport();
 
   void renderDimensionsNotSet();
 
@@ -10,6 +10,7 @@
 #include <QFileDialog>
 #include <QInputDialog>
 #include <QMessageBox>
+#include <QProgressDialog>
 #include <QSettings>
 
 #include "ReAcsel.h"
@@ -178,10 +179,19 @@ void ReAcselManager::importBundle() {
   }
   auto acsel = ReAcsel::getInstance();
   ReAcsel::ExistingShaderSets existingShaderSets;
+  // Large bundles can take several seconds to import
+  QProgressDialog progressDlg(tr("Importing the ACSEL bundle..."), 
+                              QString(), 0, 0, this);
+  progressDlg.setWindowModality(Qt::WindowModal);
+  auto progress = [&progressDlg]( const int done, const int total ) {
+    progressDlg.setMaximum(total);
+    progressDlg.setValue(done);
+  };
   ReAcsel::ReturnCode retval = acsel->importBundle(
                                  fileName, 
                                  false, 
-                                 existingShaderSets
+                                 existingShaderSets,
+                                 progress
                                );
   switch(retval) {
     case ReAcsel::ShaderSetAlreadyExists: {
@@ -206,7 +216,7 @@ void ReAcselManager::importBundle() {
       }
       // User confirmed the overwriting so we re-execute the import, this
       // time with the overwrite flag
-      acsel->importBundle(fileName, true, existingShaderSets);
+      acsel->importBundle(fileName, true, existingShaderSets, progress);
       break;
     }
     case ReAcsel::WrongACSELVersion: {
@@ -306,8 +316,15 @@ void ReAcselManager::exportShaders( const bool saveAcselShaders,
     universalShaders = usSelector->getSelectedShaderIDs();
   }
 
+  QProgressDialog progressDlg(tr("Exporting the shader bundle..."), 
+                              QString(), 0, 0, this);
+  progressDlg.setWindowModality(Qt::WindowModal);
   QString result = ReAcsel::getInstance()->exportToBundle(
-                     sets, universalShaders, title, author, fileName
+                     sets, universalShaders, title, author, fileName,
+                     [&progressDlg]( const int done, const int total ) {
+                       progressDlg.setMaximum(total);
+                       progressDlg.setValue(done);
+                     }
                    );
   if (result != "") {
     QMessageBox::information(this, tr("Information"), result);  
@@ -8,6 +8,7 @@
 
 #include <QDialog>
 
+#include "ReExportSession.h"
 #include "ui_reExportProgress.h"
 
 
@@ -18,6 +19,7 @@ class ReExportProgressDialog : public QDialog, public Ui::reExportProgress
 public:
    ReExportProgressDialog(QWidget *parent = 0) : QDialog(parent) {
      setupUi(this);     
+     connect(btnCancel, SIGNAL(clicked()), this, SIGNAL(cancelRequested()));
    }
 
 public:
@@ -34,9 +36,28 @@ public:
     progressBar->setMaximum(limit);
   }
 
+  //! Shows the counters of the data exported so far
+  void showProgress( const Reality::ReExportProgress& progress ) {
+    QString text = tr("%1 objects, %2 materials, %3 triangles, %4 MB")
+                     .arg(progress.objects)
+                     .arg(progress.materials)
+                     .arg(progress.triangles)
+                     .arg(progress.bytes/(1024.0*1024.0), 0, 'f', 1);
+    if (progress.reusedObjects) {
+      text += tr(" (%1 from the previous export)").arg(progress.reusedObjects);
+    }
+    details->setText(text);
+  }
+
   void reset() {
     progressBar->setValue(0);
+    details->clear();
+    btnCancel->setEnabled(true);
   }
+
+signals:
+  //! Emitted when the user clicks the Cancel button
+  void cancelRequested();
 };
 
 #endif
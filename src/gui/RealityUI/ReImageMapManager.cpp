@@ -6,8 +6,10 @@
 
 #include <QDir>
 #include <QFileInfo>
+#include <QImageReader>
 #include <QProcess>
 
+#include "ReTextureInfoCache.h"
 #include "actions/ReSetImageMapAction.h"
 #include "textures/ReImageMap.h"
 
@@ -110,9 +112,10 @@ void ReImageMapManager::updatePreview() {
     return;
   }
 
-  QImage tmp;
-  tmp.load(fileName);
-  if (tmp.isNull()) {
+  // The size of the original bitmap comes from the texture index, so the
+  // image doesn't need to be loaded at full size
+  QSize origSize = ReTextureInfoCache::getInstance()->getImageSize(fileName);
+  if (!origSize.isValid()) {
     imPreview->clear();
     return;
   }
@@ -121,10 +124,16 @@ void ReImageMapManager::updatePreview() {
   // In this way we save memory and all the transformations take
   // much less time.
   int w,h;
-  w = tmp.width();
-  h = tmp.height();
+  w = origSize.width();
+  h = origSize.height();
   QSize imgSize(imPreview->width(), imPreview->height());
-  QImage scaled = tmp.scaled(imgSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+  QImageReader reader(fileName);
+  reader.setScaledSize(imgSize);
+  QImage scaled = reader.read();
+  if (scaled.isNull()) {
+    imPreview->clear();
+    return;
+  }
   // If the image is grayscale then we need to render the preview as such.
   // We can use either the median version of a grayscale obtained from one of the
   // channels.
@@ -81,6 +81,7 @@ ReOutputOptions::ReOutputOptions( QWidget* parent ) : QWidget(parent) {
   connect(texSize1K, SIGNAL(toggled(bool)), this, SLOT(updateTextureSize()));
   connect(texSize2K, SIGNAL(toggled(bool)), this, SLOT(updateTextureSize()));
   connect(texSizeOriginal, SIGNAL(toggled(bool)), this, SLOT(updateTextureSize()));
+  connect(cbIBLMapSize, SIGNAL(currentIndexChanged(int)), this, SLOT(updateIBLMapSize(int)));
 
   //
   // Surface Integrator editors
@@ -310,6 +311,8 @@ void ReOutputOptions::updateUI() {
       texSizeOriginal->setChecked(true);
       break;
   }
+  // The items of the combo box are in the same order of ReIBLMapSize
+  cbIBLMapSize->setCurrentIndex(RealitySceneData->getIBLMapSize());
   chbAsStatue->setChecked(RealitySceneData->isRenderAsStatueEnabled());
   // if (currentParameterGroup) {
   //   parameterGroups->setCurrentItem(currentParameterGroup);
@@ -726,6 +729,14 @@ void ReOutputOptions::updateTextureSize() {
   emit outputDataChanged();
 }
 
+void ReOutputOptions::updateIBLMapSize( int newSize ) {
+  if (updatingUI) {
+    return;
+  }
+  RealitySceneData->setIBLMapSize(static_cast<ReIBLMapSize>(newSize));
+  emit outputDataChanged();
+}
+
 
 void ReOutputOptions::updateSIValue( int newVal ) {
   if (updatingUI) {
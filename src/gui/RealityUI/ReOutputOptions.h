@@ -185,6 +185,7 @@ private slots:
 
   void updateTextureCollection(bool isOn);
   void updateTextureSize();
+  void updateIBLMapSize( int newSize );
 
   //! Called to set the verbosity of the Lux log
   void setLuxLogLevel(const QString & level);
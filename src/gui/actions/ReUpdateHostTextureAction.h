@@ -50,15 +50,10 @@ public:
   }
 
   inline void execute() {
-    // Communicate to the host-side the change
-    QVariantMap args;
-    // Prepare the data to be sent to the server
-    args["objectID"]     = objID;
-    args["materialName"] = matName;
-    args["textureName"]  = tex->getName();
-    args["propertyName"] = propName;
-    args["value"]        = newVal;
-    realityDataRelay->sendMessageToServer(UI_MATERIAL_EDITED, &args);
+    // Communicate to the host-side the change. The edit is sent with the
+    // next batch.
+    realityDataRelay->queueMaterialEdit(objID, matName, propName, newVal,
+                                        tex->getName());
   }
 
 };
@@ -0,0 +1,152 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+/**
+ * A stand-in for the Lux library, used to test the rendering through the
+ * Lux API on the machines where Lux is not installed. It exports the same
+ * functions resolved by LuxLibraryLoader.
+ *
+ * luxParse() reads the resolution and the haltspp of the scene and then
+ * "renders" one sample per pixel every RE_LUX_STUB_SAMPLE_TIME
+ * milliseconds, until the halt condition or luxAbort(). The pixel (x, y)
+ * of the frame buffer has the color (x, y, 255 * samples / haltspp).
+ */
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <string.h>
+
+#if defined(_WIN32)
+  #define LUX_STUB_EXPORT extern "C" __declspec(dllexport)
+#else
+  #define LUX_STUB_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+#define RE_LUX_STUB_SAMPLE_TIME 2
+
+static std::atomic<bool> initialized(false);
+static std::atomic<bool> sceneIsReady(false);
+static std::atomic<bool> aborted(false);
+static std::atomic<int>  samples(0);
+static int xRes    = 0;
+static int yRes    = 0;
+static int haltSpp = 0;
+static std::vector<unsigned char> frameBuffer;
+
+//! Returns the value of an integer parameter of the scene, or -1
+static int findInteger( const std::string& scene, const std::string& name ) {
+  size_t pos = scene.find("\"integer " + name + "\"");
+  if (pos == std::string::npos) {
+    return -1;
+  }
+  pos = scene.find('[', pos);
+  if (pos == std::string::npos) {
+    return -1;
+  }
+  std::istringstream value(scene.substr(pos + 1));
+  int result = -1;
+  value >> result;
+  return result;
+}
+
+LUX_STUB_EXPORT const char* luxVersion() {
+  return "Lux stub";
+}
+
+LUX_STUB_EXPORT void luxInit() {
+  initialized = true;
+  aborted = false;
+}
+
+LUX_STUB_EXPORT void luxCleanup() {
+  initialized  = false;
+  sceneIsReady = false;
+  samples      = 0;
+  xRes = yRes = haltSpp = 0;
+  frameBuffer.clear();
+}
+
+LUX_STUB_EXPORT int luxParse( const char* fileName ) {
+  if (!initialized) {
+    return 1;
+  }
+  std::ifstream file(fileName);
+  if (!file) {
+    return 1;
+  }
+  std::stringstream text;
+  text << file.rdbuf();
+  std::string scene = text.str();
+  xRes    = findInteger(scene, "xresolution");
+  yRes    = findInteger(scene, "yresolution");
+  haltSpp = findInteger(scene, "haltspp");
+  if (xRes <= 0 || yRes <= 0 || haltSpp <= 0 ||
+      scene.find("WorldEnd") == std::string::npos)
+  {
+    return 1;
+  }
+  frameBuffer.assign(xRes * yRes * 3, 0);
+  sceneIsReady = true;
+  while (samples < haltSpp && !aborted) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(RE_LUX_STUB_SAMPLE_TIME));
+    samples++;
+  }
+  return 0;
+}
+
+LUX_STUB_EXPORT void luxWorldEnd() {
+}
+
+LUX_STUB_EXPORT void luxAbort() {
+  aborted = true;
+}
+
+LUX_STUB_EXPORT void luxUpdateFramebuffer() {
+  if (!sceneIsReady) {
+    return;
+  }
+  unsigned char blue = static_cast<unsigned char>(255 * samples / haltSpp);
+  unsigned char* pixel = &frameBuffer[0];
+  for (int y = 0; y < yRes; y++) {
+    for (int x = 0; x < xRes; x++) {
+      pixel[0] = static_cast<unsigned char>(x);
+      pixel[1] = static_cast<unsigned char>(y);
+      pixel[2] = blue;
+      pixel += 3;
+    }
+  }
+}
+
+LUX_STUB_EXPORT unsigned char* luxFramebuffer() {
+  return sceneIsReady ? &frameBuffer[0] : NULL;
+}
+
+LUX_STUB_EXPORT double luxStatistics( const char* statName ) {
+  if (!strcmp(statName, "sceneIsReady")) {
+    return sceneIsReady ? 1.0 : 0.0;
+  }
+  if (!sceneIsReady) {
+    return 0.0;
+  }
+  if (!strcmp(statName, "enoughSamples")) {
+    return samples >= haltSpp ? 1.0 : 0.0;
+  }
+  if (!strcmp(statName, "samplesPx")) {
+    return samples;
+  }
+  if (!strcmp(statName, "filmXres")) {
+    return xRes;
+  }
+  if (!strcmp(statName, "filmYres")) {
+    return yRes;
+  }
+  return 0.0;
+}
@@ -0,0 +1,115 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+//! Tests of the streamed ACSEL bundle format. A bundle is written to a
+//! memory buffer and read back, the records must match the originals and
+//! a damaged bundle must be rejected.
+
+#include <boost/test/unit_test.hpp>
+
+#include <QBuffer>
+
+#include "ReAcselBundleStream.h"
+
+using namespace Reality;
+
+#define RE_BUNDLE_TEST_RECORDS 20
+
+static QVariantMap makeDescription( const int i ) {
+  QVariantMap desc;
+  desc["Type"] = "A";
+  desc["SetID"] = QString("set-%1").arg(i);
+  desc["Description"] = QString("Shader set number %1").arg(i);
+  return desc;
+}
+
+static QVariantMap makeContent( const int i ) {
+  QVariantMap content;
+  QVariantList shaders;
+  for (int s = 0; s < 10; s++) {
+    QVariantMap shader;
+    shader["UUID"] = QString("uuid-%1-%2").arg(i).arg(s);
+    shader["ShaderCode"] = QString("{ \"type\": \"glossy\", \"index\": %1 }").arg(s)
+                             .repeated(20);
+    shaders.append(shader);
+  }
+  content["Shaders"] = shaders;
+  return content;
+}
+
+static QByteArray writeTestBundle() {
+  QByteArray data;
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::WriteOnly);
+  ReAcselBundleWriter writer(&buffer);
+  QVariantMap header;
+  header["ID"] = "Reality Shader Bundle";
+  header["Title"] = "Test";
+  BOOST_REQUIRE(writer.writeHeader(header, RE_BUNDLE_TEST_RECORDS));
+  for (int i = 0; i < RE_BUNDLE_TEST_RECORDS; i++) {
+    BOOST_REQUIRE(writer.writeRecord(makeDescription(i), makeContent(i)));
+  }
+  buffer.close();
+  return data;
+}
+
+BOOST_AUTO_TEST_CASE(test_AcselBundleRoundTrip) {
+  QByteArray data = writeTestBundle();
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::ReadOnly);
+  BOOST_CHECK(ReAcselBundleReader::isStreamedBundle(&buffer));
+
+  ReAcselBundleReader reader(&buffer);
+  QVariantMap header;
+  BOOST_REQUIRE(reader.readHeader(header));
+  BOOST_CHECK_EQUAL(reader.count(), RE_BUNDLE_TEST_RECORDS);
+  BOOST_CHECK(header.value("Title").toString() == "Test");
+
+  // First pass: descriptions only
+  QVariantMap desc;
+  for (int i = 0; i < reader.count(); i++) {
+    BOOST_REQUIRE(reader.readRecord(desc));
+    BOOST_CHECK(desc == makeDescription(i));
+  }
+  BOOST_CHECK(!reader.readRecord(desc));
+
+  // Second pass: full records
+  BOOST_REQUIRE(reader.rewind());
+  QVariantMap content;
+  for (int i = 0; i < reader.count(); i++) {
+    BOOST_REQUIRE(reader.readRecord(desc, &content));
+    BOOST_CHECK(desc == makeDescription(i));
+    BOOST_CHECK(content == makeContent(i));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_AcselBundleCorrupted) {
+  QByteArray data = writeTestBundle();
+  // Truncate the bundle in the middle of the last record
+  data.chop(10);
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::ReadOnly);
+
+  ReAcselBundleReader reader(&buffer);
+  QVariantMap header, desc, content;
+  BOOST_REQUIRE(reader.readHeader(header));
+  int numRead = 0;
+  while( reader.readRecord(desc, &content) ) {
+    numRead++;
+  }
+  BOOST_CHECK_EQUAL(numRead, RE_BUNDLE_TEST_RECORDS-1);
+}
+
+BOOST_AUTO_TEST_CASE(test_AcselBundleJsonDetection) {
+  QByteArray data("{ \"ID\": \"Reality Shader Bundle\" }");
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::ReadOnly);
+  BOOST_CHECK(!ReAcselBundleReader::isStreamedBundle(&buffer));
+
+  ReAcselBundleReader reader(&buffer);
+  QVariantMap header;
+  BOOST_CHECK(!reader.readHeader(header));
+}
@@ -0,0 +1,119 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+//! Tests of the background logger. Several threads log at the same time,
+//! each message must be written exactly once and, for each thread, in the
+//! order it was logged.
+
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+#include <QStringList>
+#include <QThread>
+#include <QVector>
+
+#include "ReAsyncLogger.h"
+
+using namespace Reality;
+
+#define RE_LOG_TEST_THREADS  4
+#define RE_LOG_TEST_MESSAGES 5000
+
+class ReLogProducer : public QThread {
+private:
+  ReAsyncLogger* logger;
+  int threadNo;
+
+public:
+  ReLogProducer( ReAsyncLogger* logger, const int threadNo ) :
+    logger(logger),
+    threadNo(threadNo)
+  {
+  }
+
+  void run() {
+    for (int i = 0; i < RE_LOG_TEST_MESSAGES; i++) {
+      LOG_INFO(*logger) << "msg " << threadNo << " " << i;
+    }
+  }
+};
+
+BOOST_AUTO_TEST_CASE(test_AsyncLoggerThreads) {
+  std::ostringstream out;
+  // Large enough to never drop a message
+  ReAsyncLogger logger(out, RE_LOG_TEST_THREADS*RE_LOG_TEST_MESSAGES);
+  logger.start();
+  BOOST_CHECK(logger.isRunning());
+
+  QList<ReLogProducer*> producers;
+  for (int i = 0; i < RE_LOG_TEST_THREADS; i++) {
+    producers << new ReLogProducer(&logger, i);
+  }
+  foreach(ReLogProducer* p, producers) {
+    p->start();
+  }
+  foreach(ReLogProducer* p, producers) {
+    p->wait();
+  }
+  qDeleteAll(producers);
+  logger.stop();
+  BOOST_CHECK(!logger.isRunning());
+
+  QVector<int> nextMessage(RE_LOG_TEST_THREADS, 0);
+  bool inOrder = true;
+  QStringList lines = QString::fromStdString(out.str()).split('\n', QString::SkipEmptyParts);
+  foreach(QString line, lines) {
+    QStringList tokens = line.mid(line.indexOf("msg ")).split(' ');
+    int threadNo = tokens.value(1).toInt();
+    int msgNo = tokens.value(2).toInt();
+    if (msgNo != nextMessage[threadNo]) {
+      inOrder = false;
+    }
+    nextMessage[threadNo] = msgNo+1;
+  }
+  BOOST_CHECK(inOrder);
+  BOOST_CHECK_EQUAL(lines.count(), RE_LOG_TEST_THREADS*RE_LOG_TEST_MESSAGES);
+  for (int i = 0; i < RE_LOG_TEST_THREADS; i++) {
+    BOOST_CHECK_EQUAL(nextMessage[i], RE_LOG_TEST_MESSAGES);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_AsyncLoggerLongMessage) {
+  std::ostringstream out;
+  ReAsyncLogger logger(out);
+  logger.start();
+  LOG_INFO(logger) << "first";
+  std::string longText(ReAsyncLogger::MaxMessageLength*2, 'x');
+  LOG_INFO(logger) << longText;
+  // Written, in full and in order, without waiting for the writer
+  std::string text = out.str();
+  size_t longPos = text.find(longText + "\n");
+  BOOST_CHECK(longPos != std::string::npos);
+  BOOST_CHECK(text.find("first\n") < longPos);
+  logger.stop();
+}
+
+BOOST_AUTO_TEST_CASE(test_AsyncLoggerWarning) {
+  std::ostringstream out;
+  ReAsyncLogger logger(out);
+  logger.start();
+  LOG_INFO(logger) << "info";
+  LOG_WARN(logger) << "warning";
+  // Warnings are flushed before the log call returns
+  std::string text = out.str();
+  size_t warnPos = text.find("warning\n");
+  BOOST_CHECK(warnPos != std::string::npos);
+  BOOST_CHECK(text.find("info\n") < warnPos);
+  logger.stop();
+}
+
+BOOST_AUTO_TEST_CASE(test_AsyncLoggerNotStarted) {
+  // Without the writer thread the messages are written right away
+  std::ostringstream out;
+  ReAsyncLogger logger(out);
+  LOG_WARN(logger) << "direct";
+  BOOST_CHECK(out.str().find("direct\n") != std::string::npos);
+}
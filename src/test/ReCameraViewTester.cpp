@@ -0,0 +1,77 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+//! Tests of the view of the camera used by the exporter to decimate and
+//! cull the meshes
+
+#include <boost/test/unit_test.hpp>
+
+#include "ReCameraView.h"
+#include "ReMatrix.h"
+
+using namespace Reality;
+
+//! A camera at the origin, looking down the negative Z axis, with a FOV
+//! of 90 degrees and a frame of 200x100 pixels
+static void setTestView( ReCameraView& view ) {
+  ReMatrix matrix( 1, 0, 0, 0,
+                   0, 1, 0, 0,
+                   0, 0, 1, 0,
+                   0, 0, 0, 1 );
+  view.set(matrix, 90.0f, 200, 100);
+}
+
+BOOST_AUTO_TEST_CASE(test_CameraViewDistance) {
+  ReCameraView view;
+  BOOST_CHECK(!view.isValid());
+  setTestView(view);
+  BOOST_REQUIRE(view.isValid());
+
+  // At 10 units of distance the frame is 20 units, 100 pixels, high
+  BOOST_CHECK_CLOSE(view.getPixelSize(10.0f), 0.2f, 0.001f);
+
+  ReVectorF boxMin = { 3, -1, -1 };
+  ReVectorF boxMax = { 5, 1, 1 };
+  BOOST_CHECK_CLOSE(view.getDistance(boxMin, boxMax), 3.0f, 0.001f);
+  boxMin[0] = -1;
+  BOOST_CHECK_EQUAL(view.getDistance(boxMin, boxMax), 0.0f);
+}
+
+BOOST_AUTO_TEST_CASE(test_CameraViewCulling) {
+  ReCameraView view;
+  setTestView(view);
+
+  // In front of the camera
+  ReVectorF frontMin = { -1, -1, -11 };
+  ReVectorF frontMax = {  1,  1,  -9 };
+  BOOST_CHECK(!view.isOutside(frontMin, frontMax, 0.0f));
+
+  // Behind the camera
+  ReVectorF backMin = { -1, -1,  9 };
+  ReVectorF backMax = {  1,  1, 11 };
+  BOOST_CHECK(view.isOutside(backMin, backMax, 0.0f));
+
+  // At 10 units of distance the frame goes from -20 to 20 horizontally
+  ReVectorF sideMin = { 30, -1, -11 };
+  ReVectorF sideMax = { 32,  1,  -9 };
+  BOOST_CHECK(view.isOutside(sideMin, sideMax, 0.0f));
+  // With a margin of half the frame on each side the view goes to 40
+  BOOST_CHECK(!view.isOutside(sideMin, sideMax, 0.5f));
+
+  // and from -10 to 10 vertically
+  ReVectorF topMin = { -1, 15, -11 };
+  ReVectorF topMax = {  1, 16,  -9 };
+  BOOST_CHECK(view.isOutside(topMin, topMax, 0.0f));
+
+  // A box around the camera is always in view
+  ReVectorF aroundMin = { -100, -100, -100 };
+  ReVectorF aroundMax = {  100,  100,  100 };
+  BOOST_CHECK(!view.isOutside(aroundMin, aroundMax, 0.0f));
+
+  // Without a camera nothing is culled
+  view.clear();
+  BOOST_CHECK(!view.isOutside(backMin, backMax, 0.0f));
+}
@@ -0,0 +1,487 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+//! Headless benchmark of the export pipeline.
+//!
+//! Builds a synthetic scene and exports it once for each geometry format,
+//! going through the same calls used by the host-side plugins:
+//! renderSceneStart(), newGeometryBuffer(), renderSceneExportMaterial()
+//! and renderSceneFinish(). The results can be saved as a baseline and
+//! later runs compared against it. The program returns 1 when the
+//! throughput of any format drops below the baseline by more than the
+//! threshold, so that it can be used as a regression test.
+//!
+//! With --lend the geometry is passed with lendGeometryBuffer(), from
+//! arrays owned by the benchmark, instead of being copied in the geometry
+//! buffer.
+//!
+//! Each format is exported by a child process, a copy of the benchmark
+//! started with --format, so that the peak resident set size reported
+//! for a format is the one of its own export. The peak of a process can
+//! only grow, in one process every format after the first would report
+//! the highest peak of the formats exported before it.
+//!
+//! Usage:
+//!   Reality_ExportBenchmark [--objects N] [--materials N] [--triangles N]
+//!                           [--textures N] [--collect] [--profile]
+//!                           [--lend]
+//!                           [--out dir] [--results file]
+//!                           [--baseline file] [--write-baseline file]
+//!                           [--threshold percent]
+//!   Reality_ExportBenchmark --format name --results file [...]
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QJson/Parser>
+#include <QJson/Serializer>
+#include <QProcess>
+#include <QVector>
+
+#include <iostream>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "RealityBase.h"
+#include "ReCamera.h"
+#include "ReGeometryObject.h"
+#include "ReMatte.h"
+#include "ReProfiler.h"
+#include "ReSceneData.h"
+#include "ReSceneDataGlobal.h"
+#include "textures/ReImageMap.h"
+
+using namespace Reality;
+
+struct BenchmarkParams {
+  int numObjects;
+  int numMaterials;
+  int numTriangles;
+  int numTextures;
+  bool collectTextures;
+  bool profile;
+  bool lendStorage;
+  QString outDir;
+
+  BenchmarkParams() :
+    numObjects(20),
+    numMaterials(20),
+    numTriangles(5000),
+    numTextures(16),
+    collectTextures(false),
+    profile(false),
+    lendStorage(false)
+  {
+  }
+
+  QVariantMap toMap() const {
+    QVariantMap map;
+    map["objects"]   = numObjects;
+    map["materials"] = numMaterials;
+    map["triangles"] = numTriangles;
+    map["textures"]  = numTextures;
+    map["collect"]   = collectTextures;
+    map["lend"]      = lendStorage;
+    return map;
+  }
+};
+
+//! Peak resident set size of the process, in bytes
+static qint64 getPeakRSS() {
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+    return counters.PeakWorkingSetSize;
+  }
+  return 0;
+#else
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+  return usage.ru_maxrss;
+#else
+  return static_cast<qint64>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+//! Total size of the files in a directory, recursively
+static qint64 getDirectorySize( const QString& dirName ) {
+  qint64 size = 0;
+  QDirIterator it(dirName, QDir::Files, QDirIterator::Subdirectories);
+  while( it.hasNext() ) {
+    it.next();
+    size += it.fileInfo().size();
+  }
+  return size;
+}
+
+static QStringList createTextures( const BenchmarkParams& params ) {
+  QStringList textures;
+  QDir(params.outDir).mkpath("maps");
+  for (int i = 0; i < params.numTextures; i++) {
+    QString fileName = QString("%1/maps/texture_%2.png").arg(params.outDir).arg(i);
+    if (!QFileInfo(fileName).exists()) {
+      QImage img(256, 256, QImage::Format_RGB32);
+      img.fill(qRgb(i*16 % 256, 128, 255 - i*16 % 256));
+      img.save(fileName);
+    }
+    textures << fileName;
+  }
+  return textures;
+}
+
+static void createScene( const BenchmarkParams& params ) {
+  QStringList textures = createTextures(params);
+  RealitySceneData->newScene();
+  RealitySceneData->addCamera(ReCameraPtr(new ReCamera("Camera", "Camera")));
+  RealitySceneData->selectCamera("Camera");
+  RealitySceneData->setTextureCollection(params.collectTextures);
+
+  int texNo = 0;
+  for (int i = 0; i < params.numObjects; i++) {
+    QString objID = QString("Figure_%1").arg(i);
+    ReGeometryObject* obj = new ReGeometryObject(objID, objID, objID);
+    for (int m = 0; m < params.numMaterials; m++) {
+      QString matName = QString("Material_%1").arg(m);
+      ReMatte* mat = new ReMatte(matName, obj);
+      if (!textures.isEmpty()) {
+        mat->setKd(ReTexturePtr(
+          new ReImageMap(QString("%1_Kd").arg(matName), mat, textures[texNo++ % textures.count()])
+        ));
+      }
+      obj->addMaterial(matName, ReMaterialPtr(mat));
+    }
+    RealitySceneData->addObject(obj);
+  }
+}
+
+//! Fills the geometry buffer with a strip of triangles, the same layout
+//! used by the host plugins.
+static void fillGeometry( const int numTriangles,
+                          float* vertices,
+                          float* normals,
+                          ReUVPoint* uvs,
+                          int* faces ) 
+{
+  int numVertices = numTriangles+2;
+  for (int i = 0; i < numVertices; i++) {
+    vertices[i*3]   = (i/2) * 0.01;
+    vertices[i*3+1] = (i%2) * 0.01;
+    vertices[i*3+2] = 0;
+    normals[i*3]    = 0;
+    normals[i*3+1]  = 0;
+    normals[i*3+2]  = 1;
+    uvs[i][0] = static_cast<float>(i/2) / numVertices;
+    uvs[i][1] = i%2;
+  }
+  for (int t = 0; t < numTriangles; t++) {
+    faces[t*3]   = t;
+    faces[t*3+1] = t+1;
+    faces[t*3+2] = t+2;
+  }
+}
+
+static void fillGeometryBuffer( const int numTriangles ) {
+  fillGeometry(numTriangles,
+               RealitySceneData->getGeometryVertexBuffer(),
+               RealitySceneData->getGeometryNormalBuffer(),
+               RealitySceneData->getGeometryUVPointBuffer(),
+               RealitySceneData->getGeometryFaceBuffer());
+}
+
+//! Geometry owned by the benchmark, for the --lend option
+struct LentGeometry {
+  QVector<float> vertices;
+  QVector<float> normals;
+  QVector<float> uvs;
+  QVector<int> faces;
+
+  explicit LentGeometry( const int numTriangles ) :
+    vertices((numTriangles+2)*3),
+    normals((numTriangles+2)*3),
+    uvs((numTriangles+2)*2),
+    faces(numTriangles*3)
+  {
+    fillGeometry(numTriangles,
+                 vertices.data(),
+                 normals.data(),
+                 reinterpret_cast<ReUVPoint*>(uvs.data()),
+                 faces.data());
+  }
+};
+
+static QVariantMap runExport( const BenchmarkParams& params,
+                              const GeometryFileFormat format,
+                              const QString& formatName )
+{
+  QString sceneDir = QString("%1/%2").arg(params.outDir).arg(formatName);
+  QDir(sceneDir).mkpath(".");
+  RealitySceneData->setGeometryFormat(format);
+  RealitySceneData->setSceneFileName(QString("%1/benchmark.lxs").arg(sceneDir));
+  RealitySceneData->setImageFileName(QString("%1/benchmark.png").arg(sceneDir));
+
+  if (params.profile) {
+    ReProfiler::beginSession();
+  }
+  LentGeometry lent(params.lendStorage ? params.numTriangles : 0);
+  QElapsedTimer timer;
+  timer.start();
+  RealitySceneData->renderSceneStart("", 1);
+  for (int i = 0; i < params.numObjects; i++) {
+    QString objID = QString("Figure_%1").arg(i);
+    RealitySceneData->renderSceneObjectBegin(objID);
+    for (int m = 0; m < params.numMaterials; m++) {
+      QString matName = QString("Material_%1").arg(m);
+      QString bufferName = QString("%1:%2").arg(objID).arg(matName);
+      if (params.lendStorage) {
+        RealitySceneData->lendGeometryBuffer(
+          bufferName,
+          params.numTriangles+2,
+          params.numTriangles,
+          lent.vertices.data(),
+          lent.normals.data(),
+          lent.uvs.data(),
+          lent.faces.data()
+        );
+      }
+      else {
+        RealitySceneData->newGeometryBuffer(
+          bufferName,
+          params.numTriangles+2,
+          params.numTriangles,
+          true
+        );
+        fillGeometryBuffer(params.numTriangles);
+      }
+      RealitySceneData->renderSceneExportMaterial(matName, objID, matName, DAZStudio);
+    }
+    RealitySceneData->renderSceneObjectEnd(objID);
+  }
+  RealitySceneData->renderSceneFinish(false);
+  qint64 elapsed = timer.elapsed();
+
+  double totalTriangles = static_cast<double>(params.numObjects) *
+                          params.numMaterials * params.numTriangles;
+  QVariantMap result;
+  result["ms"]              = elapsed;
+  result["bytes"]           = getDirectorySize(sceneDir);
+  result["trianglesPerSec"] = elapsed ? totalTriangles * 1000.0 / elapsed : 0.0;
+  result["peakRSS"]         = getPeakRSS();
+  return result;
+}
+
+static QVariantMap readJSON( const QString& fileName, bool& ok ) {
+  QFile file(fileName);
+  ok = file.open(QIODevice::ReadOnly);
+  if (!ok) {
+    return QVariantMap();
+  }
+  QJson::Parser parser;
+  return parser.parse(file.readAll(), &ok).toMap();
+}
+
+static bool writeJSON( const QString& fileName, const QVariantMap& data ) {
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  QJson::Serializer json;
+  json.setIndentMode(QJson::IndentFull);
+  return file.write(json.serialize(data)) != -1;
+}
+
+//! Exports the scene in one format in the current process and saves the
+//! result in resultFileName. This is the work done by the child processes.
+static int runFormat( const BenchmarkParams& params,
+                      const QString& formatName,
+                      const QString& resultFileName )
+{
+  GeometryFileFormat format;
+  if (formatName == "LuxNative") {
+    format = LuxNative;
+  }
+  else if (formatName == "BinaryPLY") {
+    format = BinaryPLY;
+  }
+  else if (formatName == "TextPLY") {
+    format = TextPLY;
+  }
+  else {
+    std::cerr << "Unknown format: " << QSS(formatName) << std::endl;
+    return 2;
+  }
+  RealityBase::getRealityBase();
+  // No IPC with the GUI
+  RealitySceneData->setGUIMode(true);
+  createScene(params);
+  return writeJSON(resultFileName, runExport(params, format, formatName)) ? 0 : 2;
+}
+
+//! Runs the export of one format in a child process, started with the
+//! same options and --format. Returns an empty map if the child fails.
+static QVariantMap runFormatProcess( const QStringList& options,
+                                     const QString& outDir,
+                                     const QString& formatName )
+{
+  QDir(outDir).mkpath(".");
+  QString resultFileName = QString("%1/%2.json").arg(outDir).arg(formatName);
+  QFile::remove(resultFileName);
+
+  QStringList childOptions = options;
+  childOptions << "--format" << formatName << "--results" << resultFileName;
+  QProcess child;
+  child.setProcessChannelMode(QProcess::ForwardedChannels);
+  child.start(QCoreApplication::applicationFilePath(), childOptions);
+  if (!child.waitForFinished(-1) || child.exitStatus() != QProcess::NormalExit ||
+      child.exitCode() != 0)
+  {
+    std::cerr << "The export of " << QSS(formatName) << " failed" << std::endl;
+    return QVariantMap();
+  }
+  bool ok;
+  QVariantMap result = readJSON(resultFileName, ok);
+  QFile::remove(resultFileName);
+  return ok ? result : QVariantMap();
+}
+
+int main( int argc, char** argv ) {
+  QCoreApplication app(argc, argv);
+  BenchmarkParams params;
+  params.outDir = QDir::temp().absoluteFilePath("RealityExportBenchmark");
+  QString resultsFileName, baselineFileName, newBaselineFileName, formatName;
+  double threshold = 20;
+
+  QStringList args = app.arguments();
+  for (int i = 1; i < args.count(); i++) {
+    QString arg = args[i];
+    QString value = args.value(i+1);
+    if (arg == "--objects") {
+      params.numObjects = value.toInt(); i++;
+    }
+    else if (arg == "--materials") {
+      params.numMaterials = value.toInt(); i++;
+    }
+    else if (arg == "--triangles") {
+      params.numTriangles = value.toInt(); i++;
+    }
+    else if (arg == "--textures") {
+      params.numTextures = value.toInt(); i++;
+    }
+    else if (arg == "--collect") {
+      params.collectTextures = true;
+    }
+    else if (arg == "--profile") {
+      params.profile = true;
+    }
+    else if (arg == "--lend") {
+      params.lendStorage = true;
+    }
+    else if (arg == "--out") {
+      params.outDir = value; i++;
+    }
+    else if (arg == "--results") {
+      resultsFileName = value; i++;
+    }
+    else if (arg == "--baseline") {
+      baselineFileName = value; i++;
+    }
+    else if (arg == "--write-baseline") {
+      newBaselineFileName = value; i++;
+    }
+    else if (arg == "--threshold") {
+      threshold = value.toDouble(); i++;
+    }
+    else if (arg == "--format") {
+      formatName = value; i++;
+    }
+    else {
+      std::cerr << "Unknown option: " << QSS(arg) << std::endl;
+      return 2;
+    }
+  }
+
+  if (!formatName.isEmpty()) {
+    return runFormat(params, formatName, resultsFileName);
+  }
+
+  // The options are passed to the child processes as they are, a later
+  // --results overrides the one given here
+  QStringList options = args.mid(1);
+  QStringList formats;
+  formats << "LuxNative" << "BinaryPLY" << "TextPLY";
+  QVariantMap results;
+  results["params"] = params.toMap();
+  results["peakRSSScope"] = "process";
+  foreach(QString format, formats) {
+    QVariantMap r = runFormatProcess(options, params.outDir, format);
+    if (r.isEmpty()) {
+      return 2;
+    }
+    results[format] = r;
+  }
+
+  std::cout << "Export benchmark: " << params.numObjects << " objects x "
+            << params.numMaterials << " materials x "
+            << params.numTriangles << " triangles, "
+            << params.numTextures << " textures" << std::endl;
+  std::cout << "  Each format is exported in a process of its own, the peak RSS "
+               "is the one of that process" << std::endl;
+  foreach(QString format, formats) {
+    QVariantMap r = results[format].toMap();
+    std::cout << "  " << QSS(format) << ": "
+              << r["ms"].toLongLong() << " ms, "
+              << static_cast<qint64>(r["trianglesPerSec"].toDouble()) << " tris/s, "
+              << r["bytes"].toLongLong() / 1024 << " KB, peak RSS "
+              << r["peakRSS"].toLongLong() / (1024*1024) << " MB" << std::endl;
+  }
+
+  if (!resultsFileName.isEmpty()) {
+    writeJSON(resultsFileName, results);
+  }
+  if (!newBaselineFileName.isEmpty()) {
+    writeJSON(newBaselineFileName, results);
+  }
+
+  int retVal = 0;
+  if (!baselineFileName.isEmpty()) {
+    bool ok;
+    QVariantMap baseline = readJSON(baselineFileName, ok);
+    if (!ok) {
+      std::cout << "No baseline found in " << QSS(baselineFileName)
+                << ", skipping the comparison" << std::endl;
+    }
+    else if (baseline["params"].toMap() != params.toMap()) {
+      std::cout << "The baseline was recorded with a different scene size, "
+                   "skipping the comparison" << std::endl;
+    }
+    else {
+      foreach(QString format, formats) {
+        double base = baseline[format].toMap()["trianglesPerSec"].toDouble();
+        double current = results[format].toMap()["trianglesPerSec"].toDouble();
+        if (base <= 0) {
+          continue;
+        }
+        double change = (current - base) * 100.0 / base;
+        bool failed = change < -threshold;
+        std::cout << "  " << QSS(format) << " vs baseline: "
+                  << (change >= 0 ? "+" : "") << change << "%"
+                  << (failed ? " REGRESSION" : "") << std::endl;
+        if (failed) {
+          retVal = 1;
+        }
+      }
+    }
+  }
+  return retVal;
+}
@@ -0,0 +1,208 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+//! Tests of the export sessions: the atomic replacement of the scene
+//! files and of the geometry directory, and the reuse of the objects of
+//! an interrupted export.
+
+#include <boost/test/unit_test.hpp>
+
+#include <QDir>
+#include <QFile>
+
+#include "ReExportSession.h"
+#include "RealityTester.h"
+
+using namespace Reality;
+
+struct ExportSessionFixture {
+  QString sceneName;
+  QString includeName;
+  QString objectsDir;
+
+  ExportSessionFixture() {
+    QString dirName = getTestDir(
+      "ExportSession", QStringList() << "objects" << "objects" RE_EXPORT_TEMP_EXT
+    );
+    sceneName   = QString("%1/scene.lxs").arg(dirName);
+    includeName = QString("%1/scene.lxi").arg(dirName);
+    objectsDir  = QString("%1/objects").arg(dirName);
+  }
+
+  static QByteArray readFile( const QString& fileName ) {
+    QFile f(fileName);
+    if (!f.open(QIODevice::ReadOnly)) {
+      return QByteArray();
+    }
+    return f.readAll();
+  }
+
+  static void writeFile( const QString& fileName, const QByteArray& data ) {
+    QFile f(fileName);
+    f.open(QIODevice::WriteOnly);
+    f.write(data);
+  }
+
+  //! Exports one object made of one material
+  static void exportObject( ReExportSession& session,
+                            const QString& objectID,
+                            const QByteArray& hash )
+  {
+    session.beginObject(objectID, hash);
+    session.writeInclude(QString("Shape \"%1\"\n").arg(objectID).toUtf8());
+    session.addMaterial(10);
+    session.endObject();
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(ExportSession, ExportSessionFixture)
+
+BOOST_AUTO_TEST_CASE(test_ExportSessionCommit) {
+  writeFile(sceneName, "old scene");
+  writeFile(includeName, "old include");
+
+  ReExportSession session;
+  BOOST_REQUIRE(session.begin(sceneName, includeName));
+  session.setSceneKey("key");
+  session.writeScene("scene\n");
+  session.writeInclude("header\n");
+  exportObject(session, "A", "hashA");
+
+  // The previous export is untouched until the commit
+  BOOST_CHECK(readFile(sceneName) == "old scene");
+  BOOST_CHECK(readFile(includeName) == "old include");
+
+  BOOST_REQUIRE(session.commit());
+  BOOST_CHECK(readFile(sceneName) == "scene\n");
+  BOOST_CHECK(readFile(includeName) == "header\nShape \"A\"\n");
+  BOOST_CHECK(!QFile::exists(sceneName + RE_EXPORT_TEMP_EXT));
+  BOOST_CHECK(!QFile::exists(includeName + RE_EXPORT_TEMP_EXT));
+  BOOST_CHECK(!QFile::exists(includeName + RE_EXPORT_JOURNAL_EXT));
+
+  const ReExportProgress& progress = session.getProgress();
+  BOOST_CHECK_EQUAL(progress.objects, 1u);
+  BOOST_CHECK_EQUAL(progress.materials, 1u);
+  BOOST_CHECK_EQUAL(progress.triangles, 10u);
+  BOOST_CHECK_EQUAL(progress.bytes, (quint64) 23);
+}
+
+BOOST_AUTO_TEST_CASE(test_ExportSessionStagedDirectory) {
+  QString stagingDir = ReExportSession::getStagingDir(objectsDir);
+  writeFile(objectsDir + "/A.ply", "old A");
+  writeFile(objectsDir + "/B.ply", "old B");
+  {
+    ReExportSession session;
+    BOOST_REQUIRE(session.begin(sceneName, includeName));
+    session.setSceneKey("key");
+    session.stageDirectory(objectsDir);
+    writeFile(stagingDir + "/A.ply", "new A");
+    session.abort();
+  }
+  // The geometry of the previous export is untouched and the one of the
+  // interrupted export is kept for the next one
+  BOOST_CHECK(readFile(objectsDir + "/A.ply") == "old A");
+  BOOST_CHECK(readFile(stagingDir + "/A.ply") == "new A");
+
+  ReExportSession session;
+  BOOST_REQUIRE(session.begin(sceneName, includeName));
+  session.setSceneKey("key");
+  session.stageDirectory(objectsDir);
+  writeFile(stagingDir + "/C.ply", "new C");
+  BOOST_REQUIRE(session.commit());
+
+  BOOST_CHECK(readFile(objectsDir + "/A.ply") == "new A");
+  BOOST_CHECK(readFile(objectsDir + "/C.ply") == "new C");
+  BOOST_CHECK(!QFile::exists(objectsDir + "/B.ply"));
+  BOOST_CHECK(!QDir(stagingDir).exists());
+  BOOST_CHECK(!QDir(objectsDir + RE_EXPORT_BACKUP_EXT).exists());
+}
+
+BOOST_AUTO_TEST_CASE(test_ExportSessionResume) {
+  writeFile(includeName, "old include");
+  {
+    ReExportSession session;
+    BOOST_REQUIRE(session.begin(sceneName, includeName));
+    session.setSceneKey("key");
+    session.writeScene("scene\n");
+    session.writeInclude("header\n");
+    exportObject(session, "A", "hashA");
+    exportObject(session, "B", "hashB");
+    // Cancelled before the third object
+    session.abort();
+  }
+  BOOST_CHECK(readFile(includeName) == "old include");
+  BOOST_CHECK(QFile::exists(includeName + RE_EXPORT_JOURNAL_EXT));
+
+  ReExportSession session;
+  BOOST_REQUIRE(session.begin(sceneName, includeName));
+  BOOST_CHECK(session.canResume());
+  session.setSceneKey("key");
+  session.writeScene("scene\n");
+  session.writeInclude("header\n");
+  BOOST_CHECK(session.reuseObject("A", "hashA"));
+  BOOST_CHECK(session.reuseObject("B", "hashB"));
+  BOOST_CHECK(!session.reuseObject("C", "hashC"));
+  exportObject(session, "C", "hashC");
+  BOOST_REQUIRE(session.commit());
+
+  BOOST_CHECK(readFile(includeName) == "header\nShape \"A\"\nShape \"B\"\nShape \"C\"\n");
+  BOOST_CHECK_EQUAL(session.getProgress().objects, 3u);
+  BOOST_CHECK_EQUAL(session.getProgress().reusedObjects, 2u);
+  BOOST_CHECK_EQUAL(session.getProgress().materials, 3u);
+  BOOST_CHECK(!QFile::exists(includeName + RE_EXPORT_RESUME_EXT));
+}
+
+BOOST_AUTO_TEST_CASE(test_ExportSessionChangedObject) {
+  {
+    ReExportSession session;
+    BOOST_REQUIRE(session.begin(sceneName, includeName));
+    session.setSceneKey("key");
+    exportObject(session, "A", "hashA");
+    exportObject(session, "B", "hashB");
+    session.abort();
+  }
+  ReExportSession session;
+  BOOST_REQUIRE(session.begin(sceneName, includeName));
+  session.setSceneKey("key");
+  // A has changed, nothing after it can be reused
+  BOOST_CHECK(!session.reuseObject("A", "hashA2"));
+  exportObject(session, "A", "hashA2");
+  BOOST_CHECK(!session.reuseObject("B", "hashB"));
+  session.abort();
+}
+
+BOOST_AUTO_TEST_CASE(test_ExportSessionChangedScene) {
+  {
+    ReExportSession session;
+    BOOST_REQUIRE(session.begin(sceneName, includeName));
+    session.setSceneKey("key");
+    exportObject(session, "A", "hashA");
+    session.abort();
+  }
+  ReExportSession session;
+  BOOST_REQUIRE(session.begin(sceneName, includeName));
+  BOOST_CHECK(session.canResume());
+  // Different render settings
+  session.setSceneKey("key2");
+  BOOST_CHECK(!session.canResume());
+  BOOST_CHECK(!session.reuseObject("A", "hashA"));
+  session.abort();
+}
+
+BOOST_AUTO_TEST_CASE(test_ExportSessionCancel) {
+  ReExportSession session;
+  BOOST_REQUIRE(session.begin(sceneName, includeName));
+  BOOST_CHECK(!session.isCancelRequested());
+  session.requestCancel();
+  BOOST_CHECK(session.isCancelRequested());
+  session.abort();
+  // A new export clears the request
+  BOOST_REQUIRE(session.begin(sceneName, includeName));
+  BOOST_CHECK(!session.isCancelRequested());
+  session.abort();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
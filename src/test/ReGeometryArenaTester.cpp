@@ -0,0 +1,85 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+//! Tests of the arena used to store the geometry during the export
+
+#include <boost/test/unit_test.hpp>
+
+#include <string.h>
+
+#include <QDir>
+
+#include "ReGeometryArena.h"
+#include "RealityTester.h"
+
+using namespace Reality;
+
+#define RE_ARENA_TEST_MB (1024*1024)
+
+BOOST_AUTO_TEST_CASE(test_GeometryArenaGrowth) {
+  ReGeometryArena arena;
+  BOOST_CHECK_EQUAL(arena.getCapacity(), (size_t) 0);
+
+  BOOST_REQUIRE(arena.reserve(1000));
+  size_t firstCapacity = arena.getCapacity();
+  BOOST_CHECK(firstCapacity >= 1000);
+  BOOST_CHECK(arena.getBacking() == ReGeometryArena::Heap);
+
+  // Smaller requests reuse the same memory
+  BOOST_REQUIRE(arena.reserve(500));
+  BOOST_CHECK_EQUAL(arena.getCapacity(), firstCapacity);
+
+  // Growing at least doubles the capacity
+  BOOST_REQUIRE(arena.reserve(firstCapacity + 1));
+  BOOST_CHECK(arena.getCapacity() >= firstCapacity * 2);
+
+  arena.release();
+  BOOST_CHECK_EQUAL(arena.getCapacity(), (size_t) 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_GeometryArenaAllocate) {
+  ReGeometryArena arena;
+  BOOST_REQUIRE(arena.reserve(ReGeometryArena::alignedSize(10) * 3));
+  char* a = static_cast<char*>(arena.allocate(10));
+  char* b = static_cast<char*>(arena.allocate(10));
+  BOOST_REQUIRE(a && b);
+  BOOST_CHECK_EQUAL(reinterpret_cast<quintptr>(a) % 16, (quintptr) 0);
+  BOOST_CHECK_EQUAL(static_cast<size_t>(b - a) % 16, (size_t) 0);
+  BOOST_CHECK(b >= a + 10);
+
+  // Allocations past the reserved space fail
+  BOOST_CHECK(arena.allocate(arena.getCapacity()) == NULL);
+
+  // After clear() the same memory is handed out again
+  arena.clear();
+  BOOST_CHECK(arena.allocate(10) == a);
+}
+
+BOOST_AUTO_TEST_CASE(test_GeometryArenaMapping) {
+  ReGeometryArena arena;
+  arena.setMappingThreshold(2 * RE_ARENA_TEST_MB);
+
+  BOOST_REQUIRE(arena.reserve(4 * RE_ARENA_TEST_MB));
+  BOOST_CHECK(arena.getBacking() == ReGeometryArena::AnonymousMap);
+  char* block = static_cast<char*>(arena.allocate(4 * RE_ARENA_TEST_MB));
+  BOOST_REQUIRE(block);
+  memset(block, 0x5a, 4 * RE_ARENA_TEST_MB);
+  BOOST_CHECK_EQUAL(block[4 * RE_ARENA_TEST_MB - 1], 0x5a);
+  arena.release();
+
+  QString mapDir = getTestDir("GeometryArena");
+  arena.setMappingDir(mapDir);
+  BOOST_REQUIRE(arena.reserve(4 * RE_ARENA_TEST_MB));
+  BOOST_CHECK(arena.getBacking() == ReGeometryArena::FileMap);
+  BOOST_CHECK_EQUAL(QDir(mapDir).entryList(QDir::Files).count(), 1);
+  block = static_cast<char*>(arena.allocate(RE_ARENA_TEST_MB));
+  BOOST_REQUIRE(block);
+  memset(block, 0x5a, RE_ARENA_TEST_MB);
+
+  // The temporary file is removed with the mapping
+  arena.release();
+  BOOST_CHECK_EQUAL(QDir(mapDir).entryList(QDir::Files).count(), 0);
+}
@@ -0,0 +1,114 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+//! Stress test of the host command queue. Several producer threads push
+//! commands while the main thread drains the queue. Every command must be
+//! received exactly once and, for each producer, in the order it was sent.
+
+#include <boost/test/unit_test.hpp>
+
+#include <QThread>
+#include <QVector>
+
+#include "ReHostCommandQueue.h"
+
+using namespace Reality;
+
+#define RE_QUEUE_TEST_PRODUCERS 4
+#define RE_QUEUE_TEST_COMMANDS  50000
+// Small, to make the producers hit the full queue often
+#define RE_QUEUE_TEST_CAPACITY  64
+
+class ReCommandProducer : public QThread {
+private:
+  ReHostCommandQueue* queue;
+  int producerNo;
+
+public:
+  int numRetries;
+
+  ReCommandProducer( ReHostCommandQueue* queue, const int producerNo ) :
+    queue(queue),
+    producerNo(producerNo),
+    numRetries(0)
+  {
+  }
+
+  void run() {
+    for (int i = 0; i < RE_QUEUE_TEST_COMMANDS; i++) {
+      // startFrame identifies the producer, endFrame the sequence
+      ReHostCommand cmd = ReHostCommand::renderAnimation(true, producerNo, i);
+      cmd.objectID = QString::number(i);
+      while( !queue->push(cmd) ) {
+        numRetries++;
+        QThread::yieldCurrentThread();
+      }
+    }
+  }
+};
+
+BOOST_AUTO_TEST_CASE(test_HostCommandQueueStress) {
+  ReHostCommandQueue queue(RE_QUEUE_TEST_CAPACITY);
+  BOOST_CHECK_EQUAL(queue.capacity(), (quint32)RE_QUEUE_TEST_CAPACITY);
+
+  QList<ReCommandProducer*> producers;
+  for (int i = 0; i < RE_QUEUE_TEST_PRODUCERS; i++) {
+    producers << new ReCommandProducer(&queue, i);
+  }
+  foreach(ReCommandProducer* producer, producers) {
+    producer->start();
+  }
+
+  QVector<int> nextExpected(RE_QUEUE_TEST_PRODUCERS, 0);
+  int received = 0;
+  int outOfOrder = 0;
+  int total = RE_QUEUE_TEST_PRODUCERS * RE_QUEUE_TEST_COMMANDS;
+  ReHostCommand cmd;
+  while( received < total ) {
+    if (!queue.pop(cmd)) {
+      QThread::yieldCurrentThread();
+      continue;
+    }
+    received++;
+    if (cmd.endFrame != nextExpected[cmd.startFrame] ||
+        cmd.objectID != QString::number(cmd.endFrame)) {
+      outOfOrder++;
+    }
+    nextExpected[cmd.startFrame] = cmd.endFrame+1;
+  }
+
+  foreach(ReCommandProducer* producer, producers) {
+    producer->wait();
+  }
+  qDeleteAll(producers);
+
+  BOOST_CHECK_EQUAL(outOfOrder, 0);
+  BOOST_CHECK_EQUAL(queue.count(), 0);
+  BOOST_CHECK(!queue.pop(cmd));
+  for (int i = 0; i < RE_QUEUE_TEST_PRODUCERS; i++) {
+    BOOST_CHECK_EQUAL(nextExpected[i], RE_QUEUE_TEST_COMMANDS);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_HostCommandQueueFull) {
+  ReHostCommandQueue queue(4);
+  for (int i = 0; i < 4; i++) {
+    BOOST_CHECK(queue.push(ReHostCommand::renderFrame(true)));
+  }
+  BOOST_CHECK(!queue.push(ReHostCommand::renderFrame(true)));
+  ReHostCommand cmd;
+  BOOST_CHECK(queue.pop(cmd));
+  BOOST_CHECK(queue.push(ReHostCommand::renderFrame(false)));
+  BOOST_CHECK_EQUAL(queue.count(), 4);
+}
+
+BOOST_AUTO_TEST_CASE(test_HostCommandTokens) {
+  // The order expected by the Python code in Poser
+  QStringList tokens = ReHostCommand::renderAnimation(true, 10, 20).toTokens();
+  BOOST_CHECK(tokens == QStringList() << "renderAnim" << "1" << "10" << "20");
+  tokens = ReHostCommand::selectMaterial("Figure", "Skin").toTokens();
+  BOOST_CHECK(tokens == QStringList() << "smha" << "Figure" << "Skin");
+}
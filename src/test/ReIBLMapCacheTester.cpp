@@ -0,0 +1,125 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+//! Tests of the preparation of the IBL maps: the Radiance HDR reader and
+//! writer, the reduction of the maps and the reuse of the cached copies.
+
+#include <boost/test/unit_test.hpp>
+
+#include <math.h>
+
+#include <QDateTime>
+#include <QFileInfo>
+
+#include "ReIBLMapCache.h"
+#include "RealityTester.h"
+
+using namespace Reality;
+
+#define RE_IBL_TEST_WIDTH  64
+#define RE_IBL_TEST_HEIGHT 32
+
+//! Creates a lat-long map with 4x4 blocks of constant color
+static void makeTestMap( ReIBLMapCache::FloatImage& image ) {
+  image.resize(RE_IBL_TEST_WIDTH, RE_IBL_TEST_HEIGHT);
+  for (int y = 0; y < image.height; y++) {
+    for (int x = 0; x < image.width; x++) {
+      float* p = image.pixel(x, y);
+      p[0] = 0.25f * ((x/4) % 8);
+      p[1] = 10.0f * ((y/4) % 4);
+      p[2] = 0.5f;
+    }
+  }
+}
+
+static bool isClose( const float a, const float b ) {
+  // RGBE keeps 8 bits of mantissa
+  return fabs(a-b) <= 0.01f * qMax(1.0f, fabs(b));
+}
+
+BOOST_AUTO_TEST_CASE(test_IBLRadianceRoundTrip) {
+  ReIBLMapCache::FloatImage image, loaded;
+  makeTestMap(image);
+  QString fileName = QString("%1/roundtrip.hdr").arg(getTestDir("IBLMapCache"));
+  BOOST_REQUIRE(ReIBLMapCache::writeRadianceHDR(fileName, image));
+
+  int width, height;
+  BOOST_REQUIRE(ReIBLMapCache::readRadianceHDRSize(fileName, width, height));
+  BOOST_CHECK_EQUAL(width, RE_IBL_TEST_WIDTH);
+  BOOST_CHECK_EQUAL(height, RE_IBL_TEST_HEIGHT);
+
+  BOOST_REQUIRE(ReIBLMapCache::readRadianceHDR(fileName, loaded));
+  BOOST_REQUIRE_EQUAL(loaded.width, image.width);
+  BOOST_REQUIRE_EQUAL(loaded.height, image.height);
+  bool allClose = true;
+  for (int i = 0; i < image.pixels.count(); i++) {
+    allClose = allClose && isClose(loaded.pixels[i], image.pixels[i]);
+  }
+  BOOST_CHECK(allClose);
+}
+
+BOOST_AUTO_TEST_CASE(test_IBLReducedRead) {
+  ReIBLMapCache::FloatImage image, reduced;
+  makeTestMap(image);
+  QString fileName = QString("%1/reduce.hdr").arg(getTestDir("IBLMapCache"));
+  BOOST_REQUIRE(ReIBLMapCache::writeRadianceHDR(fileName, image));
+
+  // Each pixel of the reduced map covers exactly one 4x4 block
+  BOOST_REQUIRE(ReIBLMapCache::readRadianceHDR(fileName, reduced, RE_IBL_TEST_WIDTH/4));
+  BOOST_REQUIRE_EQUAL(reduced.width, RE_IBL_TEST_WIDTH/4);
+  BOOST_REQUIRE_EQUAL(reduced.height, RE_IBL_TEST_HEIGHT/4);
+  for (int y = 0; y < reduced.height; y++) {
+    for (int x = 0; x < reduced.width; x++) {
+      const float* p = reduced.pixel(x, y);
+      const float* src = image.pixel(x*4, y*4);
+      BOOST_CHECK(isClose(p[0], src[0]));
+      BOOST_CHECK(isClose(p[1], src[1]));
+      BOOST_CHECK(isClose(p[2], src[2]));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_IBLMapCacheReuse) {
+  QString dirName = getTestDir("IBLMapCache");
+  ReIBLMapCache::FloatImage image;
+  makeTestMap(image);
+  QString fileName = QString("%1/source.hdr").arg(dirName);
+  BOOST_REQUIRE(ReIBLMapCache::writeRadianceHDR(fileName, image));
+
+  ReIBLMapCache* cache = ReIBLMapCache::getInstance();
+  QString oldCacheDir = cache->getCacheDir();
+  cache->setCacheDir(QString("%1/cache").arg(dirName));
+
+  // The map is smaller than the selected size, nothing to do
+  bool isAngular = false;
+  BOOST_CHECK(cache->prepareMap(fileName, isAngular, IBL_1K, false) == fileName);
+
+  // Angular maps are converted when the renderer needs lat-long
+  isAngular = true;
+  QString prepared = cache->prepareMap(fileName, isAngular, IBL_ORIGINAL, true);
+  BOOST_CHECK(prepared != fileName);
+  BOOST_CHECK(!isAngular);
+  int width, height;
+  BOOST_REQUIRE(ReIBLMapCache::readRadianceHDRSize(prepared, width, height));
+  BOOST_CHECK_EQUAL(width, RE_IBL_TEST_WIDTH);
+  BOOST_CHECK_EQUAL(height, RE_IBL_TEST_WIDTH/2);
+
+  // The second request is served from the cache
+  QDateTime preparedTime = QFileInfo(prepared).lastModified();
+  isAngular = true;
+  BOOST_CHECK(cache->prepareMap(fileName, isAngular, IBL_ORIGINAL, true) == prepared);
+  BOOST_CHECK(!isAngular);
+  BOOST_CHECK(QFileInfo(prepared).lastModified() == preparedTime);
+
+  // Angular maps are kept as they are for the renderers that support them
+  isAngular = true;
+  BOOST_CHECK(cache->prepareMap(fileName, isAngular, IBL_ORIGINAL, false) == fileName);
+  BOOST_CHECK(isAngular);
+
+  cache->clear();
+  BOOST_CHECK(!QFileInfo(prepared).exists());
+  cache->setCacheDir(oldCacheDir);
+}
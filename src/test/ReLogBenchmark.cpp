@@ -0,0 +1,128 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+//! Benchmark of the cost of a log call on the export path.
+//!
+//! The export logs one message per object, like "Exporting object <name>"
+//! in the Studio plugin. The benchmark logs bursts of those messages, one
+//! burst per simulated export, and reports the average cost of one call
+//! for each configuration:
+//!   - disabled: the message is below CPPLOG_FILTER_LEVEL and it's removed
+//!     at compile time
+//!   - cpplog: the synchronous cpplog::OstreamLogger used before the
+//!     background logger
+//!   - sync: ReAsyncLogger without its writer thread
+//!   - async: ReAsyncLogger with its writer thread
+//!
+//! Usage:
+//!   Reality_LogBenchmark [--objects N] [--exports N] [--out file]
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+
+#include <fstream>
+#include <iostream>
+
+#include "ReAsyncLogger.h"
+
+using namespace Reality;
+
+struct BenchmarkParams {
+  int numObjects;
+  int numExports;
+  QString logFileName;
+
+  BenchmarkParams() :
+    numObjects(2000),
+    numExports(20)
+  {
+  }
+};
+
+enum LogMode {
+  Disabled,
+  Cpplog,
+  Sync,
+  Async
+};
+
+//! Returns the average time of one log call, in nanoseconds
+static double runLog( const BenchmarkParams& params, const LogMode mode ) {
+  std::ofstream out(params.logFileName.toUtf8(), std::ios::trunc);
+  cpplog::OstreamLogger cpplogLogger(out);
+  ReAsyncLogger asyncLogger(out);
+  cpplog::BaseLogger& logger = (mode == Cpplog ?
+                                  static_cast<cpplog::BaseLogger&>(cpplogLogger) :
+                                  static_cast<cpplog::BaseLogger&>(asyncLogger));
+
+  QStringList objNames;
+  for (int i = 0; i < params.numObjects; i++) {
+    objNames << QString("Figure_%1").arg(i);
+  }
+
+  qint64 elapsed = 0;
+  QElapsedTimer timer;
+  for (int e = 0; e < params.numExports; e++) {
+    if (mode == Async) {
+      asyncLogger.start();
+    }
+    timer.start();
+    if (mode == Disabled) {
+      for (int i = 0; i < params.numObjects; i++) {
+        // This is what the RE_LOG macros expand to when the level is
+        // filtered out
+        LOG_NOTHING(LL_INFO, logger) << "Exporting object " << QSS(objNames[i]);
+      }
+    }
+    else {
+      for (int i = 0; i < params.numObjects; i++) {
+        LOG_INFO(logger) << "Exporting object " << QSS(objNames[i]);
+      }
+    }
+    elapsed += timer.nsecsElapsed();
+    // The writer drains the ring between exports, outside of the timing
+    if (mode == Async) {
+      asyncLogger.stop();
+    }
+  }
+  out.close();
+  return static_cast<double>(elapsed) / (params.numExports * params.numObjects);
+}
+
+int main( int argc, char** argv ) {
+  QCoreApplication app(argc, argv);
+  BenchmarkParams params;
+  params.logFileName = QDir::temp().absoluteFilePath("RealityLogBenchmark.txt");
+
+  QStringList args = app.arguments();
+  for (int i = 1; i < args.count(); i++) {
+    QString arg = args[i];
+    QString value = args.value(i+1);
+    if (arg == "--objects") {
+      params.numObjects = value.toInt(); i++;
+    }
+    else if (arg == "--exports") {
+      params.numExports = value.toInt(); i++;
+    }
+    else if (arg == "--out") {
+      params.logFileName = value; i++;
+    }
+    else {
+      std::cerr << "Unknown option: " << QSS(arg) << std::endl;
+      return 2;
+    }
+  }
+
+  std::cout << "Log benchmark: " << params.numExports << " exports x "
+            << params.numObjects << " objects" << std::endl;
+  std::cout << "  disabled: " << runLog(params, Disabled) << " ns/call" << std::endl;
+  std::cout << "  cpplog:   " << runLog(params, Cpplog)   << " ns/call" << std::endl;
+  std::cout << "  sync:     " << runLog(params, Sync)     << " ns/call" << std::endl;
+  std::cout << "  async:    " << runLog(params, Async)    << " ns/call" << std::endl;
+  QFile::remove(params.logFileName);
+  return 0;
+}
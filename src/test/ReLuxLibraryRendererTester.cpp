@@ -0,0 +1,103 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+//! Tests of the rendering of the previews with the Lux library. The
+//! library is replaced by the stub in LuxStub.cpp
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <thread>
+
+#include <QTime>
+
+#include "LuxApi.h"
+#include "ReLuxLibraryRenderer.h"
+
+using namespace Reality;
+
+static QByteArray stubScene( const int width, const int height, const int haltSpp ) {
+  return QString(
+           "Film \"fleximage\"\n"
+           " \"integer xresolution\" [%1]\n"
+           " \"integer yresolution\" [%2]\n"
+           " \"integer haltspp\" [%3]\n"
+           "WorldBegin\n"
+           "WorldEnd\n"
+         ).arg(width).arg(height).arg(haltSpp).toUtf8();
+}
+
+//! Waits for the end of the rendering, at most timeOut milliseconds
+static bool waitForRenderer( ReLuxLibraryRenderer& renderer, const int timeOut ) {
+  QTime clock;
+  clock.start();
+  while (!renderer.isDone()) {
+    if (clock.elapsed() > timeOut) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return true;
+}
+
+struct LuxStubFixture {
+  LuxStubFixture() {
+    LuxLibraryLoader::loadLuxLibrary(RE_LUX_STUB_LIBRARY);
+  }
+};
+
+BOOST_FIXTURE_TEST_CASE(test_LuxLibraryRender, LuxStubFixture) {
+  BOOST_REQUIRE(ReLuxLibraryRenderer::isAvailable());
+
+  ReLuxLibraryRenderer renderer;
+  BOOST_REQUIRE(renderer.start(stubScene(8, 4, 5)));
+  BOOST_REQUIRE(waitForRenderer(renderer, 5000));
+  BOOST_CHECK_EQUAL(renderer.getSamplesPerPixel(), 5.0);
+
+  QByteArray frameBuffer;
+  BOOST_REQUIRE(renderer.getFrameBuffer(frameBuffer, 8*4*3));
+  BOOST_REQUIRE_EQUAL(frameBuffer.size(), 8*4*3);
+  // Pixel (7, 3), fully rendered
+  const uchar* pixel = reinterpret_cast<const uchar*>(frameBuffer.constData()) + (3*8 + 7)*3;
+  BOOST_CHECK_EQUAL(pixel[0], 7);
+  BOOST_CHECK_EQUAL(pixel[1], 3);
+  BOOST_CHECK_EQUAL(pixel[2], 255);
+
+  // The frame buffer is not copied if its size is not the expected one
+  BOOST_REQUIRE(renderer.start(stubScene(8, 4, 1)));
+  BOOST_REQUIRE(waitForRenderer(renderer, 5000));
+  BOOST_CHECK(!renderer.getFrameBuffer(frameBuffer, 4*4*3));
+  BOOST_CHECK(frameBuffer.isEmpty());
+
+  // A scene that Lux can't parse
+  BOOST_REQUIRE(renderer.start("WorldBegin\n"));
+  BOOST_REQUIRE(waitForRenderer(renderer, 5000));
+  BOOST_CHECK(!renderer.getFrameBuffer(frameBuffer, 8*4*3));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_LuxLibraryAbort, LuxStubFixture) {
+  BOOST_REQUIRE(ReLuxLibraryRenderer::isAvailable());
+
+  ReLuxLibraryRenderer renderer;
+  // About 200 seconds with the stub
+  BOOST_REQUIRE(renderer.start(stubScene(8, 8, 100000)));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  BOOST_CHECK(!renderer.isDone());
+  QTime clock;
+  clock.start();
+  renderer.abort();
+  BOOST_CHECK(clock.elapsed() < 5000);
+  BOOST_CHECK(renderer.isDone());
+
+  // The renderer can be used again, also when the rendering is stopped
+  // before it starts
+  BOOST_REQUIRE(renderer.start(stubScene(8, 8, 100000)));
+  renderer.abort();
+  BOOST_REQUIRE(renderer.start(stubScene(2, 2, 2)));
+  BOOST_REQUIRE(waitForRenderer(renderer, 5000));
+  QByteArray frameBuffer;
+  BOOST_CHECK(renderer.getFrameBuffer(frameBuffer, 2*2*3));
+}
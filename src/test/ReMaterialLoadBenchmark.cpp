@@ -0,0 +1,265 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+//! Benchmark of the conversion of materials during the load of a scene.
+//!
+//! Generates the JSON data for a number of objects, each one with a number
+//! of materials that use a small network of image maps, mix and math nodes,
+//! the same format sent by the host-side plugins. The materials are then
+//! converted by ReMaterialBatchConverter with an increasing number of
+//! threads, from one up to the number of cores, and the speed-up relative
+//! to the single thread run is reported. The program returns 1 when the
+//! speed-up with all the cores is lower than the value passed with
+//! --min-speedup, so that it can be used as a regression test.
+//!
+//! Usage:
+//!   Reality_MaterialLoadBenchmark [--objects N] [--materials N]
+//!                                 [--threads N] [--min-speedup X]
+//!                                 [--results file]
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QJson/Parser>
+#include <QJson/Serializer>
+
+#include <iostream>
+
+#include "RealityBase.h"
+#include "ReAcsel.h"
+#include "ReGeometryObject.h"
+#include "ReMaterialBatchConverter.h"
+#include "ReMaterialPropertyKeys.h"
+#include "ReNodeConverter.h"
+#include "ReSceneData.h"
+#include "ReSceneDataGlobal.h"
+
+using namespace Reality;
+
+struct BenchmarkParams {
+  int numObjects;
+  int numMaterials;
+  int maxThreads;
+
+  BenchmarkParams() :
+    numObjects(40),
+    numMaterials(30),
+    maxThreads(QThread::idealThreadCount())
+  {
+  }
+};
+
+static QVariantList makeColor( const double r, const double g, const double b ) {
+  QVariantList color;
+  color << r << g << b;
+  return color;
+}
+
+static QVariantMap makeImageMap( const QString& fileName ) {
+  QVariantMap node;
+  node["type"]     = ReNodeConverter::ImageMap;
+  node["fileName"] = fileName;
+  node["u tile"]   = 1.0;
+  node["v tile"]   = 1.0;
+  node["u offset"] = 0.0;
+  node["v offset"] = 0.0;
+  node["gain"]     = 1.0;
+  return node;
+}
+
+static QVariantMap makeChannel( const QVariantList& color, const QString& map ) {
+  QVariantMap channel;
+  channel["color"] = color;
+  channel["map"]   = map;
+  return channel;
+}
+
+//! Returns the JSON for a material similar to the ones of a figure
+static QByteArray makeMaterialJSON( const int objNo, const int matNo ) {
+  QString prefix = QString("/Runtime/Textures/Figure_%1/Mat_%2").arg(objNo).arg(matNo);
+  QVariantMap nodes;
+  nodes["diffuse"]  = makeImageMap(prefix + "_D.jpg");
+  nodes["detail"]   = makeImageMap(prefix + "_Detail.jpg");
+  nodes["specular"] = makeImageMap(prefix + "_S.jpg");
+  nodes["bump"]     = makeImageMap(prefix + "_B.jpg");
+
+  QVariantMap mix;
+  mix["type"]       = ReNodeConverter::Mix;
+  mix["tex1 color"] = makeColor(1, 1, 1);
+  mix["tex1 map"]   = "diffuse";
+  mix["tex2 color"] = makeColor(0.9, 0.8, 0.7);
+  mix["tex2 map"]   = "detail";
+  mix["mix"]        = 0.3;
+  mix["mix map"]    = "bump";
+  nodes["diffuseMix"] = mix;
+
+  QVariantMap value1, value2, math;
+  value1["map"]   = "specular";
+  value1["value"] = 0.8;
+  value2["map"]   = "bump";
+  value2["value"] = 0.5;
+  math["type"]     = ReNodeConverter::Math;
+  math["function"] = "m";
+  math["value 1"]  = value1;
+  math["value 2"]  = value2;
+  nodes["specularMath"] = math;
+
+  QVariantMap bump;
+  bump["map"]      = "bump";
+  bump["strength"] = 0.2;
+  bump["pos"]      = 0.001;
+  bump["neg"]      = -0.001;
+
+  QVariantMap alpha;
+  alpha["strength"] = 1.0;
+  alpha["map"]      = "";
+
+  QVariantMap mat;
+  mat["name"]                   = QString("Mat_%1").arg(matNo);
+  mat["type"]                   = RE_MAT_TYPE_CODE_UNDEFINED;
+  mat["source"]                 = "";
+  mat[RE_MAT_KEY_NODES_ROOT]    = nodes;
+  mat[RE_MAT_KEY_DIFFUSE]       = makeChannel(makeColor(0.95, 0.9, 0.85), "diffuseMix");
+  mat[RE_MAT_KEY_SPECULAR]      = makeChannel(makeColor(1, 1, 1), "specularMath");
+  mat[RE_MAT_KEY_SPECULAR2]     = makeChannel(makeColor(0, 0, 0), "");
+  mat[RE_MAT_KEY_COAT]          = makeChannel(makeColor(1, 1, 1), "");
+  mat[RE_MAT_KEY_TRANSLUCENCE]  = makeChannel(makeColor(0, 0, 0), "");
+  mat[RE_MAT_KEY_AMBIENT]       = makeChannel(makeColor(0, 0, 0), "");
+  mat[RE_MAT_KEY_BUMP]          = bump;
+  mat[RE_MAT_KEY_ALPHA]         = alpha;
+  mat[RE_MAT_KEY_UROUGHNESS]    = 0.3;
+  mat[RE_MAT_KEY_VROUGHNESS]    = 0.3;
+  mat[RE_MAT_KEY_LIGHT_GAIN]    = 0.0;
+
+  QJson::Serializer json;
+  return json.serialize(mat);
+}
+
+//! Converts all the materials with the given number of threads and
+//! returns the elapsed time in milliseconds
+static qint64 runLoad( const BenchmarkParams& params,
+                       const QList<QVariantMap>& materials,
+                       const int numThreads )
+{
+  RealitySceneData->newScene();
+  ReMaterialBatchConverter batch;
+  batch.setMaxThreads(numThreads);
+
+  QElapsedTimer timer;
+  timer.start();
+  // The scene data writes the original shaders to ACSEL. Like in a real
+  // scene load all the writes are done in one transaction
+  ReAcsel::getInstance()->startCaching();
+  for (int i = 0; i < params.numObjects; i++) {
+    QString objID = QString("MaterialLoadBenchmark_%1").arg(i);
+    RealitySceneData->addObject(objID, objID, objID);
+    for (int m = 0; m < params.numMaterials; m++) {
+      batch.addMaterial(
+        objID, QString("Mat_%1").arg(m), materials[i*params.numMaterials+m]
+      );
+    }
+  }
+  batch.convert();
+  ReAcsel::getInstance()->stopCaching();
+  return timer.elapsed();
+}
+
+static bool writeJSON( const QString& fileName, const QVariantMap& data ) {
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  QJson::Serializer json;
+  json.setIndentMode(QJson::IndentFull);
+  return file.write(json.serialize(data)) != -1;
+}
+
+int main( int argc, char** argv ) {
+  QCoreApplication app(argc, argv);
+  BenchmarkParams params;
+  QString resultsFileName;
+  double minSpeedup = 0;
+
+  QStringList args = app.arguments();
+  for (int i = 1; i < args.count(); i++) {
+    QString arg = args[i];
+    QString value = args.value(i+1);
+    if (arg == "--objects") {
+      params.numObjects = value.toInt(); i++;
+    }
+    else if (arg == "--materials") {
+      params.numMaterials = value.toInt(); i++;
+    }
+    else if (arg == "--threads") {
+      params.maxThreads = value.toInt(); i++;
+    }
+    else if (arg == "--min-speedup") {
+      minSpeedup = value.toDouble(); i++;
+    }
+    else if (arg == "--results") {
+      resultsFileName = value; i++;
+    }
+    else {
+      std::cerr << "Unknown option: " << QSS(arg) << std::endl;
+      return 2;
+    }
+  }
+
+  RealityBase::getRealityBase();
+  // No IPC with the GUI
+  RealitySceneData->setGUIMode(true);
+
+  // The host plugins send the data already parsed, so the parsing is
+  // not part of the timing
+  QJson::Parser parser;
+  QList<QVariantMap> materials;
+  for (int i = 0; i < params.numObjects; i++) {
+    for (int m = 0; m < params.numMaterials; m++) {
+      materials << parser.parse(makeMaterialJSON(i, m)).toMap();
+    }
+  }
+
+  std::cout << "Material load benchmark: " << params.numObjects << " objects x "
+            << params.numMaterials << " materials" << std::endl;
+
+  // Warm-up run, it opens the ACSEL database
+  runLoad(params, materials, 1);
+
+  // Powers of two up to the number of threads requested, which is always
+  // the last run
+  QList<int> threadCounts;
+  for (int n = 1; n < params.maxThreads; n *= 2) {
+    threadCounts << n;
+  }
+  threadCounts << qMax(params.maxThreads, 1);
+
+  QVariantMap results;
+  qint64 serialTime = 0;
+  double speedup = 1.0;
+  foreach(int numThreads, threadCounts) {
+    qint64 elapsed = runLoad(params, materials, numThreads);
+    if (numThreads == 1) {
+      serialTime = elapsed;
+    }
+    speedup = elapsed ? static_cast<double>(serialTime) / elapsed : 1.0;
+    QVariantMap r;
+    r["ms"]      = elapsed;
+    r["speedup"] = speedup;
+    results[QString::number(numThreads)] = r;
+    std::cout << "  " << numThreads << " threads: " << elapsed << " ms, speed-up "
+              << speedup << "x" << std::endl;
+  }
+  RealitySceneData->newScene();
+
+  if (!resultsFileName.isEmpty()) {
+    writeJSON(resultsFileName, results);
+  }
+  if (speedup < minSpeedup) {
+    std::cout << "Speed-up lower than " << minSpeedup << "x" << std::endl;
+    return 1;
+  }
+  return 0;
+}
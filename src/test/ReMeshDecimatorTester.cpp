@@ -0,0 +1,140 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+//! Tests of the decimation of the meshes that are small in the frame
+
+#include <boost/test/unit_test.hpp>
+
+#include <math.h>
+
+#include <QVector>
+
+#include "ReMeshDecimator.h"
+
+using namespace Reality;
+
+#define RE_DECIMATOR_TEST_SIZE 32
+
+/**
+ * A grid of size x size quads on the unit square of the XY plane. If
+ * withSeam is true the column of vertices in the middle is duplicated, as
+ * the host apps do along the UV seams. The height of the vertices is
+ * given by bump * sin(6x) * sin(6y).
+ */
+static void setGrid( ReMeshDecimator& decimator, const bool withSeam, const float bump ) {
+  const int size = RE_DECIMATOR_TEST_SIZE;
+  QVector<float> verts, norms, uvs;
+  QVector<int> tris;
+  for (int j = 0; j <= size; j++) {
+    for (int i = 0; i <= size; i++) {
+      float x = static_cast<float>(i) / size;
+      float y = static_cast<float>(j) / size;
+      verts << x << y << bump * sin(x*6) * sin(y*6);
+      norms << 0 << 0 << 1;
+      uvs << x << y;
+    }
+  }
+  int seamBase = verts.count() / 3;
+  if (withSeam) {
+    for (int j = 0; j <= size; j++) {
+      int v = j * (size+1) + size/2;
+      verts << verts[v*3] << verts[v*3 + 1] << verts[v*3 + 2];
+      norms << 0 << 0 << 1;
+      uvs << 0.5f << uvs[v*2 + 1];
+    }
+  }
+  for (int j = 0; j < size; j++) {
+    for (int i = 0; i < size; i++) {
+      int a = j * (size+1) + i;
+      int b = a + 1;
+      int c = b + size + 1;
+      int d = a + size + 1;
+      if (withSeam && i == size/2) {
+        a = seamBase + j;
+        d = seamBase + j + 1;
+      }
+      tris << a << b << c << a << c << d;
+    }
+  }
+  decimator.setMesh(verts.count() / 3,
+                    reinterpret_cast<const ReVectorF*>(verts.constData()),
+                    reinterpret_cast<const ReVectorF*>(norms.constData()),
+                    reinterpret_cast<const ReUVPoint*>(uvs.constData()),
+                    tris.count() / 3,
+                    reinterpret_cast<const ReTriangle*>(tris.constData()));
+}
+
+//! Returns the area of the mesh projected on the XY plane. Flipped faces
+//! count as negative.
+static double projectedArea( ReMeshDecimator& decimator ) {
+  double area = 0.0;
+  ReVectorF* v = decimator.getVertices();
+  ReTriangle* t = decimator.getTriangles();
+  for (int f = 0; f < decimator.getNumTriangles(); f++) {
+    float* a = v[t[f].a[0]];
+    float* b = v[t[f].a[1]];
+    float* c = v[t[f].a[2]];
+    area += ((b[0]-a[0]) * (c[1]-a[1]) - (b[1]-a[1]) * (c[0]-a[0])) / 2.0;
+  }
+  return area;
+}
+
+BOOST_AUTO_TEST_CASE(test_DecimatorFlatMesh) {
+  ReMeshDecimator decimator;
+  setGrid(decimator, false, 0.0f);
+  int numTriangles = decimator.getNumTriangles();
+  int removed = decimator.decimate(1e-5f, 0);
+  BOOST_CHECK(removed > numTriangles / 2);
+  BOOST_CHECK_EQUAL(decimator.getNumTriangles(), numTriangles - removed);
+  BOOST_CHECK_CLOSE(projectedArea(decimator), 1.0, 0.001);
+
+  // The boundary of the mesh is kept
+  int boundaryVertices = 0;
+  ReVectorF* v = decimator.getVertices();
+  for (int i = 0; i < decimator.getNumVertices(); i++) {
+    if (v[i][0] == 0.0f || v[i][0] == 1.0f || v[i][1] == 0.0f || v[i][1] == 1.0f) {
+      boundaryVertices++;
+    }
+  }
+  BOOST_CHECK_EQUAL(boundaryVertices, RE_DECIMATOR_TEST_SIZE * 4);
+}
+
+BOOST_AUTO_TEST_CASE(test_DecimatorError) {
+  ReMeshDecimator decimator;
+  setGrid(decimator, false, 0.05f);
+  int numTriangles = decimator.getNumTriangles();
+
+  // A curved surface is not decimated with no tolerance
+  BOOST_CHECK_EQUAL(decimator.decimate(0.0f, 0), 0);
+
+  int removed = decimator.decimate(0.002f, 0);
+  BOOST_CHECK(removed > 0);
+  BOOST_CHECK(removed < numTriangles);
+  // No face has been flipped
+  BOOST_CHECK_CLOSE(projectedArea(decimator), 1.0, 0.001);
+
+  // The minimum number of triangles is respected
+  setGrid(decimator, false, 0.05f);
+  decimator.decimate(1.0f, 1000);
+  BOOST_CHECK(decimator.getNumTriangles() >= 1000);
+}
+
+BOOST_AUTO_TEST_CASE(test_DecimatorSeams) {
+  ReMeshDecimator decimator;
+  setGrid(decimator, true, 0.0f);
+  decimator.decimate(1e-5f, 0);
+  BOOST_CHECK_CLOSE(projectedArea(decimator), 1.0, 0.001);
+
+  // Both copies of every vertex of the seam are still there
+  int seamVertices = 0;
+  ReVectorF* v = decimator.getVertices();
+  for (int i = 0; i < decimator.getNumVertices(); i++) {
+    if (v[i][0] == 0.5f) {
+      seamVertices++;
+    }
+  }
+  BOOST_CHECK_EQUAL(seamVertices, (RE_DECIMATOR_TEST_SIZE + 1) * 2);
+}
@@ -0,0 +1,187 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+//! Tests of the reordering of the exported meshes for locality
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include <QVector>
+
+#include "ReMeshOptimizer.h"
+
+using namespace Reality;
+
+#define RE_OPTIMIZER_TEST_SIZE 48
+
+//! A simple generator, so that the shuffled meshes are the same on every
+//! platform
+static int nextRandom( quint32& seed, const int range ) {
+  seed = seed * 1664525u + 1013904223u;
+  return static_cast<int>((seed >> 8) % static_cast<quint32>(range));
+}
+
+/**
+ * A grid on the XY plane with the triangles and the vertices in random
+ * order, as they can come from the facets of a host app. One vertex is
+ * not used by any triangle.
+ */
+static void setShuffledGrid( ReMeshOptimizer& optimizer ) {
+  const int size = RE_OPTIMIZER_TEST_SIZE;
+  int numVertices = (size+1) * (size+1) + 1;
+  QVector<int> vertexOrder(numVertices);
+  for (int i = 0; i < numVertices; i++) {
+    vertexOrder[i] = i;
+  }
+  quint32 seed = 1;
+  for (int i = numVertices - 1; i > 0; i--) {
+    std::swap(vertexOrder[i], vertexOrder[nextRandom(seed, i + 1)]);
+  }
+  QVector<float> verts(numVertices*3), norms(numVertices*3), uvs(numVertices*2);
+  for (int v = 0; v < numVertices; v++) {
+    float x = static_cast<float>(v % (size+1)) / size;
+    float y = static_cast<float>(v / (size+1)) / size;
+    int i = vertexOrder[v];
+    verts[i*3] = x; verts[i*3 + 1] = y; verts[i*3 + 2] = x * y;
+    norms[i*3] = 0; norms[i*3 + 1] = 0; norms[i*3 + 2] = 1;
+    uvs[i*2] = x; uvs[i*2 + 1] = y;
+  }
+  QVector<int> tris;
+  for (int j = 0; j < size; j++) {
+    for (int i = 0; i < size; i++) {
+      int a = vertexOrder[j * (size+1) + i];
+      int b = vertexOrder[j * (size+1) + i + 1];
+      int c = vertexOrder[(j+1) * (size+1) + i + 1];
+      int d = vertexOrder[(j+1) * (size+1) + i];
+      tris << a << b << c << a << c << d;
+    }
+  }
+  int numTriangles = tris.count() / 3;
+  for (int i = numTriangles - 1; i > 0; i--) {
+    int j = nextRandom(seed, i + 1);
+    for (int k = 0; k < 3; k++) {
+      std::swap(tris[i*3 + k], tris[j*3 + k]);
+    }
+  }
+  optimizer.setMesh(numVertices,
+                    reinterpret_cast<const ReVectorF*>(verts.constData()),
+                    reinterpret_cast<const ReVectorF*>(norms.constData()),
+                    reinterpret_cast<const ReUVPoint*>(uvs.constData()),
+                    numTriangles,
+                    reinterpret_cast<const ReTriangle*>(tris.constData()));
+}
+
+/**
+ * Returns each triangle as the list of the attributes of its corners,
+ * starting from the smallest corner so that the winding is preserved,
+ * and the triangles sorted. Two meshes with the same geometry return the
+ * same list.
+ */
+static std::vector< std::vector<float> > getTriangleSet( ReMeshOptimizer& optimizer ) {
+  std::vector< std::vector<float> > triSet;
+  ReVectorF* v  = optimizer.getVertices();
+  ReVectorF* n  = optimizer.getNormals();
+  ReUVPoint* uv = optimizer.getUVs();
+  ReTriangle* t = optimizer.getTriangles();
+  for (int f = 0; f < optimizer.getNumTriangles(); f++) {
+    std::vector<float> corners[3];
+    for (int k = 0; k < 3; k++) {
+      int i = t[f].a[k];
+      float attributes[8] = { v[i][0], v[i][1], v[i][2], 
+                              n[i][0], n[i][1], n[i][2], 
+                              uv[i][0], uv[i][1] };
+      corners[k].assign(attributes, attributes + 8);
+    }
+    int first = 0;
+    for (int k = 1; k < 3; k++) {
+      if (corners[k] < corners[first]) {
+        first = k;
+      }
+    }
+    std::vector<float> tri;
+    for (int k = 0; k < 3; k++) {
+      const std::vector<float>& c = corners[(first + k) % 3];
+      tri.insert(tri.end(), c.begin(), c.end());
+    }
+    triSet.push_back(tri);
+  }
+  std::sort(triSet.begin(), triSet.end());
+  return triSet;
+}
+
+static float getACMR( ReMeshOptimizer& optimizer ) {
+  return ReMeshOptimizer::getACMR(
+           reinterpret_cast<const int*>(optimizer.getTriangles()),
+           optimizer.getNumTriangles(),
+           RE_MESH_OPTIMIZER_CACHE_SIZE
+         );
+}
+
+BOOST_AUTO_TEST_CASE(test_MeshOptimizerACMR) {
+  // Every vertex of a single triangle is a miss
+  int tri[6] = { 0, 1, 2, 2, 1, 3 };
+  BOOST_CHECK_CLOSE(ReMeshOptimizer::getACMR(tri, 1, 16), 3.0f, 0.001);
+  BOOST_CHECK_CLOSE(ReMeshOptimizer::getACMR(tri, 2, 16), 2.0f, 0.001);
+  // With one entry the shared vertices are evicted
+  BOOST_CHECK_CLOSE(ReMeshOptimizer::getACMR(tri, 2, 1), 3.0f, 0.001);
+}
+
+BOOST_AUTO_TEST_CASE(test_MeshOptimizerOrder) {
+  ReMeshOptimizer optimizer;
+  setShuffledGrid(optimizer);
+  std::vector< std::vector<float> > original = getTriangleSet(optimizer);
+  float originalACMR = getACMR(optimizer);
+  int numVertices = optimizer.getNumVertices();
+
+  optimizer.optimize();
+  BOOST_CHECK_EQUAL(optimizer.getNumVertices(), numVertices);
+  BOOST_CHECK(getTriangleSet(optimizer) == original);
+  float optimizedACMR = getACMR(optimizer);
+  BOOST_CHECK(optimizedACMR < 1.0f);
+  BOOST_CHECK(optimizedACMR < originalACMR / 2);
+
+  // The vertices are numbered in the order of first use
+  int nextIndex = 0;
+  bool firstUse = true;
+  ReTriangle* t = optimizer.getTriangles();
+  for (int f = 0; f < optimizer.getNumTriangles(); f++) {
+    for (int k = 0; k < 3; k++) {
+      if (t[f].a[k] > nextIndex) {
+        firstUse = false;
+      }
+      else if (t[f].a[k] == nextIndex) {
+        nextIndex++;
+      }
+    }
+  }
+  BOOST_CHECK(firstUse);
+  // Only the unused vertex is left at the end
+  BOOST_CHECK_EQUAL(nextIndex, numVertices - 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_MeshOptimizerMorton) {
+  ReMeshOptimizer optimizer;
+  setShuffledGrid(optimizer);
+  std::vector< std::vector<float> > original = getTriangleSet(optimizer);
+
+  optimizer.setMortonOrder(true);
+  optimizer.optimize();
+  BOOST_CHECK(getTriangleSet(optimizer) == original);
+  BOOST_CHECK(getACMR(optimizer) < 1.0f);
+
+  // The result doesn't depend on the number of threads
+  ReMeshOptimizer single;
+  setShuffledGrid(single);
+  single.setMortonOrder(true);
+  single.setMaxThreads(1);
+  single.optimize();
+  BOOST_CHECK(std::equal(reinterpret_cast<int*>(single.getTriangles()),
+                         reinterpret_cast<int*>(single.getTriangles()) + 
+                           single.getNumTriangles() * 3,
+                         reinterpret_cast<int*>(optimizer.getTriangles())));
+}
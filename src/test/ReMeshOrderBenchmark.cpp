@@ -0,0 +1,320 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+//! Benchmark of the reordering of the exported meshes for locality.
+//!
+//! Builds a large bumpy grid with the triangles and the vertices in random
+//! order, like the meshes of a figure with many facets, and writes it as a
+//! binary PLY file three times: in the original order, reordered by
+//! ReMeshOptimizer and reordered following a Morton curve. For each file
+//! the benchmark reports the time spent in the optimization, the average
+//! vertex cache miss rate and the time to load the file as the renderer
+//! does: the PLY is parsed and the bounding box of every triangle is
+//! computed from its vertices, which is the first step of the
+//! construction of the acceleration structure. The program returns 1 if
+//! a reordered mesh doesn't have the same triangles as the original.
+//!
+//! Usage:
+//!   Reality_MeshOrderBenchmark [--triangles N] [--repeat N] [--out dir]
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QVector>
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <iostream>
+
+#include "ReMeshOptimizer.h"
+#include "ply/rply.h"
+
+using namespace Reality;
+
+struct BenchmarkParams {
+  int numTriangles;
+  int numRepeats;
+  QString outDir;
+
+  BenchmarkParams() :
+    numTriangles(2000000),
+    numRepeats(3),
+    outDir(QDir::tempPath())
+  {
+  }
+};
+
+//! The mesh read back from a PLY file
+struct ReLoadedMesh {
+  QVector<float> vertices;
+  QVector<int> triangles;
+  int vertexCount;
+  int indexCount;
+};
+
+//! A triangle as the positions of its corners, starting from the smallest
+//! corner so that two meshes with the same geometry can be compared
+struct ReTriangleKey {
+  float c[9];
+
+  bool operator<( const ReTriangleKey& other ) const {
+    return memcmp(c, other.c, sizeof(c)) < 0;
+  }
+
+  bool operator==( const ReTriangleKey& other ) const {
+    return memcmp(c, other.c, sizeof(c)) == 0;
+  }
+};
+
+static quint32 nextRandom( quint32& seed ) {
+  seed = seed * 1664525u + 1013904223u;
+  return seed >> 8;
+}
+
+//! Builds a grid with at least numTriangles triangles, shuffled
+static void makeMesh( const int numTriangles, ReMeshOptimizer& optimizer ) {
+  int size = static_cast<int>(sqrt(numTriangles / 2.0)) + 1;
+  int numVertices = (size+1) * (size+1);
+  QVector<int> vertexOrder(numVertices);
+  for (int i = 0; i < numVertices; i++) {
+    vertexOrder[i] = i;
+  }
+  quint32 seed = 7;
+  for (int i = numVertices - 1; i > 0; i--) {
+    std::swap(vertexOrder[i], vertexOrder[nextRandom(seed) % (i + 1)]);
+  }
+  QVector<float> verts(numVertices*3), norms(numVertices*3), uvs(numVertices*2);
+  for (int v = 0; v < numVertices; v++) {
+    float x = static_cast<float>(v % (size+1)) / size;
+    float y = static_cast<float>(v / (size+1)) / size;
+    int i = vertexOrder[v];
+    verts[i*3] = x; verts[i*3 + 1] = y; verts[i*3 + 2] = 0.05f * sin(x*20) * sin(y*20);
+    norms[i*3] = 0; norms[i*3 + 1] = 0; norms[i*3 + 2] = 1;
+    uvs[i*2] = x; uvs[i*2 + 1] = y;
+  }
+  QVector<int> tris;
+  tris.reserve(size * size * 6);
+  for (int j = 0; j < size; j++) {
+    for (int i = 0; i < size; i++) {
+      int a = vertexOrder[j * (size+1) + i];
+      int b = vertexOrder[j * (size+1) + i + 1];
+      int c = vertexOrder[(j+1) * (size+1) + i + 1];
+      int d = vertexOrder[(j+1) * (size+1) + i];
+      tris << a << b << c << a << c << d;
+    }
+  }
+  int count = tris.count() / 3;
+  for (int i = count - 1; i > 0; i--) {
+    int j = nextRandom(seed) % (i + 1);
+    for (int k = 0; k < 3; k++) {
+      std::swap(tris[i*3 + k], tris[j*3 + k]);
+    }
+  }
+  optimizer.setMesh(numVertices,
+                    reinterpret_cast<const ReVectorF*>(verts.constData()),
+                    reinterpret_cast<const ReVectorF*>(norms.constData()),
+                    reinterpret_cast<const ReUVPoint*>(uvs.constData()),
+                    count,
+                    reinterpret_cast<const ReTriangle*>(tris.constData()));
+}
+
+//! Writes the mesh with the same layout used by the Lux exporter
+static void writePLY( const QString& fileName, ReMeshOptimizer& optimizer ) {
+  p_ply plyFile = ply_create(fileName.toUtf8(), PLY_LITTLE_ENDIAN, NULL);
+  ply_add_element(plyFile, "vertex", optimizer.getNumVertices());
+  ply_add_scalar_property(plyFile, "x",  PLY_FLOAT);
+  ply_add_scalar_property(plyFile, "y",  PLY_FLOAT);
+  ply_add_scalar_property(plyFile, "z",  PLY_FLOAT);
+  ply_add_scalar_property(plyFile, "nx", PLY_FLOAT);
+  ply_add_scalar_property(plyFile, "ny", PLY_FLOAT);
+  ply_add_scalar_property(plyFile, "nz", PLY_FLOAT);
+  ply_add_scalar_property(plyFile, "s",  PLY_FLOAT);
+  ply_add_scalar_property(plyFile, "t",  PLY_FLOAT);
+  ply_add_element(plyFile, "face", optimizer.getNumTriangles());
+  ply_add_list_property(plyFile, "vertex_indices", PLY_UCHAR, PLY_UINT);
+  ply_write_header(plyFile);
+
+  ReVectorF* v  = optimizer.getVertices();
+  ReVectorF* n  = optimizer.getNormals();
+  ReUVPoint* uv = optimizer.getUVs();
+  for (int i = 0; i < optimizer.getNumVertices(); i++) {
+    ply_write(plyFile, v[i][0]);
+    ply_write(plyFile, v[i][1]);
+    ply_write(plyFile, v[i][2]);
+    ply_write(plyFile, n[i][0]);
+    ply_write(plyFile, n[i][1]);
+    ply_write(plyFile, n[i][2]);
+    ply_write(plyFile, uv[i][0]);
+    ply_write(plyFile, uv[i][1]);
+  }
+  ReTriangle* t = optimizer.getTriangles();
+  for (int i = 0; i < optimizer.getNumTriangles(); i++) {
+    ply_write(plyFile, 3);
+    ply_write(plyFile, t[i].a[0]);
+    ply_write(plyFile, t[i].a[1]);
+    ply_write(plyFile, t[i].a[2]);
+  }
+  ply_close(plyFile);
+}
+
+static int readVertex( p_ply_argument argument ) {
+  void* data;
+  long coord;
+  ply_get_argument_user_data(argument, &data, &coord);
+  ReLoadedMesh* mesh = static_cast<ReLoadedMesh*>(data);
+  mesh->vertices[mesh->vertexCount++] = ply_get_argument_value(argument);
+  return 1;
+}
+
+static int readFace( p_ply_argument argument ) {
+  long length, index;
+  ply_get_argument_property(argument, NULL, &length, &index);
+  if (index < 0) {
+    return 1;
+  }
+  void* data;
+  ply_get_argument_user_data(argument, &data, NULL);
+  ReLoadedMesh* mesh = static_cast<ReLoadedMesh*>(data);
+  mesh->triangles[mesh->indexCount++] = static_cast<int>(ply_get_argument_value(argument));
+  return 1;
+}
+
+/**
+ * Loads the PLY file and computes the bounds of its triangles. Returns the
+ * time in milliseconds. The positions are read in the interleaved order of
+ * the file, so only the x, y and z are kept.
+ */
+static double loadPLY( const QString& fileName, ReLoadedMesh& mesh ) {
+  QElapsedTimer timer;
+  timer.start();
+  p_ply plyFile = ply_open(fileName.toUtf8(), NULL);
+  if (!plyFile || !ply_read_header(plyFile)) {
+    return -1.0;
+  }
+  long numVertices = ply_set_read_cb(plyFile, "vertex", "x", readVertex, &mesh, 0);
+  ply_set_read_cb(plyFile, "vertex", "y", readVertex, &mesh, 1);
+  ply_set_read_cb(plyFile, "vertex", "z", readVertex, &mesh, 2);
+  long numTriangles = ply_set_read_cb(plyFile, "face", "vertex_indices", readFace, &mesh, 0);
+  mesh.vertices.resize(numVertices * 3);
+  mesh.triangles.resize(numTriangles * 3);
+  mesh.vertexCount = 0;
+  mesh.indexCount  = 0;
+  ply_read(plyFile);
+  ply_close(plyFile);
+
+  // The bounds of each triangle, gathered through the indices
+  QVector<float> bounds(numTriangles * 6);
+  const float* v = mesh.vertices.constData();
+  const int* t   = mesh.triangles.constData();
+  for (long i = 0; i < numTriangles; i++) {
+    const float* p0 = v + t[i*3]*3;
+    const float* p1 = v + t[i*3 + 1]*3;
+    const float* p2 = v + t[i*3 + 2]*3;
+    for (int k = 0; k < 3; k++) {
+      bounds[i*6 + k]     = qMin(p0[k], qMin(p1[k], p2[k]));
+      bounds[i*6 + 3 + k] = qMax(p0[k], qMax(p1[k], p2[k]));
+    }
+  }
+  return timer.nsecsElapsed() / 1000000.0;
+}
+
+static void getTriangleKeys( const ReLoadedMesh& mesh, QVector<ReTriangleKey>& keys ) {
+  int numTriangles = mesh.triangles.count() / 3;
+  keys.resize(numTriangles);
+  for (int i = 0; i < numTriangles; i++) {
+    const int* t = mesh.triangles.constData() + i*3;
+    int first = 0;
+    for (int k = 1; k < 3; k++) {
+      if (memcmp(&mesh.vertices[t[k]*3], &mesh.vertices[t[first]*3], sizeof(float)*3) < 0) {
+        first = k;
+      }
+    }
+    for (int k = 0; k < 3; k++) {
+      memcpy(keys[i].c + k*3, &mesh.vertices[t[(first + k) % 3]*3], sizeof(float)*3);
+    }
+  }
+  std::sort(keys.begin(), keys.end());
+}
+
+int main( int argc, char** argv ) {
+  QCoreApplication app(argc, argv);
+  BenchmarkParams params;
+
+  QStringList args = app.arguments();
+  for (int i = 1; i < args.count(); i++) {
+    QString arg = args[i];
+    QString value = args.value(i+1);
+    if (arg == "--triangles") {
+      params.numTriangles = value.toInt(); i++;
+    }
+    else if (arg == "--repeat") {
+      params.numRepeats = value.toInt(); i++;
+    }
+    else if (arg == "--out") {
+      params.outDir = value; i++;
+    }
+    else {
+      std::cerr << "Unknown option: " << arg.toStdString() << std::endl;
+      return 2;
+    }
+  }
+
+  const char* variants[3] = { "original", "optimized", "morton" };
+  QVector<ReTriangleKey> originalKeys;
+  bool sameGeometry = true;
+  std::cout << "Mesh order benchmark" << std::endl;
+  for (int variant = 0; variant < 3; variant++) {
+    ReMeshOptimizer optimizer;
+    makeMesh(params.numTriangles, optimizer);
+    double optimizeTime = 0.0;
+    if (variant > 0) {
+      optimizer.setMortonOrder(variant == 2);
+      QElapsedTimer timer;
+      timer.start();
+      optimizer.optimize();
+      optimizeTime = timer.nsecsElapsed() / 1000000.0;
+    }
+    float acmr = ReMeshOptimizer::getACMR(
+                   reinterpret_cast<const int*>(optimizer.getTriangles()),
+                   optimizer.getNumTriangles(),
+                   RE_MESH_OPTIMIZER_CACHE_SIZE
+                 );
+    QString fileName = QString("%1/mesh_order_%2.ply").arg(params.outDir).arg(variants[variant]);
+    writePLY(fileName, optimizer);
+
+    // The best of the runs, to filter the noise of the file cache
+    double loadTime = -1.0;
+    ReLoadedMesh mesh;
+    for (int r = 0; r < params.numRepeats; r++) {
+      double t = loadPLY(fileName, mesh);
+      if (loadTime < 0.0 || t < loadTime) {
+        loadTime = t;
+      }
+    }
+    QVector<ReTriangleKey> keys;
+    getTriangleKeys(mesh, keys);
+    if (variant == 0) {
+      originalKeys = keys;
+      std::cout << "  " << optimizer.getNumTriangles() << " triangles, "
+                << optimizer.getNumVertices() << " vertices" << std::endl;
+    }
+    else if (!(keys == originalKeys)) {
+      sameGeometry = false;
+    }
+    std::cout << "  " << variants[variant] << ": ACMR " << acmr
+              << ", optimization " << optimizeTime << " ms"
+              << ", load " << loadTime << " ms" << std::endl;
+    QFile::remove(fileName);
+  }
+
+  if (!sameGeometry) {
+    std::cerr << "Error: the reordered mesh has different triangles" << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,186 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+//! Tests of the subdivision and displacement done by the exporter
+
+#include <boost/test/unit_test.hpp>
+
+#include <math.h>
+
+#include <QFile>
+#include <QImage>
+
+#include "ReMeshRefiner.h"
+#include "RealityTester.h"
+
+using namespace Reality;
+
+#define RE_REFINER_TEST_EPSILON 1e-5f
+
+static bool samePosition( const ReVectorF& a, const ReVectorF& b ) {
+  return fabs(a[0] - b[0]) < RE_REFINER_TEST_EPSILON &&
+         fabs(a[1] - b[1]) < RE_REFINER_TEST_EPSILON &&
+         fabs(a[2] - b[2]) < RE_REFINER_TEST_EPSILON;
+}
+
+//! A flat quad on the XY plane made of two triangles. If withSeam is true
+//! the vertices of the diagonal are duplicated, as the host apps do along
+//! the UV seams.
+static void setQuad( ReMeshRefiner& refiner, const bool withSeam ) {
+  ReVectorF verts[6] = {
+    {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}, {0, 0, 0}, {1, 1, 0}
+  };
+  ReVectorF norms[6] = {
+    {0, 0, 1}, {0, 0, 1}, {0, 0, 1}, {0, 0, 1}, {0, 0, 1}, {0, 0, 1}
+  };
+  ReUVPoint uvs[6] = {
+    {0, 0}, {1, 0}, {1, 1}, {0, 1}, {0.5f, 0}, {1, 0.5f}
+  };
+  ReTriangle tris[2];
+  tris[0].s.a = 0; tris[0].s.b = 1; tris[0].s.c = 2;
+  if (withSeam) {
+    tris[1].s.a = 4; tris[1].s.b = 5; tris[1].s.c = 3;
+  }
+  else {
+    tris[1].s.a = 0; tris[1].s.b = 2; tris[1].s.c = 3;
+  }
+  refiner.setMesh(withSeam ? 6 : 4, verts, norms, uvs, 2, tris);
+}
+
+static void setTetrahedron( ReMeshRefiner& refiner ) {
+  ReVectorF verts[4] = {
+    {1, 1, 1}, {-1, -1, 1}, {-1, 1, -1}, {1, -1, -1}
+  };
+  ReVectorF norms[4];
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < 3; j++) {
+      norms[i][j] = verts[i][j] / sqrt(3.0f);
+    }
+  }
+  int indices[12] = { 0,1,2, 0,3,1, 0,2,3, 1,3,2 };
+  ReTriangle tris[4];
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < 3; j++) {
+      tris[i].a[j] = indices[i*3 + j];
+    }
+  }
+  refiner.setMesh(4, verts, norms, NULL, 4, tris);
+}
+
+BOOST_AUTO_TEST_CASE(test_RefinerTriangleCount) {
+  ReMeshRefiner refiner;
+  setTetrahedron(refiner);
+  BOOST_CHECK(refiner.getUVs() == NULL);
+
+  refiner.subdivide(1, false);
+  BOOST_CHECK_EQUAL(refiner.getNumVertices(), 10);
+  BOOST_CHECK_EQUAL(refiner.getNumTriangles(), 16);
+
+  refiner.subdivide(1, false);
+  BOOST_CHECK_EQUAL(refiner.getNumTriangles(), 64);
+
+  // Loop subdivision shrinks the closed mesh towards its center
+  ReVectorF* verts = refiner.getVertices();
+  for (int i = 0; i < refiner.getNumVertices(); i++) {
+    BOOST_CHECK(fabs(verts[i][0]) < 1.0f);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_RefinerSharpBoundary) {
+  ReMeshRefiner refiner;
+  setQuad(refiner, false);
+  refiner.subdivide(1, true);
+  BOOST_CHECK_EQUAL(refiner.getNumTriangles(), 8);
+
+  // With a sharp boundary the corners of the quad don't move
+  ReVectorF* verts = refiner.getVertices();
+  ReVectorF corner = {1, 0, 0};
+  BOOST_CHECK(samePosition(verts[1], corner));
+}
+
+BOOST_AUTO_TEST_CASE(test_RefinerSeams) {
+  ReMeshRefiner refiner;
+  setQuad(refiner, true);
+  refiner.subdivide(2, false);
+
+  // The vertices split along the seam must stay at the same positions,
+  // otherwise the mesh would crack
+  int numVertices = refiner.getNumVertices();
+  ReVectorF* verts = refiner.getVertices();
+  ReMeshRefiner welded;
+  setQuad(welded, false);
+  welded.subdivide(2, false);
+  ReVectorF* weldedVerts = welded.getVertices();
+  for (int i = 0; i < numVertices; i++) {
+    bool found = false;
+    for (int j = 0; j < welded.getNumVertices() && !found; j++) {
+      found = samePosition(verts[i], weldedVerts[j]);
+    }
+    BOOST_CHECK(found);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_RefinerDisplacement) {
+  QImage img(4, 4, QImage::Format_RGB32);
+  img.fill(qRgb(255, 255, 255));
+  ReDisplacementSampler sampler;
+  sampler.setImage(img);
+  sampler.setLimits(0.0f, 1.0f, 0.5f);
+  BOOST_CHECK_CLOSE(sampler.sample(0.3f, 0.7f), 0.5f, 0.001f);
+
+  ReMeshRefiner refiner;
+  setQuad(refiner, false);
+  refiner.displace(sampler, 2.0f);
+  ReVectorF* verts = refiner.getVertices();
+  ReVectorF* norms = refiner.getNormals();
+  for (int i = 0; i < refiner.getNumVertices(); i++) {
+    BOOST_CHECK_CLOSE(verts[i][2], 1.0f, 0.001f);
+    BOOST_CHECK_CLOSE(norms[i][2], 1.0f, 0.001f);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_RefinerThreads) {
+  ReMeshRefiner single;
+  single.setMaxThreads(1);
+  setTetrahedron(single);
+  single.subdivide(5, false);
+  single.computeNormals();
+
+  ReMeshRefiner multi;
+  multi.setMaxThreads(4);
+  setTetrahedron(multi);
+  multi.subdivide(5, false);
+  multi.computeNormals();
+
+  BOOST_REQUIRE_EQUAL(single.getNumVertices(), multi.getNumVertices());
+  for (int i = 0; i < single.getNumVertices(); i++) {
+    BOOST_CHECK(samePosition(single.getVertices()[i], multi.getVertices()[i]));
+    BOOST_CHECK(samePosition(single.getNormals()[i], multi.getNormals()[i]));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_RefinerCacheLimit) {
+  QString dirName = getTestDir("MeshCache", QStringList() << "cache");
+  ReMeshRefiner::setCacheDir(dirName + "/cache");
+  QString plyName = dirName + "/mesh.ply";
+  QFile ply(plyName);
+  BOOST_REQUIRE(ply.open(QIODevice::WriteOnly));
+  ply.write(QByteArray(1000, 'x'));
+  ply.close();
+
+  // Room for one mesh only, the mesh just stored is always kept
+  ReMeshRefiner::setCacheLimit(1500);
+  QByteArray keyA(40, 'a'), keyB(40, 'b');
+  ReMeshRefiner::storeCachedMesh("A", keyA, plyName);
+  ReMeshRefiner::storeCachedMesh("B", keyB, plyName);
+  QString outName = dirName + "/out.ply";
+  BOOST_CHECK(!ReMeshRefiner::fetchCachedMesh("A", keyA, outName));
+  BOOST_CHECK(ReMeshRefiner::fetchCachedMesh("B", keyB, outName));
+
+  ReMeshRefiner::purgeCache();
+  BOOST_CHECK(!ReMeshRefiner::fetchCachedMesh("B", keyB, outName));
+  ReMeshRefiner::setCacheLimit(static_cast<qint64>(RE_MESH_CACHE_MAX_SIZE)*1024*1024);
+}
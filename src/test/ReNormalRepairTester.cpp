@@ -0,0 +1,149 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+//! Tests of the repair of the invalid normals of the exported meshes
+
+#include <boost/test/unit_test.hpp>
+
+#include <math.h>
+
+#include <QVector>
+
+#include "ReNormalRepair.h"
+
+using namespace Reality;
+
+#define RE_NORMAL_TEST_EPSILON 1e-5f
+
+static bool sameDirection( const ReVectorF& n, const float x, const float y, const float z ) {
+  return fabs(n[0] - x) < RE_NORMAL_TEST_EPSILON &&
+         fabs(n[1] - y) < RE_NORMAL_TEST_EPSILON &&
+         fabs(n[2] - z) < RE_NORMAL_TEST_EPSILON;
+}
+
+static int repairMesh( ReNormalRepair& repair,
+                       const QVector<float>& verts,
+                       QVector<float>& norms,
+                       const QVector<int>& tris ) 
+{
+  return repair.repair(verts.count() / 3,
+                       reinterpret_cast<const ReVectorF*>(verts.constData()),
+                       reinterpret_cast<ReVectorF*>(norms.data()),
+                       tris.count() / 3,
+                       reinterpret_cast<const ReTriangle*>(tris.constData()));
+}
+
+BOOST_AUTO_TEST_CASE(test_NormalRepairFlat) {
+  // A quad on the XY plane, one vertex has a NaN normal and one a zero
+  // normal
+  QVector<float> verts, norms;
+  QVector<int> tris;
+  verts << 0 << 0 << 0  << 1 << 0 << 0  << 1 << 1 << 0  << 0 << 1 << 0;
+  norms << NAN << NAN << NAN  << 0 << 0 << 0  << 0 << 0 << 1  << 0 << 0 << 1;
+  tris << 0 << 1 << 2 << 0 << 2 << 3;
+
+  ReNormalRepair repair;
+  BOOST_CHECK(!ReNormalRepair::isValidNormal(
+                 *reinterpret_cast<const ReVectorF*>(norms.constData())));
+  BOOST_CHECK_EQUAL(repairMesh(repair, verts, norms, tris), 2);
+  const ReVectorF* n = reinterpret_cast<const ReVectorF*>(norms.constData());
+  for (int i = 0; i < 4; i++) {
+    BOOST_CHECK(sameDirection(n[i], 0, 0, 1));
+  }
+  // Nothing left to repair
+  BOOST_CHECK_EQUAL(repairMesh(repair, verts, norms, tris), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_NormalRepairValidKept) {
+  // The valid normals are kept even when they don't match the faces
+  QVector<float> verts, norms;
+  QVector<int> tris;
+  verts << 0 << 0 << 0  << 1 << 0 << 0  << 0 << 1 << 0;
+  norms << 1 << 0 << 0  << 0 << 1 << 0  << 0 << 0 << -1;
+  tris << 0 << 1 << 2;
+  QVector<float> original = norms;
+
+  ReNormalRepair repair;
+  BOOST_CHECK_EQUAL(repairMesh(repair, verts, norms, tris), 0);
+  BOOST_CHECK(norms == original);
+}
+
+BOOST_AUTO_TEST_CASE(test_NormalRepairCrease) {
+  // Two quads folded at 90 degrees along the Y axis. The vertices of the
+  // fold are duplicated, as the host apps do for a hard edge. All the
+  // normals are invalid.
+  QVector<float> verts, norms;
+  QVector<int> tris;
+  // The floor, on the XY plane, facing +Z
+  verts << 0 << 0 << 0  << 1 << 0 << 0  << 1 << 1 << 0  << 0 << 1 << 0;
+  // The wall, on the YZ plane, facing +X
+  verts << 0 << 0 << 0  << 0 << 1 << 0  << 0 << 1 << 1  << 0 << 0 << 1;
+  for (int i = 0; i < 8; i++) {
+    norms << 0 << 0 << 0;
+  }
+  tris << 0 << 1 << 2 << 0 << 2 << 3;
+  tris << 4 << 5 << 6 << 4 << 6 << 7;
+
+  // With the default crease angle the edge stays sharp
+  ReNormalRepair repair;
+  QVector<float> sharp = norms;
+  BOOST_CHECK_EQUAL(repairMesh(repair, verts, sharp, tris), 8);
+  const ReVectorF* n = reinterpret_cast<const ReVectorF*>(sharp.constData());
+  BOOST_CHECK(sameDirection(n[0], 0, 0, 1));
+  BOOST_CHECK(sameDirection(n[3], 0, 0, 1));
+  BOOST_CHECK(sameDirection(n[4], 1, 0, 0));
+  BOOST_CHECK(sameDirection(n[5], 1, 0, 0));
+
+  // Above the angle of the fold the copies are smoothed together
+  repair.setCreaseAngle(180.0f);
+  QVector<float> smooth = norms;
+  repairMesh(repair, verts, smooth, tris);
+  n = reinterpret_cast<const ReVectorF*>(smooth.constData());
+  BOOST_CHECK(sameDirection(n[0], n[4][0], n[4][1], n[4][2]));
+  BOOST_CHECK(sameDirection(n[3], n[5][0], n[5][1], n[5][2]));
+  BOOST_CHECK_CLOSE(n[3][0], n[3][2], 0.001);
+  // The vertices away from the fold see only their own faces
+  BOOST_CHECK(sameDirection(n[1], 0, 0, 1));
+  BOOST_CHECK(sameDirection(n[6], 1, 0, 0));
+}
+
+BOOST_AUTO_TEST_CASE(test_NormalRepairThreads) {
+  // A bumpy grid large enough to be split between threads
+  const int size = 64;
+  QVector<float> verts, norms;
+  QVector<int> tris;
+  for (int j = 0; j <= size; j++) {
+    for (int i = 0; i <= size; i++) {
+      float x = static_cast<float>(i) / size;
+      float y = static_cast<float>(j) / size;
+      verts << x << y << 0.1f * sin(x*6) * sin(y*6);
+      norms << NAN << NAN << NAN;
+    }
+  }
+  for (int j = 0; j < size; j++) {
+    for (int i = 0; i < size; i++) {
+      int a = j * (size+1) + i;
+      tris << a << a + 1 << a + size + 2 << a << a + size + 2 << a + size + 1;
+    }
+  }
+  ReNormalRepair repair;
+  repair.setMaxThreads(1);
+  QVector<float> single = norms;
+  BOOST_CHECK_EQUAL(repairMesh(repair, verts, single, tris), verts.count() / 3);
+
+  repair.setMaxThreads(4);
+  QVector<float> multi = norms;
+  BOOST_CHECK_EQUAL(repairMesh(repair, verts, multi, tris), verts.count() / 3);
+  BOOST_CHECK(single == multi);
+
+  // All the normals are unit length and point up
+  const ReVectorF* n = reinterpret_cast<const ReVectorF*>(multi.constData());
+  for (int i = 0; i < verts.count() / 3; i++) {
+    float length = sqrt(n[i][0]*n[i][0] + n[i][1]*n[i][1] + n[i][2]*n[i][2]);
+    BOOST_CHECK_CLOSE(length, 1.0f, 0.001);
+    BOOST_CHECK(n[i][2] > 0.0f);
+  }
+}
@@ -0,0 +1,155 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+//! Benchmark of the material tree data model. It builds a synthetic scene
+//! with 80 objects and 5,040 materials and walks the model the same way
+//! Qt's model tester does: every index is checked against its parent and
+//! every object node is fetched lazily.
+//!
+//! The model is part of the GUI, so these tests are built as a program of
+//! their own, Reality_SceneDataModelTester.
+
+#define BOOST_TEST_MODULE SceneDataModelTester
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <QElapsedTimer>
+
+#include "RealityBase.h"
+#include "ReMatte.h"
+#include "ReSceneData.h"
+#include "ReSceneDataGlobal.h"
+#include "ReSceneDataModel.h"
+
+using namespace Reality;
+
+#define RE_BENCH_NUM_OBJECTS 80
+#define RE_BENCH_MATS_PER_OBJECT 63
+
+static ReGeometryObjectDictionary createSyntheticScene() {
+  ReGeometryObjectDictionary objects;
+  for (int i = 0; i < RE_BENCH_NUM_OBJECTS; i++) {
+    QString objID = QString("Figure_%1").arg(i);
+    ReGeometryObject* obj = new ReGeometryObject(objID, objID, objID);
+    for (int m = 0; m < RE_BENCH_MATS_PER_OBJECT; m++) {
+      QString matName = QString("Material_%1").arg(m);
+      obj->addMaterial(matName, ReMaterialPtr(new ReMatte(matName, obj)));
+    }
+    objects[objID] = ReGeometryObjectPtr(obj);
+  }
+  return objects;
+}
+
+//! Visits every index of the model, fetching the children when the model
+//! supports it. Returns the number of indexes visited.
+static int traverseModel( QAbstractItemModel* model, const QModelIndex& parent ) {
+  if (model->canFetchMore(parent)) {
+    model->fetchMore(parent);
+  }
+  int visited = 0;
+  int rows = model->rowCount(parent);
+  int columns = model->columnCount(parent);
+  for (int r = 0; r < rows; r++) {
+    for (int c = 0; c < columns; c++) {
+      QModelIndex idx = model->index(r, c, parent);
+      BOOST_REQUIRE(idx.isValid());
+      BOOST_CHECK(model->parent(idx) == parent);
+      BOOST_CHECK_EQUAL(idx.row(), r);
+      model->data(idx, Qt::DisplayRole);
+      model->data(idx, Qt::CheckStateRole);
+      visited++;
+    }
+    QModelIndex child = model->index(r, 0, parent);
+    if (model->hasChildren(child)) {
+      visited += traverseModel(model, child);
+    }
+  }
+  return visited;
+}
+
+BOOST_AUTO_TEST_CASE(benchmark_SceneDataModel) {
+  RealityBase::getRealityBase();
+  ReSceneDataModel model;
+
+  QElapsedTimer timer;
+  timer.start();
+  model.addObjectsToModel(createSyntheticScene());
+  qint64 loadTime = timer.elapsed();
+  BOOST_CHECK_EQUAL(model.rowCount(QModelIndex()), RE_BENCH_NUM_OBJECTS);
+
+  timer.restart();
+  int visited = traverseModel(&model, QModelIndex());
+  qint64 traversalTime = timer.elapsed();
+  BOOST_CHECK_EQUAL(
+    visited,
+    RE_BENCH_NUM_OBJECTS * (RE_BENCH_MATS_PER_OBJECT+1) * RE_MB_NUM_COLUMS
+  );
+
+  // Host notifications look up a material by object and material ID
+  timer.restart();
+  for (int i = 0; i < RE_BENCH_NUM_OBJECTS; i++) {
+    for (int m = 0; m < RE_BENCH_MATS_PER_OBJECT; m++) {
+      QModelIndex idx = model.findMaterial(
+        QString("Figure_%1").arg(i), QString("Material_%1").arg(m)
+      );
+      BOOST_CHECK(model.getSelectedMaterial(idx) != NULL);
+    }
+  }
+  qint64 lookupTime = timer.elapsed();
+
+  BOOST_TEST_MESSAGE(
+    "Scene data model, "
+    << RE_BENCH_NUM_OBJECTS * RE_BENCH_MATS_PER_OBJECT << " materials. "
+    << "Load: " << loadTime << "ms, "
+    << "traversal: " << traversalTime << "ms, "
+    << "lookups: " << lookupTime << "ms"
+  );
+}
+
+BOOST_AUTO_TEST_CASE(test_SceneDataModelRenameID) {
+  RealityBase::getRealityBase();
+  ReSceneDataModel model;
+  ReGeometryObjectDictionary objects = createSyntheticScene();
+  model.addObjectsToModel(objects);
+
+  // The host gives a new ID to an object
+  ReGeometryObjectPtr obj = objects.value("Figure_1");
+  obj->setInternalName("Figure_1_renamed");
+  model.objectIDChanged("Figure_1");
+
+  BOOST_CHECK(model.findObject("Figure_1") == NULL);
+  BOOST_REQUIRE(model.findObject("Figure_1_renamed") != NULL);
+  QModelIndex idx = model.findMaterial("Figure_1_renamed", "Material_3");
+  BOOST_CHECK(model.getSelectedMaterial(idx) != NULL);
+
+  // No entry is left behind when the node is deleted
+  model.deleteObject("Figure_1_renamed");
+  BOOST_CHECK(model.findObject("Figure_1_renamed") == NULL);
+  BOOST_CHECK(model.findObject("Figure_1") == NULL);
+  BOOST_CHECK_EQUAL(model.rowCount(QModelIndex()), RE_BENCH_NUM_OBJECTS - 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_SceneDataModelEmptyObject) {
+  RealityBase::getRealityBase();
+  ReSceneDataModel model;
+  ReGeometryObjectDictionary objects = createSyntheticScene();
+  objects["Empty"] = ReGeometryObjectPtr(new ReGeometryObject("Empty", "Empty", "Empty"));
+  model.addObjectsToModel(objects);
+
+  // Only the objects with materials show an expander, before and after
+  // their nodes are populated
+  int rows = model.rowCount(QModelIndex());
+  BOOST_REQUIRE_EQUAL(rows, RE_BENCH_NUM_OBJECTS + 1);
+  for (int r = 0; r < rows; r++) {
+    QModelIndex idx = model.index(r, 0, QModelIndex());
+    bool isEmpty = model.data(idx, Qt::DisplayRole).toString() == "Empty";
+    BOOST_CHECK_EQUAL(model.hasChildren(idx), !isEmpty);
+    if (model.canFetchMore(idx)) {
+      model.fetchMore(idx);
+    }
+    BOOST_CHECK_EQUAL(model.hasChildren(idx), !isEmpty);
+  }
+}
@@ -0,0 +1,89 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+//! Tests of the scene templates used by the material previews
+
+#include <boost/test/unit_test.hpp>
+
+#include <QFile>
+
+#include "ReSceneTemplate.h"
+#include "RealityTester.h"
+
+using namespace Reality;
+
+static void writeFile( const QString& fileName, const QByteArray& text ) {
+  QFile file(fileName);
+  file.open(QIODevice::WriteOnly);
+  file.write(text);
+}
+
+BOOST_AUTO_TEST_CASE(test_SceneTemplateFill) {
+  ReSceneTemplate scene("Texture\n%1\nNamedMaterial \"%2\"\nShape %1");
+  BOOST_CHECK_EQUAL(scene.getNumPlaceholders(), 2);
+  QList<QByteArray> values;
+  values << "Material \"a\"" << "a";
+  BOOST_CHECK_EQUAL(scene.fill(values).constData(),
+                    "Texture\nMaterial \"a\"\nNamedMaterial \"a\"\nShape Material \"a\"");
+
+  // The values are copied as they are, even when they look like
+  // placeholders
+  values.clear();
+  values << "\"float gain\" [%2] 100%" << "%1";
+  BOOST_CHECK_EQUAL(scene.fill(values).constData(),
+                    "Texture\n\"float gain\" [%2] 100%\nNamedMaterial \"%1\"\n"
+                    "Shape \"float gain\" [%2] 100%");
+
+  // The placeholders without a value are left in the text
+  values.clear();
+  values << "x";
+  BOOST_CHECK_EQUAL(scene.fill(values).constData(),
+                    "Texture\nx\nNamedMaterial \"%2\"\nShape x");
+}
+
+BOOST_AUTO_TEST_CASE(test_SceneTemplateParse) {
+  // A % not followed by a number is text, %0 is not a placeholder and
+  // the placeholders have up to two digits, like in QString::arg()
+  ReSceneTemplate scene("50% %0 %12%1 %");
+  BOOST_CHECK_EQUAL(scene.getNumPlaceholders(), 12);
+  QList<QByteArray> values;
+  for (int i = 1; i <= 12; i++) {
+    values << QByteArray::number(i * 100);
+  }
+  BOOST_CHECK_EQUAL(scene.fill(values).constData(), "50% %0 1200100 %");
+
+  ReSceneTemplate empty;
+  BOOST_CHECK(empty.isEmpty());
+  BOOST_CHECK(empty.fill(values).isEmpty());
+  ReSceneTemplate noPlaceholders("Film \"fleximage\"");
+  BOOST_CHECK_EQUAL(noPlaceholders.getNumPlaceholders(), 0);
+  BOOST_CHECK_EQUAL(noPlaceholders.fill(values).constData(), "Film \"fleximage\"");
+}
+
+BOOST_AUTO_TEST_CASE(test_SceneTemplateCache) {
+  QString dirName = getTestDir("SceneTemplate", QStringList() << "override");
+  QString overrideDir = QString("%1/override").arg(dirName);
+  QString baseName = QString("%1/plane_preview.lxs").arg(dirName);
+  QString overrideName = QString("%1/plane_preview.lxs").arg(overrideDir);
+  writeFile(baseName, "base %1");
+
+  ReSceneTemplateCache cache;
+  cache.setOverrideDir(overrideDir);
+  BOOST_CHECK_EQUAL(cache.get(baseName).getText().constData(), "base %1");
+
+  // A file in the override directory replaces the template
+  writeFile(overrideName, "override %1");
+  BOOST_CHECK_EQUAL(cache.get(baseName).getText().constData(), "override %1");
+
+  // and it's reloaded when it changes
+  writeFile(overrideName, "edited override %1 %2");
+  const ReSceneTemplate& edited = cache.get(baseName);
+  BOOST_CHECK_EQUAL(edited.getText().constData(), "edited override %1 %2");
+  BOOST_CHECK_EQUAL(edited.getNumPlaceholders(), 2);
+
+  QFile::remove(overrideName);
+  BOOST_CHECK_EQUAL(cache.get(baseName).getText().constData(), "base %1");
+}
@@ -0,0 +1,189 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+//! Tests of the persistent index of the size and format of the image maps
+
+#include <boost/test/unit_test.hpp>
+
+#include <QFile>
+#include <QImage>
+
+#include "ReTextureInfoCache.h"
+#include "RealityTester.h"
+
+using namespace Reality;
+
+//! Writes a color image, or a gray image with alpha
+static QString makeTestImage( const QString& dirName,
+                              const QString& name,
+                              const int width,
+                              const int height,
+                              const bool grayWithAlpha )
+{
+  QImage img(width, height, grayWithAlpha ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      if (grayWithAlpha) {
+        img.setPixel(x, y, qRgba(x % 256, x % 256, x % 256, y % 256));
+      }
+      else {
+        img.setPixel(x, y, x < width/2 ? qRgb(255, 0, 0) : qRgb(0, 0, 255));
+      }
+    }
+  }
+  QString fileName = QString("%1/%2").arg(dirName).arg(name);
+  QFile::remove(fileName);
+  img.save(fileName, "PNG");
+  return fileName;
+}
+
+BOOST_AUTO_TEST_CASE(test_TextureInfoProbe) {
+  QString dirName = getTestDir("TextureInfo");
+  ReTextureInfoCache* cache = ReTextureInfoCache::getInstance();
+  QString oldIndex = cache->getIndexFileName();
+  cache->setIndexFileName(QString("%1/index.idx").arg(dirName));
+
+  QString colorName = makeTestImage(dirName, "color.png", 300, 200, false);
+  QString grayName  = makeTestImage(dirName, "gray.png", 100, 120, true);
+
+  ReTextureInfo info;
+  BOOST_REQUIRE(cache->getInfo(colorName, info));
+  BOOST_CHECK_EQUAL(info.width, 300u);
+  BOOST_CHECK_EQUAL(info.height, 200u);
+  BOOST_CHECK_EQUAL(info.channels, 3);
+  BOOST_CHECK_EQUAL(info.bitDepth, 8);
+  BOOST_CHECK(!info.hasAlpha);
+  BOOST_CHECK(!info.isGrayscale);
+  BOOST_CHECK_EQUAL(info.fileSize, static_cast<quint64>(QFileInfo(colorName).size()));
+
+  BOOST_REQUIRE(cache->getInfo(grayName, info));
+  BOOST_CHECK(cache->getImageSize(grayName) == QSize(100, 120));
+  BOOST_CHECK_EQUAL(info.channels, 2);
+  BOOST_CHECK(info.hasAlpha);
+  BOOST_CHECK(info.isGrayscale);
+
+  // Missing and unreadable files
+  BOOST_CHECK(!cache->getInfo(QString("%1/missing.png").arg(dirName), info));
+  BOOST_CHECK(!cache->getImageSize(QString("%1/index.idx").arg(dirName)).isValid());
+
+  cache->setIndexFileName(oldIndex);
+}
+
+BOOST_AUTO_TEST_CASE(test_TextureInfoPersistence) {
+  QString dirName = getTestDir("TextureInfo");
+  ReTextureInfoCache* cache = ReTextureInfoCache::getInstance();
+  QString oldIndex = cache->getIndexFileName();
+  QString indexName = QString("%1/index.idx").arg(dirName);
+  cache->setIndexFileName(indexName);
+
+  QString fileName = makeTestImage(dirName, "map.png", 64, 32, false);
+  int probes = cache->getNumProbes();
+  BOOST_CHECK(cache->getImageSize(fileName) == QSize(64, 32));
+  BOOST_CHECK_EQUAL(cache->getNumProbes(), probes + 1);
+  // The second time the size comes from the index
+  BOOST_CHECK(cache->getImageSize(fileName) == QSize(64, 32));
+  BOOST_CHECK_EQUAL(cache->getNumProbes(), probes + 1);
+
+  // The index is kept in the file, like it happens for another process
+  cache->setIndexFileName(indexName);
+  BOOST_CHECK(cache->getImageSize(fileName) == QSize(64, 32));
+  BOOST_CHECK_EQUAL(cache->getNumProbes(), probes + 1);
+
+  // A changed file is probed again
+  makeTestImage(dirName, "map.png", 128, 16, true);
+  BOOST_CHECK(cache->getImageSize(fileName) == QSize(128, 16));
+  BOOST_CHECK_EQUAL(cache->getNumProbes(), probes + 2);
+
+  // After clear() all the images are probed again
+  cache->clear();
+  cache->getImageSize(fileName);
+  BOOST_CHECK_EQUAL(cache->getNumProbes(), probes + 3);
+
+  // An index written by another version is discarded
+  cache->setIndexFileName(oldIndex);
+  QFile index(indexName);
+  BOOST_REQUIRE(index.open(QIODevice::ReadWrite));
+  index.write("XXXX");
+  index.close();
+  cache->setIndexFileName(indexName);
+  BOOST_CHECK(cache->getImageSize(fileName) == QSize(128, 16));
+  BOOST_CHECK_EQUAL(cache->getNumProbes(), probes + 4);
+
+  cache->setIndexFileName(oldIndex);
+}
+
+BOOST_AUTO_TEST_CASE(test_TextureInfoContentHash) {
+  QString dirName = getTestDir("TextureInfo");
+  ReTextureInfoCache* cache = ReTextureInfoCache::getInstance();
+  QString oldIndex = cache->getIndexFileName();
+  cache->setIndexFileName(QString("%1/index.idx").arg(dirName));
+
+  QString first  = makeTestImage(dirName, "first.png", 50, 50, false);
+  QString copy   = QString("%1/copy.png").arg(dirName);
+  QFile::copy(first, copy);
+  QString second = makeTestImage(dirName, "second.png", 50, 50, true);
+
+  ReTextureInfo info;
+  BOOST_REQUIRE(cache->getInfo(first, info));
+  BOOST_CHECK_EQUAL(info.contentHash, 0u);
+
+  int probes = cache->getNumProbes();
+  ReTextureInfo firstInfo, copyInfo, secondInfo;
+  BOOST_REQUIRE(cache->getInfo(first, firstInfo, true));
+  // The hash is added to the entry without probing the image again
+  BOOST_CHECK_EQUAL(cache->getNumProbes(), probes);
+  BOOST_REQUIRE(cache->getInfo(copy, copyInfo, true));
+  BOOST_REQUIRE(cache->getInfo(second, secondInfo, true));
+  BOOST_CHECK(firstInfo.contentHash != 0);
+  BOOST_CHECK_EQUAL(firstInfo.contentHash, copyInfo.contentHash);
+  BOOST_CHECK(firstInfo.contentHash != secondInfo.contentHash);
+
+  // The hash is kept in the index
+  BOOST_REQUIRE(cache->getInfo(first, info));
+  BOOST_CHECK_EQUAL(info.contentHash, firstInfo.contentHash);
+
+  cache->setIndexFileName(oldIndex);
+}
+
+BOOST_AUTO_TEST_CASE(test_TextureInfoStaleEntry) {
+  QString dirName = getTestDir("TextureInfo");
+  ReTextureInfoCache* cache = ReTextureInfoCache::getInstance();
+  QString oldIndex = cache->getIndexFileName();
+  QString indexName = QString("%1/index.idx").arg(dirName);
+  cache->setIndexFileName(indexName);
+
+  QString fileName = makeTestImage(dirName, "map.png", 64, 32, false);
+  int probes = cache->getNumProbes();
+  BOOST_CHECK(cache->getImageSize(fileName) == QSize(64, 32));
+
+  // Leave the entry odd, like a writer that crashed while updating it. The
+  // records follow the 64-byte header, with the sequence at offset 0 and
+  // the path hash at 8. The odd sequence 1 is a claim made at the epoch.
+  cache->setIndexFileName(oldIndex);
+  QFile index(indexName);
+  BOOST_REQUIRE(index.open(QIODevice::ReadWrite));
+  uchar* data = index.map(0, index.size());
+  BOOST_REQUIRE(data);
+  int staleEntries = 0;
+  for (uchar* rec = data + 64; rec < data + index.size(); rec += 64) {
+    if (*reinterpret_cast<quint64*>(rec + 8) != 0) {
+      *reinterpret_cast<qint32*>(rec) = 1;
+      staleEntries++;
+    }
+  }
+  index.unmap(data);
+  index.close();
+  BOOST_REQUIRE_EQUAL(staleEntries, 1);
+
+  // The entry is missing, then it's reclaimed by the next store
+  cache->setIndexFileName(indexName);
+  BOOST_CHECK(cache->getImageSize(fileName) == QSize(64, 32));
+  BOOST_CHECK_EQUAL(cache->getNumProbes(), probes + 2);
+  BOOST_CHECK(cache->getImageSize(fileName) == QSize(64, 32));
+  BOOST_CHECK_EQUAL(cache->getNumProbes(), probes + 2);
+
+  cache->setIndexFileName(oldIndex);
+}
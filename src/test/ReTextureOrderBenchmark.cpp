@@ -0,0 +1,219 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+//! Benchmark of the serialization of materials with deep texture networks.
+//!
+//! Each material has a layered network: the first layer is made of
+//! constant textures and every following layer combines pairs of nodes
+//! of the previous layer with alternating Mix and Color Math textures.
+//! The top node is linked to the diffuse channel. This is similar to the
+//! networks generated for skin shaders with several detail layers.
+//!
+//! The materials are serialized with the topological order of the
+//! textures recomputed every time, which was the behavior before the
+//! order was cached, and with the cached order. The average time per
+//! material is reported for both. The program returns 1 if the cached
+//! order doesn't list the dependencies of a texture before the texture,
+//! also after a texture has been linked to a different one.
+//!
+//! Usage:
+//!   Reality_TextureOrderBenchmark [--materials N] [--depth N]
+//!                                 [--repeat N]
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+#include <iostream>
+
+#include "ReGlossy.h"
+#include "textures/ReColorMath.h"
+#include "textures/ReConstant.h"
+#include "textures/ReMix.h"
+
+using namespace Reality;
+
+struct BenchmarkParams {
+  int numMaterials;
+  int depth;
+  int numRepeats;
+
+  BenchmarkParams() :
+    numMaterials(50),
+    depth(6),
+    numRepeats(20)
+  {
+  }
+};
+
+//! Creates a material with a network of textures 2^depth nodes wide at
+//! the bottom, linked to the diffuse channel.
+static ReMaterial* makeMaterial( const int matNo, const int depth ) {
+  QString matName = QString("Mat_%1").arg(matNo);
+  ReGlossy* mat = new ReGlossy(matName, NULL);
+
+  QList<ReTexturePtr> layer;
+  int width = 1 << depth;
+  for (int i = 0; i < width; i++) {
+    ReTexturePtr tex(
+      new ReConstant(QString("%1_c%2").arg(matName).arg(i), mat, QColor(i % 256, 128, 64))
+    );
+    mat->addTextureToCatalog(tex);
+    layer.append(tex);
+  }
+
+  for (int level = 1; level <= depth; level++) {
+    QList<ReTexturePtr> nextLayer;
+    for (int i = 0; i < layer.count(); i += 2) {
+      QString texName = QString("%1_l%2_%3").arg(matName).arg(level).arg(i/2);
+      ReTexturePtr tex;
+      if ((i/2 + level) % 2) {
+        ReMixTexture* mix = new ReMixTexture(texName, mat);
+        mix->setTexture1(layer[i]);
+        mix->setTexture2(layer[i+1]);
+        mix->setMixTexture(ReTexturePtr(
+          new ReConstant(QString("%1_amount").arg(texName), mat, 0.5f)
+        ));
+        tex = ReTexturePtr(mix);
+      }
+      else {
+        tex = ReTexturePtr(
+          new ReColorMath(texName, mat, layer[i], layer[i+1], ReColorMath::multiply)
+        );
+      }
+      mat->addTextureToCatalog(tex);
+      nextLayer.append(tex);
+    }
+    layer = nextLayer;
+  }
+  mat->setChannel(RE_GLOSSY_KD_CH, layer[0]->getName());
+  return mat;
+}
+
+//! Checks that every texture is listed after the textures it depends on
+static bool checkOrder( const ReMaterial* mat ) {
+  const QVector<ReTexturePtr>& texOrder = mat->getTextureOrder();
+  if (texOrder.count() != mat->getTextures().count()) {
+    return false;
+  }
+  QHash<QString, int> position;
+  for (int i = 0; i < texOrder.count(); i++) {
+    position[texOrder[i]->getName()] = i;
+  }
+  for (int i = 0; i < texOrder.count(); i++) {
+    foreach( QString dep, texOrder[i]->getDependencies() ) {
+      if (position.value(dep, texOrder.count()) >= i) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+//! Links the first compound texture of the lowest layer to the last one
+//! of the same layer. The texture listed first in the cached order is
+//! made to depend on the other, so a stale order is detected by 
+//! checkOrder(). The size of the catalog doesn't change.
+static void relinkTexture( ReMaterial* mat, const int depth ) {
+  if (depth < 2) {
+    return;
+  }
+  QString nameA = QString("%1_l1_0").arg(mat->getName());
+  QString nameB = QString("%1_l1_%2").arg(mat->getName()).arg((1 << (depth-1)) - 1);
+  const QVector<ReTexturePtr> texOrder = mat->getTextureOrder();
+  int posA = -1, posB = -1;
+  for (int i = 0; i < texOrder.count(); i++) {
+    if (texOrder[i]->getName() == nameA) {
+      posA = i;
+    }
+    else if (texOrder[i]->getName() == nameB) {
+      posB = i;
+    }
+  }
+  if (posA < 0 || posB < 0) {
+    return;
+  }
+  ReTexturePtr first  = texOrder[qMin(posA, posB)];
+  ReTexturePtr second = texOrder[qMax(posA, posB)];
+  first->setNamedValue("texture1", QVariant::fromValue(second));
+}
+
+//! Returns the average time to serialize one material, in microseconds
+static double runSerialization( const QList<ReMaterial*>& materials,
+                                const int numRepeats,
+                                const bool useCache )
+{
+  QByteArray data;
+  qint64 elapsed = 0;
+  QElapsedTimer timer;
+  for (int r = 0; r < numRepeats; r++) {
+    foreach( ReMaterial* mat, materials ) {
+      if (!useCache) {
+        mat->textureLinksChanged();
+      }
+      data.clear();
+      QDataStream dataStream(&data, QIODevice::WriteOnly);
+      timer.start();
+      mat->serialize(dataStream);
+      elapsed += timer.nsecsElapsed();
+    }
+  }
+  return static_cast<double>(elapsed) / (1000.0 * numRepeats * materials.count());
+}
+
+int main( int argc, char** argv ) {
+  QCoreApplication app(argc, argv);
+  BenchmarkParams params;
+
+  QStringList args = app.arguments();
+  for (int i = 1; i < args.count(); i++) {
+    QString arg = args[i];
+    QString value = args.value(i+1);
+    if (arg == "--materials") {
+      params.numMaterials = value.toInt(); i++;
+    }
+    else if (arg == "--depth") {
+      params.depth = value.toInt(); i++;
+    }
+    else if (arg == "--repeat") {
+      params.numRepeats = value.toInt(); i++;
+    }
+    else {
+      std::cerr << "Unknown option: " << arg.toStdString() << std::endl;
+      return 2;
+    }
+  }
+
+  QList<ReMaterial*> materials;
+  for (int i = 0; i < params.numMaterials; i++) {
+    materials.append(makeMaterial(i, params.depth));
+  }
+  bool orderIsValid = true;
+  foreach( ReMaterial* mat, materials ) {
+    orderIsValid = orderIsValid && checkOrder(mat);
+  }
+  foreach( ReMaterial* mat, materials ) {
+    relinkTexture(mat, params.depth);
+    orderIsValid = orderIsValid && checkOrder(mat);
+  }
+
+  std::cout << "Texture order benchmark: " << params.numMaterials
+            << " materials, " << materials[0]->getTextures().count()
+            << " textures each" << std::endl;
+  double uncached = runSerialization(materials, params.numRepeats, false);
+  double cached   = runSerialization(materials, params.numRepeats, true);
+  std::cout << "  recomputed order: " << uncached << " us/material" << std::endl;
+  std::cout << "  cached order:     " << cached   << " us/material" << std::endl;
+  if (cached > 0) {
+    std::cout << "  speed-up:         " << uncached / cached << "x" << std::endl;
+  }
+
+  qDeleteAll(materials);
+  if (!orderIsValid) {
+    std::cerr << "Error: the cached texture order is not topological" << std::endl;
+    return 1;
+  }
+  return 0;
+}
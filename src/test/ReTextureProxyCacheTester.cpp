@@ -0,0 +1,95 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+//! Tests of the reduced copies of the image maps used by the material
+//! previews.
+
+#include <boost/test/unit_test.hpp>
+
+#include <QDir>
+#include <QImage>
+
+#include "ReTextureProxyCache.h"
+#include "RealityTester.h"
+
+using namespace Reality;
+
+#define RE_PROXY_TEST_SIZE 64
+
+//! Writes an image of the given size, red on the left half and blue on
+//! the right half
+static QString makeTestImage( const QString& dirName,
+                              const QString& name,
+                              const int width,
+                              const int height )
+{
+  QImage img(width, height, QImage::Format_RGB32);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      img.setPixel(x, y, x < width/2 ? qRgb(255, 0, 0) : qRgb(0, 0, 255));
+    }
+  }
+  QString fileName = QString("%1/%2").arg(dirName).arg(name);
+  img.save(fileName, "PNG");
+  return fileName;
+}
+
+BOOST_AUTO_TEST_CASE(test_TextureProxyGeneration) {
+  QString dirName = getTestDir("TextureProxy", QStringList() << "cache");
+  ReTextureProxyCache* cache = ReTextureProxyCache::getInstance();
+  QString oldCacheDir = cache->getCacheDir();
+  int oldMaxSize = cache->getMaxSize();
+  cache->setCacheDir(QString("%1/cache").arg(dirName));
+  cache->setMaxSize(RE_PROXY_TEST_SIZE);
+
+  QString fileName = makeTestImage(dirName, "large.png", RE_PROXY_TEST_SIZE*4, RE_PROXY_TEST_SIZE*2);
+
+  // The first request starts the generation and uses the original map
+  BOOST_CHECK(cache->getProxy(fileName, RGB_Mean) == fileName);
+  cache->waitForDone();
+  QString proxy = cache->getProxy(fileName, RGB_Mean);
+  BOOST_REQUIRE(proxy != fileName);
+  QImage img(proxy);
+  BOOST_CHECK_EQUAL(img.width(), RE_PROXY_TEST_SIZE);
+  BOOST_CHECK_EQUAL(img.height(), RE_PROXY_TEST_SIZE/2);
+
+  // A single channel is stored as a separate, gray, proxy
+  BOOST_CHECK(cache->getProxy(fileName, RGB_Red) == fileName);
+  cache->waitForDone();
+  QString redProxy = cache->getProxy(fileName, RGB_Red);
+  BOOST_REQUIRE(redProxy != fileName);
+  BOOST_CHECK(redProxy != proxy);
+  img = QImage(redProxy);
+  BOOST_CHECK_EQUAL(qRed(img.pixel(0, 0)), 255);
+  BOOST_CHECK_EQUAL(qBlue(img.pixel(0, 0)), 255);
+  BOOST_CHECK_EQUAL(qRed(img.pixel(img.width()-1, 0)), 0);
+
+  cache->setCacheDir(oldCacheDir);
+  cache->setMaxSize(oldMaxSize);
+}
+
+BOOST_AUTO_TEST_CASE(test_TextureProxyPassThrough) {
+  QString dirName = getTestDir("TextureProxy", QStringList() << "cache");
+  ReTextureProxyCache* cache = ReTextureProxyCache::getInstance();
+  QString oldCacheDir = cache->getCacheDir();
+  int oldMaxSize = cache->getMaxSize();
+  cache->setCacheDir(QString("%1/cache").arg(dirName));
+  cache->setMaxSize(RE_PROXY_TEST_SIZE);
+
+  // Small maps are used as they are
+  QString fileName = makeTestImage(dirName, "small.png", RE_PROXY_TEST_SIZE/2, RE_PROXY_TEST_SIZE/2);
+  BOOST_CHECK(cache->getProxy(fileName, RGB_Mean) == fileName);
+  cache->waitForDone();
+  BOOST_CHECK(cache->getProxy(fileName, RGB_Mean) == fileName);
+  BOOST_CHECK_EQUAL(QDir(cache->getCacheDir()).entryList(QDir::Files).count(), 0);
+
+  // Unsupported formats and missing files are passed through
+  QString exrName = QString("%1/map.exr").arg(dirName);
+  BOOST_CHECK(cache->getProxy(exrName, RGB_Mean) == exrName);
+
+  cache->setCacheDir(oldCacheDir);
+  cache->setMaxSize(oldMaxSize);
+}
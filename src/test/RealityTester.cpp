@@ -10,10 +10,52 @@
 
 #include <boost/test/included/unit_test.hpp>
 
+#include <QDir>
+
+#include "RealityTester.h"
 #include "ReGlossy.h"
+#include "textures/ReImageMap.h"
+#include "textures/ReMath.h"
+
+QString getTestDir( const QString& name, const QStringList& subDirs ) {
+  QString dirName = QDir::temp().absoluteFilePath(QString("Reality%1Test").arg(name));
+  foreach( QString subDir, QStringList(subDirs) << "." ) {
+    QDir dir(QDir(dirName).absoluteFilePath(subDir));
+    foreach( QString entry, dir.entryList(QDir::Files) ) {
+      dir.remove(entry);
+    }
+    QDir().mkpath(dir.absolutePath());
+  }
+  return dirName;
+}
 
 BOOST_AUTO_TEST_CASE(test_Glossy) {
     auto gl = new Reality::Glossy("GlossyTest", 0);
 	BOOST_CHECK(!gl->getName().isEmpty());
 }
 
+
+BOOST_AUTO_TEST_CASE(test_TextureGUID) {
+  using namespace Reality;
+  // Same settings, different names: the textures are interchangeable
+  ReTexturePtr skin(new ReImageMap("Skin_Kd", 0, "/runtime/textures/skin.jpg"));
+  ReTexturePtr limbs(new ReImageMap("Limbs_Kd", 0, "/runtime/textures/skin.jpg"));
+  BOOST_CHECK_EQUAL(skin->getGUID(), limbs->getGUID());
+
+  limbs.staticCast<ReImageMap>()->setRgbChannel(RGB_Red);
+  BOOST_CHECK(skin->getGUID() != limbs->getGUID());
+
+  // Linked textures are compared by structure, not by name
+  ReMathPtr skinScale(new ReMath("Skin_scale"));
+  skinScale->setTexture1(skin);
+  skinScale->setAmount2(0.5);
+  ReMathPtr limbsScale(new ReMath("Limbs_scale"));
+  limbsScale->setTexture1(ReTexturePtr(
+    new ReImageMap("Limbs_Kd", 0, "/runtime/textures/skin.jpg")
+  ));
+  limbsScale->setAmount2(0.5);
+  BOOST_CHECK_EQUAL(skinScale->getGUID(), limbsScale->getGUID());
+
+  limbsScale->setFunction(ReMath::add);
+  BOOST_CHECK(skinScale->getGUID() != limbsScale->getGUID());
+}
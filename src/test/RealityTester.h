@@ -0,0 +1,21 @@
+/**
+ * \file
+ *  Reality plug-in
+ *  Copyright (c) Pret-a-3D/Paolo Ciccone 2014. All rights reserved.
+ */
+
+#ifndef REALITY_TESTER_H
+#define REALITY_TESTER_H
+
+#include <QString>
+#include <QStringList>
+
+/**
+ * Returns an empty directory for the files of a test, Reality<name>Test
+ * in the temporary directory. The files left by a previous run are
+ * removed, from the directory and from its subDirs, which are created if
+ * needed.
+ */
+QString getTestDir( const QString& name, const QStringList& subDirs = QStringList() );
+
+#endif